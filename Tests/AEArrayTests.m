@@ -9,6 +9,7 @@
 #import <XCTest/XCTest.h>
 #import "AEArray.h"
 #import "AEManagedValue.h"
+#import "AETime.h"
 
 @interface AEArrayTests : XCTestCase
 
@@ -16,6 +17,11 @@
 
 @implementation AEArrayTests
 
+- (void)tearDown {
+    // Tests render on the main thread; don't leave it holding up the release of old values
+    AEManagedValueUnregisterRenderThread(pthread_self());
+}
+
 - (void)testItemLifecycle {
     AEArray * array = [AEArray new];
     [array updateWithContentsOfArray:@[@(1), @(2), @(3)]];
@@ -121,4 +127,262 @@ struct testStruct {
     XCTAssertEqualObjects(released, (@[@(2), @(3), @(4), @(1), @(2), @(3)]));
 }
 
+- (void)testIncrementalUpdates {
+    AEArray * array = [[AEArray alloc] initWithCustomMapping:^void *(id item) {
+        struct testStruct * value = calloc(sizeof(struct testStruct), 1);
+        value->value = ((NSNumber*)item).intValue;
+        return value;
+    }];
+    
+    NSMutableArray * released = [NSMutableArray array];
+    array.releaseBlock = ^(id item, void * bytes) {
+        [released addObject:item];
+        free(bytes);
+    };
+    
+    // Enough items to span several chunks
+    NSMutableArray * expected = [NSMutableArray array];
+    for ( int i=0; i<300; i++ ) {
+        [array addObject:@(i)];
+        [expected addObject:@(i)];
+    }
+    [array insertObject:@(1000) atIndex:0];
+    [expected insertObject:@(1000) atIndex:0];
+    [array insertObject:@(1001) atIndex:150];
+    [expected insertObject:@(1001) atIndex:150];
+    for ( int i=0; i<100; i++ ) {
+        [array removeObjectAtIndex:10];
+        [expected removeObjectAtIndex:10];
+    }
+    [array removeObject:@(299)];
+    [expected removeObject:@(299)];
+    [array replaceObjectAtIndex:50 withObject:@(2000)];
+    NSNumber * replaced = expected[50];
+    expected[50] = @(2000);
+    
+    XCTAssertEqualObjects(array.allValues, expected);
+    XCTAssertEqual(array.count, (int)expected.count);
+    XCTAssertEqualObjects(array[150], expected[150]);
+    XCTAssertFalse([array containsObject:replaced pointerValue:NULL]);
+    XCTAssertEqual(((struct testStruct*)[array pointerValueForObject:@(2000)])->value, 2000);
+    
+    int i=0;
+    NSMutableArray * enumerated = [NSMutableArray array];
+    for ( NSNumber * number in array ) {
+        [enumerated addObject:number];
+    }
+    XCTAssertEqualObjects(enumerated, expected);
+    
+    AEArrayToken token = AEArrayGetToken(array);
+    XCTAssertEqual(AEArrayGetCount(token), (int)expected.count);
+    XCTAssertEqual(((struct testStruct*)AEArrayGetItem(token, 150))->value, [expected[150] intValue]);
+    AEArrayEnumeratePointersToken(token, struct testStruct *, value) {
+        XCTAssertEqual(value->value, [expected[i++] intValue]);
+    }
+    XCTAssertEqual(i, (int)expected.count);
+    
+    AEManagedValueCommitPendingUpdates();
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.3]];
+    
+    // Only removed items are released
+    XCTAssertEqual((int)released.count, 102);
+    XCTAssertTrue([released containsObject:@(299)]);
+    XCTAssertTrue([released containsObject:replaced]);
+    XCTAssertFalse([released containsObject:@(1000)]);
+    
+    array = nil;
+    XCTAssertEqual(released.count, 102 + expected.count);
+}
+
+- (void)testUpdatePointerValueWithDuplicates {
+    AEArray * array = [[AEArray alloc] initWithCustomMapping:^void *(id item) {
+        struct testStruct * value = calloc(sizeof(struct testStruct), 1);
+        value->value = ((NSNumber*)item).intValue;
+        return value;
+    }];
+    
+    NSMutableArray * released = [NSMutableArray array];
+    array.releaseBlock = ^(id item, void * bytes) {
+        [released addObject:@(((struct testStruct*)bytes)->value)];
+        free(bytes);
+    };
+    
+    [array updateWithContentsOfArray:@[@(1), @(2), @(1)]];
+    
+    // All occurrences take the new value
+    struct testStruct * update = calloc(sizeof(struct testStruct), 1);
+    update->value = 10;
+    [array updatePointerValue:update forObject:@(1)];
+    
+    AEArrayToken token = AEArrayGetToken(array);
+    XCTAssertEqual(AEArrayGetCount(token), 3);
+    XCTAssertEqual(AEArrayGetItem(token, 0), update);
+    XCTAssertEqual(((struct testStruct*)AEArrayGetItem(token, 1))->value, 2);
+    XCTAssertEqual(AEArrayGetItem(token, 2), update);
+    XCTAssertEqual([array pointerValueForObject:@(1)], update);
+    
+    // Removing one occurrence leaves the other with the new value
+    [array removeObjectAtIndex:0];
+    token = AEArrayGetToken(array);
+    XCTAssertEqual(AEArrayGetCount(token), 2);
+    XCTAssertEqual(AEArrayGetItem(token, 1), update);
+    XCTAssertEqual([array pointerValueForObject:@(1)], update);
+    
+    AEManagedValueCommitPendingUpdates();
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.3]];
+    
+    // The old value is released once
+    XCTAssertEqualObjects(released, (@[@(1)]));
+    
+    array = nil;
+    XCTAssertEqualObjects(released, (@[@(1), @(2), @(10)]));
+}
+
+- (void)testIncrementalUpdatePerformance {
+    NSMutableArray * objects = [NSMutableArray array];
+    for ( int i=0; i<10000; i++ ) {
+        [objects addObject:[NSObject new]];
+    }
+    AEArray * array = [AEArray new];
+    [array updateWithContentsOfArray:objects];
+    
+    [self measureBlock:^{
+        // Add and remove a voice, many times over
+        for ( int i=0; i<1000; i++ ) {
+            NSObject * object = [NSObject new];
+            [array addObject:object];
+            [array removeObject:object];
+            [array removeObject:objects[i]];
+            [array insertObject:objects[i] atIndex:i];
+        }
+    }];
+    
+    XCTAssertEqualObjects(array.allValues, objects);
+}
+
+- (void)testInlineStorage {
+    AEArray * array = [[AEArray alloc] initWithInlineItemSize:sizeof(struct testStruct) customMapping:^void *(id item) {
+        struct testStruct * value = malloc(sizeof(struct testStruct));
+        value->value = ((NSNumber*)item).intValue;
+        value->otherValue = -value->value;
+        return value;
+    }];
+    
+    NSMutableArray * released = [NSMutableArray array];
+    array.releaseBlock = ^(id item, void * bytes) {
+        XCTAssertEqual(((struct testStruct*)bytes)->value, [item intValue]);
+        [released addObject:item];
+    };
+    
+    NSMutableArray * expected = [NSMutableArray array];
+    for ( int i=0; i<200; i++ ) {
+        [expected addObject:@(i)];
+    }
+    [array updateWithContentsOfArray:expected];
+    [array removeObjectAtIndex:100];
+    [expected removeObjectAtIndex:100];
+    [array insertObject:@(1000) atIndex:5];
+    [expected insertObject:@(1000) atIndex:5];
+    
+    struct testStruct update = { .value = 50, .otherValue = 500 };
+    [array updatePointerValue:&update forObject:@(50)];
+    
+    AEArrayToken token = AEArrayGetToken(array);
+    XCTAssertEqual(AEArrayGetCount(token), (int)expected.count);
+    int i=0;
+    AEArrayEnumeratePointersToken(token, struct testStruct *, value) {
+        XCTAssertEqual(value->value, [expected[i] intValue]);
+        XCTAssertEqual(value->otherValue, value->value == 50 ? 500 : -value->value);
+        i++;
+    }
+    XCTAssertEqual(i, (int)expected.count);
+    
+    // Items are stored contiguously within the array
+    struct testStruct * first = AEArrayGetItem(token, 0);
+    XCTAssertEqual((struct testStruct *)AEArrayGetItem(token, 1), first + 1);
+    XCTAssertEqual(((struct testStruct*)[array pointerValueForObject:@(1000)])->value, 1000);
+    
+    AEManagedValueCommitPendingUpdates();
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.3]];
+    
+    XCTAssertEqualObjects(released, (@[@(100), @(50)]));
+    
+    array = nil;
+    XCTAssertEqual(released.count, 2 + expected.count);
+}
+
+- (void)testEnumerationPerformance {
+    const int count = 10000;
+    NSMutableArray * objects = [NSMutableArray array];
+    for ( int i=0; i<count; i++ ) {
+        [objects addObject:@(i)];
+    }
+    void * (^mapping)(id item) = ^void *(id item) {
+        struct testStruct * value = calloc(sizeof(struct testStruct), 1);
+        value->value = ((NSNumber*)item).intValue;
+        return value;
+    };
+    AEArray * pointerArray = [[AEArray alloc] initWithCustomMapping:mapping];
+    [pointerArray updateWithContentsOfArray:objects];
+    AEArray * inlineArray = [[AEArray alloc] initWithInlineItemSize:sizeof(struct testStruct) customMapping:mapping];
+    [inlineArray updateWithContentsOfArray:objects];
+    
+    [self measureBlock:^{
+        for ( AEArray * array in @[pointerArray, inlineArray] ) {
+            AEArrayToken token = AEArrayGetToken(array);
+            AEHostTicks start = AECurrentTimeInHostTicks();
+            long sum = 0;
+            for ( int pass=0; pass<100; pass++ ) {
+                AEArrayEnumeratePointersToken(token, struct testStruct *, value) {
+                    sum += value->value;
+                }
+            }
+            AESeconds time = AESecondsFromHostTicks(AECurrentTimeInHostTicks() - start);
+            XCTAssertEqual(sum, 100L * count * (count-1) / 2);
+            NSLog(@"%@: %.2f ns per item", array == inlineArray ? @"Inline" : @"Pointer", time / (100.0 * count) * 1.0e9);
+        }
+    }];
+}
+
+- (void)testUpdatePerformance {
+    NSMutableArray <NSArray *> * sets = [NSMutableArray array];
+    for ( NSNumber * size in @[@(1000), @(10000), @(100000)] ) {
+        NSMutableArray * objects = [NSMutableArray arrayWithCapacity:size.intValue];
+        for ( int i=0; i<size.intValue; i++ ) {
+            [objects addObject:[NSObject new]];
+        }
+        [sets addObject:objects];
+    }
+    
+    [self measureBlock:^{
+        for ( NSArray * objects in sets ) {
+            int count = (int)objects.count;
+            AEArray * array = [AEArray new];
+            [array updateWithContentsOfArray:objects];
+            
+            // Remove one item and add another, as when adding or removing a voice
+            NSMutableArray * updated = [objects mutableCopy];
+            [updated removeObjectAtIndex:count / 2];
+            [updated addObject:[NSObject new]];
+            
+            AEHostTicks start = AECurrentTimeInHostTicks();
+            [array updateWithContentsOfArray:updated];
+            AESeconds updateTime = AESecondsFromHostTicks(AECurrentTimeInHostTicks() - start);
+            
+            start = AECurrentTimeInHostTicks();
+            int missing = 0;
+            for ( id object in updated ) {
+                if ( ![array containsObject:object pointerValue:NULL] ) missing++;
+            }
+            AESeconds lookupTime = AESecondsFromHostTicks(AECurrentTimeInHostTicks() - start);
+            
+            XCTAssertEqual(missing, 0);
+            XCTAssertEqual(array.count, count);
+            XCTAssertFalse([array containsObject:objects[count / 2] pointerValue:NULL]);
+            XCTAssertEqual([array pointerValueForObject:updated.lastObject], (__bridge void*)updated.lastObject);
+            NSLog(@"%d entries: update %.3f ms, %.1f ns per lookup", count, updateTime * 1.0e3, lookupTime / count * 1.0e9);
+        }
+    }];
+}
+
 @end
@@ -0,0 +1,193 @@
+//
+//  AEAudioDiskCacheTests.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "AEAudioDiskCache.h"
+#import "AEAudioSampleCache.h"
+#import "AEAudioFileOutput.h"
+#import "AEAudioBufferListUtilities.h"
+#import "AERenderer.h"
+#import "AEBufferStack.h"
+#import "AETypes.h"
+
+static const double kSampleRate = 44100.0;
+static const UInt32 kTestLength = 1000;
+
+@interface AEAudioDiskCacheTests : XCTestCase
+@property (nonatomic, strong) NSString * folder;
+@property (nonatomic, strong) AEAudioDiskCache * cache;
+@end
+
+@implementation AEAudioDiskCacheTests
+
+- (void)setUp {
+    self.folder = [NSTemporaryDirectory() stringByAppendingPathComponent:@"AEAudioDiskCacheTests"];
+    [[NSFileManager defaultManager] removeItemAtPath:self.folder error:NULL];
+    self.cache = [[AEAudioDiskCache alloc] initWithDirectory:[self.folder stringByAppendingPathComponent:@"Cache"]];
+    [[@"source a" dataUsingEncoding:NSUTF8StringEncoding] writeToFile:[self file:@"a"] atomically:YES];
+    [[@"source b" dataUsingEncoding:NSUTF8StringEncoding] writeToFile:[self file:@"b"] atomically:YES];
+    [[@"source a" dataUsingEncoding:NSUTF8StringEncoding] writeToFile:[self file:@"a copy"] atomically:YES];
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath:self.folder error:NULL];
+}
+
+- (void)testKeyFollowsContents {
+    AudioStreamBasicDescription format = AEAudioDescriptionWithChannelsAndRate(2, kSampleRate);
+    NSString * a = [self.cache keyForFileAtPath:[self file:@"a"] audioDescription:format error:NULL];
+    XCTAssertNotNil(a);
+    XCTAssertEqualObjects(a, [self.cache keyForFileAtPath:[self file:@"a copy"] audioDescription:format error:NULL]);
+    XCTAssertNotEqualObjects(a, [self.cache keyForFileAtPath:[self file:@"b"] audioDescription:format error:NULL]);
+    XCTAssertNotEqualObjects(a, [self.cache keyForFileAtPath:[self file:@"a"]
+                                            audioDescription:AEAudioDescriptionWithChannelsAndRate(2, 48000) error:NULL]);
+    XCTAssertNotEqualObjects(a, [self.cache keyForFileAtPath:[self file:@"a"]
+                                            audioDescription:AEAudioDescriptionWithChannelsAndRate(1, kSampleRate) error:NULL]);
+
+    NSError * error = nil;
+    XCTAssertNil([self.cache keyForFileAtPath:[self file:@"missing"] audioDescription:format error:&error]);
+    XCTAssertNotNil(error);
+}
+
+- (void)testStoresAndMapsAudio {
+    AudioStreamBasicDescription format = AEAudioDescriptionWithChannelsAndRate(2, kSampleRate);
+    NSString * key = [self.cache keyForFileAtPath:[self file:@"a"] audioDescription:format error:NULL];
+
+    UInt32 length = 0;
+    XCTAssertTrue([self.cache mapAudioForKey:key length:&length] == NULL);
+
+    AudioBufferList * audio = [self createTestAudioWithFormat:format];
+    NSError * error = nil;
+    XCTAssertTrue([self.cache storeAudio:audio length:kTestLength forKey:key error:&error]);
+    XCTAssertNil(error);
+
+    AudioBufferList * mapped = [self.cache mapAudioForKey:key length:&length];
+    XCTAssertTrue(mapped != NULL);
+    XCTAssertEqual(length, kTestLength);
+    XCTAssertEqual(mapped->mNumberBuffers, 2);
+    for ( int i=0; i<mapped->mNumberBuffers; i++ ) {
+        XCTAssertEqual(mapped->mBuffers[i].mDataByteSize, kTestLength * sizeof(float));
+        XCTAssertEqual((uintptr_t)mapped->mBuffers[i].mData % 16, 0);
+        XCTAssertEqual(memcmp(mapped->mBuffers[i].mData, audio->mBuffers[i].mData, kTestLength * sizeof(float)), 0);
+    }
+
+    AEAudioDiskCacheFreeMappedAudio(mapped);
+    AEAudioBufferListFree(audio);
+
+    [self.cache removeAllCachedAudio];
+    XCTAssertTrue([self.cache mapAudioForKey:key length:&length] == NULL);
+}
+
+- (void)testRejectsTruncatedEntry {
+    AudioStreamBasicDescription format = AEAudioDescriptionWithChannelsAndRate(2, kSampleRate);
+    NSString * key = [self.cache keyForFileAtPath:[self file:@"a"] audioDescription:format error:NULL];
+    AudioBufferList * audio = [self createTestAudioWithFormat:format];
+    XCTAssertTrue([self.cache storeAudio:audio length:kTestLength forKey:key error:NULL]);
+    AEAudioBufferListFree(audio);
+
+    NSString * path = [[self.cache.directory stringByAppendingPathComponent:key] stringByAppendingPathExtension:@"aedc"];
+    NSFileHandle * handle = [NSFileHandle fileHandleForWritingAtPath:path];
+    XCTAssertNotNil(handle);
+    [handle truncateFileAtOffset:1000];
+    [handle closeFile];
+
+    UInt32 length = 0;
+    XCTAssertTrue([self.cache mapAudioForKey:key length:&length] == NULL);
+}
+
+- (void)testSampleCacheLoadsFromDiskCache {
+    NSString * file = [self file:@"audio.aiff"];
+    XCTAssertNil([self createTestAudioFile:file]);
+    AudioStreamBasicDescription format = AEAudioDescriptionWithChannelsAndRate(1, kSampleRate);
+
+    // First load decodes, and persists in the background
+    AEAudioSampleCache * first = [[AEAudioSampleCache alloc] initWithByteBudget:0];
+    first.diskCache = self.cache;
+    AEAudioSample * decoded = [self load:file format:format cache:first];
+    XCTAssertNotNil(decoded);
+
+    NSString * key = [self.cache keyForFileAtPath:file audioDescription:format error:NULL];
+    UInt32 length = 0;
+    AudioBufferList * mapped = NULL;
+    for ( int i=0; i<50 && !mapped; i++ ) {
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+        mapped = [self.cache mapAudioForKey:key length:&length];
+    }
+    XCTAssertTrue(mapped != NULL);
+    XCTAssertEqual(length, decoded.length);
+    AEAudioDiskCacheFreeMappedAudio(mapped);
+
+    // A fresh cache maps the stored audio
+    AEAudioSampleCache * second = [[AEAudioSampleCache alloc] initWithByteBudget:0];
+    second.diskCache = self.cache;
+    AEAudioSample * loaded = [self load:file format:format cache:second];
+    XCTAssertNotNil(loaded);
+    XCTAssertEqual(loaded.length, decoded.length);
+    XCTAssertNotEqual(loaded.audio, decoded.audio);
+    XCTAssertEqual(memcmp(loaded.audio->mBuffers[0].mData, decoded.audio->mBuffers[0].mData, decoded.length * sizeof(float)), 0);
+}
+
+- (AEAudioSample *)load:(NSString *)path format:(AudioStreamBasicDescription)format cache:(AEAudioSampleCache *)cache {
+    __block AEAudioSample * result = nil;
+    XCTestExpectation * expectation = [self expectationWithDescription:@"load"];
+    [cache loadSampleAtPath:path targetAudioDescription:format completionBlock:^(AEAudioSample * sample, NSError * error) {
+        XCTAssertNil(error);
+        result = sample;
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+    return result;
+}
+
+- (AudioBufferList *)createTestAudioWithFormat:(AudioStreamBasicDescription)format {
+    AudioBufferList * audio = AEAudioBufferListCreateWithFormat(format, kTestLength);
+    for ( int i=0; i<audio->mNumberBuffers; i++ ) {
+        float * data = audio->mBuffers[i].mData;
+        for ( UInt32 j=0; j<kTestLength; j++ ) {
+            data[j] = (float)(i+1) * (float)j / kTestLength;
+        }
+    }
+    return audio;
+}
+
+- (NSString *)file:(NSString *)name {
+    return [self.folder stringByAppendingPathComponent:name];
+}
+
+- (NSError *)createTestAudioFile:(NSString *)path {
+    AERenderer * renderer = [AERenderer new];
+
+    AEAudioFileOutput * output = [[AEAudioFileOutput alloc] initWithRenderer:renderer path:path type:AEAudioFileTypeAIFFInt16 sampleRate:kSampleRate channelCount:1];
+    __block NSError * error = nil;
+    if ( ![output prepareForWriting:&error] ) {
+        return error;
+    }
+
+    __block UInt64 frame = 0;
+    renderer.block = ^(const AERenderContext * context) {
+        const AudioBufferList * abl = AEBufferStackPushWithChannels(context->stack, 1, 1);
+        float * data = abl->mBuffers[0].mData;
+        for ( UInt32 i=0; i<context->frames; i++ ) {
+            data[i] = (float)(frame++ % 1000) / 2000.0f;
+        }
+        AERenderContextOutput(context, 1);
+    };
+
+    __block BOOL done = NO;
+    [output runForDuration:0.25 completionBlock:^(NSError * e){
+        done = YES;
+        error = e;
+    }];
+    while ( !done ) {
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+    }
+    [output finishWriting];
+    return error;
+}
+
+@end
@@ -0,0 +1,201 @@
+//
+//  AEAudioFileBatchLoaderTests.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "AEAudioFileReader.h"
+#import "AEAudioBufferListUtilities.h"
+#import "AETypes.h"
+
+static const int kLibrarySize = 96;
+static const UInt32 kSampleLength = 44100;
+
+@interface AEAudioFileBatchLoaderTests : XCTestCase
+@property (nonatomic, strong) NSString * folder;
+@end
+
+@implementation AEAudioFileBatchLoaderTests
+
+- (void)setUp {
+    // A synthetic sample library: one second of 16-bit stereo audio per file
+    self.folder = [NSTemporaryDirectory() stringByAppendingPathComponent:@"AEAudioFileBatchLoaderTests"];
+    [[NSFileManager defaultManager] createDirectoryAtPath:self.folder withIntermediateDirectories:YES attributes:nil error:NULL];
+    for ( int i=0; i<kLibrarySize; i++ ) {
+        [[self WAVWithValue:i] writeToFile:[self file:i] atomically:YES];
+    }
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath:self.folder error:NULL];
+}
+
+- (void)testLoadsLibrary {
+    AEAudioFileBatchLoader * loader = [[AEAudioFileBatchLoader alloc] initWithMaximumConcurrentLoads:4];
+    __block double lastProgress = 0;
+    __block int lastCompleted = 0;
+    loader.progressBlock = ^(double progress, int completedLoads, int totalLoads) {
+        XCTAssertGreaterThanOrEqual(completedLoads, lastCompleted);
+        XCTAssertLessThanOrEqual(completedLoads, totalLoads);
+        lastProgress = progress;
+        lastCompleted = completedLoads;
+    };
+
+    __block int loaded = 0;
+    for ( int i=0; i<kLibrarySize; i++ ) {
+        [loader loadFileAtPath:[self file:i] targetAudioDescription:AEAudioDescription
+                      priority:AEAudioFileLoadPriorityBackground
+               completionBlock:^(AudioBufferList * audio, UInt32 length, NSError * error) {
+            XCTAssertNil(error);
+            XCTAssertEqual(length, kSampleLength);
+            XCTAssertEqual(((float *)audio->mBuffers[1].mData)[0], [self valueForFile:i]);
+            AEAudioBufferListFree(audio);
+            loaded++;
+        }];
+    }
+    XCTAssertEqual(loader.totalLoads, kLibrarySize);
+
+    [self waitFor:^BOOL{ return lastCompleted == kLibrarySize; }];
+    XCTAssertEqual(loaded, kLibrarySize);
+    XCTAssertEqual(lastProgress, 1.0);
+    XCTAssertEqual(loader.progress, 1.0);
+}
+
+- (void)testPlaybackLoadsTakePriority {
+    AEAudioFileBatchLoader * loader = [[AEAudioFileBatchLoader alloc] initWithMaximumConcurrentLoads:2];
+    __block int backgroundLoaded = 0;
+    __block int backgroundLoadedBeforePlayback = -1;
+    for ( int i=0; i<kLibrarySize-1; i++ ) {
+        [loader loadFileAtPath:[self file:i] targetAudioDescription:AEAudioDescription
+                      priority:AEAudioFileLoadPriorityBackground
+               completionBlock:^(AudioBufferList * audio, UInt32 length, NSError * error) {
+            AEAudioBufferListFree(audio);
+            backgroundLoaded++;
+        }];
+    }
+
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    __block CFAbsoluteTime latency = 0;
+    [loader loadFileAtPath:[self file:kLibrarySize-1] targetAudioDescription:AEAudioDescription
+                  priority:AEAudioFileLoadPriorityPlayback
+           completionBlock:^(AudioBufferList * audio, UInt32 length, NSError * error) {
+        XCTAssertNil(error);
+        AEAudioBufferListFree(audio);
+        latency = CFAbsoluteTimeGetCurrent() - start;
+        backgroundLoadedBeforePlayback = backgroundLoaded;
+    }];
+
+    [self waitFor:^BOOL{ return backgroundLoaded == kLibrarySize-1 && backgroundLoadedBeforePlayback >= 0; }];
+    NSLog(@"Playback-critical load latency behind %d background loads: %lf ms", kLibrarySize-1, latency * 1000.0);
+    XCTAssertLessThan(backgroundLoadedBeforePlayback, kLibrarySize / 2);
+}
+
+- (void)testCancelsAllLoads {
+    AEAudioFileBatchLoader * loader = [[AEAudioFileBatchLoader alloc] initWithMaximumConcurrentLoads:2];
+    __block int lastCompleted = 0;
+    loader.progressBlock = ^(double progress, int completedLoads, int totalLoads) {
+        lastCompleted = completedLoads;
+    };
+
+    __block int loaded = 0;
+    AEAudioFileReader * reader = nil;
+    for ( int i=0; i<kLibrarySize; i++ ) {
+        reader = [loader loadFileAtPath:[self file:i] targetAudioDescription:AEAudioDescription
+                               priority:AEAudioFileLoadPriorityBackground
+                        completionBlock:^(AudioBufferList * audio, UInt32 length, NSError * error) {
+            AEAudioBufferListFree(audio);
+            loaded++;
+        }];
+    }
+    [loader cancelAllLoads];
+
+    [self waitFor:^BOOL{ return lastCompleted == kLibrarySize; }];
+    XCTAssertLessThan(loaded, kLibrarySize);
+    XCTAssertLessThan(reader.progress, 1.0);
+    XCTAssertEqual(loader.progress, 1.0);
+}
+
+- (void)testLibraryLoadPerformance {
+    NSUInteger bytes = 0;
+    for ( int i=0; i<kLibrarySize; i++ ) {
+        bytes += [[[NSFileManager defaultManager] attributesOfItemAtPath:[self file:i] error:NULL] fileSize];
+    }
+
+    AEAudioFileBatchLoader * loader = [AEAudioFileBatchLoader new];
+    [self measureBlock:^{
+        __block int loaded = 0;
+        __block CFAbsoluteTime totalLatency = 0;
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        for ( int i=0; i<kLibrarySize; i++ ) {
+            [loader loadFileAtPath:[self file:i] targetAudioDescription:AEAudioDescription
+                          priority:AEAudioFileLoadPriorityBackground
+                   completionBlock:^(AudioBufferList * audio, UInt32 length, NSError * error) {
+                AEAudioBufferListFree(audio);
+                totalLatency += CFAbsoluteTimeGetCurrent() - start;
+                loaded++;
+            }];
+        }
+        [self waitFor:^BOOL{ return loaded == kLibrarySize; }];
+        CFAbsoluteTime duration = CFAbsoluteTimeGetCurrent() - start;
+        NSLog(@"%d files with %d workers: %.1lf MB/s, mean latency %.2lf ms", kLibrarySize, loader.maximumConcurrentLoads,
+              bytes / duration / (1024.0 * 1024.0), totalLatency / kLibrarySize * 1000.0);
+    }];
+}
+
+#pragma mark - Helpers
+
+- (void)waitFor:(BOOL(^)(void))condition {
+    NSDate * timeout = [NSDate dateWithTimeIntervalSinceNow:10.0];
+    while ( !condition() && [timeout timeIntervalSinceNow] > 0 ) {
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    XCTAssertTrue(condition());
+}
+
+- (NSString *)file:(int)index {
+    return [self.folder stringByAppendingPathComponent:[NSString stringWithFormat:@"sample%d.wav", index]];
+}
+
+- (float)valueForFile:(int)index {
+    return (index % 64) / 128.0f;
+}
+
+- (NSData *)WAVWithValue:(int)index {
+    NSMutableData * data = [NSMutableData data];
+    UInt32 dataSize = kSampleLength * 4;
+    UInt32 riffSize = CFSwapInt32HostToLittle(4 + 24 + 8 + dataSize);
+    UInt32 fmtSize = CFSwapInt32HostToLittle(16);
+    UInt16 formatTag = CFSwapInt16HostToLittle(1);
+    UInt16 channelCount = CFSwapInt16HostToLittle(2);
+    UInt32 sampleRate = CFSwapInt32HostToLittle(44100);
+    UInt32 byteRate = CFSwapInt32HostToLittle(44100 * 4);
+    UInt16 blockAlign = CFSwapInt16HostToLittle(4);
+    UInt16 bits = CFSwapInt16HostToLittle(16);
+    UInt32 dataChunkSize = CFSwapInt32HostToLittle(dataSize);
+    [data appendBytes:"RIFF" length:4];
+    [data appendBytes:&riffSize length:4];
+    [data appendBytes:"WAVEfmt " length:8];
+    [data appendBytes:&fmtSize length:4];
+    [data appendBytes:&formatTag length:2];
+    [data appendBytes:&channelCount length:2];
+    [data appendBytes:&sampleRate length:4];
+    [data appendBytes:&byteRate length:4];
+    [data appendBytes:&blockAlign length:2];
+    [data appendBytes:&bits length:2];
+    [data appendBytes:"data" length:4];
+    [data appendBytes:&dataChunkSize length:4];
+
+    // Left channel is a ramp; right channel holds a constant identifying the file
+    SInt16 right = CFSwapInt16HostToLittle((SInt16)([self valueForFile:index] * 32768.0f));
+    for ( UInt32 frame=0; frame<kSampleLength; frame++ ) {
+        SInt16 left = CFSwapInt16HostToLittle((SInt16)(frame % 32768));
+        [data appendBytes:&left length:2];
+        [data appendBytes:&right length:2];
+    }
+    return data;
+}
+
+@end
@@ -0,0 +1,279 @@
+//
+//  AEAudioFilePlayerModuleTests.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "AEAudioFilePlayerModule.h"
+#import "AEAudioFileOutput.h"
+#import "AERenderer.h"
+#import "AEAudioBufferListUtilities.h"
+#import "AEBufferStack.h"
+#import "AETypes.h"
+
+static const double kSampleRate = 44100.0;
+static const NSTimeInterval kTestFileLength = 2.0;
+static const UInt32 kSliceFrames = 512;
+
+// Each frame of the test file identifies its own position, exactly representable at 16 bits
+static float AEPlayerTestSample(UInt64 frame) {
+    return (float)(frame % 16384) / 32768.0f;
+}
+
+// Count frames which don't match the file at the given position, wrapping within the region
+static UInt32 AEPlayerTestMismatches(const float * data, UInt32 length, UInt64 position,
+                                     UInt64 regionStart, UInt64 regionLength) {
+    UInt32 mismatches = 0;
+    for ( UInt32 i=0; i<length; i++ ) {
+        UInt64 frame = regionStart + ((position - regionStart + i) % regionLength);
+        if ( data[i] != AEPlayerTestSample(frame) ) mismatches++;
+    }
+    return mismatches;
+}
+
+@interface AEAudioFilePlayerModuleTests : XCTestCase
+@property (nonatomic, strong, readonly) NSString * file;
+@end
+
+@implementation AEAudioFilePlayerModuleTests
+@dynamic file;
+
+- (void)setUp {
+    NSString * documentsFolder = NSSearchPathForDirectoriesInDomains(NSDocumentDirectory, NSUserDomainMask, YES).firstObject;
+    if ( ![[NSFileManager defaultManager] fileExistsAtPath:documentsFolder] ) {
+        [[NSFileManager defaultManager] createDirectoryAtPath:documentsFolder
+                                  withIntermediateDirectories:YES attributes:nil error:NULL];
+    }
+    XCTAssertNil([self createTestFile]);
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath:self.file error:NULL];
+}
+
+- (void)testStreamsFile {
+    AERenderer * renderer = [self testRenderer];
+    AEAudioFilePlayerModule * player = [[AEAudioFilePlayerModule alloc] initWithRenderer:renderer path:self.file error:NULL];
+    XCTAssertNotNil(player);
+    XCTAssertEqual(player.numberOfChannels, 1);
+    XCTAssertEqualWithAccuracy(player.duration, kTestFileLength, 1.0e-6);
+    
+    [self prepareToPlay:player renderer:renderer];
+    [player playAtTime:AETimeStampNone];
+    
+    UInt32 frames = kSampleRate;
+    AudioBufferList * output = [self render:player renderer:renderer frames:frames start:0];
+    XCTAssertEqual(AEPlayerTestMismatches(output->mBuffers[0].mData, frames, 0, 0, UINT32_MAX), 0);
+    AEAudioBufferListFree(output);
+}
+
+- (void)testSeekIsSampleAccurate {
+    AERenderer * renderer = [self testRenderer];
+    AEAudioFilePlayerModule * player = [[AEAudioFilePlayerModule alloc] initWithRenderer:renderer path:self.file error:NULL];
+    player.currentTime = 1.0;
+    XCTAssertEqualWithAccuracy(player.currentTime, 1.0, 1.0e-9);
+    
+    [self prepareToPlay:player renderer:renderer];
+    [player playAtTime:AETimeStampNone];
+    
+    UInt32 frames = kSampleRate / 4;
+    AudioBufferList * output = [self render:player renderer:renderer frames:frames start:0];
+    XCTAssertEqual(AEPlayerTestMismatches(output->mBuffers[0].mData, frames, kSampleRate, 0, UINT32_MAX), 0);
+    AEAudioBufferListFree(output);
+}
+
+- (void)testLoopIsSeamless {
+    AERenderer * renderer = [self testRenderer];
+    AEAudioFilePlayerModule * player = [[AEAudioFilePlayerModule alloc] initWithRenderer:renderer path:self.file error:NULL];
+    player.regionStartTime = 0.5;
+    player.regionDuration = 0.1;
+    player.loop = YES;
+    
+    [self prepareToPlay:player renderer:renderer];
+    [player playAtTime:AETimeStampNone];
+    
+    // Ten times through a 4410-frame region, rejoining the start without a gap each time
+    UInt32 frames = kSampleRate;
+    AudioBufferList * output = [self render:player renderer:renderer frames:frames start:0];
+    XCTAssertEqual(AEPlayerTestMismatches(output->mBuffers[0].mData, frames, kSampleRate / 2, kSampleRate / 2, kSampleRate / 10), 0);
+    XCTAssertTrue(player.playing);
+    AEAudioBufferListFree(output);
+}
+
+- (void)testRegionEndStopsPlayback {
+    AERenderer * renderer = [self testRenderer];
+    AEAudioFilePlayerModule * player = [[AEAudioFilePlayerModule alloc] initWithRenderer:renderer path:self.file error:NULL];
+    player.regionStartTime = 0.5;
+    player.regionDuration = 0.1;
+    __block BOOL completed = NO;
+    player.completionBlock = ^{ completed = YES; };
+    
+    [self prepareToPlay:player renderer:renderer];
+    [player playAtTime:AETimeStampNone];
+    
+    UInt32 frames = kSampleRate / 4;
+    UInt32 regionFrames = kSampleRate / 10;
+    AudioBufferList * output = [self render:player renderer:renderer frames:frames start:0];
+    XCTAssertEqual(AEPlayerTestMismatches(output->mBuffers[0].mData, regionFrames, kSampleRate / 2, 0, UINT32_MAX), 0);
+    
+    AEAudioBufferListCopyOnStack(tail, output, regionFrames);
+    AEAudioBufferListSetLength(tail, frames - regionFrames);
+    XCTAssertTrue(AEAudioBufferListIsSilent(tail));
+    XCTAssertFalse(player.playing);
+    AEAudioBufferListFree(output);
+    
+    NSDate * deadline = [NSDate dateWithTimeIntervalSinceNow:1.0];
+    while ( !completed && [deadline timeIntervalSinceNow] > 0 ) {
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    }
+    XCTAssertTrue(completed);
+    XCTAssertEqualWithAccuracy(player.currentTime, 0.5, 1.0e-9);
+}
+
+- (void)testStartTimeInPastSkipsAhead {
+    AERenderer * renderer = [self testRenderer];
+    AEAudioFilePlayerModule * player = [[AEAudioFilePlayerModule alloc] initWithRenderer:renderer path:self.file error:NULL];
+    
+    [self prepareToPlay:player renderer:renderer];
+    
+    // Playback was due to begin 1000 frames before the first render
+    [player playAtTime:(AudioTimeStamp){ .mFlags = kAudioTimeStampSampleTimeValid, .mSampleTime = 9000 }];
+    
+    UInt32 frames = kSampleRate / 4;
+    AudioBufferList * output = [self render:player renderer:renderer frames:frames start:10000];
+    XCTAssertEqual(AEPlayerTestMismatches(output->mBuffers[0].mData, frames, 1000, 0, UINT32_MAX), 0);
+    AEAudioBufferListFree(output);
+}
+
+- (void)testManyStreamingPlayers {
+    // Hundreds of players streaming at once, each from a different position
+    const int kPlayers = 256;
+    const UInt32 kSpacing = 100;
+    AERenderer * renderer = [self testRenderer];
+    NSMutableArray <AEAudioFilePlayerModule *> * players = [NSMutableArray array];
+    for ( int i=0; i<kPlayers; i++ ) {
+        AEAudioFilePlayerModule * player =
+            [[AEAudioFilePlayerModule alloc] initWithRenderer:renderer path:self.file error:NULL];
+        XCTAssertNotNil(player);
+        player.currentTime = (i * kSpacing) / kSampleRate;
+        [players addObject:player];
+    }
+    
+    __block UInt32 mismatches = 0;
+    __block UInt64 position = 0;
+    renderer.block = ^(const AERenderContext * context) {
+        for ( int i=0; i<kPlayers; i++ ) {
+            AEModuleProcess(players[i], context);
+            if ( AEAudioFilePlayerModuleGetPlaying(players[i]) ) {
+                const AudioBufferList * abl = AEBufferStackGet(context->stack, 0);
+                mismatches += AEPlayerTestMismatches(abl->mBuffers[0].mData, context->frames,
+                                                     position + i * kSpacing, 0, UINT32_MAX);
+            }
+            AEBufferStackPop(context->stack, 1);
+        }
+        position += AEAudioFilePlayerModuleGetPlaying(players[0]) ? context->frames : 0;
+    };
+    
+    // Let the streams pick up their positions and prefetch
+    AudioBufferList * output = AEAudioBufferListCreateWithFormat(AEAudioDescriptionWithChannelsAndRate(1, kSampleRate), kSliceFrames);
+    AudioTimeStamp timestamp = { .mFlags = kAudioTimeStampSampleTimeValid, .mSampleTime = 0 };
+    AERendererRun(renderer, output, kSliceFrames, &timestamp);
+    [NSThread sleepForTimeInterval:0.2];
+    
+    for ( AEAudioFilePlayerModule * player in players ) {
+        [player playAtTime:AETimeStampNone];
+    }
+    
+    // Half a second, at realtime pace
+    for ( UInt32 frame = 0; frame < kSampleRate / 2; frame += kSliceFrames ) {
+        timestamp.mSampleTime += kSliceFrames;
+        AERendererRun(renderer, output, kSliceFrames, &timestamp);
+        [NSThread sleepForTimeInterval:kSliceFrames / kSampleRate];
+    }
+    
+    XCTAssertGreaterThan(position, kSampleRate / 4);
+    XCTAssertEqual(mismatches, 0);
+    AEAudioBufferListFree(output);
+}
+
+#pragma mark -
+
+- (AERenderer *)testRenderer {
+    AERenderer * renderer = [AERenderer new];
+    renderer.sampleRate = kSampleRate;
+    return renderer;
+}
+
+- (void)prepareToPlay:(AEAudioFilePlayerModule *)player renderer:(AERenderer *)renderer {
+    // Run a cycle while stopped, so the player picks up its position, then give the stream time to prefetch
+    renderer.block = ^(const AERenderContext * context) {
+        AEModuleProcess(player, context);
+        AERenderContextOutput(context, 1);
+    };
+    AudioBufferList * buffer = AEAudioBufferListCreateWithFormat(AEAudioDescriptionWithChannelsAndRate(1, kSampleRate), kSliceFrames);
+    AudioTimeStamp timestamp = { .mFlags = kAudioTimeStampSampleTimeValid, .mSampleTime = 0 };
+    AERendererRun(renderer, buffer, kSliceFrames, &timestamp);
+    AEAudioBufferListFree(buffer);
+    [NSThread sleepForTimeInterval:0.1];
+}
+
+- (AudioBufferList *)render:(AEAudioFilePlayerModule *)player renderer:(AERenderer *)renderer
+                     frames:(UInt32)frames start:(double)sampleTime {
+    renderer.block = ^(const AERenderContext * context) {
+        AEModuleProcess(player, context);
+        AERenderContextOutput(context, 1);
+    };
+    
+    AudioBufferList * output = AEAudioBufferListCreateWithFormat(AEAudioDescriptionWithChannelsAndRate(1, kSampleRate), frames);
+    AudioTimeStamp timestamp = { .mFlags = kAudioTimeStampSampleTimeValid, .mSampleTime = sampleTime };
+    for ( UInt32 position = 0; position < frames; position += kSliceFrames ) {
+        UInt32 length = MIN(kSliceFrames, frames - position);
+        AEAudioBufferListCopyOnStack(target, output, position);
+        AERendererRun(renderer, target, length, &timestamp);
+        timestamp.mSampleTime += length;
+        
+        // Run a few times faster than realtime, leaving the streaming thread room to keep up
+        [NSThread sleepForTimeInterval:length / kSampleRate / 4.0];
+    }
+    return output;
+}
+
+- (NSString *)file {
+    return [NSSearchPathForDirectoriesInDomains(NSDocumentDirectory, NSUserDomainMask, YES).firstObject stringByAppendingPathComponent:@"AEAudioFilePlayerModuleTests.aiff"];
+}
+
+- (NSError *)createTestFile {
+    AERenderer * renderer = [AERenderer new];
+    
+    AEAudioFileOutput * output = [[AEAudioFileOutput alloc] initWithRenderer:renderer path:self.file type:AEAudioFileTypeAIFFInt16 sampleRate:kSampleRate channelCount:1];
+    __block NSError * error = nil;
+    if ( ![output prepareForWriting:&error] ) {
+        return error;
+    }
+    
+    __block UInt64 frame = 0;
+    renderer.block = ^(const AERenderContext * context) {
+        const AudioBufferList * abl = AEBufferStackPushWithChannels(context->stack, 1, 1);
+        float * data = abl->mBuffers[0].mData;
+        for ( UInt32 i=0; i<context->frames; i++ ) {
+            data[i] = AEPlayerTestSample(frame++);
+        }
+        AERenderContextOutput(context, 1);
+    };
+    
+    __block BOOL done = NO;
+    [output runForDuration:kTestFileLength completionBlock:^(NSError * e){
+        done = YES;
+        error = e;
+    }];
+    while ( !done ) {
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+    }
+    [output finishWriting];
+    return error;
+}
+
+@end
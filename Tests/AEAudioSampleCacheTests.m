@@ -0,0 +1,214 @@
+//
+//  AEAudioSampleCacheTests.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "AEAudioSampleCache.h"
+#import "AEAudioFileOutput.h"
+#import "AEAudioBufferListUtilities.h"
+#import "AERenderer.h"
+#import "AEBufferStack.h"
+#import "AETypes.h"
+
+static const double kSampleRate = 44100.0;
+static const NSTimeInterval kTestFileLength = 0.25;
+
+@interface AEAudioSampleCacheTests : XCTestCase
+@end
+
+@implementation AEAudioSampleCacheTests
+
+- (void)setUp {
+    NSString * documentsFolder = NSSearchPathForDirectoriesInDomains(NSDocumentDirectory, NSUserDomainMask, YES).firstObject;
+    if ( ![[NSFileManager defaultManager] fileExistsAtPath:documentsFolder] ) {
+        [[NSFileManager defaultManager] createDirectoryAtPath:documentsFolder
+                                  withIntermediateDirectories:YES attributes:nil error:NULL];
+    }
+    XCTAssertNil([self createTestFile:[self file:0] value:0.25]);
+    XCTAssertNil([self createTestFile:[self file:1] value:0.5]);
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath:[self file:0] error:NULL];
+    [[NSFileManager defaultManager] removeItemAtPath:[self file:1] error:NULL];
+}
+
+- (void)testCoalescesLoads {
+    AEAudioSampleCache * cache = [[AEAudioSampleCache alloc] initWithByteBudget:0];
+
+    __block AEAudioSample * first = nil;
+    __block AEAudioSample * second = nil;
+    XCTestExpectation * firstLoaded = [self expectationWithDescription:@"first"];
+    XCTestExpectation * secondLoaded = [self expectationWithDescription:@"second"];
+    [cache loadSampleAtPath:[self file:0] targetAudioDescription:[self format] completionBlock:^(AEAudioSample * sample, NSError * error) {
+        first = sample;
+        [firstLoaded fulfill];
+    }];
+    XCTAssertNil([cache cachedSampleAtPath:[self file:0] targetAudioDescription:[self format]]);
+    [cache loadSampleAtPath:[self file:0] targetAudioDescription:[self format] completionBlock:^(AEAudioSample * sample, NSError * error) {
+        second = sample;
+        [secondLoaded fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+
+    XCTAssertNotNil(first);
+    XCTAssertNotNil(second);
+    XCTAssertEqual(AEAudioSampleGetAudio(first), AEAudioSampleGetAudio(second));
+    XCTAssertEqual(AEAudioSampleGetLength(first), (UInt32)(kTestFileLength * kSampleRate));
+    XCTAssertEqualWithAccuracy(first.duration, kTestFileLength, 1.0e-6);
+    XCTAssertEqual(((float*)AEAudioSampleGetAudio(first)->mBuffers[0].mData)[100], 0.25f);
+
+    size_t bytes = AEAudioSampleGetLength(first) * sizeof(float);
+    XCTAssertEqual(cache.residentBytes, bytes);
+    XCTAssertEqual(cache.referencedBytes, bytes);
+}
+
+- (void)testKeepsReferencedSamples {
+    AEAudioSampleCache * cache = [[AEAudioSampleCache alloc] initWithByteBudget:0];
+
+    @autoreleasepool {
+        AEAudioSample * sample = [self load:[self file:0] cache:cache];
+        size_t bytes = AEAudioSampleGetLength(sample) * sizeof(float);
+
+        // Over budget, but still referenced
+        XCTAssertEqual(cache.residentBytes, bytes);
+        XCTAssertEqual([cache cachedSampleAtPath:[self file:0] targetAudioDescription:[self format]].audio, sample.audio);
+        sample = nil;
+    }
+
+    XCTAssertEqual(cache.residentBytes, 0);
+    XCTAssertEqual(cache.referencedBytes, 0);
+    XCTAssertNil([cache cachedSampleAtPath:[self file:0] targetAudioDescription:[self format]]);
+}
+
+- (void)testEvictsLeastRecentlyUsed {
+    size_t bytes = (size_t)(kTestFileLength * kSampleRate) * sizeof(float);
+    AEAudioSampleCache * cache = [[AEAudioSampleCache alloc] initWithByteBudget:bytes];
+
+    @autoreleasepool {
+        AEAudioSample * first = [self load:[self file:0] cache:cache];
+        AEAudioSample * second = [self load:[self file:1] cache:cache];
+        XCTAssertEqual(cache.residentBytes, 2*bytes);
+
+        first = nil;
+        XCTAssertEqual(cache.residentBytes, 2*bytes);
+
+        // Releasing the second sample takes the cache over budget, evicting the least recently used
+        second = nil;
+    }
+
+    XCTAssertEqual(cache.residentBytes, bytes);
+    XCTAssertEqual(cache.referencedBytes, 0);
+    XCTAssertNil([cache cachedSampleAtPath:[self file:0] targetAudioDescription:[self format]]);
+    XCTAssertNotNil([cache cachedSampleAtPath:[self file:1] targetAudioDescription:[self format]]);
+
+    [cache removeUnreferencedSamples];
+    XCTAssertEqual(cache.residentBytes, 0);
+}
+
+- (void)testReloadsModifiedFile {
+    AEAudioSampleCache * cache = [[AEAudioSampleCache alloc] initWithByteBudget:SIZE_MAX];
+    AEAudioSample * original = [self load:[self file:0] cache:cache];
+    XCTAssertEqual(((float*)original.audio->mBuffers[0].mData)[0], 0.25f);
+
+    XCTAssertNil([self createTestFile:[self file:0] value:0.75]);
+    [[NSFileManager defaultManager] setAttributes:@{NSFileModificationDate: [NSDate dateWithTimeIntervalSinceNow:10]}
+                                     ofItemAtPath:[self file:0] error:NULL];
+
+    XCTAssertNil([cache cachedSampleAtPath:[self file:0] targetAudioDescription:[self format]]);
+    AEAudioSample * modified = [self load:[self file:0] cache:cache];
+    XCTAssertNotEqual(modified.audio, original.audio);
+    XCTAssertEqual(((float*)modified.audio->mBuffers[0].mData)[0], 0.75f);
+
+    // The superseded version remains valid for its holders
+    XCTAssertEqual(((float*)original.audio->mBuffers[0].mData)[0], 0.25f);
+}
+
+- (void)testCompactStorage {
+    AEAudioSampleCache * cache = [[AEAudioSampleCache alloc] initWithByteBudget:SIZE_MAX];
+    AEAudioSample * full = [self load:[self file:0] cache:cache];
+    cache.compactStorage = YES;
+    AEAudioSample * compact = [self load:[self file:0] cache:cache];
+
+    XCTAssertFalse(full.compact);
+    XCTAssertTrue(compact.compact);
+    XCTAssertTrue(compact.audio == NULL);
+    XCTAssertEqual(compact.length, full.length);
+    XCTAssertLessThan(cache.residentBytes, full.length * sizeof(float) * 1.6);
+
+    // Both read the same way
+    AudioBufferList * output = AEAudioBufferListCreateWithFormat([self format], full.length);
+    XCTAssertEqual(AEAudioSampleRead(compact, output, 0, full.length), full.length);
+    XCTAssertEqualWithAccuracy(((float*)output->mBuffers[0].mData)[100], 0.25f, 1.0e-4);
+    XCTAssertEqual(AEAudioSampleRead(full, output, 10, full.length), full.length - 10);
+    XCTAssertEqual(((float*)output->mBuffers[0].mData)[100], 0.25f);
+    AEAudioBufferListFree(output);
+}
+
+- (void)testReportsMissingFile {
+    XCTestExpectation * expectation = [self expectationWithDescription:@"load"];
+    [[AEAudioSampleCache sharedCache] loadSampleAtPath:@"/nonexistent.aiff" targetAudioDescription:[self format]
+                                       completionBlock:^(AEAudioSample * sample, NSError * error) {
+        XCTAssertNil(sample);
+        XCTAssertNotNil(error);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+}
+
+- (AEAudioSample *)load:(NSString *)path cache:(AEAudioSampleCache *)cache {
+    __block AEAudioSample * result = nil;
+    XCTestExpectation * expectation = [self expectationWithDescription:@"load"];
+    [cache loadSampleAtPath:path targetAudioDescription:[self format] completionBlock:^(AEAudioSample * sample, NSError * error) {
+        XCTAssertNil(error);
+        result = sample;
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+    return result;
+}
+
+- (AudioStreamBasicDescription)format {
+    return AEAudioDescriptionWithChannelsAndRate(1, kSampleRate);
+}
+
+- (NSString *)file:(int)index {
+    return [NSSearchPathForDirectoriesInDomains(NSDocumentDirectory, NSUserDomainMask, YES).firstObject
+            stringByAppendingPathComponent:[NSString stringWithFormat:@"AEAudioSampleCacheTests%d.aiff", index]];
+}
+
+- (NSError *)createTestFile:(NSString *)path value:(float)value {
+    AERenderer * renderer = [AERenderer new];
+
+    AEAudioFileOutput * output = [[AEAudioFileOutput alloc] initWithRenderer:renderer path:path type:AEAudioFileTypeAIFFInt16 sampleRate:kSampleRate channelCount:1];
+    __block NSError * error = nil;
+    if ( ![output prepareForWriting:&error] ) {
+        return error;
+    }
+
+    renderer.block = ^(const AERenderContext * context) {
+        const AudioBufferList * abl = AEBufferStackPushWithChannels(context->stack, 1, 1);
+        float * data = abl->mBuffers[0].mData;
+        for ( UInt32 i=0; i<context->frames; i++ ) {
+            data[i] = value;
+        }
+        AERenderContextOutput(context, 1);
+    };
+
+    __block BOOL done = NO;
+    [output runForDuration:kTestFileLength completionBlock:^(NSError * e){
+        done = YES;
+        error = e;
+    }];
+    while ( !done ) {
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+    }
+    [output finishWriting];
+    return error;
+}
+
+@end
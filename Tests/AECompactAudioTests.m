@@ -0,0 +1,107 @@
+//
+//  AECompactAudioTests.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "AECompactAudio.h"
+#import "AEAudioBufferListUtilities.h"
+#import "AETypes.h"
+#import <Accelerate/Accelerate.h>
+#import <mach/mach_time.h>
+
+static const UInt32 kTestLength = 100003;
+static const UInt32 kQuietLength = 49920; // A whole number of blocks
+
+@interface AECompactAudioTests : XCTestCase
+@end
+
+@implementation AECompactAudioTests
+
+- (void)testRoundTrip {
+    AudioBufferList * input = [self createTestAudio];
+    AECompactAudio * compact = AECompactAudioCreate(input, kTestLength);
+    XCTAssertTrue(compact != NULL);
+    XCTAssertEqual(AECompactAudioGetLength(compact), kTestLength);
+    XCTAssertEqual(AECompactAudioGetNumberOfChannels(compact), 2);
+    XCTAssertLessThan(AECompactAudioGetByteSize(compact), kTestLength * 2 * sizeof(float) * 0.52);
+
+    // Read from arbitrary positions, with an extra output buffer which repeats the last channel
+    AudioBufferList * output = AEAudioBufferListCreateWithFormat(AEAudioDescriptionWithChannelsAndRate(3, 44100), kTestLength);
+    UInt32 mismatches = 0;
+    for ( UInt32 frame = 0; frame < kTestLength; frame += 9973 ) {
+        UInt32 frames = AECompactAudioRead(compact, output, frame, 20000);
+        XCTAssertEqual(frames, MIN(20000, kTestLength - frame));
+        for ( int i=0; i<3; i++ ) {
+            const float * reference = input->mBuffers[MIN(i, 1)].mData;
+            const float * data = output->mBuffers[i].mData;
+            for ( UInt32 j=0; j<frames; j++ ) {
+                // Error is within half a step of the block's scale
+                float tolerance = (frame+j < kQuietLength ? 0.001f : 0.9f) / 32767.0f * 0.51f;
+                if ( fabsf(data[j] - reference[frame+j]) > tolerance ) mismatches++;
+            }
+        }
+    }
+    XCTAssertEqual(mismatches, 0);
+    XCTAssertEqual(AECompactAudioRead(compact, output, kTestLength, 1), 0);
+
+    AEAudioBufferListFree(output);
+    AECompactAudioFree(compact);
+    AEAudioBufferListFree(input);
+}
+
+- (void)testSilence {
+    AudioBufferList * input = AEAudioBufferListCreateWithFormat(AEAudioDescriptionWithChannelsAndRate(1, 44100), 1000);
+    AECompactAudio * compact = AECompactAudioCreate(input, 1000);
+    AudioBufferList * output = AEAudioBufferListCreateWithFormat(AEAudioDescriptionWithChannelsAndRate(1, 44100), 1000);
+    XCTAssertEqual(AECompactAudioRead(compact, output, 0, 1000), 1000);
+    float peak;
+    vDSP_maxmgv(output->mBuffers[0].mData, 1, &peak, 1000);
+    XCTAssertEqual(peak, 0.0f);
+    AEAudioBufferListFree(output);
+    AECompactAudioFree(compact);
+    AEAudioBufferListFree(input);
+}
+
+- (void)testDecodePerformance {
+    AudioBufferList * input = [self createTestAudio];
+    AECompactAudio * compact = AECompactAudioCreate(input, kTestLength);
+    AudioBufferList * output = AEAudioBufferListCreateWithFormat(AEAudioDescriptionWithChannelsAndRate(2, 44100), 512);
+    const int iterations = 20;
+
+    [self measureBlock:^{
+        // Render-sized reads, from the start of the audio to the end
+        uint64_t start = mach_absolute_time();
+        for ( int i=0; i<iterations; i++ ) {
+            for ( UInt32 frame = 0; frame < kTestLength; frame += 512 ) {
+                AECompactAudioRead(compact, output, frame, 512);
+            }
+        }
+        uint64_t end = mach_absolute_time();
+        mach_timebase_info_data_t timebase;
+        mach_timebase_info(&timebase);
+        double nanoseconds = (double)(end - start) * timebase.numer / timebase.denom;
+        NSLog(@"Stereo decode: %.2lf ns per frame", nanoseconds / ((double)kTestLength * iterations));
+    }];
+
+    AEAudioBufferListFree(output);
+    AECompactAudioFree(compact);
+    AEAudioBufferListFree(input);
+}
+
+- (AudioBufferList *)createTestAudio {
+    // A quiet passage followed by a loud one, to exercise the per-block scale
+    AudioBufferList * audio = AEAudioBufferListCreateWithFormat(AEAudioDescriptionWithChannelsAndRate(2, 44100), kTestLength);
+    for ( int i=0; i<2; i++ ) {
+        float * data = audio->mBuffers[i].mData;
+        for ( UInt32 j=0; j<kTestLength; j++ ) {
+            data[j] = sinf(j * 0.01f * (i+1)) * (j < kQuietLength ? 0.001f : 0.9f);
+        }
+    }
+    return audio;
+}
+
+@end
@@ -9,13 +9,36 @@
 #import <XCTest/XCTest.h>
 #import "AEMainThreadEndpoint.h"
 #import "AEAudioThreadEndpoint.h"
+#import "AEAudioThreadParameterEndpoint.h"
 #import "AEMessageQueue.h"
+#import "TPCircularBuffer+MPSC.h"
+#import "TPCircularBuffer+MultiProducer.h"
 
 typedef struct {
     int value1;
     int value2;
 } AECrossThreadMessagingTestsTestStruct;
 
+typedef struct {
+    int messageCount;
+    double sum;
+    size_t lastLength;
+} AECrossThreadMessagingTestsReceiver;
+
+typedef struct {
+    int producer;
+    int sequence;
+} AECrossThreadMessagingTestsProducerMessage;
+
+static void AECrossThreadMessagingTestsChannelHandler(void * context, const void * payload, size_t length) {
+    AECrossThreadMessagingTestsReceiver * receiver = context;
+    receiver->messageCount++;
+    receiver->lastLength = length;
+    if ( payload ) {
+        receiver->sum += *(const double *)payload;
+    }
+}
+
 @interface AECrossThreadMessagingTests : XCTestCase
 @property (nonatomic) int mainThreadMessageValue1;
 @property (nonatomic, weak) id mainThreadMessageValue2;
@@ -80,6 +103,201 @@ typedef struct {
     XCTAssertEqual(counter, 100);
 }
 
+- (void)testMainThreadEndpointBurst {
+    __block int counter = 0;
+    AEMainThreadEndpoint * endpoint = [[AEMainThreadEndpoint alloc] initWithHandler:^(const void *data, size_t length) {
+        counter++;
+    } bufferCapacity:16384];
+    
+    // Far more messages than are serviced per wake, sent faster than they're serviced
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_DEFAULT, 0), ^{
+        for ( int i=0; i<500; i++) {
+            AEMainThreadEndpointSend(endpoint, NULL, 0);
+        }
+    });
+    
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+    
+    XCTAssertEqual(counter, 500);
+    XCTAssertEqual(AEMainThreadEndpointGetDroppedMessageCount(endpoint), (uint64_t)0);
+}
+
+- (void)testMainThreadEndpointDroppedMessageCount {
+    AEMainThreadEndpoint * endpoint = [[AEMainThreadEndpoint alloc] initWithHandler:^(const void *data, size_t length) {
+    } bufferCapacity:1024];
+    
+    // Send much more than fits; the service thread may drain some along the way
+    char message[256] = {};
+    uint64_t failed = 0;
+    for ( int i=0; i<1000; i++ ) {
+        if ( !AEMainThreadEndpointSend(endpoint, message, sizeof(message)) ) {
+            failed++;
+        }
+    }
+    XCTAssertGreaterThan(failed, (uint64_t)0);
+    XCTAssertEqual(endpoint.droppedMessageCount, failed);
+    
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+}
+
+- (void)testMainThreadEndpointUndispatchedMessage {
+    NSMutableArray * messages = [NSMutableArray array];
+    AEMainThreadEndpoint * endpoint = [[AEMainThreadEndpoint alloc] initWithHandler:^(const void *data, size_t length) {
+        [messages addObject:@(*(const int *)data)];
+    }];
+    
+    // Cancelled and abandoned messages don't hold back the messages after them
+    *(int *)AEMainThreadEndpointCreateMessage(endpoint, sizeof(int)) = 1;
+    AEMainThreadEndpointCancelMessage(endpoint);
+    *(int *)AEMainThreadEndpointCreateMessage(endpoint, sizeof(int)) = 2;
+    *(int *)AEMainThreadEndpointCreateMessage(endpoint, sizeof(int)) = 3;
+    AEMainThreadEndpointDispatchMessage(endpoint);
+    
+    // Dispatching with no message created does nothing
+    AEMainThreadEndpointDispatchMessage(endpoint);
+    
+    int value = 4;
+    AEMainThreadEndpointSend(endpoint, &value, sizeof(value));
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    
+    XCTAssertEqualObjects(messages, (@[@3, @4]));
+}
+
+- (void)testMainThreadEndpointInterleavedMessages {
+    NSMutableArray * messages1 = [NSMutableArray array];
+    NSMutableArray * messages2 = [NSMutableArray array];
+    AEMainThreadEndpoint * endpoint1 = [[AEMainThreadEndpoint alloc] initWithHandler:^(const void *data, size_t length) {
+        [messages1 addObject:@(*(const int *)data)];
+    }];
+    AEMainThreadEndpoint * endpoint2 = [[AEMainThreadEndpoint alloc] initWithHandler:^(const void *data, size_t length) {
+        [messages2 addObject:@(*(const int *)data)];
+    }];
+    
+    // Messages in progress on different endpoints don't affect one another
+    *(int *)AEMainThreadEndpointCreateMessage(endpoint1, sizeof(int)) = 1;
+    *(int *)AEMainThreadEndpointCreateMessage(endpoint2, sizeof(int)) = 2;
+    AEMainThreadEndpointDispatchMessage(endpoint1);
+    *(int *)AEMainThreadEndpointCreateMessage(endpoint1, sizeof(int)) = 3;
+    AEMainThreadEndpointDispatchMessage(endpoint2);
+    AEMainThreadEndpointDispatchMessage(endpoint1);
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    
+    XCTAssertEqualObjects(messages1, (@[@1, @3]));
+    XCTAssertEqualObjects(messages2, (@[@2]));
+    
+    // Releasing an endpoint with a message in progress leaves others working
+    *(int *)AEMainThreadEndpointCreateMessage(endpoint2, sizeof(int)) = 4;
+    *(int *)AEMainThreadEndpointCreateMessage(endpoint1, sizeof(int)) = 5;
+    endpoint2 = nil;
+    AEMainThreadEndpointDispatchMessage(endpoint1);
+    *(int *)AEMainThreadEndpointCreateMessage(endpoint1, sizeof(int)) = 6;
+    AEMainThreadEndpointDispatchMessage(endpoint1);
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    
+    XCTAssertEqualObjects(messages1, (@[@1, @3, @5, @6]));
+}
+
+- (void)testMainThreadEndpointMultipleProducers {
+    const int producerCount = 8;
+    const int messageCount = 100;
+    __block int received = 0;
+    __block BOOL ordered = YES;
+    int * lastSequence = calloc(producerCount, sizeof(int));
+    AEMainThreadEndpoint * endpoint = [[AEMainThreadEndpoint alloc] initWithHandler:^(const void *data, size_t length) {
+        const AECrossThreadMessagingTestsProducerMessage * message = data;
+        if ( message->sequence != lastSequence[message->producer] + 1 ) ordered = NO;
+        lastSequence[message->producer] = message->sequence;
+        received++;
+    } bufferCapacity:65536];
+    
+    for ( int producer=0; producer<producerCount; producer++ ) {
+        dispatch_async(dispatch_get_global_queue(QOS_CLASS_DEFAULT, 0), ^{
+            for ( int i=1; i<=messageCount; i++ ) {
+                AECrossThreadMessagingTestsProducerMessage message = { producer, i };
+                AEMainThreadEndpointSend(endpoint, &message, sizeof(message));
+            }
+        });
+    }
+    
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.5]];
+    
+    XCTAssertEqual(received, producerCount * messageCount);
+    XCTAssertTrue(ordered);
+    XCTAssertEqual(endpoint.droppedMessageCount, (uint64_t)0);
+    free(lastSequence);
+}
+
+- (void)testMultiProducerBufferPerformance {
+    const int messageCount = 20000;
+    for ( int producerCount=1; producerCount<=16; producerCount*=2 ) {
+        for ( int shared=1; shared>=0; shared-- ) {
+            TPMPSCBuffer mpscBuffer;
+            TPMultiProducerBuffer perThreadBuffer;
+            if ( shared ) {
+                XCTAssertTrue(TPMPSCBufferInit(&mpscBuffer, 65536));
+            } else {
+                XCTAssertTrue(TPMultiProducerBufferInit(&perThreadBuffer, 65536 / producerCount, producerCount));
+            }
+            TPMPSCBuffer * mpsc = &mpscBuffer;
+            TPMultiProducerBuffer * perThread = &perThreadBuffer;
+            
+            dispatch_group_t group = dispatch_group_create();
+            for ( int producer=0; producer<producerCount; producer++ ) {
+                dispatch_group_enter(group);
+                [NSThread detachNewThreadWithBlock:^{
+                    for ( int i=1; i<=messageCount; ) {
+                        AECrossThreadMessagingTestsProducerMessage * message;
+                        if ( shared ) {
+                            if ( !(message = TPMPSCBufferReserve(mpsc, sizeof(*message))) ) continue;
+                            *message = (AECrossThreadMessagingTestsProducerMessage){ producer, i++ };
+                            TPMPSCBufferCommit(mpsc, message);
+                        } else {
+                            TPCircularBuffer * buffer = TPMultiProducerBufferGetProducerBuffer(perThread);
+                            int32_t availableBytes;
+                            message = TPCircularBufferHead(buffer, &availableBytes);
+                            if ( availableBytes < (int32_t)sizeof(*message) ) continue;
+                            *message = (AECrossThreadMessagingTestsProducerMessage){ producer, i++ };
+                            TPCircularBufferProduce(buffer, sizeof(*message));
+                        }
+                    }
+                    dispatch_group_leave(group);
+                }];
+            }
+            
+            AEHostTicks start = AECurrentTimeInHostTicks();
+            int received = 0;
+            while ( received < producerCount * messageCount ) {
+                if ( shared ) {
+                    uint32_t length;
+                    while ( TPMPSCBufferNextMessage(mpsc, &length) ) {
+                        TPMPSCBufferConsume(mpsc);
+                        received++;
+                    }
+                } else {
+                    TPCircularBuffer * buffer;
+                    TPMultiProducerBufferIterateBuffers(perThread, buffer) {
+                        int32_t availableBytes;
+                        TPCircularBufferTail(buffer, &availableBytes);
+                        int count = availableBytes / (int)sizeof(AECrossThreadMessagingTestsProducerMessage);
+                        TPCircularBufferConsume(buffer, count * (int32_t)sizeof(AECrossThreadMessagingTestsProducerMessage));
+                        received += count;
+                    }
+                }
+            }
+            AESeconds time = AESecondsFromHostTicks(AECurrentTimeInHostTicks() - start);
+            dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+            NSLog(@"%@, %d producers: %.1f ns per message", shared ? @"MPSC" : @"Per-thread", producerCount,
+                  time / (producerCount * messageCount) * 1.0e9);
+            
+            if ( shared ) {
+                TPMPSCBufferCleanup(mpsc);
+            } else {
+                TPMultiProducerBufferCleanup(perThread);
+            }
+        }
+    }
+}
+
 - (void)testAudioThreadEndpointMessaging {
     NSMutableArray * messages = [NSMutableArray array];
     AEAudioThreadEndpoint * endpoint = [[AEAudioThreadEndpoint alloc] initWithHandler:^(const void *data, size_t length) {
@@ -127,6 +345,54 @@ typedef struct {
     [messages removeAllObjects];
 }
 
+- (void)testAudioThreadParameterEndpointCoalescesUpdates {
+    NSMutableDictionary * received = [NSMutableDictionary dictionary];
+    __block int calls = 0;
+    AEAudioThreadParameterEndpoint * endpoint = [[AEAudioThreadParameterEndpoint alloc] initWithHandler:^(AEAudioThreadParameterKey key, double value) {
+        received[@(key)] = @(value);
+        calls++;
+    }];
+    
+    AEAudioThreadParameterKey fader = AEAudioThreadParameterKeyMake(1, 0);
+    AEAudioThreadParameterKey pan = AEAudioThreadParameterKeyMake(1, 1);
+    for ( int i=0; i<=100; i++ ) {
+        XCTAssertTrue([endpoint setValue:i / 100.0 forKey:fader]);
+    }
+    XCTAssertTrue([endpoint setValue:-0.5 forKey:pan]);
+    
+    AEAudioThreadParameterEndpointPoll(endpoint);
+    XCTAssertEqual(calls, 2);
+    XCTAssertEqualObjects(received[@(fader)], @(1.0));
+    XCTAssertEqualObjects(received[@(pan)], @(-0.5));
+    
+    // Nothing more until another value is set
+    AEAudioThreadParameterEndpointPoll(endpoint);
+    XCTAssertEqual(calls, 2);
+    
+    XCTAssertTrue([endpoint setValue:0.25 forKey:pan]);
+    AEAudioThreadParameterEndpointPoll(endpoint);
+    XCTAssertEqual(calls, 3);
+    XCTAssertEqualObjects(received[@(pan)], @(0.25));
+}
+
+- (void)testAudioThreadParameterEndpointCapacity {
+    AEAudioThreadParameterEndpoint * endpoint = [[AEAudioThreadParameterEndpoint alloc] initWithHandler:^(AEAudioThreadParameterKey key, double value) {} capacity:4];
+    for ( uint32_t i=0; i<4; i++ ) {
+        XCTAssertTrue([endpoint setValue:1 forKey:AEAudioThreadParameterKeyMake(i, i)]);
+    }
+    XCTAssertFalse([endpoint setValue:1 forKey:AEAudioThreadParameterKeyMake(4, 4)]);
+    
+    // Existing keys can still be set
+    XCTAssertTrue([endpoint setValue:2 forKey:AEAudioThreadParameterKeyMake(0, 0)]);
+}
+
+- (void)testAudioThreadParameterEndpointInvalidCapacity {
+    AEAudioThreadParameterEndpointHandler handler = ^(AEAudioThreadParameterKey key, double value) {};
+    XCTAssertNil([[AEAudioThreadParameterEndpoint alloc] initWithHandler:handler capacity:0]);
+    XCTAssertNil([[AEAudioThreadParameterEndpoint alloc] initWithHandler:handler capacity:-1]);
+    XCTAssertNil([[AEAudioThreadParameterEndpoint alloc] initWithHandler:handler capacity:INT32_MAX]);
+}
+
 - (void)testMessageQueueAudioThreadMessaging {
     AEMessageQueue * queue = [AEMessageQueue new];
     
@@ -182,6 +448,80 @@ typedef struct {
     XCTAssertEqual(self.mainThreadMessageValue1, 3);
 }
 
+- (void)testMessageQueueAudioThreadChannel {
+    AEMessageQueue * queue = [AEMessageQueue new];
+    AECrossThreadMessagingTestsReceiver receiver = {};
+    AEMessageQueueChannel channel = [queue registerAudioThreadChannelWithHandler:AECrossThreadMessagingTestsChannelHandler context:&receiver];
+    XCTAssertNotEqual(channel, (AEMessageQueueChannel)0);
+    
+    for ( int i=1; i<=10; i++ ) {
+        double value = i;
+        XCTAssertTrue(AEMessageQueueSendToAudioThread(queue, channel, &value, sizeof(value)));
+    }
+    XCTAssertTrue(AEMessageQueueSendToAudioThread(queue, channel, NULL, 0));
+    XCTAssertEqual(receiver.messageCount, 0);
+    
+    AEMessageQueuePoll(queue);
+    XCTAssertEqual(receiver.messageCount, 11);
+    XCTAssertEqual(receiver.sum, 55.0);
+    XCTAssertEqual(receiver.lastLength, (size_t)0);
+}
+
+- (void)testMessageQueueMainThreadChannel {
+    AEMessageQueue * queue = [AEMessageQueue new];
+    AECrossThreadMessagingTestsReceiver first = {};
+    AECrossThreadMessagingTestsReceiver second = {};
+    AEMessageQueueChannel firstChannel = [queue registerMainThreadChannelWithHandler:AECrossThreadMessagingTestsChannelHandler context:&first];
+    AEMessageQueueChannel secondChannel = [queue registerMainThreadChannelWithHandler:AECrossThreadMessagingTestsChannelHandler context:&second];
+    XCTAssertNotEqual(firstChannel, secondChannel);
+    
+    double value = 1.5;
+    XCTAssertTrue(AEMessageQueueSendToMainThread(queue, firstChannel, &value, sizeof(value)));
+    value = 2.5;
+    XCTAssertTrue(AEMessageQueueSendToMainThread(queue, secondChannel, &value, sizeof(value)));
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    
+    XCTAssertEqual(first.messageCount, 1);
+    XCTAssertEqual(first.sum, 1.5);
+    XCTAssertEqual(first.lastLength, sizeof(double));
+    XCTAssertEqual(second.messageCount, 1);
+    XCTAssertEqual(second.sum, 2.5);
+}
+
+- (void)testMessageQueueInvalidChannel {
+    AEMessageQueue * queue = [AEMessageQueue new];
+    AECrossThreadMessagingTestsReceiver receiver = {};
+    AEMessageQueueChannel channel = [queue registerMainThreadChannelWithHandler:AECrossThreadMessagingTestsChannelHandler context:&receiver];
+    
+    // Unregistered channels, and channels for the other thread, are rejected
+    double value = 1.0;
+    XCTAssertFalse(AEMessageQueueSendToMainThread(queue, 0, &value, sizeof(value)));
+    XCTAssertFalse(AEMessageQueueSendToMainThread(queue, channel + 1, &value, sizeof(value)));
+    XCTAssertFalse(AEMessageQueueSendToAudioThread(queue, channel, &value, sizeof(value)));
+    
+    AEMessageQueuePoll(queue);
+    [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+    XCTAssertEqual(receiver.messageCount, 0);
+}
+
+- (void)testMessageQueueChannelPerformance {
+    AEMessageQueue * queue = [[AEMessageQueue alloc] initWithBufferCapacity:65536];
+    AECrossThreadMessagingTestsReceiver receiver = {};
+    AEMessageQueueChannel channel = [queue registerAudioThreadChannelWithHandler:AECrossThreadMessagingTestsChannelHandler context:&receiver];
+    
+    [self measureBlock:^{
+        for ( int i=0; i<100; i++ ) {
+            for ( int j=0; j<1000; j++ ) {
+                double value = j;
+                AEMessageQueueSendToAudioThread(queue, channel, &value, sizeof(value));
+            }
+            AEMessageQueuePoll(queue);
+        }
+    }];
+    
+    XCTAssertEqual(receiver.messageCount % 100000, 0);
+}
+
 - (void)testReleaseWithinHandler {
     __weak AEMainThreadEndpoint * weakEndpoint = nil;
     @autoreleasepool {
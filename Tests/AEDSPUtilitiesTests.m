@@ -444,8 +444,123 @@ static StereoPair StereoPairMakeMono(float sample) { return (StereoPair) {{sampl
     AEDSPFFTConvolutionDealloc(conv);
 }
 
+- (void)testFFTConvolutionBatchVsSingle {
+    const int channels = 3;
+    float inputs[channels][1000];
+    float filters[channels][50];
+    for ( int c=0; c<channels; c++ ) {
+        for ( int i=0; i<alen(inputs[c]); i++ ) inputs[c][i] = random()/(float)RAND_MAX;
+        for ( int i=0; i<alen(filters[c]); i++ ) filters[c][i] = random()/(float)RAND_MAX;
+    }
+    
+    for ( int shared=0; shared<2; shared++ ) {
+        // Reference: one AEDSPFFTConvolution per channel
+        float expected[channels][alen(inputs[0])];
+        float expectedSum[alen(inputs[0])];
+        memset(expectedSum, 0, sizeof(expectedSum));
+        for ( int c=0; c<channels; c++ ) {
+            AEDSPFFTConvolution * conv = AEDSPFFTConvolutionInit(128);
+            AEDSPFFTConvolutionPrepareContinuous(conv, filters[shared ? 0 : c], alen(filters[0]), AEDSPFFTConvolutionOperation_ConvolutionFull);
+            for ( int i=0; i<alen(inputs[c]); ) {
+                int block = (int)MIN(alen(inputs[c])-i, 37);
+                AEDSPFFTConvolutionExecuteContinuous(conv, inputs[c]+i, block, expected[c]+i, block);
+                i += block;
+            }
+            vDSP_vadd(expected[c], 1, expectedSum, 1, expectedSum, 1, alen(expectedSum));
+            AEDSPFFTConvolutionDealloc(conv);
+        }
+        
+        float * filterPointers[channels];
+        for ( int c=0; c<channels; c++ ) filterPointers[c] = filters[c];
+        
+        AEDSPFFTConvolutionBatch * batch = AEDSPFFTConvolutionBatchInit(128, channels);
+        AEDSPFFTConvolutionBatchPrepareContinuous(batch, filterPointers, shared ? 1 : channels, alen(filters[0]), AEDSPFFTConvolutionOperation_ConvolutionFull);
+        
+        float outputs[channels][alen(inputs[0])];
+        for ( int i=0; i<alen(inputs[0]); ) {
+            int block = (int)MIN(alen(inputs[0])-i, 37);
+            float * inputPointers[channels];
+            float * outputPointers[channels];
+            for ( int c=0; c<channels; c++ ) {
+                inputPointers[c] = inputs[c]+i;
+                outputPointers[c] = outputs[c]+i;
+            }
+            AEDSPFFTConvolutionBatchExecuteContinuous(batch, inputPointers, block, outputPointers, block);
+            i += block;
+        }
+        
+        for ( int c=0; c<channels; c++ ) {
+            for ( int i=0; i<alen(outputs[c]); i++ ) {
+                XCTAssertEqualWithAccuracy(outputs[c][i], expected[c][i], 1.0e-4);
+            }
+        }
+        
+        AEDSPFFTConvolutionBatchReset(batch);
+        
+        float sum[alen(inputs[0])];
+        for ( int i=0; i<alen(sum); ) {
+            int block = (int)MIN(alen(sum)-i, 37);
+            float * inputPointers[channels];
+            for ( int c=0; c<channels; c++ ) inputPointers[c] = inputs[c]+i;
+            AEDSPFFTConvolutionBatchExecuteContinuousSummed(batch, inputPointers, block, sum+i, block);
+            i += block;
+        }
+        
+        for ( int i=0; i<alen(sum); i++ ) {
+            XCTAssertEqualWithAccuracy(sum[i], expectedSum[i], 1.0e-3);
+        }
+        
+        AEDSPFFTConvolutionBatchDealloc(batch);
+    }
+}
+
+- (void)testFFTConvolutionBatchPerformance2Channels {
+    [self measureFFTConvolutionBatchWithChannels:2];
+}
+
+- (void)testFFTConvolutionBatchPerformance8Channels {
+    [self measureFFTConvolutionBatchWithChannels:8];
+}
+
+- (void)testFFTConvolutionBatchPerformance32Channels {
+    [self measureFFTConvolutionBatchWithChannels:32];
+}
+
 #pragma mark - Helpers
 
+- (void)measureFFTConvolutionBatchWithChannels:(int)channels {
+    const int filterLength = 4096;
+    const int blockLength = 512;
+    const int blocks = 200;
+    
+    float * filter = malloc(sizeof(float) * filterLength);
+    for ( int i=0; i<filterLength; i++ ) filter[i] = (random()/(float)RAND_MAX) * expf(-i/1000.0f);
+    
+    float * inputs[channels];
+    float * outputs[channels];
+    for ( int c=0; c<channels; c++ ) {
+        inputs[c] = malloc(sizeof(float) * blockLength);
+        outputs[c] = malloc(sizeof(float) * blockLength);
+        for ( int i=0; i<blockLength; i++ ) inputs[c][i] = random()/(float)RAND_MAX;
+    }
+    
+    AEDSPFFTConvolutionBatch * batch = AEDSPFFTConvolutionBatchInit(filterLength + blockLength, channels);
+    AEDSPFFTConvolutionBatchPrepareContinuous(batch, &filter, 1, filterLength, AEDSPFFTConvolutionOperation_ConvolutionFull);
+    
+    [self measureBlock:^{
+        for ( int i=0; i<blocks; i++ ) {
+            AEDSPFFTConvolutionBatchExecuteContinuous(batch, inputs, blockLength, outputs, blockLength);
+        }
+    }];
+    
+    AEDSPFFTConvolutionBatchDealloc(batch);
+    for ( int c=0; c<channels; c++ ) {
+        free(inputs[c]);
+        free(outputs[c]);
+    }
+    free(filter);
+}
+
 - (AudioBufferList *)bufferWithChannels:(int)channels {
     AudioBufferList * abl =
         AEAudioBufferListCreateWithFormat(AEAudioDescriptionWithChannelsAndRate(channels, 44100.0), kFrames);
@@ -0,0 +1,198 @@
+//
+//  AEGranularModuleTests.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "AEGranularModule.h"
+#import "AEAudioSampleCache.h"
+#import "AEAudioFileOutput.h"
+#import "AEAudioBufferListUtilities.h"
+#import "AERenderer.h"
+#import "AEBufferStack.h"
+#import "AETypes.h"
+
+static const double kSampleRate = 48000.0;
+static const UInt32 kSliceFrames = 512;
+static const NSTimeInterval kTestFileLength = 2.0;
+
+@interface AEGranularModuleTests : XCTestCase
+@property (nonatomic, strong) NSString * path;
+@property (nonatomic, strong) AEAudioSample * sample;
+@end
+
+@implementation AEGranularModuleTests
+
+- (void)setUp {
+    self.path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"AEGranularModuleTests.aiff"];
+    XCTAssertNil([self createTestFile]);
+    
+    XCTestExpectation * expectation = [self expectationWithDescription:@"load"];
+    AEAudioSampleCache * cache = [[AEAudioSampleCache alloc] initWithByteBudget:0];
+    [cache loadSampleAtPath:self.path targetAudioDescription:AEAudioDescriptionWithChannelsAndRate(1, kSampleRate)
+            completionBlock:^(AEAudioSample * sample, NSError * error) {
+        XCTAssertNil(error);
+        self.sample = sample;
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath:self.path error:NULL];
+}
+
+- (void)testGrainIsSampleAccurate {
+    AERenderer * renderer = [AERenderer new];
+    renderer.sampleRate = kSampleRate;
+    AEGranularModule * module = [[AEGranularModule alloc] initWithRenderer:renderer maximumGrains:16];
+    module.sample = self.sample;
+    
+    // A centered Hann grain over a constant signal, starting part-way through the first slice
+    const UInt32 duration = 1000;
+    const UInt32 offset = 300;
+    __block BOOL added = NO;
+    UInt32 frames = kSliceFrames * 4;
+    AudioBufferList * output = [self render:renderer frames:frames block:^(const AERenderContext * context) {
+        if ( !added ) {
+            XCTAssertTrue(AEGranularModuleAddGrain(module, 1000, duration, 1.0, 1.0, 0, offset));
+            added = YES;
+        }
+        AEModuleProcess(module, context);
+    }];
+    
+    double maxError = 0;
+    for ( int channel=0; channel<2; channel++ ) {
+        const float * data = (const float *)output->mBuffers[channel].mData;
+        for ( UInt32 i=0; i<frames; i++ ) {
+            double expected = 0;
+            if ( i >= offset && i < offset + duration ) {
+                expected = 0.5 * M_SQRT1_2 * (0.5 - 0.5 * cos(2.0 * M_PI * (i - offset) / duration));
+            }
+            maxError = MAX(maxError, fabs(data[i] - expected));
+        }
+        XCTAssertEqual(data[offset-1], 0.0f);
+        XCTAssertEqual(data[offset+duration], 0.0f);
+    }
+    XCTAssertLessThan(maxError, 1.0e-3);
+    XCTAssertEqual(module.activeGrainCount, 0);
+    AEAudioBufferListFree(output);
+}
+
+- (void)testSchedulesAtDensity {
+    AERenderer * renderer = [AERenderer new];
+    renderer.sampleRate = kSampleRate;
+    AEGranularModule * module = [[AEGranularModule alloc] initWithRenderer:renderer maximumGrains:64];
+    module.sample = self.sample;
+    module.density = 1000;
+    module.grainDuration = 0.01;
+    module.position = 0.5;
+    module.positionJitter = 0.25;
+    module.rateJitter = 7;
+    module.panSpread = 1.0;
+    
+    AudioBufferList * output = [self render:renderer frames:kSampleRate block:^(const AERenderContext * context) {
+        AEModuleProcess(module, context);
+    }];
+    
+    // Grains of 480 frames, every 48 frames
+    XCTAssertEqualWithAccuracy(module.activeGrainCount, 10, 1);
+    XCTAssertEqual(module.droppedGrainCount, 0);
+    XCTAssertFalse(AEAudioBufferListIsSilent(output));
+    AEAudioBufferListFree(output);
+}
+
+- (void)testPerformance {
+    // 5,000 grains of 100ms, with varying position, pitch and stereo position
+    AERenderer * renderer = [AERenderer new];
+    renderer.sampleRate = kSampleRate;
+    AEGranularModule * module = [[AEGranularModule alloc] initWithRenderer:renderer maximumGrains:8192];
+    module.sample = self.sample;
+    module.density = 50000;
+    module.grainDuration = 0.1;
+    module.position = 0.5;
+    module.positionJitter = 0.5;
+    module.rateJitter = 12;
+    module.panSpread = 1.0;
+    module.gain = 0.01;
+    renderer.block = ^(const AERenderContext * context) {
+        AEModuleProcess(module, context);
+        AERenderContextOutput(context, 1);
+    };
+    
+    // Warm up, to reach the steady state
+    AudioBufferList * output = AEAudioBufferListCreate(kSliceFrames);
+    AudioTimeStamp timestamp = { .mFlags = kAudioTimeStampSampleTimeValid, .mSampleTime = 0 };
+    for ( UInt32 position = 0; position < kSampleRate * 0.2; position += kSliceFrames ) {
+        AERendererRun(renderer, output, kSliceFrames, &timestamp);
+        timestamp.mSampleTime += kSliceFrames;
+    }
+    XCTAssertEqualWithAccuracy(module.activeGrainCount, 5000, 20);
+    
+    [self measureBlock:^{
+        // Ten seconds of audio
+        NSTimeInterval start = [NSDate timeIntervalSinceReferenceDate];
+        AudioTimeStamp timestamp = { .mFlags = kAudioTimeStampSampleTimeValid, .mSampleTime = 0 };
+        for ( UInt32 position = 0; position < kSampleRate * 10; position += kSliceFrames ) {
+            AERendererRun(renderer, output, kSliceFrames, &timestamp);
+            timestamp.mSampleTime += kSliceFrames;
+        }
+        NSLog(@"%d grains: %.2fx realtime", module.activeGrainCount, 10.0 / ([NSDate timeIntervalSinceReferenceDate] - start));
+    }];
+    XCTAssertEqual(module.droppedGrainCount, 0);
+    AEAudioBufferListFree(output);
+}
+
+#pragma mark - Helpers
+
+- (AudioBufferList *)render:(AERenderer *)renderer frames:(UInt32)frames block:(AERenderLoopBlock)block {
+    renderer.block = ^(const AERenderContext * context) {
+        block(context);
+        AERenderContextOutput(context, 1);
+    };
+    
+    AudioBufferList * output = AEAudioBufferListCreate(frames + kSliceFrames);
+    AudioTimeStamp timestamp = { .mFlags = kAudioTimeStampSampleTimeValid, .mSampleTime = 0 };
+    for ( UInt32 position = 0; position < frames; position += kSliceFrames ) {
+        AEAudioBufferListCopyOnStack(target, output, position);
+        AERendererRun(renderer, target, kSliceFrames, &timestamp);
+        timestamp.mSampleTime += kSliceFrames;
+    }
+    return output;
+}
+
+- (NSError *)createTestFile {
+    AERenderer * renderer = [AERenderer new];
+    
+    AEAudioFileOutput * output = [[AEAudioFileOutput alloc] initWithRenderer:renderer path:self.path type:AEAudioFileTypeAIFFInt16 sampleRate:kSampleRate channelCount:1];
+    __block NSError * error = nil;
+    if ( ![output prepareForWriting:&error] ) {
+        return error;
+    }
+    
+    // A constant signal, exactly representable at 16 bits
+    renderer.block = ^(const AERenderContext * context) {
+        const AudioBufferList * abl = AEBufferStackPushWithChannels(context->stack, 1, 1);
+        float * data = abl->mBuffers[0].mData;
+        for ( UInt32 i=0; i<context->frames; i++ ) {
+            data[i] = 0.5f;
+        }
+        AERenderContextOutput(context, 1);
+    };
+    
+    __block BOOL done = NO;
+    [output runForDuration:kTestFileLength completionBlock:^(NSError * e){
+        done = YES;
+        error = e;
+    }];
+    while ( !done ) {
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+    }
+    [output finishWriting];
+    return error;
+}
+
+@end
@@ -8,6 +8,7 @@
 
 #import <XCTest/XCTest.h>
 #import "AEManagedValue.h"
+#import "AETime.h"
 
 @interface AEManagedValueTests : XCTestCase
 
@@ -15,6 +16,11 @@
 
 @implementation AEManagedValueTests
 
+- (void)tearDown {
+    // Tests render on the main thread; don't leave it holding up the release of old values
+    AEManagedValueUnregisterRenderThread(pthread_self());
+}
+
 - (void)testUpdateAndRelease {
     AEManagedValue * value = [AEManagedValue new];
     __weak id weakRef = nil;
@@ -84,6 +90,210 @@
     XCTAssertNil(weakRef);
 }
 
+- (void)testReadPerformanceDuringBatchUpdates {
+    static const int kValueCount = 10000;
+    static const int kCycles = 1000;
+    static const int kValuesPerUpdate = 16;
+    
+    NSMutableArray <AEManagedValue *> * values = [NSMutableArray array];
+    __unsafe_unretained AEManagedValue ** valueArray = (__unsafe_unretained AEManagedValue **)calloc(kValueCount, sizeof(AEManagedValue *));
+    for ( int i=0; i<kValueCount; i++ ) {
+        AEManagedValue * value = [AEManagedValue new];
+        int * ptr = malloc(sizeof(int)); *ptr = i;
+        value.pointerValue = ptr;
+        [values addObject:value];
+        valueArray[i] = value;
+    }
+    
+    [self measureBlock:^{
+        // Render thread: read every value, every cycle
+        __block long sum = 0;
+        __block AESeconds renderTime = 0;
+        dispatch_semaphore_t finished = dispatch_semaphore_create(0);
+        [NSThread detachNewThreadWithBlock:^{
+            AEHostTicks start = AECurrentTimeInHostTicks();
+            for ( int cycle=0; cycle<kCycles; cycle++ ) {
+                AEManagedValueCommitPendingUpdates();
+                for ( int i=0; i<kValueCount; i++ ) {
+                    sum += *((int*)AEManagedValueGetValue(valueArray[i]));
+                }
+            }
+            renderTime = AESecondsFromHostTicks(AECurrentTimeInHostTicks() - start);
+            dispatch_semaphore_signal(finished);
+        }];
+        
+        // Main thread: replace values in batch updates until the render thread is done
+        int updates = 0;
+        while ( dispatch_semaphore_wait(finished, DISPATCH_TIME_NOW) != 0 ) {
+            [AEManagedValue performAtomicBatchUpdate:^{
+                for ( int i=0; i<kValuesPerUpdate; i++ ) {
+                    int index = (updates * kValuesPerUpdate + i) % kValueCount;
+                    int * ptr = malloc(sizeof(int)); *ptr = index;
+                    valueArray[index].pointerValue = ptr;
+                }
+            }];
+            updates++;
+        }
+        
+        XCTAssertEqual(sum, (long)kCycles * kValueCount * (kValueCount - 1) / 2);
+        NSLog(@"%d values: %.1f µs per cycle, with %d batch updates", kValueCount, renderTime / kCycles * 1.0e6, updates);
+    }];
+    
+    free(valueArray);
+}
+
+- (void)testWaitsForEveryRenderThread {
+    AEManagedValue * value = [AEManagedValue new];
+    __weak id weakRef = nil;
+    
+    // A second render thread, which begins a render cycle then stalls
+    dispatch_semaphore_t started = dispatch_semaphore_create(0);
+    dispatch_semaphore_t resume = dispatch_semaphore_create(0);
+    dispatch_semaphore_t finished = dispatch_semaphore_create(0);
+    [NSThread detachNewThreadWithBlock:^{
+        AEManagedValueCommitPendingUpdates();
+        dispatch_semaphore_signal(started);
+        dispatch_semaphore_wait(resume, DISPATCH_TIME_FOREVER);
+        AEManagedValueCommitPendingUpdates();
+        dispatch_semaphore_signal(finished);
+    }];
+    dispatch_semaphore_wait(started, DISPATCH_TIME_FOREVER);
+    
+    @autoreleasepool {
+        value.objectValue = [[NSMutableString alloc] initWithFormat:@"%d", 1];
+        weakRef = value.objectValue;
+        value.objectValue = [[NSMutableString alloc] initWithFormat:@"%d", 2];
+    }
+    AEManagedValueCommitPendingUpdates();
+    [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+    
+    // The stalled thread may still be using the old value
+    XCTAssertNotNil(weakRef);
+    
+    // Once it passes the epoch, the old value is released
+    dispatch_semaphore_signal(resume);
+    dispatch_semaphore_wait(finished, DISPATCH_TIME_FOREVER);
+    [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+    XCTAssertNil(weakRef);
+}
+
+- (void)testUnregisteredRenderThread {
+    AEManagedValue * value = [AEManagedValue new];
+    __weak id weakRef = nil;
+    
+    // A second render thread, which renders once then stops
+    __block pthread_t renderThread = NULL;
+    dispatch_semaphore_t started = dispatch_semaphore_create(0);
+    dispatch_semaphore_t resume = dispatch_semaphore_create(0);
+    [NSThread detachNewThreadWithBlock:^{
+        renderThread = pthread_self();
+        AEManagedValueCommitPendingUpdates();
+        dispatch_semaphore_signal(started);
+        dispatch_semaphore_wait(resume, DISPATCH_TIME_FOREVER);
+    }];
+    dispatch_semaphore_wait(started, DISPATCH_TIME_FOREVER);
+    
+    @autoreleasepool {
+        value.objectValue = [[NSMutableString alloc] initWithFormat:@"%d", 1];
+        weakRef = value.objectValue;
+        value.objectValue = [[NSMutableString alloc] initWithFormat:@"%d", 2];
+    }
+    AEManagedValueCommitPendingUpdates();
+    [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+    XCTAssertNotNil(weakRef);
+    
+    // Once unregistered, it no longer holds up release
+    AEManagedValueUnregisterRenderThread(renderThread);
+    [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+    XCTAssertNil(weakRef);
+    
+    dispatch_semaphore_signal(resume);
+}
+
+- (void)testReleaseWithNoRenderThreads {
+    AEManagedValueUnregisterRenderThread(pthread_self());
+    
+    AEManagedValue * value = [AEManagedValue new];
+    __weak id weakRef = nil;
+    @autoreleasepool {
+        value.objectValue = [[NSMutableString alloc] initWithFormat:@"%d", 1];
+        weakRef = value.objectValue;
+        value.objectValue = [[NSMutableString alloc] initWithFormat:@"%d", 2];
+    }
+    
+    // Nothing can be using the old value, so it's released without waiting for a render cycle
+    [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+    XCTAssertNil(weakRef);
+}
+
+- (void)testRenderThreadQuiescentState {
+    AEManagedValueUnregisterRenderThread(pthread_self());
+    
+    AEManagedValue * value = [AEManagedValue new];
+    __weak id weakRef = nil;
+    
+    // An offline render thread, which marks quiescent states without committing batch updates
+    dispatch_semaphore_t started = dispatch_semaphore_create(0);
+    dispatch_semaphore_t resume = dispatch_semaphore_create(0);
+    dispatch_semaphore_t finished = dispatch_semaphore_create(0);
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        AEManagedValueMarkRenderThreadQuiescent();
+        dispatch_semaphore_signal(started);
+        dispatch_semaphore_wait(resume, DISPATCH_TIME_FOREVER);
+        AEManagedValueMarkRenderThreadQuiescent();
+        AEManagedValueUnregisterRenderThread(pthread_self());
+        dispatch_semaphore_signal(finished);
+    });
+    dispatch_semaphore_wait(started, DISPATCH_TIME_FOREVER);
+    
+    @autoreleasepool {
+        value.objectValue = [[NSMutableString alloc] initWithFormat:@"%d", 1];
+        weakRef = value.objectValue;
+        value.objectValue = [[NSMutableString alloc] initWithFormat:@"%d", 2];
+    }
+    [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+    XCTAssertNotNil(weakRef);
+    
+    dispatch_semaphore_signal(resume);
+    dispatch_semaphore_wait(finished, DISPATCH_TIME_FOREVER);
+    [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+    XCTAssertNil(weakRef);
+}
+
+- (void)testServiceReleaseQueueAffectsOnlyInstance {
+    AEManagedValue * value1 = [AEManagedValue new];
+    AEManagedValue * value2 = [AEManagedValue new];
+    value1.usedOnAudioThread = NO;
+    value2.usedOnAudioThread = NO;
+    __weak id weakRef1 = nil;
+    __weak id weakRef2 = nil;
+    
+    @autoreleasepool {
+        value1.objectValue = [[NSMutableString alloc] initWithFormat:@"%d", 1];
+        value2.objectValue = [[NSMutableString alloc] initWithFormat:@"%d", 2];
+        weakRef1 = value1.objectValue;
+        weakRef2 = value2.objectValue;
+        value1.objectValue = [[NSMutableString alloc] initWithFormat:@"%d", 3];
+        value2.objectValue = [[NSMutableString alloc] initWithFormat:@"%d", 4];
+    }
+    
+    // Render cycles don't release values of instances used elsewhere
+    AEManagedValueCommitPendingUpdates();
+    [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+    XCTAssertNotNil(weakRef1);
+    XCTAssertNotNil(weakRef2);
+    
+    // Servicing one instance releases only its own old value
+    AEManagedValueServiceReleaseQueue(value1);
+    [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+    XCTAssertNil(weakRef1);
+    XCTAssertNotNil(weakRef2);
+    
+    AEManagedValueServiceReleaseQueue(value2);
+    [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+    XCTAssertNil(weakRef2);
+}
+
 - (void)testAtomicBatchUpdate {
     AEManagedValue * value1 = [AEManagedValue new];
     AEManagedValue * value2 = [AEManagedValue new];
@@ -0,0 +1,202 @@
+//
+//  AEMappedAudioFileTests.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "AEMappedAudioFile.h"
+#import "AEAudioFileOutput.h"
+#import "AEAudioBufferListUtilities.h"
+#import "AERenderer.h"
+#import "AEBufferStack.h"
+#import "AETypes.h"
+
+static const UInt32 kTestLength = 10007;
+
+// Test values are multiples of 1/128, so they're exactly representable in every sample format
+static int AEMappedAudioFileTestValue(UInt64 frame, int channel) {
+    return (int)((frame * 7 + channel * 3) % 200) - 100;
+}
+
+@interface AEMappedAudioFileTests : XCTestCase
+@property (nonatomic, strong) NSString * folder;
+@end
+
+@implementation AEMappedAudioFileTests
+
+- (void)setUp {
+    self.folder = [NSTemporaryDirectory() stringByAppendingPathComponent:@"AEMappedAudioFileTests"];
+    [[NSFileManager defaultManager] createDirectoryAtPath:self.folder withIntermediateDirectories:YES attributes:nil error:NULL];
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath:self.folder error:NULL];
+}
+
+- (void)testFloatWAVIsZeroCopy {
+    NSString * path = [self.folder stringByAppendingPathComponent:@"float.wav"];
+    [[self WAVWithChannels:2 bytesPerSample:4 isFloat:YES] writeToFile:path atomically:YES];
+
+    AEMappedAudioFile * file = AEMappedAudioFileOpen(path, NULL);
+    XCTAssertTrue(file != NULL);
+    XCTAssertTrue(AEMappedAudioFileIsZeroCopy(file));
+    XCTAssertEqual(AEMappedAudioFileGetNumberOfChannels(file), 2);
+    XCTAssertEqual(AEMappedAudioFileGetLength(file), kTestLength);
+    XCTAssertEqual(AEMappedAudioFileGetSampleRate(file), 48000.0);
+    [self verifyFile:file channels:2];
+    AEMappedAudioFileClose(file);
+}
+
+- (void)testIntegerWAVIsConverted {
+    for ( int bytesPerSample = 1; bytesPerSample <= 4; bytesPerSample++ ) {
+        NSString * path = [self.folder stringByAppendingPathComponent:[NSString stringWithFormat:@"int%d.wav", bytesPerSample*8]];
+        [[self WAVWithChannels:2 bytesPerSample:bytesPerSample isFloat:NO] writeToFile:path atomically:YES];
+
+        AEMappedAudioFile * file = AEMappedAudioFileOpen(path, NULL);
+        XCTAssertTrue(file != NULL);
+        XCTAssertFalse(AEMappedAudioFileIsZeroCopy(file));
+        XCTAssertEqual(AEMappedAudioFileGetFileFormat(file).mBitsPerChannel, bytesPerSample*8);
+        [self verifyFile:file channels:2];
+        AEMappedAudioFileClose(file);
+    }
+}
+
+- (void)testMatchesExtAudioFile {
+    // AIFF, as written by the engine: big-endian 16-bit
+    NSString * path = [self.folder stringByAppendingPathComponent:@"engine.aiff"];
+    XCTAssertNil([self createAIFFAtPath:path]);
+
+    AEMappedAudioFile * file = AEMappedAudioFileOpen(path, NULL);
+    XCTAssertTrue(file != NULL);
+    XCTAssertEqual(AEMappedAudioFileGetSampleRate(file), 44100.0);
+    AudioStreamBasicDescription format = AEMappedAudioFileGetFileFormat(file);
+    XCTAssertTrue(format.mFormatFlags & kAudioFormatFlagIsBigEndian);
+
+    AudioBufferList * reference = AEAudioBufferListCreateWithContentsOfFile(path, AEAudioDescriptionWithChannelsAndRate(2, 44100));
+    UInt32 length = AEAudioBufferListGetLength(reference, 0);
+    XCTAssertEqual(AEMappedAudioFileGetLength(file), length);
+
+    AudioBufferList * mapped = AEAudioBufferListCreateWithFormat(AEAudioDescriptionWithChannelsAndRate(2, 44100), length);
+    XCTAssertEqual(AEMappedAudioFileRead(file, mapped, 0, length), length);
+    for ( int i=0; i<2; i++ ) {
+        XCTAssertEqual(memcmp(mapped->mBuffers[i].mData, reference->mBuffers[i].mData, length * sizeof(float)), 0);
+    }
+
+    AEAudioBufferListFree(mapped);
+    AEAudioBufferListFree(reference);
+    AEMappedAudioFileClose(file);
+}
+
+- (void)testRejectsUnsupportedFile {
+    NSString * path = [self.folder stringByAppendingPathComponent:@"garbage.wav"];
+    [[@"not an audio file" dataUsingEncoding:NSUTF8StringEncoding] writeToFile:path atomically:YES];
+
+    NSError * error = nil;
+    XCTAssertTrue(AEMappedAudioFileOpen(path, &error) == NULL);
+    XCTAssertNotNil(error);
+}
+
+- (void)verifyFile:(AEMappedAudioFile *)file channels:(int)channels {
+    // Non-interleaved, with an extra output buffer which repeats the last channel
+    AudioBufferList * output = AEAudioBufferListCreateWithFormat(AEAudioDescriptionWithChannelsAndRate(channels+1, 48000), kTestLength);
+    XCTAssertEqual(AEMappedAudioFileRead(file, output, 3, kTestLength), kTestLength - 3);
+    UInt32 mismatches = 0;
+    for ( int i=0; i<channels+1; i++ ) {
+        const float * data = output->mBuffers[i].mData;
+        for ( UInt32 j=0; j<kTestLength-3; j++ ) {
+            if ( data[j] != AEMappedAudioFileTestValue(j+3, MIN(i, channels-1)) / 128.0f ) mismatches++;
+        }
+    }
+    XCTAssertEqual(mismatches, 0);
+    AEAudioBufferListFree(output);
+
+    // Interleaved
+    const float * interleaved = AEMappedAudioFileGetInterleavedFrames(file, 5000, kTestLength - 5000);
+    XCTAssertTrue(interleaved != NULL);
+    mismatches = 0;
+    for ( UInt32 j=0; j<kTestLength-5000; j++ ) {
+        for ( int i=0; i<channels; i++ ) {
+            if ( interleaved[j*channels + i] != AEMappedAudioFileTestValue(j+5000, i) / 128.0f ) mismatches++;
+        }
+    }
+    XCTAssertEqual(mismatches, 0);
+    XCTAssertTrue(AEMappedAudioFileGetInterleavedFrames(file, kTestLength - 1, 2) == NULL);
+}
+
+- (NSData *)WAVWithChannels:(int)channels bytesPerSample:(int)bytesPerSample isFloat:(BOOL)isFloat {
+    NSMutableData * data = [NSMutableData data];
+    UInt32 dataSize = kTestLength * channels * bytesPerSample;
+    UInt32 riffSize = CFSwapInt32HostToLittle(4 + 24 + 8 + dataSize);
+    UInt32 fmtSize = CFSwapInt32HostToLittle(16);
+    UInt16 formatTag = CFSwapInt16HostToLittle(isFloat ? 3 : 1);
+    UInt16 channelCount = CFSwapInt16HostToLittle(channels);
+    UInt32 sampleRate = CFSwapInt32HostToLittle(48000);
+    UInt32 byteRate = CFSwapInt32HostToLittle(48000 * channels * bytesPerSample);
+    UInt16 blockAlign = CFSwapInt16HostToLittle(channels * bytesPerSample);
+    UInt16 bits = CFSwapInt16HostToLittle(bytesPerSample * 8);
+    UInt32 dataChunkSize = CFSwapInt32HostToLittle(dataSize);
+    [data appendBytes:"RIFF" length:4];
+    [data appendBytes:&riffSize length:4];
+    [data appendBytes:"WAVEfmt " length:8];
+    [data appendBytes:&fmtSize length:4];
+    [data appendBytes:&formatTag length:2];
+    [data appendBytes:&channelCount length:2];
+    [data appendBytes:&sampleRate length:4];
+    [data appendBytes:&byteRate length:4];
+    [data appendBytes:&blockAlign length:2];
+    [data appendBytes:&bits length:2];
+    [data appendBytes:"data" length:4];
+    [data appendBytes:&dataChunkSize length:4];
+
+    for ( UInt32 frame=0; frame<kTestLength; frame++ ) {
+        for ( int channel=0; channel<channels; channel++ ) {
+            int value = AEMappedAudioFileTestValue(frame, channel);
+            if ( isFloat ) {
+                float sample = value / 128.0f;
+                [data appendBytes:&sample length:4];
+            } else {
+                // Little-endian, left-justified in the sample width; 8-bit WAV is unsigned
+                UInt32 sample = bytesPerSample == 1 ? (UInt32)(value + 128) : (UInt32)(value * (1 << (bytesPerSample*8 - 8)));
+                sample = CFSwapInt32HostToLittle(sample);
+                [data appendBytes:&sample length:bytesPerSample];
+            }
+        }
+    }
+    return data;
+}
+
+- (NSError *)createAIFFAtPath:(NSString *)path {
+    AERenderer * renderer = [AERenderer new];
+
+    AEAudioFileOutput * output = [[AEAudioFileOutput alloc] initWithRenderer:renderer path:path type:AEAudioFileTypeAIFFInt16 sampleRate:44100 channelCount:2];
+    __block NSError * error = nil;
+    if ( ![output prepareForWriting:&error] ) {
+        return error;
+    }
+
+    __block UInt64 frame = 0;
+    renderer.block = ^(const AERenderContext * context) {
+        const AudioBufferList * abl = AEBufferStackPushWithChannels(context->stack, 1, 2);
+        for ( UInt32 i=0; i<context->frames; i++, frame++ ) {
+            ((float *)abl->mBuffers[0].mData)[i] = sinf(frame * 0.01f) * 0.5f;
+            ((float *)abl->mBuffers[1].mData)[i] = AEMappedAudioFileTestValue(frame, 1) / 128.0f;
+        }
+        AERenderContextOutput(context, 1);
+    };
+
+    __block BOOL done = NO;
+    [output runForDuration:0.25 completionBlock:^(NSError * e){
+        done = YES;
+        error = e;
+    }];
+    while ( !done ) {
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+    }
+    [output finishWriting];
+    return error;
+}
+
+@end
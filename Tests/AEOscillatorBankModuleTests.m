@@ -0,0 +1,220 @@
+//
+//  AEOscillatorBankModuleTests.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "AEOscillatorBankModule.h"
+#import "AERenderer.h"
+#import "AEAudioBufferListUtilities.h"
+#import "AEDSPUtilities.h"
+#import <Accelerate/Accelerate.h>
+
+static const double kSampleRate = 44100.0;
+static const UInt32 kSliceFrames = 512;
+static const int kAnalysisLength = 16384;
+
+@interface AEOscillatorBankModuleTests : XCTestCase
+@end
+
+@implementation AEOscillatorBankModuleTests
+
+- (void)testSine {
+    AERenderer * renderer = [AERenderer new];
+    renderer.sampleRate = kSampleRate;
+    AEOscillatorBankModule * module = [[AEOscillatorBankModule alloc] initWithRenderer:renderer numberOfOscillators:4];
+    AEOscillatorBankModuleSetFrequency(module, 2, 440.0);
+    AEOscillatorBankModuleSetAmplitude(module, 2, 0.5);
+    
+    UInt32 frames = kSliceFrames * 20;
+    AudioBufferList * output = [self renderModule:module renderer:renderer frames:frames];
+    
+    // After the first slice's fade-in
+    double maxError = 0;
+    for ( UInt32 i=kSliceFrames; i<frames; i++ ) {
+        double expected = 0.5 * sin(2.0 * M_PI * 440.0 * i / kSampleRate);
+        maxError = MAX(maxError, fabs(((float*)output->mBuffers[0].mData)[i] - expected));
+    }
+    XCTAssertLessThan(maxError, 1.0e-5);
+    
+    AEAudioBufferListFree(output);
+}
+
+- (void)testPhaseRemainsAccurate {
+    // Ten minutes, with a frequency that isn't a whole number of cycles per slice
+    AERenderer * renderer = [AERenderer new];
+    renderer.sampleRate = kSampleRate;
+    AEOscillatorBankModule * module = [[AEOscillatorBankModule alloc] initWithRenderer:renderer numberOfOscillators:1];
+    AEOscillatorBankModuleSetFrequency(module, 0, 1000.1);
+    AEOscillatorBankModuleSetAmplitude(module, 0, 1.0);
+    renderer.block = ^(const AERenderContext * context) {
+        AEModuleProcess(module, context);
+        AERenderContextOutput(context, 1);
+    };
+    
+    AudioBufferList * output = AEAudioBufferListCreate(kSliceFrames);
+    AudioTimeStamp timestamp = { .mFlags = kAudioTimeStampSampleTimeValid, .mSampleTime = 0 };
+    UInt64 position = 0;
+    for ( ; position < kSampleRate * 600; position += kSliceFrames ) {
+        AERendererRun(renderer, output, kSliceFrames, &timestamp);
+        timestamp.mSampleTime += kSliceFrames;
+    }
+    
+    double maxError = 0;
+    for ( UInt32 i=0; i<kSliceFrames; i++ ) {
+        double expected = sin(2.0 * M_PI * fmod(1000.1 * (position - kSliceFrames + i) / kSampleRate, 1.0));
+        maxError = MAX(maxError, fabs(((float*)output->mBuffers[0].mData)[i] - expected));
+    }
+    XCTAssertLessThan(maxError, 1.0e-4);
+    
+    AEAudioBufferListFree(output);
+}
+
+- (void)testBandLimitedWaveforms {
+    // Choose frequencies with a whole number of cycles in the analysis window, so harmonics and their
+    // aliases fall exactly on FFT bins, with aliases between harmonics
+    int cycles = 1117;
+    double frequency = kSampleRate * cycles / kAnalysisLength;
+    AEOscillatorWaveform waveforms[] = { AEOscillatorWaveformSaw, AEOscillatorWaveformSquare, AEOscillatorWaveformTriangle };
+    double limits[] = { -24.0, -28.0, -45.0 };
+    
+    for ( int i=0; i<sizeof(waveforms)/sizeof(waveforms[0]); i++ ) {
+        double aliasing = [self aliasingForWaveform:waveforms[i] frequency:frequency cycles:cycles wavetable:nil];
+        XCTAssertLessThan(aliasing, limits[i], @"Waveform %d", (int)waveforms[i]);
+    }
+}
+
+- (void)testWavetable {
+    // A sawtooth table, played high enough that most of its harmonics must be removed
+    int length = 2048;
+    NSMutableData * table = [NSMutableData dataWithLength:sizeof(float) * length];
+    float * samples = (float*)table.mutableBytes;
+    for ( int i=0; i<length; i++ ) {
+        samples[i] = 2.0 * i / length - 1.0;
+    }
+    
+    int cycles = 2953;
+    double frequency = kSampleRate * cycles / kAnalysisLength;
+    double aliasing = [self aliasingForWaveform:AEOscillatorWaveformWavetable frequency:frequency cycles:cycles wavetable:table];
+    XCTAssertLessThan(aliasing, -60.0);
+    
+    AERenderer * renderer = [AERenderer new];
+    AEOscillatorBankModule * module = [[AEOscillatorBankModule alloc] initWithRenderer:renderer numberOfOscillators:1];
+    XCTAssertFalse([module setWavetable:samples length:1000]);
+}
+
+- (void)testFrequencySmoothing {
+    AERenderer * renderer = [AERenderer new];
+    renderer.sampleRate = kSampleRate;
+    AEOscillatorBankModule * module = [[AEOscillatorBankModule alloc] initWithRenderer:renderer numberOfOscillators:1];
+    AEOscillatorBankModuleSetFrequency(module, 0, 440.0);
+    AEOscillatorBankModuleSetAmplitude(module, 0, 1.0);
+    
+    __block int slice = 0;
+    renderer.block = ^(const AERenderContext * context) {
+        if ( slice++ == 4 ) AEOscillatorBankModuleSetFrequency(module, 0, 4400.0);
+        AEModuleProcess(module, context);
+        AERenderContextOutput(context, 1);
+    };
+    
+    UInt32 frames = kSliceFrames * 16;
+    AudioBufferList * output = AEAudioBufferListCreate(frames);
+    AudioTimeStamp timestamp = { .mFlags = kAudioTimeStampSampleTimeValid, .mSampleTime = 0 };
+    for ( UInt32 position = 0; position < frames; position += kSliceFrames ) {
+        AEAudioBufferListCopyOnStack(target, output, position);
+        AERendererRun(renderer, target, kSliceFrames, &timestamp);
+        timestamp.mSampleTime += kSliceFrames;
+    }
+    
+    // The step between samples never exceeds that of the final frequency: the frequency glides, and
+    // the phase is continuous
+    float * samples = (float*)output->mBuffers[0].mData;
+    double maxStep = 0;
+    for ( UInt32 i=1; i<frames; i++ ) {
+        maxStep = MAX(maxStep, fabsf(samples[i] - samples[i-1]));
+    }
+    XCTAssertLessThan(maxStep, 2.0 * M_PI * 4400.0 / kSampleRate * 1.01);
+    
+    AEAudioBufferListFree(output);
+}
+
+- (void)testPerformance {
+    // 256 oscillators of mixed waveforms
+    const int kOscillators = 256;
+    AERenderer * renderer = [AERenderer new];
+    renderer.sampleRate = kSampleRate;
+    AEOscillatorBankModule * module = [[AEOscillatorBankModule alloc] initWithRenderer:renderer numberOfOscillators:kOscillators];
+    for ( int i=0; i<kOscillators; i++ ) {
+        AEOscillatorBankModuleSetWaveform(module, i, (AEOscillatorWaveform)(i % 4));
+        AEOscillatorBankModuleSetFrequency(module, i, 55.0 * (i + 1));
+        AEOscillatorBankModuleSetAmplitude(module, i, 1.0 / kOscillators);
+    }
+    renderer.block = ^(const AERenderContext * context) {
+        AEModuleProcess(module, context);
+        AERenderContextOutput(context, 1);
+    };
+    
+    AudioBufferList * output = AEAudioBufferListCreate(kSliceFrames);
+    [self measureBlock:^{
+        // Ten seconds of audio
+        AudioTimeStamp timestamp = { .mFlags = kAudioTimeStampSampleTimeValid, .mSampleTime = 0 };
+        for ( UInt32 position = 0; position < kSampleRate * 10; position += kSliceFrames ) {
+            AERendererRun(renderer, output, kSliceFrames, &timestamp);
+            timestamp.mSampleTime += kSliceFrames;
+        }
+    }];
+    AEAudioBufferListFree(output);
+}
+
+#pragma mark - Helpers
+
+- (AudioBufferList *)renderModule:(AEOscillatorBankModule *)module renderer:(AERenderer *)renderer frames:(UInt32)frames {
+    renderer.block = ^(const AERenderContext * context) {
+        AEModuleProcess(module, context);
+        AERenderContextOutput(context, 1);
+    };
+    
+    AudioBufferList * output = AEAudioBufferListCreate(frames);
+    AudioTimeStamp timestamp = { .mFlags = kAudioTimeStampSampleTimeValid, .mSampleTime = 0 };
+    for ( UInt32 position = 0; position < frames; position += kSliceFrames ) {
+        AEAudioBufferListCopyOnStack(target, output, position);
+        AERendererRun(renderer, target, kSliceFrames, &timestamp);
+        timestamp.mSampleTime += kSliceFrames;
+    }
+    return output;
+}
+
+- (double)aliasingForWaveform:(AEOscillatorWaveform)waveform frequency:(double)frequency cycles:(int)cycles wavetable:(NSData *)wavetable {
+    AERenderer * renderer = [AERenderer new];
+    renderer.sampleRate = kSampleRate;
+    AEOscillatorBankModule * module = [[AEOscillatorBankModule alloc] initWithRenderer:renderer numberOfOscillators:1];
+    if ( wavetable ) [module setWavetable:(const float *)wavetable.bytes length:(int)(wavetable.length / sizeof(float))];
+    AEOscillatorBankModuleSetWaveform(module, 0, waveform);
+    AEOscillatorBankModuleSetFrequency(module, 0, frequency);
+    AEOscillatorBankModuleSetAmplitude(module, 0, 1.0);
+    
+    // Analyse a whole window, after the fade-in
+    AudioBufferList * output = [self renderModule:module renderer:renderer frames:2 * kAnalysisLength];
+    AEDSPFFT * fft = AEDSPFFTInit(kAnalysisLength);
+    float * real = malloc(sizeof(float) * kAnalysisLength / 2);
+    float * imag = malloc(sizeof(float) * kAnalysisLength / 2);
+    AEDSPFFTForward(fft, (float*)output->mBuffers[0].mData + kAnalysisLength, real, imag);
+    
+    // Compare the power in harmonic bins with the power everywhere else
+    double harmonicPower = 0, aliasPower = 0;
+    for ( int bin=1; bin<kAnalysisLength/2; bin++ ) {
+        double power = real[bin] * real[bin] + imag[bin] * imag[bin];
+        if ( bin % cycles == 0 ) harmonicPower += power; else aliasPower += power;
+    }
+    
+    free(real);
+    free(imag);
+    AEDSPFFTDealloc(fft);
+    AEAudioBufferListFree(output);
+    return 10.0 * log10(aliasPower / harmonicPower);
+}
+
+@end
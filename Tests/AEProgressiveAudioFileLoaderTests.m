@@ -0,0 +1,157 @@
+//
+//  AEProgressiveAudioFileLoaderTests.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+
+#import <XCTest/XCTest.h>
+#import "AEProgressiveAudioFileLoader.h"
+#import "AEAudioFileOutput.h"
+#import "AEAudioBufferListUtilities.h"
+#import "AERenderer.h"
+#import "AEBufferStack.h"
+#import "AETypes.h"
+
+static const double kSampleRate = 44100.0;
+static const NSTimeInterval kTestFileLength = 5.0;
+
+@interface AEProgressiveAudioFileLoaderTests : XCTestCase
+@property (nonatomic, strong) NSString * folder;
+@end
+
+@implementation AEProgressiveAudioFileLoaderTests
+
+- (void)setUp {
+    self.folder = [NSTemporaryDirectory() stringByAppendingPathComponent:@"AEProgressiveAudioFileLoaderTests"];
+    [[NSFileManager defaultManager] createDirectoryAtPath:self.folder withIntermediateDirectories:YES attributes:nil error:NULL];
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath:self.folder error:NULL];
+}
+
+- (void)testLoadsPCMFile {
+    NSString * path = [self.folder stringByAppendingPathComponent:@"audio.aiff"];
+    XCTAssertNil([self createTestFile:path type:AEAudioFileTypeAIFFInt16]);
+    [self verifyLoadOfFile:path tolerance:0];
+}
+
+- (void)testLoadsCompressedFileInParallel {
+    NSString * path = [self.folder stringByAppendingPathComponent:@"audio.m4a"];
+    XCTAssertNil([self createTestFile:path type:AEAudioFileTypeM4A]);
+    [self verifyLoadOfFile:path tolerance:1.0e-3];
+}
+
+- (void)testConvertsSampleRate {
+    NSString * path = [self.folder stringByAppendingPathComponent:@"audio.aiff"];
+    XCTAssertNil([self createTestFile:path type:AEAudioFileTypeAIFFInt16]);
+
+    XCTestExpectation * expectation = [self expectationWithDescription:@"load"];
+    AEProgressiveAudioFileLoader * loader = [AEProgressiveAudioFileLoader loadFileAtPath:path sampleRate:48000
+                                                                         completionBlock:^(NSError * error) {
+        XCTAssertNil(error);
+        [expectation fulfill];
+    } error:NULL];
+    XCTAssertNotNil(loader);
+    XCTAssertEqual(loader.numberOfWorkers, 1);
+    XCTAssertEqual(loader.audioDescription.mSampleRate, 48000.0);
+    [self waitForExpectationsWithTimeout:10.0 handler:nil];
+
+    XCTAssertTrue(loader.finished);
+    XCTAssertEqualWithAccuracy(loader.validFrames, kTestFileLength * 48000, 48000 * 0.01);
+}
+
+- (void)testCancels {
+    NSString * path = [self.folder stringByAppendingPathComponent:@"audio.m4a"];
+    XCTAssertNil([self createTestFile:path type:AEAudioFileTypeM4A]);
+
+    AEProgressiveAudioFileLoader * loader = [AEProgressiveAudioFileLoader loadFileAtPath:path sampleRate:0
+                                                                         completionBlock:^(NSError * error) {
+        XCTFail(@"Completion block called after cancellation");
+    } error:NULL];
+    [loader cancel];
+    [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:1.0]];
+    XCTAssertFalse(loader.finished);
+    XCTAssertLessThanOrEqual(loader.validFrames, loader.capacity);
+}
+
+- (void)testRejectsMissingFile {
+    NSError * error = nil;
+    XCTAssertNil([AEProgressiveAudioFileLoader loadFileAtPath:[self.folder stringByAppendingPathComponent:@"missing.aiff"]
+                                                   sampleRate:0 completionBlock:nil error:&error]);
+    XCTAssertNotNil(error);
+}
+
+- (void)verifyLoadOfFile:(NSString *)path tolerance:(float)tolerance {
+    AudioBufferList * reference = AEAudioBufferListCreateWithContentsOfFile(path, AEAudioDescriptionWithChannelsAndRate(2, kSampleRate));
+    UInt32 referenceLength = AEAudioBufferListGetLength(reference, 0);
+
+    __block BOOL done = NO;
+    AEProgressiveAudioFileLoader * loader = [AEProgressiveAudioFileLoader loadFileAtPath:path sampleRate:0
+                                                                         completionBlock:^(NSError * error) {
+        XCTAssertNil(error);
+        done = YES;
+    } error:NULL];
+    XCTAssertNotNil(loader);
+    XCTAssertEqual(loader.audioDescription.mChannelsPerFrame, 2);
+
+    // Play along behind the watermark as a realtime reader would, checking audio as it becomes valid
+    const AudioBufferList * audio = AEProgressiveAudioFileLoaderGetAudio(loader);
+    UInt32 checked = 0;
+    UInt32 mismatches = 0;
+    BOOL finished = NO;
+    while ( !finished ) {
+        UInt32 valid = AEProgressiveAudioFileLoaderGetValidFrames(loader, &finished);
+        XCTAssertGreaterThanOrEqual(valid, checked);
+        for ( ; checked < MIN(valid, referenceLength); checked++ ) {
+            for ( int i=0; i<2; i++ ) {
+                if ( fabsf(((float *)audio->mBuffers[i].mData)[checked]
+                           - ((float *)reference->mBuffers[i].mData)[checked]) > tolerance ) mismatches++;
+            }
+        }
+        if ( !finished ) usleep(1000);
+    }
+    XCTAssertEqual(mismatches, 0);
+    XCTAssertEqual(loader.validFrames, referenceLength);
+
+    while ( !done ) {
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+    }
+    AEAudioBufferListFree(reference);
+}
+
+- (NSError *)createTestFile:(NSString *)path type:(AEAudioFileType)type {
+    AERenderer * renderer = [AERenderer new];
+
+    AEAudioFileOutput * output = [[AEAudioFileOutput alloc] initWithRenderer:renderer path:path type:type sampleRate:kSampleRate channelCount:2];
+    __block NSError * error = nil;
+    if ( ![output prepareForWriting:&error] ) {
+        return error;
+    }
+
+    __block UInt64 frame = 0;
+    renderer.block = ^(const AERenderContext * context) {
+        const AudioBufferList * abl = AEBufferStackPushWithChannels(context->stack, 1, 2);
+        for ( UInt32 i=0; i<context->frames; i++, frame++ ) {
+            ((float *)abl->mBuffers[0].mData)[i] = sinf(frame * 0.01f) * 0.5f;
+            ((float *)abl->mBuffers[1].mData)[i] = sinf(frame * 0.003f) * 0.25f;
+        }
+        AERenderContextOutput(context, 1);
+    };
+
+    __block BOOL done = NO;
+    [output runForDuration:kTestFileLength completionBlock:^(NSError * e){
+        done = YES;
+        error = e;
+    }];
+    while ( !done ) {
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+    }
+    [output finishWriting];
+    return error;
+}
+
+@end
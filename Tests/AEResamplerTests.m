@@ -0,0 +1,189 @@
+//
+//  AEResamplerTests.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "AEResampler.h"
+#import "AEAudioBufferListUtilities.h"
+#import "AETypes.h"
+#import <Accelerate/Accelerate.h>
+
+static const UInt32 kSineFrames = 48000;
+static const double kSineFrequency = 1000.0;
+static const double kSineAmplitude = 0.5;
+
+@interface AEResamplerTests : XCTestCase
+@end
+
+@implementation AEResamplerTests
+
+- (void)testSineAccuracy {
+    double rates[][2] = { {44100, 48000}, {48000, 44100}, {22050, 48000}, {96000, 44100}, {44100, 44100.5} };
+    float tolerances[] = {
+        [AEResamplerQualityLinear] = 1.0e-2,
+        [AEResamplerQualityCubic] = 5.0e-4,
+        [AEResamplerQualityLow] = 2.0e-3,
+        [AEResamplerQualityMedium] = 2.0e-4,
+        [AEResamplerQualityHigh] = 5.0e-5,
+        [AEResamplerQualityBest] = 5.0e-6
+    };
+    
+    for ( int i=0; i<sizeof(rates)/sizeof(rates[0]); i++ ) {
+        for ( AEResamplerQuality quality = AEResamplerQualityLinear; quality <= AEResamplerQualityBest; quality++ ) {
+            double maxError = [self sineErrorFromRate:rates[i][0] toRate:rates[i][1] quality:quality];
+            XCTAssertLessThan(maxError, tolerances[quality], @"%g -> %g, quality %d", rates[i][0], rates[i][1], (int)quality);
+        }
+    }
+}
+
+- (void)testAntiAliasing {
+    // A 30kHz tone at 96kHz is above Nyquist at 44.1kHz, and should be removed
+    AudioBufferList * input = [self sineWithFrequency:30000 rate:96000 channels:1];
+    UInt32 outputFrames;
+    AudioBufferList * output = AEResamplerCreateResampledBufferList(input, kSineFrames, 96000, 44100, AEResamplerQualityHigh, &outputFrames);
+    
+    float peak = 0;
+    vDSP_maxmgv((float*)output->mBuffers[0].mData + 256, 1, &peak, outputFrames - 512);
+    XCTAssertLessThan(peak, 1.0e-4);
+    
+    AEAudioBufferListFree(input);
+    AEAudioBufferListFree(output);
+}
+
+- (void)testInputFramesRequiredIsExact {
+    AEResampler * fixed = AEResamplerNew(44100, 48000, 2, AEResamplerQualityHigh);
+    AEResampler * variable = AEResamplerNewWithVariableRatio(1.0, 2.0, 2, AEResamplerQualityHigh);
+    AEResampler * cubic = AEResamplerNewWithVariableRatio(1.0, 2.0, 2, AEResamplerQualityCubic);
+    AudioBufferList * input = [self sineWithFrequency:kSineFrequency rate:44100 channels:2];
+    AudioBufferList * output = AEAudioBufferListCreate(4096);
+    
+    for ( int i=0; i<3000; i++ ) {
+        AEResampler * resampler = i % 3 == 2 ? cubic : i % 3 == 1 ? variable : fixed;
+        if ( resampler != fixed ) AEResamplerSetRatio(resampler, 0.5 + (i % 17) / 10.0);
+        
+        UInt32 outputFrames = 1 + (i*37) % 1024;
+        UInt32 required = AEResamplerGetInputFramesRequired(resampler, outputFrames);
+        UInt32 inputFrames = required;
+        UInt32 producedFrames = outputFrames;
+        AEResamplerProcess(resampler, input, &inputFrames, output, &producedFrames);
+        
+        XCTAssertEqual(inputFrames, required);
+        XCTAssertEqual(producedFrames, outputFrames);
+    }
+    
+    AEResamplerFree(fixed);
+    AEResamplerFree(variable);
+    AEResamplerFree(cubic);
+    AEAudioBufferListFree(input);
+    AEAudioBufferListFree(output);
+}
+
+- (void)testStreamingMatchesOneShot {
+    AudioBufferList * input = [self sineWithFrequency:kSineFrequency rate:44100 channels:1];
+    UInt32 expectedFrames;
+    AudioBufferList * expected = AEResamplerCreateResampledBufferList(input, kSineFrames, 44100, 48000, AEResamplerQualityMedium, &expectedFrames);
+    
+    AEResampler * resampler = AEResamplerNew(44100, 48000, 1, AEResamplerQualityMedium);
+    AudioBufferList * output = AEAudioBufferListCreateWithFormat(AEAudioDescriptionWithChannelsAndRate(1, 48000), expectedFrames);
+    UInt32 inputOffset = 0, outputOffset = 0;
+    for ( int block=0; inputOffset < kSineFrames; block++ ) {
+        UInt32 inputFrames = MIN(kSineFrames - inputOffset, 1 + (block*97) % 700);
+        UInt32 outputFrames = expectedFrames - outputOffset;
+        AEAudioBufferListCopyOnStack(inputBlock, input, inputOffset);
+        AEAudioBufferListCopyOnStack(outputBlock, output, outputOffset);
+        AEResamplerProcess(resampler, inputBlock, &inputFrames, outputBlock, &outputFrames);
+        inputOffset += inputFrames;
+        outputOffset += outputFrames;
+    }
+    
+    for ( UInt32 i=0; i<outputOffset; i++ ) {
+        XCTAssertEqualWithAccuracy(((float*)output->mBuffers[0].mData)[i], ((float*)expected->mBuffers[0].mData)[i], 1.0e-6);
+    }
+    
+    AEResamplerFree(resampler);
+    AEAudioBufferListFree(input);
+    AEAudioBufferListFree(output);
+    AEAudioBufferListFree(expected);
+}
+
+- (void)testVariableRatio {
+    AEResampler * resampler = AEResamplerNewWithVariableRatio(1.0, 4.0, 1, AEResamplerQualityHigh);
+    XCTAssertEqualWithAccuracy(AEResamplerGetRatio(resampler), 1.0, 1.0e-9);
+    AEResamplerSetRatio(resampler, 2.5);
+    XCTAssertEqualWithAccuracy(AEResamplerGetRatio(resampler), 2.5, 1.0e-9);
+    
+    // Consuming 2.5 input frames per output frame
+    XCTAssertEqual(AEResamplerGetInputFramesRequired(resampler, 1001) - AEResamplerGetInputFramesRequired(resampler, 1), 2500);
+    AEResamplerFree(resampler);
+}
+
+- (void)testVariableRatioCutoffFollowsRatio {
+    // A 15kHz tone passes at a ratio of 1, but is above the output Nyquist frequency at a ratio of 2
+    XCTAssertGreaterThan([self peakWithFrequency:15000 ratio:1.0], 0.49);
+    XCTAssertLessThan([self peakWithFrequency:15000 ratio:2.0], 1.0e-4);
+    XCTAssertGreaterThan([self peakWithFrequency:5000 ratio:2.0], 0.49);
+}
+
+- (void)testRatePerformance {
+    AudioBufferList * input = [self sineWithFrequency:kSineFrequency rate:44100 channels:2];
+    [self measureBlock:^{
+        UInt32 outputFrames;
+        AudioBufferList * output = AEResamplerCreateResampledBufferList(input, kSineFrames, 44100, 48000, AEResamplerQualityHigh, &outputFrames);
+        AEAudioBufferListFree(output);
+    }];
+    AEAudioBufferListFree(input);
+}
+
+#pragma mark - Helpers
+
+- (float)peakWithFrequency:(double)frequency ratio:(double)ratio {
+    AudioBufferList * input = [self sineWithFrequency:frequency rate:44100 channels:1];
+    AEResampler * resampler = AEResamplerNewWithVariableRatio(ratio, 4.0, 1, AEResamplerQualityHigh);
+    UInt32 inputFrames = kSineFrames;
+    UInt32 outputFrames = (UInt32)(kSineFrames / ratio) - 256;
+    AudioBufferList * output = AEAudioBufferListCreateWithFormat(AEAudioDescriptionWithChannelsAndRate(1, 44100), outputFrames);
+    AEResamplerProcess(resampler, input, &inputFrames, output, &outputFrames);
+    
+    float peak = 0;
+    vDSP_maxmgv((float*)output->mBuffers[0].mData + 256, 1, &peak, outputFrames - 512);
+    
+    AEResamplerFree(resampler);
+    AEAudioBufferListFree(input);
+    AEAudioBufferListFree(output);
+    return peak;
+}
+
+- (double)sineErrorFromRate:(double)inputRate toRate:(double)outputRate quality:(AEResamplerQuality)quality {
+    AudioBufferList * input = [self sineWithFrequency:kSineFrequency rate:inputRate channels:1];
+    UInt32 outputFrames;
+    AudioBufferList * output = AEResamplerCreateResampledBufferList(input, kSineFrames, inputRate, outputRate, quality, &outputFrames);
+    XCTAssertEqual(outputFrames, (UInt32)ceil(kSineFrames * (outputRate / inputRate)));
+    
+    // Skip the edges, where the filter sees the silence beyond the input
+    double maxError = 0;
+    for ( UInt32 i=200; i+200<outputFrames; i++ ) {
+        double sample = kSineAmplitude * sin(2.0 * M_PI * kSineFrequency * i / outputRate);
+        maxError = MAX(maxError, fabs(((float*)output->mBuffers[0].mData)[i] - sample));
+    }
+    
+    AEAudioBufferListFree(input);
+    AEAudioBufferListFree(output);
+    return maxError;
+}
+
+- (AudioBufferList *)sineWithFrequency:(double)frequency rate:(double)rate channels:(int)channels {
+    AudioBufferList * abl = AEAudioBufferListCreateWithFormat(AEAudioDescriptionWithChannelsAndRate(channels, rate), kSineFrames);
+    for ( int channel=0; channel<channels; channel++ ) {
+        float * samples = (float*)abl->mBuffers[channel].mData;
+        for ( UInt32 i=0; i<kSineFrames; i++ ) {
+            samples[i] = kSineAmplitude * sin(2.0 * M_PI * frequency * i / rate);
+        }
+    }
+    return abl;
+}
+
+@end
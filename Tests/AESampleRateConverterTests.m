@@ -1,6 +1,19 @@
-#import <XCTest/XCTest.h>
+//
+//  AESampleRateConverterTests.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
 
+#import <XCTest/XCTest.h>
 #import "AESampleRateConverterModule.h"
+#import "AERenderer.h"
+#import "AEAudioBufferListUtilities.h"
+
+static const double kInputRate = 44100.0;
+static const double kOutputRate = 48000.0;
+static const double kSineFrequency = 1000.0;
 
 @interface AESampleRateConverterTests : XCTestCase
 @end
@@ -8,56 +21,60 @@
 @implementation AESampleRateConverterTests
 
 - (void)testSampleRateConverter {
-  // Use stereo buffers because AEModuleProcess is currently hard-coded to use stereo buffers.
-  // If we use a mono buffer, the conversion to/from stereo internal to AEModuleProcess ends up
-  // doubling the amplitude of the samples.
-  const AudioStreamBasicDescription inFormat = AEAudioDescriptionWithChannelsAndRate(2,44100);
-  const AudioStreamBasicDescription outFormat = AEAudioDescriptionWithChannelsAndRate(2,48000);
-  const UInt32 kOutFrames = 128;
-  const UInt32 kInFrames =
-      (UInt32) ceil((inFormat.mSampleRate / outFormat.mSampleRate) * kOutFrames);
-  AudioBufferList * in = AEAudioBufferListCreateWithFormat(inFormat, kInFrames);
-  AudioBufferList * out = AEAudioBufferListCreateWithFormat(outFormat, kOutFrames);
-
-  AERenderer * renderer = [[AERenderer alloc] init];
-  renderer.isOffline = YES;
-  renderer.sampleRate = outFormat.mSampleRate;
-  renderer.numberOfOutputChannels = outFormat.mChannelsPerFrame;
-  AERenderer * subrenderer = [[AERenderer alloc] init];
-  subrenderer.isOffline = YES;
-  subrenderer.sampleRate = inFormat.mSampleRate;
-  subrenderer.numberOfOutputChannels = inFormat.mChannelsPerFrame;
-
-  GPMSampleRateConverterModule * converterModule =
-      [[GPMSampleRateConverterModule alloc] initWithRenderer:renderer subrenderer:subrenderer];
-
-  renderer.block = ^(const AERenderContext * context) {
-    AEModuleProcess(converterModule, context);
-    AERenderContextOutput(context, 1);
-  };
-  subrenderer.block = ^(const AERenderContext * context) {
-    const AudioBufferList * abl = AEBufferStackPushWithChannels(context->stack, 1, 2);
-    if ( !abl ) return;
-
-    for ( int i=0; i<context->frames; i++ ) {
-      ((float*)abl->mBuffers[0].mData)[i] = 0.0;
+    AERenderer * renderer = [AERenderer new];
+    renderer.sampleRate = kOutputRate;
+    AERenderer * subrenderer = [AERenderer new];
+    subrenderer.sampleRate = kInputRate;
+    
+    AESampleRateConverterModule * converter = [[AESampleRateConverterModule alloc] initWithRenderer:renderer subrenderer:subrenderer];
+    XCTAssertEqual(subrenderer.sampleRate, kInputRate, @"Sub-renderer sample rate should be left alone");
+    
+    __block UInt32 inputPosition = 0;
+    __block double expectedSampleTime = 0;
+    __block BOOL timestampsContiguous = YES;
+    subrenderer.block = ^(const AERenderContext * context) {
+        if ( context->timestamp->mSampleTime != expectedSampleTime ) timestampsContiguous = NO;
+        expectedSampleTime += context->frames;
+        
+        const AudioBufferList * abl = AEBufferStackPushWithChannels(context->stack, 1, 2);
+        if ( !abl ) return;
+        for ( int i=0; i<context->frames; i++, inputPosition++ ) {
+            float sample = 0.5 * sin(2.0 * M_PI * kSineFrequency * inputPosition / kInputRate);
+            ((float*)abl->mBuffers[0].mData)[i] = sample;
+            ((float*)abl->mBuffers[1].mData)[i] = sample;
+        }
+        AERenderContextOutput(context, 1);
+    };
+    
+    renderer.block = ^(const AERenderContext * context) {
+        AEModuleProcess(converter, context);
+        AERenderContextOutput(context, 1);
+    };
+    
+    // Render in irregular blocks, checking against a sine generated at the output rate
+    AudioBufferList * abl = AEAudioBufferListCreate(1024);
+    AudioTimeStamp timestamp = { .mFlags = kAudioTimeStampSampleTimeValid, .mSampleTime = 0 };
+    UInt32 outputPosition = 0;
+    double maxError = 0;
+    for ( int block=0; block<100; block++ ) {
+        UInt32 frames = 64 + (block*131) % 960;
+        AEAudioBufferListSetLength(abl, frames);
+        AERendererRun(renderer, abl, frames, &timestamp);
+        timestamp.mSampleTime += frames;
+        
+        for ( UInt32 i=0; i<frames; i++, outputPosition++ ) {
+            if ( outputPosition < 200 ) continue;
+            double expected = 0.5 * sin(2.0 * M_PI * kSineFrequency * outputPosition / kOutputRate);
+            maxError = MAX(maxError, fabs(((float*)abl->mBuffers[0].mData)[i] - expected));
+            maxError = MAX(maxError, fabs(((float*)abl->mBuffers[1].mData)[i] - expected));
+        }
     }
-
-    ((float*)abl->mBuffers[0].mData)[0] = 1.0;
-
-    AERenderContextOutput(context, 1);
-  };
-
-  AudioTimeStamp timestamp = { .mFlags = kAudioTimeStampSampleTimeValid, .mSampleTime = 0 };
-
-  AERendererRun(renderer, out, kOutFrames, &timestamp);
-
-  // Todo: Inspect the output, to see if it is a resampled version of the input.
-
-  for ( int i=0; i<kOutFrames; i++ ) {
-    NSLog(@"%d %g", i, ((float*)out->mBuffers[0].mData)[i]);
-  }
-
+    
+    XCTAssertLessThan(maxError, 5.0e-5);
+    XCTAssertTrue(timestampsContiguous);
+    XCTAssertEqualWithAccuracy(inputPosition, outputPosition * (kInputRate / kOutputRate), 64);
+    
+    AEAudioBufferListFree(abl);
 }
 
 @end
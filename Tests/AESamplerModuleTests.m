@@ -0,0 +1,242 @@
+//
+//  AESamplerModuleTests.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "AESamplerModule.h"
+#import "AEAudioSampleCache.h"
+#import "AEStreamingSampleStore.h"
+#import "AEAudioFileOutput.h"
+#import "AEAudioBufferListUtilities.h"
+#import "AERenderer.h"
+#import "AEBufferStack.h"
+#import "AETypes.h"
+
+static const double kSampleRate = 44100.0;
+static const UInt32 kSliceFrames = 512;
+static const NSTimeInterval kTestFileLength = 0.5;
+
+@interface AESamplerModuleTests : XCTestCase
+@property (nonatomic, strong) NSString * path;
+@property (nonatomic, strong) AEAudioSample * sample;
+@end
+
+@implementation AESamplerModuleTests
+
+- (void)setUp {
+    self.path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"AESamplerModuleTests.aiff"];
+    XCTAssertNil([self createTestFile]);
+    
+    XCTestExpectation * expectation = [self expectationWithDescription:@"load"];
+    AEAudioSampleCache * cache = [[AEAudioSampleCache alloc] initWithByteBudget:0];
+    [cache loadSampleAtPath:self.path targetAudioDescription:AEAudioDescriptionWithChannelsAndRate(1, kSampleRate)
+            completionBlock:^(AEAudioSample * sample, NSError * error) {
+        XCTAssertNil(error);
+        self.sample = sample;
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath:self.path error:NULL];
+}
+
+- (void)testPlaysAtRate {
+    AERenderer * renderer = [AERenderer new];
+    renderer.sampleRate = kSampleRate;
+    AESamplerModule * module = [[AESamplerModule alloc] initWithRenderer:renderer voiceCount:4 numberOfChannels:2];
+    AEAudioSample * sample = self.sample;
+    
+    // A fifth up, starting part-way through the first slice
+    const double rate = 1.5;
+    const UInt32 offset = 100;
+    __block BOOL triggered = NO;
+    UInt32 frames = (UInt32)(sample.length / rate) + offset + kSliceFrames;
+    AudioBufferList * output = [self render:renderer frames:frames block:^(const AERenderContext * context) {
+        if ( !triggered ) {
+            XCTAssertTrue(AESamplerModulePlaySample(module, sample, rate, 0.5, offset));
+            triggered = YES;
+        }
+        AEModuleProcess(module, context);
+    }];
+    
+    const float * source = (const float *)sample.audio->mBuffers[0].mData;
+    double maxError = 0;
+    for ( int channel=0; channel<2; channel++ ) {
+        const float * data = (const float *)output->mBuffers[channel].mData;
+        for ( UInt32 i=0; i<frames; i++ ) {
+            double position = ((double)i - offset) * rate;
+            double expected = 0;
+            if ( i >= offset && position < sample.length ) {
+                UInt32 index = (UInt32)position;
+                double next = index + 1 < sample.length ? source[index+1] : 0;
+                expected = 0.5 * (source[index] + (next - source[index]) * (position - index));
+            }
+            maxError = MAX(maxError, fabs(data[i] - expected));
+        }
+    }
+    XCTAssertLessThan(maxError, 1.0e-5);
+    XCTAssertEqual(module.activeVoiceCount, 0);
+    AEAudioBufferListFree(output);
+}
+
+- (void)testVoiceStealing {
+    AERenderer * renderer = [AERenderer new];
+    renderer.sampleRate = kSampleRate;
+    AESamplerModule * module = [[AESamplerModule alloc] initWithRenderer:renderer voiceCount:2 numberOfChannels:1];
+    AEAudioSample * sample = self.sample;
+    
+    __block int cycle = 0;
+    AudioBufferList * output = [self render:renderer frames:kSliceFrames * 4 block:^(const AERenderContext * context) {
+        if ( cycle == 0 ) {
+            AESamplerModulePlaySample(module, sample, 1.0, 0.5, 0);
+            AESamplerModulePlaySample(module, sample, 1.0, 0.25, 0);
+        } else if ( cycle == 1 ) {
+            XCTAssertTrue(AESamplerModulePlaySample(module, sample, 1.0, 1.0, 0));
+        } else if ( cycle == 2 ) {
+            module.voiceStealing = AESamplerVoiceStealingNone;
+            XCTAssertFalse(AESamplerModulePlaySample(module, sample, 1.0, 1.0, 0));
+        }
+        cycle++;
+        AEModuleProcess(module, context);
+    }];
+    
+    XCTAssertEqual(module.activeVoiceCount, 2);
+    XCTAssertEqual(module.stolenVoiceCount, 1);
+    XCTAssertEqual(module.droppedNoteCount, 1);
+    
+    // The oldest voice was replaced, after fading out: the remaining voices play at 0.25 and 1.0
+    const float * source = (const float *)sample.audio->mBuffers[0].mData;
+    const float * data = (const float *)output->mBuffers[0].mData;
+    UInt32 frame = kSliceFrames * 3 + 10;
+    XCTAssertEqualWithAccuracy(data[frame], 0.25 * source[frame] + source[frame - kSliceFrames], 1.0e-5);
+    AEAudioBufferListFree(output);
+}
+
+- (void)testPlaysStreamedSample {
+    AEStreamingSampleStore * store = [[AEStreamingSampleStore alloc] initWithHeadDuration:0.1 sampleRate:kSampleRate
+                                                                         numberOfChannels:1 voiceCount:4 tailBufferDuration:0.25];
+    __block AEStreamingSample * streamingSample = nil;
+    XCTestExpectation * expectation = [self expectationWithDescription:@"load"];
+    [store loadSampleAtPath:self.path completionBlock:^(AEStreamingSample * sample, NSError * error) {
+        XCTAssertNil(error);
+        streamingSample = sample;
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+    
+    AERenderer * renderer = [AERenderer new];
+    renderer.sampleRate = kSampleRate;
+    AESamplerModule * module = [[AESamplerModule alloc] initWithRenderer:renderer voiceCount:4 numberOfChannels:1 streamingStore:store];
+    XCTAssertNotNil(module);
+    XCTAssertTrue([module playStreamingSample:streamingSample rate:1.0 gain:1.0]);
+    
+    // Render slowly enough for the tail to stream
+    UInt32 frames = streamingSample.length + kSliceFrames;
+    AudioBufferList * output = [self render:renderer frames:frames block:^(const AERenderContext * context) {
+        AEModuleProcess(module, context);
+        usleep(2000);
+    }];
+    
+    const float * source = (const float *)self.sample.audio->mBuffers[0].mData;
+    const float * data = (const float *)output->mBuffers[0].mData;
+    UInt32 mismatches = 0;
+    for ( UInt32 i=0; i<frames; i++ ) {
+        float expected = i < self.sample.length ? source[i] : 0;
+        if ( fabsf(data[i] - expected) > 1.0e-5 ) mismatches++;
+    }
+    XCTAssertEqual(mismatches, 0);
+    XCTAssertEqual(store.underrunFrames, 0);
+    XCTAssertEqual(module.activeVoiceCount, 0);
+    AEAudioBufferListFree(output);
+}
+
+- (void)testPerformance {
+    // 64 voices, with a new note every 16 frames at varying pitch: over 2,700 notes per second, so voices
+    // are continually stolen
+    const int kVoices = 64;
+    AERenderer * renderer = [AERenderer new];
+    renderer.sampleRate = kSampleRate;
+    AESamplerModule * module = [[AESamplerModule alloc] initWithRenderer:renderer voiceCount:kVoices numberOfChannels:2];
+    AEAudioSample * sample = self.sample;
+    __block UInt64 triggers = 0;
+    renderer.block = ^(const AERenderContext * context) {
+        for ( UInt32 offset=0; offset<context->frames; offset += 16 ) {
+            AESamplerModulePlaySample(module, sample, pow(2.0, (double)(triggers % 25 - 12) / 12.0), 1.0 / kVoices, offset);
+            triggers++;
+        }
+        AEModuleProcess(module, context);
+        AERenderContextOutput(context, 1);
+    };
+    
+    AudioBufferList * output = AEAudioBufferListCreate(kSliceFrames);
+    [self measureBlock:^{
+        // Ten seconds of audio
+        triggers = 0;
+        NSTimeInterval start = [NSDate timeIntervalSinceReferenceDate];
+        AudioTimeStamp timestamp = { .mFlags = kAudioTimeStampSampleTimeValid, .mSampleTime = 0 };
+        for ( UInt32 position = 0; position < kSampleRate * 10; position += kSliceFrames ) {
+            AERendererRun(renderer, output, kSliceFrames, &timestamp);
+            timestamp.mSampleTime += kSliceFrames;
+        }
+        NSLog(@"%llu notes, %d voices: %.1fx realtime", triggers, kVoices,
+              10.0 / ([NSDate timeIntervalSinceReferenceDate] - start));
+    }];
+    AEAudioBufferListFree(output);
+}
+
+#pragma mark - Helpers
+
+- (AudioBufferList *)render:(AERenderer *)renderer frames:(UInt32)frames block:(AERenderLoopBlock)block {
+    renderer.block = ^(const AERenderContext * context) {
+        block(context);
+        AERenderContextOutput(context, 1);
+    };
+    
+    AudioBufferList * output = AEAudioBufferListCreate(frames + kSliceFrames);
+    AudioTimeStamp timestamp = { .mFlags = kAudioTimeStampSampleTimeValid, .mSampleTime = 0 };
+    for ( UInt32 position = 0; position < frames; position += kSliceFrames ) {
+        AEAudioBufferListCopyOnStack(target, output, position);
+        AERendererRun(renderer, target, kSliceFrames, &timestamp);
+        timestamp.mSampleTime += kSliceFrames;
+    }
+    return output;
+}
+
+- (NSError *)createTestFile {
+    AERenderer * renderer = [AERenderer new];
+    
+    AEAudioFileOutput * output = [[AEAudioFileOutput alloc] initWithRenderer:renderer path:self.path type:AEAudioFileTypeAIFFInt16 sampleRate:kSampleRate channelCount:1];
+    __block NSError * error = nil;
+    if ( ![output prepareForWriting:&error] ) {
+        return error;
+    }
+    
+    __block UInt64 frame = 0;
+    renderer.block = ^(const AERenderContext * context) {
+        const AudioBufferList * abl = AEBufferStackPushWithChannels(context->stack, 1, 1);
+        float * data = abl->mBuffers[0].mData;
+        for ( UInt32 i=0; i<context->frames; i++, frame++ ) {
+            data[i] = sinf(frame * 0.013f) * 0.5f + sinf(frame * 0.41f) * 0.25f;
+        }
+        AERenderContextOutput(context, 1);
+    };
+    
+    __block BOOL done = NO;
+    [output runForDuration:kTestFileLength completionBlock:^(NSError * e){
+        done = YES;
+        error = e;
+    }];
+    while ( !done ) {
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+    }
+    [output finishWriting];
+    return error;
+}
+
+@end
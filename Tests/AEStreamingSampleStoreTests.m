@@ -0,0 +1,187 @@
+//
+//  AEStreamingSampleStoreTests.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "AEStreamingSampleStore.h"
+#import "AEAudioFileReader.h"
+#import "AEAudioFileOutput.h"
+#import "AEAudioBufferListUtilities.h"
+#import "AERenderer.h"
+#import "AEBufferStack.h"
+#import "AETypes.h"
+
+static const double kSampleRate = 44100.0;
+static const NSTimeInterval kTestFileLength = 1.0;
+static const UInt32 kFramesPerCycle = 512;
+
+@interface AEStreamingSampleStoreTests : XCTestCase
+@property (nonatomic, strong) NSString * path;
+@property (nonatomic, strong) AEStreamingSampleStore * store;
+@end
+
+@implementation AEStreamingSampleStoreTests
+
+- (void)setUp {
+    self.path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"AEStreamingSampleStoreTests.aiff"];
+    XCTAssertNil([self createTestFile]);
+    self.store = [[AEStreamingSampleStore alloc] initWithHeadDuration:0.1 sampleRate:kSampleRate numberOfChannels:2
+                                                           voiceCount:4 tailBufferDuration:0.25];
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath:self.path error:NULL];
+}
+
+- (void)testLoadsHeadOnly {
+    AEStreamingSample * sample = [self loadSample];
+    XCTAssertNotNil(sample);
+    XCTAssertEqual(sample.length, (UInt32)(kTestFileLength * kSampleRate));
+    XCTAssertEqual(sample.headLength, (UInt32)(0.1 * kSampleRate));
+    XCTAssertEqual(self.store.residentBytes, sample.headLength * 2 * sizeof(float));
+}
+
+- (void)testStreamsTail {
+    AEStreamingSample * sample = [self loadSample];
+
+    // Play through, with render cycles running several times faster than realtime
+    AEStreamingSampleStoreStartVoice(self.store, 1, sample);
+    AudioBufferList * output = AEAudioBufferListCreateWithFormat(AEAudioDescriptionWithChannelsAndRate(2, kSampleRate), kFramesPerCycle);
+    UInt32 position = 0;
+    UInt32 mismatches = 0;
+    while ( AEStreamingSampleStoreVoiceIsPlaying(self.store, 1) ) {
+        UInt32 frames = AEStreamingSampleStoreReadVoice(self.store, 1, output, kFramesPerCycle);
+        for ( int i=0; i<2; i++ ) {
+            for ( UInt32 j=0; j<frames; j++ ) {
+                if ( fabsf(((float *)output->mBuffers[i].mData)[j] - [self valueForFrame:position + j]) > 1.0f/16384.0f ) {
+                    mismatches++;
+                }
+            }
+        }
+        position += frames;
+        usleep(2000);
+    }
+
+    XCTAssertEqual(position, sample.length);
+    XCTAssertEqual(mismatches, 0);
+    XCTAssertEqual(self.store.underrunFrames, 0);
+    XCTAssertEqual(AEStreamingSampleStoreReadVoice(self.store, 1, output, kFramesPerCycle), 0);
+    AEAudioBufferListFree(output);
+}
+
+- (void)testRestartsVoice {
+    AEStreamingSample * sample = [self loadSample];
+    AudioBufferList * output = AEAudioBufferListCreateWithFormat(AEAudioDescriptionWithChannelsAndRate(2, kSampleRate), kFramesPerCycle);
+
+    AEStreamingSampleStoreStartVoice(self.store, 0, sample);
+    for ( int i=0; i<20; i++ ) {
+        AEStreamingSampleStoreReadVoice(self.store, 0, output, kFramesPerCycle);
+        usleep(2000);
+    }
+
+    // Restarting discards the tail streamed for the previous note
+    AEStreamingSampleStoreStartVoice(self.store, 0, sample);
+    XCTAssertEqual(AEStreamingSampleStoreReadVoice(self.store, 0, output, kFramesPerCycle), kFramesPerCycle);
+    XCTAssertEqualWithAccuracy(((float *)output->mBuffers[0].mData)[10], [self valueForFrame:10], 1.0f/16384.0f);
+
+    AEStreamingSampleStoreStopVoice(self.store, 0);
+    XCTAssertFalse(AEStreamingSampleStoreVoiceIsPlaying(self.store, 0));
+    AEAudioBufferListFree(output);
+}
+
+- (void)testConvertsTailSeamlessly {
+    // Convert to another rate, where the head and tail must be converted alike
+    const double sampleRate = 48000.0;
+    self.store = [[AEStreamingSampleStore alloc] initWithHeadDuration:0.1 sampleRate:sampleRate numberOfChannels:2
+                                                           voiceCount:4 tailBufferDuration:0.25];
+    AEStreamingSample * sample = [self loadSample];
+
+    __block AudioBufferList * reference = NULL;
+    __block UInt32 referenceLength = 0;
+    XCTestExpectation * expectation = [self expectationWithDescription:@"load"];
+    [AEAudioFileReader loadFileAtPath:self.path targetAudioDescription:AEAudioDescriptionWithChannelsAndRate(2, sampleRate)
+                      completionBlock:^(AudioBufferList * audio, UInt32 length, NSError * error) {
+        XCTAssertNil(error);
+        reference = audio;
+        referenceLength = length;
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+    XCTAssertTrue(reference != NULL);
+    if ( !reference ) return;
+
+    AEStreamingSampleStoreStartVoice(self.store, 0, sample);
+    AudioBufferList * output = AEAudioBufferListCreateWithFormat(AEAudioDescriptionWithChannelsAndRate(2, sampleRate), kFramesPerCycle);
+    UInt32 position = 0;
+    UInt32 mismatches = 0;
+    while ( AEStreamingSampleStoreVoiceIsPlaying(self.store, 0) ) {
+        UInt32 frames = AEStreamingSampleStoreReadVoice(self.store, 0, output, kFramesPerCycle);
+        for ( int i=0; i<2; i++ ) {
+            for ( UInt32 j=0; j<frames && position + j < referenceLength; j++ ) {
+                if ( fabsf(((float *)output->mBuffers[i].mData)[j] - ((float *)reference->mBuffers[i].mData)[position + j]) > 1.0e-4f ) {
+                    mismatches++;
+                }
+            }
+        }
+        position += frames;
+        usleep(2000);
+    }
+
+    XCTAssertEqual(mismatches, 0);
+    XCTAssertEqual(self.store.underrunFrames, 0);
+    AEAudioBufferListFree(output);
+    AEAudioBufferListFree(reference);
+}
+
+- (AEStreamingSample *)loadSample {
+    __block AEStreamingSample * result = nil;
+    XCTestExpectation * expectation = [self expectationWithDescription:@"load"];
+    [self.store loadSampleAtPath:self.path completionBlock:^(AEStreamingSample * sample, NSError * error) {
+        XCTAssertNil(error);
+        result = sample;
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithTimeout:5.0 handler:nil];
+    return result;
+}
+
+- (float)valueForFrame:(UInt32)frame {
+    return (float)(frame % 1000) / 2000.0f;
+}
+
+- (NSError *)createTestFile {
+    AERenderer * renderer = [AERenderer new];
+
+    AEAudioFileOutput * output = [[AEAudioFileOutput alloc] initWithRenderer:renderer path:self.path type:AEAudioFileTypeAIFFInt16 sampleRate:kSampleRate channelCount:1];
+    __block NSError * error = nil;
+    if ( ![output prepareForWriting:&error] ) {
+        return error;
+    }
+
+    __block UInt32 frame = 0;
+    renderer.block = ^(const AERenderContext * context) {
+        const AudioBufferList * abl = AEBufferStackPushWithChannels(context->stack, 1, 1);
+        float * data = abl->mBuffers[0].mData;
+        for ( UInt32 i=0; i<context->frames; i++ ) {
+            data[i] = [self valueForFrame:frame++];
+        }
+        AERenderContextOutput(context, 1);
+    };
+
+    __block BOOL done = NO;
+    [output runForDuration:kTestFileLength completionBlock:^(NSError * e){
+        done = YES;
+        error = e;
+    }];
+    while ( !done ) {
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+    }
+    [output finishWriting];
+    return error;
+}
+
+@end
@@ -0,0 +1,217 @@
+//
+//  AETimeStretcherTests.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "AETimeStretcher.h"
+#import "AETimePitchModule.h"
+#import "AERenderer.h"
+#import "AEAudioBufferListUtilities.h"
+#import "AETypes.h"
+
+static const double kSampleRate = 44100.0;
+static const double kSineFrequency = 440.0;
+static const float kSineAmplitude = 0.5;
+
+@interface AETimeStretcherTests : XCTestCase
+@end
+
+@implementation AETimeStretcherTests
+
+- (void)testOfflineRateAndPitch {
+    UInt32 frames = kSampleRate * 8;
+    AudioBufferList * input = [self sineWithFrames:frames channels:2];
+    double rates[] = { 0.5, 1.0, 1.7 };
+    double pitches[] = { 0, 1200, -700 };
+    
+    for ( AETimeStretchAlgorithm algorithm = AETimeStretchAlgorithmPhaseVocoder; algorithm <= AETimeStretchAlgorithmWSOLA; algorithm++ ) {
+        for ( int i=0; i<sizeof(rates)/sizeof(rates[0]); i++ ) {
+            for ( int j=0; j<sizeof(pitches)/sizeof(pitches[0]); j++ ) {
+                UInt32 outputFrames;
+                AudioBufferList * output = AETimeStretcherCreateStretchedBufferList(input, frames, kSampleRate, algorithm,
+                                                                                    rates[i], pitches[j], &outputFrames);
+                XCTAssertEqual(outputFrames, (UInt32)ceil(frames / rates[i]));
+                
+                double frequency, rms, maxStep;
+                [self analyse:(float*)output->mBuffers[0].mData + 8192 length:outputFrames - 16384
+                    frequency:&frequency rms:&rms maxStep:&maxStep];
+                double expectedFrequency = kSineFrequency * pow(2.0, pitches[j] / 1200.0);
+                XCTAssertEqualWithAccuracy(frequency, expectedFrequency, expectedFrequency * 0.002,
+                                           @"Algorithm %d, rate %g, pitch %g", (int)algorithm, rates[i], pitches[j]);
+                XCTAssertEqualWithAccuracy(rms, kSineAmplitude / sqrt(2.0), 0.01);
+                
+                // No clicks, including at the joins between concurrently-rendered segments
+                XCTAssertLessThan(maxStep, kSineAmplitude * 2.0 * M_PI * expectedFrequency / kSampleRate * 1.1);
+                
+                AEAudioBufferListFree(output);
+            }
+        }
+    }
+    
+    AEAudioBufferListFree(input);
+}
+
+- (void)testOfflineAlignment {
+    UInt32 frames = kSampleRate;
+    AudioBufferList * input = [self sineWithFrames:frames channels:1];
+    UInt32 outputFrames;
+    AudioBufferList * output = AETimeStretcherCreateStretchedBufferList(input, frames, kSampleRate, AETimeStretchAlgorithmPhaseVocoder,
+                                                                        1.0, 0.0, &outputFrames);
+    
+    float maxError = 0;
+    for ( UInt32 i=0; i<outputFrames-4096; i++ ) {
+        maxError = MAX(maxError, fabsf(((float*)output->mBuffers[0].mData)[i] - ((float*)input->mBuffers[0].mData)[i]));
+    }
+    XCTAssertLessThan(maxError, 1.0e-3);
+    
+    AEAudioBufferListFree(input);
+    AEAudioBufferListFree(output);
+}
+
+- (void)testInputFramesRequiredIsExact {
+    UInt32 frames = kSampleRate * 2;
+    AudioBufferList * input = [self sineWithFrames:frames channels:2];
+    AudioBufferList * output = AEAudioBufferListCreate(1024);
+    
+    for ( AETimeStretchAlgorithm algorithm = AETimeStretchAlgorithmPhaseVocoder; algorithm <= AETimeStretchAlgorithmWSOLA; algorithm++ ) {
+        AETimeStretcher * stretcher = AETimeStretcherNew(2, kSampleRate, algorithm);
+        UInt32 position = 0;
+        for ( int i=0; i<600; i++ ) {
+            AETimeStretcherSetRate(stretcher, 0.3 + (i % 23) / 5.0);
+            AETimeStretcherSetPitch(stretcher, (i / 50) % 3 == 0 ? 0 : ((i % 7) - 3) * 300.0);
+            
+            UInt32 outputFrames = 1 + (i*53) % 1024;
+            UInt32 required = AETimeStretcherGetInputFramesRequired(stretcher, outputFrames);
+            if ( position + required > frames ) position = 0;
+            
+            AEAudioBufferListCopyOnStack(source, input, position);
+            UInt32 inputFrames = required;
+            UInt32 producedFrames = outputFrames;
+            AETimeStretcherProcess(stretcher, source, &inputFrames, output, &producedFrames);
+            position += inputFrames;
+            
+            XCTAssertEqual(inputFrames, required);
+            XCTAssertEqual(producedFrames, outputFrames);
+        }
+        AETimeStretcherFree(stretcher);
+    }
+    
+    AEAudioBufferListFree(input);
+    AEAudioBufferListFree(output);
+}
+
+- (void)testModule {
+    AERenderer * renderer = [AERenderer new];
+    renderer.sampleRate = kSampleRate;
+    AERenderer * subrenderer = [AERenderer new];
+    
+    AETimePitchModule * module = [[AETimePitchModule alloc] initWithRenderer:renderer subrenderer:subrenderer];
+    module.rate = 2.0;
+    module.algorithm = AETimeStretchAlgorithmWSOLA;
+    XCTAssertEqual(subrenderer.sampleRate, kSampleRate);
+    XCTAssertTrue(subrenderer.flags & AERendererContextFlagIsVariableRate);
+    
+    __block UInt32 inputPosition = 0;
+    subrenderer.block = ^(const AERenderContext * context) {
+        XCTAssertTrue(context->flags & AERendererContextFlagIsVariableRate);
+        XCTAssertEqual(context->timestamp->mSampleTime, inputPosition);
+        const AudioBufferList * abl = AEBufferStackPushWithChannels(context->stack, 1, 2);
+        if ( !abl ) return;
+        for ( int i=0; i<context->frames; i++, inputPosition++ ) {
+            float sample = kSineAmplitude * sin(2.0 * M_PI * kSineFrequency * inputPosition / kSampleRate);
+            ((float*)abl->mBuffers[0].mData)[i] = sample;
+            ((float*)abl->mBuffers[1].mData)[i] = sample;
+        }
+        AERenderContextOutput(context, 1);
+    };
+    renderer.block = ^(const AERenderContext * context) {
+        AEModuleProcess(module, context);
+        AERenderContextOutput(context, 1);
+    };
+    
+    AudioBufferList * abl = AEAudioBufferListCreate(512);
+    AudioTimeStamp timestamp = { .mFlags = kAudioTimeStampSampleTimeValid, .mSampleTime = 0 };
+    UInt32 outputPosition = 0;
+    for ( int i=0; i<200; i++ ) {
+        AERendererRun(renderer, abl, 512, &timestamp);
+        timestamp.mSampleTime += 512;
+        outputPosition += 512;
+    }
+    
+    // The sub-renderer is pulled at twice the rate, and no further than needed
+    XCTAssertEqualWithAccuracy(inputPosition, outputPosition * 2.0, 2048);
+    
+    AEAudioBufferListFree(abl);
+}
+
+- (void)testPhaseVocoderPerformance {
+    [self measureAlgorithm:AETimeStretchAlgorithmPhaseVocoder];
+}
+
+- (void)testWSOLAPerformance {
+    [self measureAlgorithm:AETimeStretchAlgorithmWSOLA];
+}
+
+#pragma mark - Helpers
+
+- (void)measureAlgorithm:(AETimeStretchAlgorithm)algorithm {
+    UInt32 frames = kSampleRate * 10;
+    AudioBufferList * input = [self sineWithFrames:frames channels:2];
+    AudioBufferList * output = AEAudioBufferListCreate(512);
+    AETimeStretcher * stretcher = AETimeStretcherNew(2, kSampleRate, algorithm);
+    AETimeStretcherSetRate(stretcher, 0.8);
+    
+    [self measureBlock:^{
+        // Render ten seconds of output, in 512-frame slices
+        AETimeStretcherReset(stretcher);
+        UInt32 position = 0;
+        for ( UInt32 produced = 0; produced < frames; produced += 512 ) {
+            UInt32 required = AETimeStretcherGetInputFramesRequired(stretcher, 512);
+            if ( position + required > frames ) position = 0;
+            AEAudioBufferListCopyOnStack(source, input, position);
+            UInt32 outputFrames = 512;
+            AETimeStretcherProcess(stretcher, source, &required, output, &outputFrames);
+            position += required;
+        }
+    }];
+    
+    AETimeStretcherFree(stretcher);
+    AEAudioBufferListFree(input);
+    AEAudioBufferListFree(output);
+}
+
+- (AudioBufferList *)sineWithFrames:(UInt32)frames channels:(int)channels {
+    AudioBufferList * abl = AEAudioBufferListCreateWithFormat(AEAudioDescriptionWithChannelsAndRate(channels, kSampleRate), frames);
+    for ( int channel=0; channel<channels; channel++ ) {
+        float * samples = (float*)abl->mBuffers[channel].mData;
+        for ( UInt32 i=0; i<frames; i++ ) {
+            samples[i] = kSineAmplitude * sin(2.0 * M_PI * kSineFrequency * i / kSampleRate);
+        }
+    }
+    return abl;
+}
+
+- (void)analyse:(const float *)samples length:(UInt32)length frequency:(double *)frequency rms:(double *)rms maxStep:(double *)maxStep {
+    // Estimate frequency from upward zero crossings
+    int crossings = 0;
+    UInt32 first = 0, last = 0;
+    double sum = 0;
+    *maxStep = 0;
+    for ( UInt32 i=1; i<length; i++ ) {
+        if ( samples[i-1] < 0 && samples[i] >= 0 ) {
+            if ( crossings == 0 ) first = i;
+            last = i;
+            crossings++;
+        }
+        sum += samples[i] * samples[i];
+        *maxStep = MAX(*maxStep, fabsf(samples[i] - samples[i-1]));
+    }
+    *frequency = crossings > 1 ? (crossings-1) * kSampleRate / (double)(last - first) : 0;
+    *rms = sqrt(sum / (length-1));
+}
+
+@end
@@ -0,0 +1,109 @@
+//
+//  AETripleBufferTests.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "AETripleBuffer.h"
+
+typedef struct {
+    int sequence;
+    float coefficients[31];
+} AETripleBufferTestState;
+
+@interface AETripleBufferTests : XCTestCase
+@end
+
+@implementation AETripleBufferTests
+
+- (void)testLatestValueWins {
+    AETripleBufferTestState state = { .sequence = 1 };
+    AETripleBuffer * buffer = [[AETripleBuffer alloc] initWithSize:sizeof(state) initialValue:&state];
+    
+    BOOL changed = NO;
+    const AETripleBufferTestState * value = AETripleBufferRead(buffer, &changed);
+    XCTAssertTrue(changed);
+    XCTAssertEqual(value->sequence, 1);
+    
+    value = AETripleBufferRead(buffer, &changed);
+    XCTAssertFalse(changed);
+    XCTAssertEqual(value->sequence, 1);
+    
+    for ( int i=2; i<=5; i++ ) {
+        state.sequence = i;
+        [buffer writeBytes:&state];
+    }
+    
+    value = AETripleBufferRead(buffer, &changed);
+    XCTAssertTrue(changed);
+    XCTAssertEqual(value->sequence, 5);
+    
+    // The value held by the reader is untouched by further writes
+    state.sequence = 6;
+    [buffer writeBytes:&state];
+    state.sequence = 7;
+    [buffer writeBytes:&state];
+    XCTAssertEqual(value->sequence, 5);
+    
+    value = AETripleBufferRead(buffer, &changed);
+    XCTAssertTrue(changed);
+    XCTAssertEqual(value->sequence, 7);
+}
+
+- (void)testUpdateWithBlock {
+    AETripleBuffer * buffer = [[AETripleBuffer alloc] initWithSize:sizeof(AETripleBufferTestState) initialValue:NULL];
+    XCTAssertEqual(((const AETripleBufferTestState *)AETripleBufferRead(buffer, NULL))->sequence, 0);
+    
+    for ( int i=0; i<10; i++ ) {
+        [buffer updateWithBlock:^(void * value) {
+            ((AETripleBufferTestState *)value)->sequence++;
+            ((AETripleBufferTestState *)value)->coefficients[i] = i;
+        }];
+    }
+    
+    const AETripleBufferTestState * value = AETripleBufferRead(buffer, NULL);
+    XCTAssertEqual(value->sequence, 10);
+    for ( int i=0; i<10; i++ ) {
+        XCTAssertEqual(value->coefficients[i], (float)i);
+    }
+}
+
+- (void)testConcurrentAccess {
+    AETripleBuffer * buffer = [[AETripleBuffer alloc] initWithSize:sizeof(AETripleBufferTestState) initialValue:NULL];
+    const int count = 200000;
+    
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INTERACTIVE, 0), ^{
+        for ( int i=1; i<=count; i++ ) {
+            AETripleBufferTestState * state = AETripleBufferGetWriteBuffer(buffer);
+            state->sequence = i;
+            for ( int j=0; j<31; j++ ) {
+                state->coefficients[j] = i * (j+1);
+            }
+            AETripleBufferPublish(buffer);
+        }
+    });
+    
+    // Every value read must be complete, and sequences never go backwards
+    int torn = 0;
+    int regressions = 0;
+    int last = 0;
+    NSDate * timeout = [NSDate dateWithTimeIntervalSinceNow:10.0];
+    while ( last < count && [timeout timeIntervalSinceNow] > 0 ) {
+        BOOL changed;
+        const AETripleBufferTestState * state = AETripleBufferRead(buffer, &changed);
+        for ( int j=0; j<31; j++ ) {
+            if ( state->coefficients[j] != (float)(state->sequence * (j+1)) ) torn++;
+        }
+        if ( state->sequence < last || (!changed && state->sequence != last) ) regressions++;
+        last = state->sequence;
+    }
+    
+    XCTAssertEqual(last, count);
+    XCTAssertEqual(torn, 0);
+    XCTAssertEqual(regressions, 0);
+}
+
+@end
@@ -0,0 +1,193 @@
+//
+//  AEVarispeedModuleTests.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+
+#import <XCTest/XCTest.h>
+#import "AEVarispeedModule.h"
+#import "AERenderer.h"
+#import "AEAudioBufferListUtilities.h"
+#import "AETypes.h"
+
+static const double kSampleRate = 44100.0;
+static const double kSineFrequency = 440.0;
+static const float kSineAmplitude = 0.5;
+static const UInt32 kSliceFrames = 512;
+
+@interface AEVarispeedModuleTests : XCTestCase
+@end
+
+@implementation AEVarispeedModuleTests
+
+- (void)testRateAndPull {
+    AEResamplerQuality qualities[] = { AEResamplerQualityLinear, AEResamplerQualityCubic, AEResamplerQualityHigh };
+    
+    for ( int q=0; q<sizeof(qualities)/sizeof(qualities[0]); q++ ) {
+        AERenderer * renderer = [AERenderer new];
+        renderer.sampleRate = kSampleRate;
+        AERenderer * subrenderer = [AERenderer new];
+        UInt32 inputPosition = 0;
+        subrenderer.block = [self sineBlockWithPosition:&inputPosition];
+        
+        AEVarispeedModule * module = [[AEVarispeedModule alloc] initWithRenderer:renderer subrenderer:subrenderer];
+        module.quality = qualities[q];
+        module.playbackRate = 1.5;
+        XCTAssertEqual(subrenderer.sampleRate, kSampleRate);
+        XCTAssertTrue(subrenderer.flags & AERendererContextFlagIsVariableRate);
+        
+        UInt32 frames = kSliceFrames * 100;
+        AudioBufferList * output = [self renderModule:module withRenderer:renderer frames:frames];
+        
+        // The sub-renderer is pulled at the playback rate, allowing for the glide from the initial rate
+        // over the first slice, and the interpolator's lookahead
+        XCTAssertEqualWithAccuracy(inputPosition, frames * 1.5, kSliceFrames / 2, @"Quality %d", (int)qualities[q]);
+        
+        double frequency, maxStep;
+        [self analyse:(float*)output->mBuffers[0].mData + 1024 length:frames - 1024 frequency:&frequency maxStep:&maxStep];
+        XCTAssertEqualWithAccuracy(frequency, kSineFrequency * 1.5, 1.0, @"Quality %d", (int)qualities[q]);
+        AEAudioBufferListFree(output);
+    }
+}
+
+- (void)testPlaybackCents {
+    AERenderer * renderer = [AERenderer new];
+    renderer.sampleRate = kSampleRate;
+    AERenderer * subrenderer = [AERenderer new];
+    UInt32 inputPosition = 0;
+    subrenderer.block = [self sineBlockWithPosition:&inputPosition];
+    
+    AEVarispeedModule * module = [[AEVarispeedModule alloc] initWithRenderer:renderer subrenderer:subrenderer];
+    module.playbackRate = 0.5;
+    module.playbackCents = 1200;
+    
+    UInt32 frames = kSliceFrames * 100;
+    AudioBufferList * output = [self renderModule:module withRenderer:renderer frames:frames];
+    
+    double frequency, maxStep;
+    [self analyse:(float*)output->mBuffers[0].mData + 1024 length:frames - 1024 frequency:&frequency maxStep:&maxStep];
+    XCTAssertEqualWithAccuracy(frequency, kSineFrequency, 1.0);
+    AEAudioBufferListFree(output);
+}
+
+- (void)testRateChangesGlide {
+    AERenderer * renderer = [AERenderer new];
+    renderer.sampleRate = kSampleRate;
+    AERenderer * subrenderer = [AERenderer new];
+    UInt32 inputPosition = 0;
+    subrenderer.block = [self sineBlockWithPosition:&inputPosition];
+    AEVarispeedModule * module = [[AEVarispeedModule alloc] initWithRenderer:renderer subrenderer:subrenderer];
+    
+    __block int slice = 0;
+    renderer.block = ^(const AERenderContext * context) {
+        // Jump between a stop and double speed, as when scratching
+        module.playbackRate = (slice++ % 8) < 4 ? 0.0 : 2.0;
+        AEModuleProcess(module, context);
+        AERenderContextOutput(context, 1);
+    };
+    
+    UInt32 frames = kSliceFrames * 64;
+    AudioBufferList * output = AEAudioBufferListCreate(frames);
+    AudioTimeStamp timestamp = { .mFlags = kAudioTimeStampSampleTimeValid, .mSampleTime = 0 };
+    for ( UInt32 position = 0; position < frames; position += kSliceFrames ) {
+        AEAudioBufferListCopyOnStack(target, output, position);
+        AERendererRun(renderer, target, kSliceFrames, &timestamp);
+        timestamp.mSampleTime += kSliceFrames;
+    }
+    
+    // The largest step between samples is no greater than that of the sine at double speed
+    double frequency, maxStep;
+    [self analyse:(float*)output->mBuffers[0].mData length:frames frequency:&frequency maxStep:&maxStep];
+    XCTAssertLessThan(maxStep, kSineAmplitude * 2.0 * M_PI * kSineFrequency * 2.0 / kSampleRate * 1.1);
+    AEAudioBufferListFree(output);
+}
+
+- (void)testManyDecksPerformance {
+    // Thirty-two decks with cubic interpolation, each at a continuously changing rate
+    const int kDecks = 32;
+    AERenderer * renderer = [AERenderer new];
+    renderer.sampleRate = kSampleRate;
+    NSMutableArray * modules = [NSMutableArray array];
+    for ( int i=0; i<kDecks; i++ ) {
+        AERenderer * subrenderer = [AERenderer new];
+        subrenderer.block = ^(const AERenderContext * context) {
+            AEBufferStackPushWithChannels(context->stack, 1, 2);
+            AERenderContextOutput(context, 1);
+        };
+        [modules addObject:[[AEVarispeedModule alloc] initWithRenderer:renderer subrenderer:subrenderer]];
+    }
+    
+    __block int slice = 0;
+    renderer.block = ^(const AERenderContext * context) {
+        slice++;
+        for ( int i=0; i<kDecks; i++ ) {
+            AEVarispeedModule * module = modules[i];
+            module.playbackRate = 1.0 + 0.9 * sin(slice * 0.1 + i);
+            AEModuleProcess(module, context);
+            AERenderContextOutput(context, 1);
+        }
+    };
+    
+    AudioBufferList * output = AEAudioBufferListCreate(kSliceFrames);
+    [self measureBlock:^{
+        // Ten seconds of audio
+        AudioTimeStamp timestamp = { .mFlags = kAudioTimeStampSampleTimeValid, .mSampleTime = 0 };
+        for ( UInt32 position = 0; position < kSampleRate * 10; position += kSliceFrames ) {
+            AERendererRun(renderer, output, kSliceFrames, &timestamp);
+            timestamp.mSampleTime += kSliceFrames;
+        }
+    }];
+    AEAudioBufferListFree(output);
+}
+
+#pragma mark - Helpers
+
+- (AERenderLoopBlock)sineBlockWithPosition:(UInt32 *)position {
+    return ^(const AERenderContext * context) {
+        XCTAssertEqual(context->timestamp->mSampleTime, *position);
+        const AudioBufferList * abl = AEBufferStackPushWithChannels(context->stack, 1, 2);
+        if ( !abl ) return;
+        for ( int i=0; i<context->frames; i++, (*position)++ ) {
+            float sample = kSineAmplitude * sin(2.0 * M_PI * kSineFrequency * *position / kSampleRate);
+            ((float*)abl->mBuffers[0].mData)[i] = sample;
+            ((float*)abl->mBuffers[1].mData)[i] = sample;
+        }
+        AERenderContextOutput(context, 1);
+    };
+}
+
+- (AudioBufferList *)renderModule:(AEVarispeedModule *)module withRenderer:(AERenderer *)renderer frames:(UInt32)frames {
+    renderer.block = ^(const AERenderContext * context) {
+        AEModuleProcess(module, context);
+        AERenderContextOutput(context, 1);
+    };
+    
+    AudioBufferList * output = AEAudioBufferListCreate(frames);
+    AudioTimeStamp timestamp = { .mFlags = kAudioTimeStampSampleTimeValid, .mSampleTime = 0 };
+    for ( UInt32 position = 0; position < frames; position += kSliceFrames ) {
+        AEAudioBufferListCopyOnStack(target, output, position);
+        AERendererRun(renderer, target, kSliceFrames, &timestamp);
+        timestamp.mSampleTime += kSliceFrames;
+    }
+    return output;
+}
+
+- (void)analyse:(const float *)samples length:(UInt32)length frequency:(double *)frequency maxStep:(double *)maxStep {
+    // Estimate frequency from upward zero crossings
+    int crossings = 0;
+    UInt32 first = 0, last = 0;
+    *maxStep = 0;
+    for ( UInt32 i=1; i<length; i++ ) {
+        if ( samples[i-1] < 0 && samples[i] >= 0 ) {
+            if ( crossings == 0 ) first = i;
+            last = i;
+            crossings++;
+        }
+        *maxStep = MAX(*maxStep, fabsf(samples[i] - samples[i-1]));
+    }
+    *frequency = crossings > 1 ? (crossings-1) * kSampleRate / (double)(last - first) : 0;
+}
+
+@end
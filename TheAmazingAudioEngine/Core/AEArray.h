@@ -56,6 +56,11 @@ typedef const void * AEArrayToken; //!< Token for real-thread use
  *  Remember to use the __unsafe_unretained directive to avoid ARC-triggered retains on the
  *  audio thread if using this class to manage Objective-C objects, and only interact with such objects
  *  via C functions they provide, not via Objective-C methods.
+ *
+ *  Each version of the array is stored as a table of fixed-size chunks, shared between versions.
+ *  The @link addObject: @endlink, @link insertObject:atIndex: @endlink, @link removeObject: @endlink,
+ *  @link removeObjectAtIndex: @endlink and @link replaceObjectAtIndex:withObject: @endlink methods
+ *  copy only the affected chunk, so small changes to large arrays are cheap.
  */
 @interface AEArray<ObjectType> : NSObject <NSFastEnumeration>
 
@@ -123,6 +128,28 @@ typedef void (^AEArrayReleaseBlock)(ObjectType _Nonnull item, void * _Nonnull pt
  */
 - (instancetype _Nullable)initWithCustomMapping:(AEArrayCustomMappingBlock _Nullable)block;
 
+/*!
+ * Inline storage initializer
+ *
+ *  This stores a fixed-size item for each object inline within the array's own storage, contiguously,
+ *  instead of as a pointer to a separate allocation. The audio thread can then visit items with a linear
+ *  scan, without chasing a pointer per item.
+ *
+ *  The mapping block is used as with @link initWithCustomMapping: @endlink, but the itemSize bytes it
+ *  returns are copied into the array, and the returned memory is then freed. If no mapping block is given,
+ *  items start zero-filled.
+ *
+ *  Items are copied whenever the part of the array holding them changes, so the pointers obtained on the
+ *  audio thread are only valid for the current token, and items should be treated as read-only on the audio
+ *  thread. Use @link updatePointerValue:forObject: @endlink to change an item. If you provide a
+ *  @link releaseBlock @endlink, it's called with the final copy of each item as it leaves the array;
+ *  the item's storage itself is managed by the array.
+ *
+ * @param itemSize Size, in bytes, of each item
+ * @param block The block mapping between objects and stored information, or nil
+ */
+- (instancetype _Nullable)initWithInlineItemSize:(size_t)itemSize customMapping:(AEArrayCustomMappingBlock _Nullable)block;
+
 /*!
  * Update the array by copying the contents of the given NSArray
  *
@@ -130,6 +157,7 @@ typedef void (^AEArrayReleaseBlock)(ObjectType _Nonnull item, void * _Nonnull pt
  *  If you have provided a custom mapping when initializing the instance, the custom mapping
  *  block will be called for all new values. Values in the new array that are also present in
  *  the prior array value will be maintained, and old values not present in the new array are released.
+ *  Objects are matched by identity, via a hash table, so updates take time proportional to the array size.
  *
  *  Using this method within an AEManagedValue
  *  @link AEManagedValue::performAtomicBatchUpdate: performAtomicBatchUpdate @endlink block
@@ -183,6 +211,76 @@ typedef void (^AEArrayReleaseBlock)(ObjectType _Nonnull item, void * _Nonnull pt
                     customMapping:(AEArrayIndexedCustomMappingBlock _Nullable)block
                   completionBlock:(void(^ _Nullable)(void))completionBlock;
 
+/*!
+ * Add an object to the end of the array
+ *
+ *  Only the last chunk of the array is copied, rather than the whole array. If you have
+ *  provided a custom mapping when initializing the instance, it will be called for the object,
+ *  unless the object is already in the array, in which case its existing value is shared.
+ *
+ *  Using this method within an AEManagedValue
+ *  @link AEManagedValue::performAtomicBatchUpdate: performAtomicBatchUpdate @endlink block
+ *  will cause the update to occur atomically along with any other value updates.
+ *
+ * @param object The object to add
+ */
+- (void)addObject:(ObjectType _Nonnull)object;
+
+/*!
+ * Add an object to the end of the array, with custom mapping
+ *
+ *  See @link addObject: @endlink and
+ *  @link updateWithContentsOfArray:customMapping: updateWithContentsOfArray:customMapping: @endlink.
+ *
+ * @param object The object to add
+ * @param block The block mapping between objects and stored information
+ */
+- (void)addObject:(ObjectType _Nonnull)object customMapping:(AEArrayIndexedCustomMappingBlock _Nullable)block;
+
+/*!
+ * Insert an object at the given index
+ *
+ *  Only the chunk containing the index is copied, rather than the whole array.
+ *
+ * @param object The object to insert
+ * @param index The index, from 0 to count inclusive
+ */
+- (void)insertObject:(ObjectType _Nonnull)object atIndex:(int)index;
+
+/*!
+ * Insert an object at the given index, with custom mapping
+ *
+ * @param object The object to insert
+ * @param index The index, from 0 to count inclusive
+ * @param block The block mapping between objects and stored information
+ */
+- (void)insertObject:(ObjectType _Nonnull)object atIndex:(int)index customMapping:(AEArrayIndexedCustomMappingBlock _Nullable)block;
+
+/*!
+ * Remove an object from the array
+ *
+ *  The object is matched by identity. If it appears more than once, one occurrence is removed.
+ *  Its value is released in a thread-safe manner once no longer in use.
+ *
+ * @param object The object to remove
+ */
+- (void)removeObject:(ObjectType _Nonnull)object;
+
+/*!
+ * Remove the object at the given index
+ *
+ * @param index The index
+ */
+- (void)removeObjectAtIndex:(int)index;
+
+/*!
+ * Replace the object at the given index
+ *
+ * @param index The index
+ * @param object The new object
+ */
+- (void)replaceObjectAtIndex:(int)index withObject:(ObjectType _Nonnull)object;
+
 /*!
  * Get the pointer value at the given index of the C array, as seen by the audio thread
  *
@@ -202,6 +300,8 @@ typedef void (^AEArrayReleaseBlock)(ObjectType _Nonnull item, void * _Nonnull pt
 /*!
  * Get the pointer value associated with the given object, if any
  *
+ *  The object is matched by identity, in constant time.
+ *
  *  This method allows you to access the same values as the audio thread; if you are using
  *  a mapping block to create structures that correspond to objects in the original array,
  *  for instance, then you may access these structures using this method.
@@ -238,6 +338,9 @@ typedef void (^AEArrayReleaseBlock)(ObjectType _Nonnull item, void * _Nonnull pt
  *  The prior value associated with this object will be released, possibly calling your
  *  @link releaseBlock @endlink, if one is provided.
  *
+ *  For arrays with inline storage, the item's bytes are copied from the given pointer, which
+ *  remains yours to free.
+ *
  * @param value The new pointer value
  * @param object The associated object
  */
@@ -285,12 +388,71 @@ int AEArrayGetCount(AEArrayToken _Nullable token);
 /*!
  * Get the item at a given index
  *
+ *  This locates the chunk holding the item by binary search; to visit every item, use
+ *  an iterator or one of the enumeration macros instead.
+ *
  * @param token The array token, as returned from AEArrayGetToken
  * @param index The item index
  * @return Item at the given index
  */
 void * _Nullable AEArrayGetItem(AEArrayToken _Nullable token, int index);
 
+/*!
+ * Iterator, for visiting each item in the array in turn on the audio thread
+ */
+typedef struct {
+    AEArrayToken _Nullable token;
+    void * _Nullable const * _Nullable items; //!< Items of the current chunk, for arrays without inline storage
+    char * _Nullable item;  //!< The current item
+    size_t stride;  //!< Item size, for arrays with inline storage, which are visited in place; otherwise 0
+    int count;      //!< Number of items in the current chunk
+    int index;      //!< Index within the current chunk
+    int chunk;      //!< Current chunk
+    int remaining;  //!< Number of items left, including the current one
+} AEArrayIterator;
+
+/*!
+ * Get an iterator positioned at the first item of the array
+ *
+ * @param token The array token, as returned from AEArrayGetToken
+ * @return The iterator
+ */
+AEArrayIterator AEArrayGetIterator(AEArrayToken _Nullable token);
+
+/*!
+ * Advance the iterator to the start of the next chunk
+ *
+ *  Used by AEArrayIteratorNext; you shouldn't need to call this directly.
+ *
+ * @param iterator The iterator
+ * @return The first item of the next chunk
+ */
+void * _Nullable AEArrayIteratorNextChunk(AEArrayIterator * _Nonnull iterator);
+
+/*!
+ * Get the item at the iterator's current position
+ *
+ * @param iterator The iterator
+ * @return The current item, or NULL if the iterator has passed the end of the array
+ */
+static inline void * _Nullable AEArrayIteratorGetItem(const AEArrayIterator * _Nonnull iterator) {
+    return iterator->remaining > 0 ? iterator->item : NULL;
+}
+
+/*!
+ * Advance the iterator to the next item
+ *
+ * @param iterator The iterator
+ * @return The next item, or NULL if the iterator has passed the end of the array
+ */
+static inline void * _Nullable AEArrayIteratorNext(AEArrayIterator * _Nonnull iterator) {
+    if ( --iterator->remaining <= 0 ) return NULL;
+    if ( ++iterator->index < iterator->count ) {
+        return iterator->item = iterator->stride ? iterator->item + iterator->stride : (char *)iterator->items[iterator->index];
+    }
+    return AEArrayIteratorNextChunk(iterator);
+}
+
 /*!
  * Enumerate object types in the array, for use on audio thread
  *
@@ -334,12 +496,10 @@ void * _Nullable AEArrayGetItem(AEArrayToken _Nullable token, int index);
  * @param varname Name of object variable for inner loop
  */
 #define AEArrayEnumerateObjectsToken(token, type, varname) \
-    int __AEArrayVar(count, __LINE__) = AEArrayGetCount(token); \
-    int __AEArrayVar(i, __LINE__) = 0; \
-    for ( __unsafe_unretained type varname = __AEArrayVar(count, __LINE__) > 0 ? (__bridge type)AEArrayGetItem(token, 0) : NULL; \
-          __AEArrayVar(i, __LINE__) < __AEArrayVar(count, __LINE__); \
-          __AEArrayVar(i, __LINE__)++, varname = __AEArrayVar(i, __LINE__) < __AEArrayVar(count, __LINE__) ? \
-            (__bridge type)AEArrayGetItem(token, __AEArrayVar(i, __LINE__)) : NULL )
+    AEArrayIterator __AEArrayVar(iterator, __LINE__) = AEArrayGetIterator(token); \
+    for ( __unsafe_unretained type varname = (__bridge type)AEArrayIteratorGetItem(&__AEArrayVar(iterator, __LINE__)); \
+          __AEArrayVar(iterator, __LINE__).remaining > 0; \
+          varname = (__bridge type)AEArrayIteratorNext(&__AEArrayVar(iterator, __LINE__)) )
 
 /*!
  * Enumerate pointer types in the array, for use on audio thread
@@ -386,12 +546,10 @@ void * _Nullable AEArrayGetItem(AEArrayToken _Nullable token, int index);
  * @param varname Name of pointer variable for inner loop
  */
 #define AEArrayEnumeratePointersToken(token, type, varname) \
-    int __AEArrayVar(count, __LINE__) = AEArrayGetCount(token); \
-    int __AEArrayVar(i, __LINE__) = 0; \
-    for ( type varname = __AEArrayVar(count, __LINE__) > 0 ? (type)AEArrayGetItem(token, 0) : NULL; \
-          __AEArrayVar(i, __LINE__) < __AEArrayVar(count, __LINE__); \
-          __AEArrayVar(i, __LINE__)++, varname = __AEArrayVar(i, __LINE__) < __AEArrayVar(count, __LINE__) ? \
-            (type)AEArrayGetItem(token, __AEArrayVar(i, __LINE__)) : NULL )
+    AEArrayIterator __AEArrayVar(iterator, __LINE__) = AEArrayGetIterator(token); \
+    for ( type varname = (type)AEArrayIteratorGetItem(&__AEArrayVar(iterator, __LINE__)); \
+          __AEArrayVar(iterator, __LINE__).remaining > 0; \
+          varname = (type)AEArrayIteratorNext(&__AEArrayVar(iterator, __LINE__)) )
 
 
 //! Number of values in array
@@ -401,7 +559,8 @@ void * _Nullable AEArrayGetItem(AEArrayToken _Nullable token, int index);
 @property (nonatomic, strong, readonly) NSArray <ObjectType> * _Nonnull allValues;
 
 //! Block to perform when deleting old items, on main thread. If not specified, will simply use
-//! free() to dispose bytes, if pointer differs from original Objective-C pointer.
+//! free() to dispose bytes, if pointer differs from original Objective-C pointer (or nothing, for
+//! inline storage).
 @property (nonatomic, copy) AEArrayReleaseBlock _Nullable releaseBlock;
 
 /*!
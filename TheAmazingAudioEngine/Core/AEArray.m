@@ -24,25 +24,77 @@
 //  3. This notice may not be removed or altered from any source distribution.
 //
 
+
 #import "AEArray.h"
 #import "AEManagedValue.h"
 
+#define kChunkCapacity 64
+
+typedef struct __array_chunk_t array_chunk_t;
+
 typedef struct {
     void * pointer;
-    int referenceCount;
+    void * object;
+    int referenceCount;     // Number of chunks containing this entry
+    int occurrences;        // Number of times this entry appears in the current array (main thread only)
+    BOOL retainsObject;
+    array_chunk_t * chunk;  // Chunk of the current array this entry was last placed in (main thread only)
 } array_entry_t;
 
+struct __array_chunk_t {
+    int referenceCount;     // Number of array versions containing this chunk
+    int count;
+    int capacity;           // Chunks are never extended once in use, so this is usually the count
+    array_entry_t ** entries;
+    void ** objects;
+    void ** pointers;       // Item values, as seen by the audio thread
+    char * payload;         // Inline item storage, for arrays with an item size
+};
+
 typedef struct {
     int count;
-    __unsafe_unretained NSPointerArray * objects;
-    array_entry_t * entries[1];
+    int chunkCount;
+    size_t itemSize;
+    int * offsets;          // Index of the first item of each chunk
+    array_chunk_t * chunks[1];
 } array_t;
 
+typedef struct {
+    void * object;
+    array_entry_t * entry;
+} array_index_entry_t;
+
+typedef struct {
+    uintptr_t mask;
+    int count;
+    array_index_entry_t * entries;
+} array_index_t;
+
+static array_t * AEArrayCreate(int chunkCount, size_t itemSize);
+static array_t * AEArrayCreateReplacingChunks(const array_t * array, int start, int replaceCount, array_chunk_t ** chunks, int chunkCount);
+static void AEArrayUpdateOffsets(array_t * array);
+static int AEArrayFindChunk(const array_t * array, int index);
+static BOOL AEArrayFindEntry(const array_t * array, const array_entry_t * entry, int * outChunk, int * outSlot);
+static BOOL AEArrayMatchesObjects(const array_t * array, NSArray * objects);
+static void AEArrayRelease(array_t * array, AEArrayReleaseBlock releaseBlock);
+static array_chunk_t * AEArrayChunkCreate(int capacity, size_t itemSize);
+static void AEArrayChunkAppend(array_chunk_t * chunk, array_entry_t * entry, void * pointer, size_t itemSize);
+static int AEArrayChunksCreate(array_entry_t ** entries, void ** pointers, int count, size_t itemSize, array_chunk_t ** outChunks);
+static void AEArrayIndexInit(array_index_t * index, int count);
+static array_entry_t * AEArrayIndexGet(const array_index_t * index, void * object);
+static void AEArrayIndexSet(array_index_t * index, void * object, array_entry_t * entry);
+static void AEArrayIndexRemove(array_index_t * index, void * object);
+
 @interface AEArrayManagedValue : AEManagedValue
 @property (nonatomic, copy) AEArrayReleaseBlock arrayReleaseBlock;
 @end
 
-@interface AEArray ()
+@interface AEArray () {
+    array_index_t _index;
+    unsigned long _mutations;
+    size_t _itemSize;
+    void * _scratch;
+}
 @property (nonatomic, strong) AEArrayManagedValue * value;
 @property (nonatomic, copy) void*(^mappingBlock)(id item);
 @end
@@ -55,18 +107,31 @@ typedef struct {
 }
 
 - (instancetype)initWithCustomMapping:(AEArrayCustomMappingBlock)block {
+    return [self initWithInlineItemSize:0 customMapping:block];
+}
+
+- (instancetype)initWithInlineItemSize:(size_t)itemSize customMapping:(AEArrayCustomMappingBlock)block {
     if ( !(self = [super init]) ) return nil;
     self.mappingBlock = block;
     
+    _itemSize = itemSize;
+    if ( itemSize ) {
+        _scratch = calloc(1, itemSize);
+    }
+    
     self.value = [AEArrayManagedValue new];
     
-    array_t * array = (array_t*)calloc(1, sizeof(array_t));
-    array->count = 0;
-    self.value.pointerValue = array;
+    AEArrayIndexInit(&_index, 0);
+    self.value.pointerValue = AEArrayCreate(0, itemSize);
     
     return self;
 }
 
+- (void)dealloc {
+    free(_index.entries);
+    free(_scratch);
+}
+
 - (void)setReleaseBlock:(AEArrayReleaseBlock)releaseBlock {
     _releaseBlock = releaseBlock;
     self.value.arrayReleaseBlock = releaseBlock;
@@ -82,7 +147,13 @@ typedef struct {
 
 - (NSArray *)allValues {
     array_t * array = (array_t*)_value.pointerValue;
-    return array->objects ? array->objects.allObjects : @[];
+    NSMutableArray * values = [NSMutableArray arrayWithCapacity:array->count];
+    for ( int i=0; i<array->chunkCount; i++ ) {
+        for ( int j=0; j<array->chunks[i]->count; j++ ) {
+            [values addObject:(__bridge id)array->chunks[i]->objects[j]];
+        }
+    }
+    return values;
 }
 
 - (int)count {
@@ -91,33 +162,41 @@ typedef struct {
 }
 
 - (NSUInteger)countByEnumeratingWithState:(NSFastEnumerationState *)state objects:(id __unsafe_unretained [])buffer count:(NSUInteger)len {
+    // Enumerate a chunk at a time, straight from the chunk's object list
     array_t * array = (array_t*)_value.pointerValue;
-    return [array->objects countByEnumeratingWithState:state objects:buffer count:len];
+    if ( state->state == 0 ) {
+        state->mutationsPtr = &_mutations;
+    }
+    if ( state->state >= array->chunkCount ) return 0;
+    array_chunk_t * chunk = array->chunks[state->state++];
+    state->itemsPtr = (__unsafe_unretained id *)(void *)chunk->objects;
+    return chunk->count;
 }
 
 - (id)objectAtIndexedSubscript:(NSUInteger)idx {
     array_t * array = (array_t*)_value.pointerValue;
-    return [array->objects pointerAtIndex:idx];
+    if ( idx >= array->count ) return nil;
+    int chunk = AEArrayFindChunk(array, (int)idx);
+    return (__bridge id)array->chunks[chunk]->objects[idx - array->offsets[chunk]];
 }
 
 - (void *)pointerValueAtIndex:(int)index {
     array_t * array = (array_t*)_value.pointerValue;
-    return index < array->count ? array->entries[index]->pointer : NULL;
+    return index >= 0 && index < array->count ? AEArrayGetItem(array, index) : NULL;
 }
 
 - (void *)pointerValueForObject:(id)object {
-    array_t * array = (array_t*)_value.pointerValue;
-    if ( !array->objects ) return NULL;
-    NSUInteger index = [array->objects.allObjects indexOfObject:object];
-    if ( index == NSNotFound ) return NULL;
-    return [self pointerValueAtIndex:(int)index];
+    array_entry_t * entry = AEArrayIndexGet(&_index, (__bridge void*)object);
+    return entry ? entry->pointer : NULL;
 }
 
 - (id)objectForPointerValue:(void *)pointer {
     array_t * array = (array_t*)_value.pointerValue;
-    for ( int i=0; i<array->count; i++ ) {
-        if ( array->entries[i]->pointer == pointer ) {
-            return [array->objects pointerAtIndex:i];
+    for ( int i=0; i<array->chunkCount; i++ ) {
+        for ( int j=0; j<array->chunks[i]->count; j++ ) {
+            if ( array->chunks[i]->pointers[j] == pointer ) {
+                return (__bridge id)array->chunks[i]->objects[j];
+            }
         }
     }
     return NULL;
@@ -125,39 +204,51 @@ typedef struct {
 
 - (void)updatePointerValue:(void *)value forObject:(id)object {
     array_t * array = (array_t*)_value.pointerValue;
-    if ( !array->objects ) return;
-    NSUInteger index = [array->objects.allObjects indexOfObject:object];
-    if ( index == NSNotFound || index >= array->count ) return;
-    
-    size_t size = sizeof(array_t) + (sizeof(void*) * array->count-1);
-    array_t * newArray = (array_t*)malloc(size);
-    memcpy(newArray, array, size);
+    array_entry_t * entry = AEArrayIndexGet(&_index, (__bridge void*)object);
+    int chunk, slot;
+    if ( !entry || !AEArrayFindEntry(array, entry, &chunk, &slot) ) return;
     
-    newArray->entries[index] = (array_entry_t*)malloc(sizeof(array_entry_t));
-    newArray->entries[index]->pointer = value;
-    newArray->entries[index]->referenceCount = 1;
+    // Every occurrence of the object shares the one entry, so they all take the new value
+    array_entry_t * newEntry = [self newEntryForObject:object pointer:value];
+    AEArrayIndexSet(&_index, (__bridge void*)object, newEntry);
+    newEntry->occurrences = entry->occurrences;
+    entry->occurrences = 0;
     
-    for ( int i=0; i<newArray->count; i++ ) {
-        if ( i != index ) newArray->entries[i]->referenceCount++;
+    if ( newEntry->occurrences == 1 ) {
+        [self replaceSlot:slot inChunk:chunk ofArray:array withEntry:newEntry];
+        return;
     }
     
-    CFBridgingRetain(newArray->objects);
+    // Copy each chunk holding an occurrence
+    array_t * newArray = AEArrayCreate(array->chunkCount, _itemSize);
+    for ( int i=0; i<array->chunkCount; i++ ) {
+        array_chunk_t * source = array->chunks[i];
+        newArray->chunks[i] = source;
+        for ( int j=0; j<source->count; j++ ) {
+            if ( source->entries[j] != entry ) continue;
+            array_chunk_t * newChunk = AEArrayChunkCreate(source->count, _itemSize);
+            for ( int k=0; k<source->count; k++ ) {
+                if ( source->entries[k] == entry ) {
+                    AEArrayChunkAppend(newChunk, newEntry, value, _itemSize);
+                } else {
+                    AEArrayChunkAppend(newChunk, source->entries[k], source->pointers[k], _itemSize);
+                }
+            }
+            newArray->chunks[i] = newChunk;
+            break;
+        }
+        newArray->chunks[i]->referenceCount++;
+    }
+    AEArrayUpdateOffsets(newArray);
     
-    _value.pointerValue = newArray;
+    [self setArray:newArray completionBlock:nil];
 }
 
 - (BOOL)containsObject:(__unsafe_unretained id)object pointerValue:(void **)outPointerValue {
-    array_t * array = (array_t*)_value.pointerValue;
-    if ( !array->objects ) return NO;
-    int index = 0;
-    for ( id entry in array->objects ) {
-        if ( entry == object ) {
-            if ( outPointerValue ) *outPointerValue = [self pointerValueAtIndex:index];
-            return YES;
-        }
-        index++;
-    }
-    return NO;
+    array_entry_t * entry = AEArrayIndexGet(&_index, (__bridge void*)object);
+    if ( !entry ) return NO;
+    if ( outPointerValue ) *outPointerValue = entry->pointer;
+    return YES;
 }
 
 - (void)updateWithContentsOfArray:(NSArray *)array {
@@ -176,43 +267,242 @@ typedef struct {
                     customMapping:(AEArrayIndexedCustomMappingBlock)block
                   completionBlock:(void (^)(void))completionBlock {
     array_t * currentArray = (array_t*)_value.pointerValue;
-    NSArray * currentArrayObjects = currentArray && currentArray->objects ? currentArray->objects.allObjects : nil;
-    if ( [currentArrayObjects isEqualToArray:array] ) {
+    if ( AEArrayMatchesObjects(currentArray, array) ) {
         // Arrays are identical - skip
         return;
     }
     
     // Create new array
-    array_t * newArray = (array_t*)malloc(sizeof(array_t) + (sizeof(void*) * array.count-1));
-    newArray->count = (int)array.count;
-    
-    NSPointerArray * objects = [NSPointerArray pointerArrayWithOptions:self.useWeakReferences ? NSPointerFunctionsOpaqueMemory : NSPointerFunctionsStrongMemory];
-    newArray->objects = objects;
-    CFBridgingRetain(objects);
+    int count = (int)array.count;
+    array_t * newArray = AEArrayCreate((count + kChunkCapacity - 1) / kChunkCapacity, _itemSize);
+    array_index_t index;
+    AEArrayIndexInit(&index, count);
     
     int i=0;
     for ( id item in array ) {
-        [objects addPointer:(__bridge void*)item];
-        NSUInteger priorIndex = currentArrayObjects ? [currentArrayObjects indexOfObject:item] : NSNotFound;
-        if ( priorIndex != NSNotFound ) {
-            // Copy value from prior array
-            newArray->entries[i] = currentArray->entries[priorIndex];
-            newArray->entries[i]->referenceCount++;
-        } else {
-            // Add new value
-            newArray->entries[i] = (array_entry_t*)malloc(sizeof(array_entry_t));
-            newArray->entries[i]->pointer = block ? block(item, i) : _mappingBlock ? _mappingBlock(item) : (__bridge void*)item;
-            newArray->entries[i]->referenceCount = 1;
+        array_chunk_t * chunk = newArray->chunks[i / kChunkCapacity];
+        if ( !chunk ) {
+            chunk = newArray->chunks[i / kChunkCapacity] = AEArrayChunkCreate(MIN(kChunkCapacity, count - i), _itemSize);
+            chunk->referenceCount = 1;
         }
+        
+        array_entry_t * entry = AEArrayIndexGet(&index, (__bridge void*)item);
+        if ( !entry ) {
+            entry = AEArrayIndexGet(&_index, (__bridge void*)item);
+            if ( !entry ) {
+                // Add new value
+                entry = [self newEntryForObject:item pointer:[self valueForNewObject:item atIndex:i customMapping:block]];
+            }
+            entry->occurrences = 0;
+            AEArrayIndexSet(&index, (__bridge void*)item, entry);
+        }
+        entry->occurrences++;
+        AEArrayChunkAppend(chunk, entry, entry->pointer, _itemSize);
         i++;
     }
     
+    AEArrayUpdateOffsets(newArray);
+    
+    free(_index.entries);
+    _index = index;
+    
+    [self setArray:newArray completionBlock:completionBlock];
+}
+
+- (void)addObject:(id)object {
+    [self addObject:object customMapping:nil];
+}
+
+- (void)addObject:(id)object customMapping:(AEArrayIndexedCustomMappingBlock)block {
+    array_t * array = (array_t*)_value.pointerValue;
+    [self insertObject:object atIndex:array->count customMapping:block];
+}
+
+- (void)insertObject:(id)object atIndex:(int)index {
+    [self insertObject:object atIndex:index customMapping:nil];
+}
+
+- (void)insertObject:(id)object atIndex:(int)index customMapping:(AEArrayIndexedCustomMappingBlock)block {
+    array_t * array = (array_t*)_value.pointerValue;
+    NSAssert(index >= 0 && index <= array->count, @"Index out of range");
+    if ( index < 0 || index > array->count ) return;
+    
+    array_entry_t * entry = [self entryForInsertingObject:object atIndex:index customMapping:block];
+    
+    int chunk = index == array->count ? array->chunkCount-1 : AEArrayFindChunk(array, index);
+    int slot = chunk >= 0 ? index - array->offsets[chunk] : 0;
+    
+    if ( chunk < 0 || slot == kChunkCapacity ) {
+        // Appending to a full chunk, or an empty array: start a new chunk
+        array_chunk_t * newChunk = AEArrayChunkCreate(1, _itemSize);
+        AEArrayChunkAppend(newChunk, entry, entry->pointer, _itemSize);
+        [self setArray:AEArrayCreateReplacingChunks(array, chunk+1, 0, &newChunk, 1) completionBlock:nil];
+        return;
+    }
+    
+    // Copy the affected chunk with the new entry, splitting it if it's full
+    array_chunk_t * source = array->chunks[chunk];
+    array_entry_t * entries[kChunkCapacity+1];
+    memcpy(entries, source->entries, sizeof(array_entry_t*) * slot);
+    entries[slot] = entry;
+    memcpy(entries + slot + 1, source->entries + slot, sizeof(array_entry_t*) * (source->count - slot));
+    void * pointers[kChunkCapacity+1];
+    memcpy(pointers, source->pointers, sizeof(void*) * slot);
+    pointers[slot] = entry->pointer;
+    memcpy(pointers + slot + 1, source->pointers + slot, sizeof(void*) * (source->count - slot));
+    
+    array_chunk_t * chunks[2];
+    int chunkCount = AEArrayChunksCreate(entries, pointers, source->count + 1, _itemSize, chunks);
+    [self setArray:AEArrayCreateReplacingChunks(array, chunk, 1, chunks, chunkCount) completionBlock:nil];
+}
+
+- (void)removeObject:(id)object {
+    array_t * array = (array_t*)_value.pointerValue;
+    array_entry_t * entry = AEArrayIndexGet(&_index, (__bridge void*)object);
+    int chunk, slot;
+    if ( !entry || !AEArrayFindEntry(array, entry, &chunk, &slot) ) return;
+    [self removeObjectAtIndex:array->offsets[chunk] + slot];
+}
+
+- (void)removeObjectAtIndex:(int)index {
+    array_t * array = (array_t*)_value.pointerValue;
+    NSAssert(index >= 0 && index < array->count, @"Index out of range");
+    if ( index < 0 || index >= array->count ) return;
+    
+    int chunk = AEArrayFindChunk(array, index);
+    int slot = index - array->offsets[chunk];
+    array_chunk_t * source = array->chunks[chunk];
+    
+    // Merge sparse chunks with a neighbour
+    int start = chunk;
+    int replaceCount = 1;
+    if ( source->count - 1 < kChunkCapacity / 4 ) {
+        if ( chunk+1 < array->chunkCount && array->chunks[chunk+1]->count + source->count - 1 <= kChunkCapacity ) {
+            replaceCount = 2;
+        } else if ( chunk > 0 && array->chunks[chunk-1]->count + source->count - 1 <= kChunkCapacity ) {
+            start = chunk-1;
+            replaceCount = 2;
+        }
+    }
+    
+    array_entry_t * entries[2*kChunkCapacity];
+    void * pointers[2*kChunkCapacity];
+    int count = 0;
+    for ( int i=start; i<start+replaceCount; i++ ) {
+        for ( int j=0; j<array->chunks[i]->count; j++ ) {
+            if ( i == chunk && j == slot ) continue;
+            entries[count] = array->chunks[i]->entries[j];
+            pointers[count++] = array->chunks[i]->pointers[j];
+        }
+    }
+    
+    array_entry_t * removed = source->entries[slot];
+    BOOL stillPresent = [self removeEntryOccurrence:removed];
+    
+    array_chunk_t * chunks[2];
+    int chunkCount = AEArrayChunksCreate(entries, pointers, count, _itemSize, chunks);
+    [self setArray:AEArrayCreateReplacingChunks(array, start, replaceCount, chunks, chunkCount) completionBlock:nil];
+    
+    if ( stillPresent ) [self relocateEntry:removed];
+}
+
+- (void)replaceObjectAtIndex:(int)index withObject:(id)object {
+    array_t * array = (array_t*)_value.pointerValue;
+    NSAssert(index >= 0 && index < array->count, @"Index out of range");
+    if ( index < 0 || index >= array->count ) return;
+    
+    int chunk = AEArrayFindChunk(array, index);
+    int slot = index - array->offsets[chunk];
+    array_entry_t * oldEntry = array->chunks[chunk]->entries[slot];
+    if ( oldEntry->object == (__bridge void*)object ) return;
+    
+    array_entry_t * entry = [self entryForInsertingObject:object atIndex:index customMapping:nil];
+    BOOL stillPresent = [self removeEntryOccurrence:oldEntry];
+    
+    [self replaceSlot:slot inChunk:chunk ofArray:array withEntry:entry];
+    
+    if ( stillPresent ) [self relocateEntry:oldEntry];
+}
+
+#pragma mark - Helpers
+
+- (array_entry_t *)newEntryForObject:(id)object pointer:(void *)pointer {
+    array_entry_t * entry = (array_entry_t*)calloc(1, sizeof(array_entry_t));
+    entry->pointer = pointer;
+    entry->object = (__bridge void*)object;
+    entry->retainsObject = !self.useWeakReferences;
+    if ( entry->retainsObject ) {
+        CFBridgingRetain(object);
+    }
+    return entry;
+}
+
+- (void *)valueForNewObject:(id)object atIndex:(int)index customMapping:(AEArrayIndexedCustomMappingBlock)block {
+    void * value = block ? block(object, index) : _mappingBlock ? _mappingBlock(object) : _itemSize ? NULL : (__bridge void*)object;
+    if ( _itemSize ) {
+        // Inline values are copied into chunk storage when the entry is placed
+        if ( value ) {
+            memcpy(_scratch, value, _itemSize);
+            free(value);
+        } else {
+            memset(_scratch, 0, _itemSize);
+        }
+        return _scratch;
+    }
+    return value;
+}
+
+- (array_entry_t *)entryForInsertingObject:(id)object atIndex:(int)index customMapping:(AEArrayIndexedCustomMappingBlock)block {
+    // Objects already in the array share their existing value
+    array_entry_t * entry = AEArrayIndexGet(&_index, (__bridge void*)object);
+    if ( !entry ) {
+        entry = [self newEntryForObject:object pointer:[self valueForNewObject:object atIndex:index customMapping:block]];
+        AEArrayIndexSet(&_index, (__bridge void*)object, entry);
+    }
+    entry->occurrences++;
+    return entry;
+}
+
+- (BOOL)removeEntryOccurrence:(array_entry_t *)entry {
+    if ( --entry->occurrences > 0 ) return YES;
+    if ( AEArrayIndexGet(&_index, entry->object) == entry ) {
+        AEArrayIndexRemove(&_index, entry->object);
+    }
+    return NO;
+}
+
+- (void)relocateEntry:(array_entry_t *)entry {
+    // Point an entry that's still present elsewhere in the array at one of its remaining occurrences,
+    // as the chunk it was last placed in may no longer be part of the array
+    array_t * array = (array_t*)_value.pointerValue;
+    int chunk, slot;
+    if ( AEArrayFindEntry(array, entry, &chunk, &slot) ) {
+        entry->chunk = array->chunks[chunk];
+        entry->pointer = array->chunks[chunk]->pointers[slot];
+    }
+}
+
+- (void)replaceSlot:(int)slot inChunk:(int)chunk ofArray:(array_t *)array withEntry:(array_entry_t *)entry {
+    array_chunk_t * source = array->chunks[chunk];
+    array_chunk_t * newChunk = AEArrayChunkCreate(source->count, _itemSize);
+    for ( int i=0; i<source->count; i++ ) {
+        if ( i == slot ) {
+            AEArrayChunkAppend(newChunk, entry, entry->pointer, _itemSize);
+        } else {
+            AEArrayChunkAppend(newChunk, source->entries[i], source->pointers[i], _itemSize);
+        }
+    }
+    [self setArray:AEArrayCreateReplacingChunks(array, chunk, 1, &newChunk, 1) completionBlock:nil];
+}
+
+- (void)setArray:(array_t *)array completionBlock:(void (^)(void))completionBlock {
+    _mutations++;
     if ( completionBlock ) {
-        [_value setPointerValue:newArray withCompletionBlock:^(void * _Nullable oldValue) {
+        [_value setPointerValue:array withCompletionBlock:^(void * _Nullable oldValue) {
             completionBlock();
         }];
     } else {
-        _value.pointerValue = newArray;
+        _value.pointerValue = array;
     }
 }
 
@@ -230,7 +520,276 @@ int AEArrayGetCount(AEArrayToken token) {
 
 void * AEArrayGetItem(AEArrayToken token, int index) {
     if ( !token ) return NULL;
-    return ((array_t*)token)->entries[index]->pointer;
+    const array_t * array = (const array_t*)token;
+    int chunk = AEArrayFindChunk(array, index);
+    int slot = index - array->offsets[chunk];
+    return array->itemSize ? array->chunks[chunk]->payload + (array->itemSize * slot) : array->chunks[chunk]->pointers[slot];
+}
+
+static void AEArrayIteratorSetChunk(AEArrayIterator * iterator, const array_chunk_t * chunk) {
+    // Inline items are visited in place, stepping through the payload
+    iterator->items = chunk->pointers;
+    iterator->item = iterator->stride ? chunk->payload : (char *)chunk->pointers[0];
+    iterator->count = chunk->count;
+    iterator->index = 0;
+}
+
+AEArrayIterator AEArrayGetIterator(AEArrayToken token) {
+    AEArrayIterator iterator = { .token = token, .remaining = AEArrayGetCount(token) };
+    if ( iterator.remaining > 0 ) {
+        const array_t * array = (const array_t*)token;
+        iterator.stride = array->itemSize;
+        AEArrayIteratorSetChunk(&iterator, array->chunks[0]);
+    }
+    return iterator;
+}
+
+void * AEArrayIteratorNextChunk(AEArrayIterator * iterator) {
+    const array_t * array = (const array_t*)iterator->token;
+    AEArrayIteratorSetChunk(iterator, array->chunks[++iterator->chunk]);
+    return iterator->item;
+}
+
+#pragma mark - Array versions
+
+/*
+ * Each version of the array is a table of chunks of up to kChunkCapacity entries. Versions share
+ * chunks, and chunks share entries, so an insert, remove or replace copies just the affected chunk
+ * and the chunk table. Chunks and entries are reference counted, and released with the last
+ * version or chunk that holds them, on the main thread.
+ *
+ * Each chunk keeps its item values in a contiguous list, so the audio thread walks a chunk
+ * linearly. For arrays with an inline item size, the items themselves live in the chunk's
+ * payload, and are copied along with the chunk.
+ *
+ * Chunks are never added to once they're part of a version - any change makes a new one - so
+ * each is allocated for exactly the items it holds. An array of a couple of items thus costs a
+ * couple of slots, not kChunkCapacity.
+ */
+
+static array_t * AEArrayCreate(int chunkCount, size_t itemSize) {
+    array_t * array = (array_t*)calloc(1, sizeof(array_t) + (sizeof(array_chunk_t*) * MAX(0, chunkCount-1)) + (sizeof(int) * chunkCount));
+    array->chunkCount = chunkCount;
+    array->itemSize = itemSize;
+    array->offsets = (int*)&array->chunks[chunkCount];
+    return array;
+}
+
+static array_t * AEArrayCreateReplacingChunks(const array_t * array, int start, int replaceCount, array_chunk_t ** chunks, int chunkCount) {
+    array_t * newArray = AEArrayCreate(array->chunkCount - replaceCount + chunkCount, array->itemSize);
+    int count = 0;
+    for ( int i=0; i<start; i++ ) {
+        newArray->chunks[count++] = array->chunks[i];
+    }
+    for ( int i=0; i<chunkCount; i++ ) {
+        newArray->chunks[count++] = chunks[i];
+    }
+    for ( int i=start+replaceCount; i<array->chunkCount; i++ ) {
+        newArray->chunks[count++] = array->chunks[i];
+    }
+    
+    for ( int i=0; i<newArray->chunkCount; i++ ) {
+        newArray->chunks[i]->referenceCount++;
+    }
+    AEArrayUpdateOffsets(newArray);
+    
+    return newArray;
+}
+
+static void AEArrayUpdateOffsets(array_t * array) {
+    int offset = 0;
+    for ( int i=0; i<array->chunkCount; i++ ) {
+        array->offsets[i] = offset;
+        offset += array->chunks[i]->count;
+    }
+    array->count = offset;
+}
+
+static int AEArrayFindChunk(const array_t * array, int index) {
+    int low = 0;
+    int high = array->chunkCount - 1;
+    while ( low < high ) {
+        int middle = (low + high + 1) / 2;
+        if ( array->offsets[middle] <= index ) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+    return low;
+}
+
+static BOOL AEArrayFindEntry(const array_t * array, const array_entry_t * entry, int * outChunk, int * outSlot) {
+    // Look in the chunk the entry was last placed in, then everywhere else
+    for ( int pass=0; pass<2; pass++ ) {
+        for ( int i=0; i<array->chunkCount; i++ ) {
+            if ( pass == 0 && array->chunks[i] != entry->chunk ) continue;
+            for ( int j=0; j<array->chunks[i]->count; j++ ) {
+                if ( array->chunks[i]->entries[j] == entry ) {
+                    *outChunk = i;
+                    *outSlot = j;
+                    return YES;
+                }
+            }
+        }
+    }
+    return NO;
+}
+
+static BOOL AEArrayMatchesObjects(const array_t * array, NSArray * objects) {
+    if ( array->count != objects.count ) return NO;
+    int chunk = 0;
+    int slot = 0;
+    for ( id object in objects ) {
+        if ( array->chunks[chunk]->objects[slot] != (__bridge void*)object ) return NO;
+        if ( ++slot == array->chunks[chunk]->count ) {
+            chunk++;
+            slot = 0;
+        }
+    }
+    return YES;
+}
+
+static void AEArrayRelease(array_t * array, AEArrayReleaseBlock releaseBlock) {
+    for ( int i=0; i<array->chunkCount; i++ ) {
+        array_chunk_t * chunk = array->chunks[i];
+        if ( --chunk->referenceCount > 0 ) continue;
+        for ( int j=0; j<chunk->count; j++ ) {
+            array_entry_t * entry = chunk->entries[j];
+            if ( --entry->referenceCount > 0 ) continue;
+            void * pointer = chunk->pointers[j];
+            if ( pointer ) {
+                if ( releaseBlock ) {
+                    releaseBlock((__bridge id)entry->object, pointer);
+                } else if ( !array->itemSize && pointer != entry->object ) {
+                    free(pointer);
+                }
+            }
+            if ( entry->retainsObject ) {
+                CFBridgingRelease(entry->object);
+            }
+            free(entry);
+        }
+        free(chunk);
+    }
+    free(array);
+}
+
+static array_chunk_t * AEArrayChunkCreate(int capacity, size_t itemSize) {
+    // One allocation, sized for the items it'll hold, so that small arrays stay small
+    size_t listsSize = sizeof(void*) * 3 * capacity;
+    size_t payloadOffset = (sizeof(array_chunk_t) + listsSize + 15) & ~(size_t)15;
+    array_chunk_t * chunk = (array_chunk_t*)calloc(1, payloadOffset + (itemSize * capacity));
+    chunk->capacity = capacity;
+    chunk->entries = (array_entry_t**)(chunk + 1);
+    chunk->objects = (void**)(chunk->entries + capacity);
+    chunk->pointers = chunk->objects + capacity;
+    chunk->payload = (char*)chunk + payloadOffset;
+    return chunk;
+}
+
+static void AEArrayChunkAppend(array_chunk_t * chunk, array_entry_t * entry, void * pointer, size_t itemSize) {
+    assert(chunk->count < chunk->capacity);
+    if ( itemSize ) {
+        // Copy the inline value into this chunk's storage
+        void * storage = chunk->payload + (itemSize * chunk->count);
+        memcpy(storage, pointer, itemSize);
+        pointer = entry->pointer = storage;
+    }
+    chunk->entries[chunk->count] = entry;
+    chunk->objects[chunk->count] = entry->object;
+    chunk->pointers[chunk->count] = pointer;
+    chunk->count++;
+    entry->referenceCount++;
+    entry->chunk = chunk;
+}
+
+static int AEArrayChunksCreate(array_entry_t ** entries, void ** pointers, int count, size_t itemSize, array_chunk_t ** outChunks) {
+    // Spread entries evenly over as few chunks as will hold them
+    int chunkCount = (count + kChunkCapacity - 1) / kChunkCapacity;
+    for ( int i=0, entry=0; i<chunkCount; i++ ) {
+        int end = (int)(((long)count * (i+1)) / chunkCount);
+        outChunks[i] = AEArrayChunkCreate(end - entry, itemSize);
+        for ( ; entry<end; entry++ ) {
+            AEArrayChunkAppend(outChunks[i], entries[entry], pointers[entry], itemSize);
+        }
+    }
+    return chunkCount;
+}
+
+#pragma mark - Object index
+
+/*
+ * Open-addressed hash table mapping object identity to entry in the current array, used on the
+ * main thread so that updates and lookups don't need a linear search
+ */
+
+static void AEArrayIndexInit(array_index_t * index, int count) {
+    uintptr_t capacity = 8;
+    while ( capacity < (uintptr_t)count * 2 ) capacity <<= 1;
+    index->entries = (array_index_entry_t*)calloc(capacity, sizeof(array_index_entry_t));
+    index->mask = capacity - 1;
+    index->count = 0;
+}
+
+static inline uintptr_t AEArrayIndexHash(void * object) {
+    uintptr_t hash = (uintptr_t)object;
+    hash ^= hash >> 4;
+    hash *= (uintptr_t)0x9E3779B97F4A7C15ULL;
+    return hash ^ (hash >> 29);
+}
+
+static array_entry_t * AEArrayIndexGet(const array_index_t * index, void * object) {
+    if ( !object ) return NULL;
+    for ( uintptr_t i = AEArrayIndexHash(object) & index->mask; ; i = (i+1) & index->mask ) {
+        if ( index->entries[i].object == object ) return index->entries[i].entry;
+        if ( !index->entries[i].object ) return NULL;
+    }
+}
+
+static void AEArrayIndexSet(array_index_t * index, void * object, array_entry_t * entry) {
+    if ( (uintptr_t)(index->count + 1) * 2 > index->mask + 1 ) {
+        // Grow
+        array_index_t old = *index;
+        AEArrayIndexInit(index, (int)(old.mask + 1));
+        for ( uintptr_t i=0; i<=old.mask; i++ ) {
+            if ( old.entries[i].object ) AEArrayIndexSet(index, old.entries[i].object, old.entries[i].entry);
+        }
+        free(old.entries);
+    }
+    
+    for ( uintptr_t i = AEArrayIndexHash(object) & index->mask; ; i = (i+1) & index->mask ) {
+        if ( index->entries[i].object == object ) {
+            index->entries[i].entry = entry;
+            return;
+        }
+        if ( !index->entries[i].object ) {
+            index->entries[i].object = object;
+            index->entries[i].entry = entry;
+            index->count++;
+            return;
+        }
+    }
+}
+
+static void AEArrayIndexRemove(array_index_t * index, void * object) {
+    uintptr_t i = AEArrayIndexHash(object) & index->mask;
+    while ( index->entries[i].object != object ) {
+        if ( !index->entries[i].object ) return;
+        i = (i+1) & index->mask;
+    }
+    index->entries[i].object = NULL;
+    index->count--;
+    
+    // Shift back following entries that would no longer be reachable across the gap
+    for ( uintptr_t j = (i+1) & index->mask; index->entries[j].object; j = (j+1) & index->mask ) {
+        uintptr_t home = AEArrayIndexHash(index->entries[j].object) & index->mask;
+        if ( ((j - home) & index->mask) >= ((j - i) & index->mask) ) {
+            index->entries[i] = index->entries[j];
+            index->entries[j].object = NULL;
+            i = j;
+        }
+    }
 }
 
 @end
@@ -242,22 +801,7 @@ void * AEArrayGetItem(AEArrayToken token, int index) {
     
     __unsafe_unretained typeof(self) weakSelf = self;
     self.releaseBlock = ^(void * value) {
-        array_t * array = (array_t *)value;
-        for ( int i=0; i<array->count; i++ ) {
-            array->entries[i]->referenceCount--;
-            if ( array->entries[i]->referenceCount == 0 ) {
-                if ( array->entries[i]->pointer ) {
-                    if ( weakSelf.arrayReleaseBlock ) {
-                        weakSelf.arrayReleaseBlock([array->objects pointerAtIndex:i], array->entries[i]->pointer);
-                    } else if ( array->entries[i]->pointer && array->entries[i]->pointer != [array->objects pointerAtIndex:i] ) {
-                        free(array->entries[i]->pointer);
-                    }
-                }
-                free(array->entries[i]);
-            }
-        }
-        if ( array->objects ) CFBridgingRelease((__bridge CFTypeRef)array->objects);
-        free(array);
+        AEArrayRelease((array_t *)value, weakSelf.arrayReleaseBlock);
     };
     
     return self;
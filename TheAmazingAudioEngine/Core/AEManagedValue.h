@@ -29,6 +29,7 @@ extern "C" {
 #endif
     
 #import <Foundation/Foundation.h>
+#import <pthread.h>
 
 //! Batch update block
 typedef void (^AEManagedValueUpdateBlock)(void);
@@ -122,19 +123,76 @@ void * _Nullable AEManagedValueGetValue(__unsafe_unretained AEManagedValue * _No
  *  then this function is already called for you within that class, so you don't need to do so yourself.
  *
  *  After this function is called, any updates made within the block passed to performAtomicBatchUpdate:
- *  become available on the render thread, and any old values are scheduled for release on the main thread.
+ *  become available on the render thread. This also marks the calling thread as no longer holding any
+ *  values from prior render cycles: old values are released once every registered render thread
+ *  has done so since the value was replaced.
+ *
+ *  The first call on a thread registers it as a render thread (see AEManagedValueRegisterRenderThread).
  *
  *  Important: Only call this function on the audio thread. If you call this on the main thread, you
  *  will see sporadic crashes on the audio thread.
  */
 void AEManagedValueCommitPendingUpdates(void);
 
+/*!
+ * Mark the calling render thread as holding no values from prior render cycles
+ *
+ *  Use this instead of AEManagedValueCommitPendingUpdates on threads that render alongside the
+ *  main render loop, such as offline renders, at the start of each of their render cycles. It
+ *  lets old values be released as AEManagedValueCommitPendingUpdates does, without committing
+ *  atomic batch updates out of step with the main render loop.
+ *
+ *  The first call on a thread registers it as a render thread (see AEManagedValueRegisterRenderThread);
+ *  unregister it with AEManagedValueUnregisterRenderThread when it's done rendering. AEAudioFileOutput
+ *  does both for you.
+ *
+ *  This function is realtime safe.
+ */
+void AEManagedValueMarkRenderThreadQuiescent(void);
+
+/*!
+ * Register the calling thread as a render thread
+ *
+ *  Old values aren't released until every registered render thread has called
+ *  AEManagedValueCommitPendingUpdates since they were replaced, so that they're not released while
+ *  still in use. AEManagedValueCommitPendingUpdates registers the calling thread automatically;
+ *  call this function beforehand if you want values retired from now on to be protected before
+ *  the thread's first render cycle.
+ *
+ *  A thread stays registered until it exits, or AEManagedValueUnregisterRenderThread is called,
+ *  and holds up the release of old values until it next passes a render cycle - so threads that only
+ *  render for a while, like offline renders on a dispatch queue, must unregister when done. If too
+ *  many threads are registered, old values aren't released at all until one is unregistered.
+ *
+ *  While no thread is registered, old values are released straight away, so any thread that reads
+ *  values with AEManagedValueGetValue across replacements must be registered.
+ *
+ *  This function is realtime safe.
+ */
+void AEManagedValueRegisterRenderThread(void);
+
+/*!
+ * Unregister a render thread
+ *
+ *  Call this when a thread will no longer render - for example, once its audio unit has been
+ *  stopped - so that it no longer holds up the release of old values. AEAudioUnitOutput does this
+ *  for you when stopped. It's not necessary for threads that are about to exit.
+ *
+ *  Important: The thread must not be in the middle of a render cycle, and it must not access any
+ *  values obtained before this call. If it renders again, it's registered again automatically.
+ *
+ * @param thread The thread to unregister
+ */
+void AEManagedValueUnregisterRenderThread(pthread_t _Nonnull thread);
+
 /*!
  * Service the release queue for this instance
  *
  *  Normally you do not need to call this function as it is done for you from AEManagedValueCommitPendingUpdates.
  *  But if you use an instance of this class from any other thread than the audio thread (usedOnAudioThread = NO),
- *  then you should call this function from the same thread that you use AEManagedValueGetValue.
+ *  then you should call this function from the same thread that you use AEManagedValueGetValue. It marks the
+ *  calling thread as no longer holding any values it obtained previously from this instance, so that
+ *  they can be released. It has no effect on instances used on the audio thread.
  */
 void AEManagedValueServiceReleaseQueue(__unsafe_unretained AEManagedValue * _Nonnull managedValue);
 
@@ -162,7 +220,8 @@ void AEManagedValueServiceReleaseQueue(__unsafe_unretained AEManagedValue * _Non
 
 /*!
  * A pointer to an allocated memory buffer. Old values will be automatically freed when the value 
- * changes. You can set this property from the main thread. Note that you can use this property, 
+ * changes, on a background thread unless you provide a releaseBlock. You can set this property from
+ * the main thread. Note that you can use this property, 
  * or objectValue, but not both.
  */
 @property (nonatomic) void * _Nullable pointerValue;
@@ -186,7 +245,8 @@ void AEManagedValueServiceReleaseQueue(__unsafe_unretained AEManagedValue * _Non
  * or call AEManagedValueServiceReleaseQueue from the same thread to avoid delayed release of old values.
  *
  * This ensures that the default cleanup mechanism in AEManagedValueCommitPendingUpdates does not cause data
- * to be released out of sync with the thread you use this instance with, causing crashes.
+ * to be released out of sync with the thread you use this instance with, causing crashes. Note that
+ * AEManagedValueGetValue on such an instance counts as a call to AEManagedValueServiceReleaseQueue.
  */
 @property (nonatomic) BOOL usedOnAudioThread;
 
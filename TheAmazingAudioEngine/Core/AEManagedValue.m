@@ -25,21 +25,31 @@
 //
 
 #import "AEManagedValue.h"
-#import <libkern/OSAtomic.h>
 #import <pthread.h>
 #import <os/lock.h>
+#import <stdatomic.h>
+#import <mach/semaphore.h>
+#import <mach/task.h>
+#import <mach/mach_init.h>
 #import "AEUtilities.h"
 
-typedef struct __linkedlistitem_t {
+typedef struct __retireditem_t {
     void * data;
     __unsafe_unretained void (^completionBlock)(void *);
-    struct __linkedlistitem_t * next;
-} linkedlistitem_t;
+    __unsafe_unretained AEManagedValue * owner;
+    BOOL releaseOnMainThread;
+    BOOL usedOnAudioThread;
+    uint64_t epoch;
+    struct __retireditem_t * next;
+} retireditem_t;
 
-static int __atomicUpdateCounter = 0;
-static pthread_rwlock_t __atomicUpdateMutex = PTHREAD_RWLOCK_INITIALIZER;
+typedef struct {
+    retireditem_t * head;
+    retireditem_t * tail;
+} retiredlist_t;
+
+static _Atomic(uint64_t) __atomicUpdateState = 0;
 static NSHashTable * __atomicUpdatedDeferredSyncValues = nil;
-static BOOL __atomicUpdateWaitingForCommit = NO;
 static NSMutableArray * __atomicUpdateCompletionBlocks = nil;
 static NSTimer * __atomicUpdateCompletionTimer = nil;
 static os_unfair_lock __atomicBypassMutex = OS_UNFAIR_LOCK_INIT;
@@ -51,9 +61,29 @@ static struct {
     int count;
 } __atomicBypassSectionCounts[kAtomicBypassSectionTableSize];
 
-static linkedlistitem_t * __pendingInstances = NULL;
-static linkedlistitem_t * __servicedInstances = NULL;
-static os_unfair_lock __pendingInstancesMutex = OS_UNFAIR_LOCK_INIT;
+static const int kParticipantTableSize = 64;
+static const intptr_t kParticipantOverflow = kParticipantTableSize + 1;
+static const NSTimeInterval kReclamationInterval = 0.01;
+
+static _Atomic(uint64_t) __epoch = 1;
+static struct {
+    _Atomic(pthread_t) thread;
+    _Atomic(uint64_t) epoch;
+} __participants[kParticipantTableSize];
+static _Atomic(int) __unregisteredParticipantCount = 0;
+static pthread_key_t __participantKey;
+static pthread_once_t __participantKeyOnce = PTHREAD_ONCE_INIT;
+
+static retiredlist_t __retiredValues = { NULL, NULL };
+static retiredlist_t __reclaimedValues = { NULL, NULL };
+static BOOL __reclaimedValuesReleaseScheduled = NO;
+static os_unfair_lock __retiredValuesMutex = OS_UNFAIR_LOCK_INIT;
+
+@interface AEManagedValueReclamationThread : NSThread
+@property (nonatomic) semaphore_t semaphore;
+@end
+
+static AEManagedValueReclamationThread * __reclamationThread = nil;
 
 @interface AEManagedValue () {
     void *      _value;
@@ -61,19 +91,34 @@ static os_unfair_lock __pendingInstancesMutex = OS_UNFAIR_LOCK_INIT;
     void *      _atomicBatchUpdateLastValue;
     BOOL        _wasUpdatedInAtomicBatchUpdate;
     BOOL        _isObjectValue;
-    OSQueueHead _pendingReleaseQueue;
-    int         _pendingReleaseCount;
-    OSQueueHead _releaseQueue;
+    _Atomic(uint64_t) _quiescentEpoch;
 }
-@property (nonatomic, strong) NSTimer * pollTimer;
 @end
 
+static int AEManagedValueRegisterParticipant(void);
+static void AEManagedValueCreateParticipantKey(void);
+static void AEManagedValueParticipantThreadExited(void * registration);
+static BOOL AEManagedValueReclaimRetiredValues(void);
+static void AEManagedValueReleaseReclaimedValues(void);
+static void AEManagedValueListAppend(retiredlist_t * list, retireditem_t * item);
+static BOOL AEManagedValueIsBypassingAtomicUpdate(__unsafe_unretained AEManagedValue * THIS);
+
+// Atomic update state: the number of open batch updates in the top half, and the sequence counter
+// in the bottom half, which is odd from the start of an update until it's committed
+static inline uint32_t AEAtomicUpdateStateGetDepth(uint64_t state) { return (uint32_t)(state >> 32); }
+static inline uint32_t AEAtomicUpdateStateGetSequence(uint64_t state) { return (uint32_t)state; }
+static inline uint64_t AEAtomicUpdateStateMake(uint32_t depth, uint32_t sequence) { return ((uint64_t)depth << 32) | sequence; }
+
 @implementation AEManagedValue
 @dynamic objectValue, pointerValue;
 
 + (void)initialize {
     __atomicUpdatedDeferredSyncValues = [[NSHashTable alloc] initWithOptions:NSPointerFunctionsWeakMemory capacity:0];
     __atomicUpdateCompletionBlocks = [NSMutableArray array];
+    if ( !__reclamationThread ) {
+        __reclamationThread = [AEManagedValueReclamationThread new];
+        [__reclamationThread start];
+    }
 }
 
 + (void)performAtomicBatchUpdate:(AEManagedValueUpdateBlock)block {
@@ -88,16 +133,18 @@ static os_unfair_lock __pendingInstancesMutex = OS_UNFAIR_LOCK_INIT;
  *
  *  - We need to protect against the scenario where the batch-update-in-progress check on the
  *    realtime thread passes followed immediately by the main thread entering the batch update and
- *    changing the value, as this violates atomicity. To do this, we use a mutex to guard the
- *    realtime thread check-and-return. We use a try lock on the realtime thread, the failure
- *    of which conveniently tells us that a batch update is happening, so it's the only check
- *    we need.
+ *    changing the value, as this violates atomicity. To do this, we use a sequence counter which
+ *    is odd from the time an update begins until it's committed. The realtime thread reads it
+ *    before and after reading the value, and if it has changed, returns the previous value instead.
+ *    The uncontended read is thus just two atomic loads, with no lock on a shared cache line.
  *
  *  - We need the realtime thread to only return the previously set value between the time an 
  *    update starts, and the time it's committed. Commit happens on the realtime thread at the
  *    start of the main render loop, initiated by the third-party developer, so that batch updates 
  *    occur all together with respect to the main render loop - otherwise, completion of a batch 
- *    update could occur while the render loop is midway through, violating atomicity.
+ *    update could occur while the render loop is midway through, violating atomicity. The open
+ *    update count shares a word with the counter, so that commit can check there are no updates
+ *    in progress and advance the counter in one compare-and-swap.
  *
  *  - This mechanism requires the previously set value (_atomicBatchUpdateLastValue) to be
  *    synced correctly to the current value at the time the atomic batch update begins.
@@ -120,47 +167,46 @@ static os_unfair_lock __pendingInstancesMutex = OS_UNFAIR_LOCK_INIT;
  */
 + (void)performAtomicBatchUpdate:(AEManagedValueUpdateBlock)block withCompletionBlock:(void (^)(void))completionBlock {
     os_unfair_lock_lock(&__atomicBatchUpdateMutex);
-    if ( !__atomicUpdateWaitingForCommit ) {
-        // Perform deferred sync to _atomicBatchUpdateLastValue for previously-batch-updated values
-        @synchronized ( __atomicUpdatedDeferredSyncValues ) {
-            for ( AEManagedValue * value in __atomicUpdatedDeferredSyncValues ) {
-                value->_atomicBatchUpdateLastValue = value->_value;
+    uint64_t state = atomic_load(&__atomicUpdateState);
+    while ( 1 ) {
+        uint32_t sequence = AEAtomicUpdateStateGetSequence(state);
+        if ( !(sequence & 1) ) {
+            // Perform deferred sync to _atomicBatchUpdateLastValue for previously-batch-updated values
+            @synchronized ( __atomicUpdatedDeferredSyncValues ) {
+                for ( AEManagedValue * value in __atomicUpdatedDeferredSyncValues ) {
+                    value->_atomicBatchUpdateLastValue = value->_value;
+                }
+                [__atomicUpdatedDeferredSyncValues removeAllObjects];
             }
-            [__atomicUpdatedDeferredSyncValues removeAllObjects];
         }
-    }
-    
-    if ( __atomicUpdateCounter == 0 ) {
-        // Wait for realtime thread to exit any GetValue calls
-        pthread_rwlock_wrlock(&__atomicUpdateMutex);
         
-        // Mark that we're awaiting a commit
-        __atomicUpdateWaitingForCommit = YES;
+        // Open the update, marking that we're awaiting a commit. This only fails if the realtime
+        // thread commits the prior update in the meantime, in which case we sync again and retry.
+        uint64_t newState = AEAtomicUpdateStateMake(AEAtomicUpdateStateGetDepth(state) + 1, sequence | 1);
+        if ( atomic_compare_exchange_strong(&__atomicUpdateState, &state, newState) ) {
+            break;
+        }
     }
     
     if ( completionBlock ) {
         [__atomicUpdateCompletionBlocks addObject:completionBlock];
     }
     
-    __atomicUpdateCounter++;
     os_unfair_lock_unlock(&__atomicBatchUpdateMutex);
     
     // Perform the updates
     block();
     
     os_unfair_lock_lock(&__atomicBatchUpdateMutex);
-    __atomicUpdateCounter--;
     
-    if ( __atomicUpdateCounter == 0 ) {
-        // Unlock, allowing GetValue to access _value again
-        pthread_rwlock_unlock(&__atomicUpdateMutex);
-    }
+    // Close the update, allowing the realtime thread to commit once it's the last one
+    atomic_fetch_sub(&__atomicUpdateState, AEAtomicUpdateStateMake(1, 0));
     
     if ( completionBlock && !__atomicUpdateCompletionTimer ) {
         __atomicUpdateCompletionTimer = [NSTimer scheduledTimerWithTimeInterval:0.01 repeats:YES block:^(NSTimer * _Nonnull timer) {
             NSArray * blocks = nil;
             os_unfair_lock_lock(&__atomicBatchUpdateMutex);
-            if ( !__atomicUpdateWaitingForCommit ) {
+            if ( !(AEAtomicUpdateStateGetSequence(atomic_load(&__atomicUpdateState)) & 1) ) {
                 [__atomicUpdateCompletionTimer invalidate];
                 __atomicUpdateCompletionTimer = nil;
                 blocks = [__atomicUpdateCompletionBlocks copy];
@@ -209,7 +255,7 @@ static os_unfair_lock __pendingInstancesMutex = OS_UNFAIR_LOCK_INIT;
 }
 
 + (BOOL)inAtomicBatchUpdate {
-    return __atomicUpdateCounter > 0;
+    return AEAtomicUpdateStateGetDepth(atomic_load(&__atomicUpdateState)) > 0;
 }
 
 - (instancetype)init {
@@ -224,33 +270,27 @@ static os_unfair_lock __pendingInstancesMutex = OS_UNFAIR_LOCK_INIT;
         [__atomicUpdatedDeferredSyncValues removeObject:self];
     }
     
-    // Remove self from instances awaiting service list
-    os_unfair_lock_lock(&__pendingInstancesMutex);
-    for ( linkedlistitem_t * entry = __pendingInstances, * prior = NULL; entry; prior = entry, entry = entry->next ) {
-        if ( entry->data == (__bridge void*)self ) {
-            if ( prior ) {
-                prior->next = entry->next;
-            } else {
-                __pendingInstances = entry->next;
-            }
-            free(entry);
-            break;
+    // Claim any of our retired values that are still outstanding
+    retiredlist_t outstanding = { NULL, NULL };
+    os_unfair_lock_lock(&__retiredValuesMutex);
+    retiredlist_t * lists[] = { &__retiredValues, &__reclaimedValues };
+    for ( int i=0; i<2; i++ ) {
+        retiredlist_t remaining = { NULL, NULL };
+        for ( retireditem_t * item = lists[i]->head, * next; item; item = next ) {
+            next = item->next;
+            AEManagedValueListAppend(item->owner == self ? &outstanding : &remaining, item);
         }
+        *lists[i] = remaining;
     }
-    os_unfair_lock_unlock(&__pendingInstancesMutex);
+    os_unfair_lock_unlock(&__retiredValuesMutex);
     
     // Perform any pending releases
     if ( _value ) {
         [self releaseOldValue:_value];
     }
-    linkedlistitem_t * release;
-    while ( (release = OSAtomicDequeue(&_pendingReleaseQueue, offsetof(linkedlistitem_t, next))) ) {
-        OSAtomicEnqueue(&_releaseQueue, release, offsetof(linkedlistitem_t, next));
-    }
-    [self pollReleaseList];
-    
-    if ( self.pollTimer ) {
-        [self.pollTimer invalidate];
+    for ( retireditem_t * item = outstanding.head, * next; item; item = next ) {
+        next = item->next;
+        [self releaseRetiredValue:item];
     }
 }
 
@@ -292,7 +332,7 @@ static os_unfair_lock __pendingInstancesMutex = OS_UNFAIR_LOCK_INIT;
     void * oldValue = _value;
     _value = value;
     
-    if ( (__atomicUpdateCounter == 0 && !__atomicUpdateWaitingForCommit) || AEManagedValueIsBypassingAtomicUpdate(self) ) {
+    if ( !(AEAtomicUpdateStateGetSequence(atomic_load(&__atomicUpdateState)) & 1) || AEManagedValueIsBypassingAtomicUpdate(self) ) {
         // Sync value for recall on realtime thread during atomic batch update
         _atomicBatchUpdateLastValue = _value;
     } else {
@@ -305,45 +345,24 @@ static os_unfair_lock __pendingInstancesMutex = OS_UNFAIR_LOCK_INIT;
     _valueSet = YES;
     
     if ( oldValue || completionBlock ) {
-        // Mark old value as pending release - it'll be transferred to the release queue by
-        // AEManagedValueGetValue on the audio thread
-        linkedlistitem_t * release = (linkedlistitem_t*)calloc(1, sizeof(linkedlistitem_t));
-        release->data = oldValue;
+        // Retire the old value at the current epoch - it'll be reclaimed once every render thread has
+        // marked a quiescent state at a later epoch, within AEManagedValueCommitPendingUpdates
+        retireditem_t * item = (retireditem_t*)calloc(1, sizeof(retireditem_t));
+        item->data = oldValue;
         if ( completionBlock ) {
-            release->completionBlock = (__bridge id)CFBridgingRetain([completionBlock copy]);
+            item->completionBlock = (__bridge id)CFBridgingRetain([completionBlock copy]);
         }
+        item->owner = self;
+        // Needs releasing on the main thread; otherwise the reclamation thread just frees it
+        item->releaseOnMainThread = completionBlock || _releaseBlock || _releaseNotificationBlock || _isObjectValue;
+        item->usedOnAudioThread = _usedOnAudioThread;
+        item->epoch = atomic_fetch_add(&__epoch, 1);
         
-        OSAtomicEnqueue(&_pendingReleaseQueue, release, offsetof(linkedlistitem_t, next));
-        _pendingReleaseCount++;
+        os_unfair_lock_lock(&__retiredValuesMutex);
+        AEManagedValueListAppend(&__retiredValues, item);
+        os_unfair_lock_unlock(&__retiredValuesMutex);
         
-        if ( !self.pollTimer ) {
-            // Start polling for pending releases
-            double interval = completionBlock ? 0.01 : 0.1;
-            __weak typeof(self) weakSelf = self;
-            self.pollTimer = [NSTimer timerWithTimeInterval:interval repeats:YES block:^(NSTimer * timer) {
-                [weakSelf pollReleaseList];
-            }];
-            self.pollTimer.tolerance = completionBlock ? 0.01 : 0.5;
-            [NSRunLoop.mainRunLoop addTimer:self.pollTimer forMode:NSDefaultRunLoopMode];
-        }
-        
-        if ( self.usedOnAudioThread ) {
-            // Add self to the list of instances to service on the realtime thread within AEManagedValueCommitPendingUpdates
-            os_unfair_lock_lock(&__pendingInstancesMutex);
-            BOOL alreadyPresent = NO;
-            for ( linkedlistitem_t * entry = __pendingInstances; entry; entry = entry->next ) {
-                if ( entry->data == (__bridge void*)self ) {
-                    alreadyPresent = YES;
-                }
-            }
-            if ( !alreadyPresent ) {
-                linkedlistitem_t * entry = malloc(sizeof(linkedlistitem_t));
-                entry->next = __pendingInstances;
-                entry->data = (__bridge void*)self;
-                __pendingInstances = entry;
-            }
-            os_unfair_lock_unlock(&__pendingInstancesMutex);
-        }
+        semaphore_signal(__reclamationThread.semaphore);
     }
 }
 
@@ -356,40 +375,70 @@ void AEManagedValueCommitPendingUpdates(void) {
     }
     #endif
     
+    // Note the epoch first: values retired by an update that begins after the check below will have a later one
+    uint64_t epoch = atomic_load(&__epoch);
+    
+    int slot = AEManagedValueRegisterParticipant();
+    
     // Finish atomic update
-    if ( pthread_rwlock_tryrdlock(&__atomicUpdateMutex) == 0 ) {
-        __atomicUpdateWaitingForCommit = NO;
-    } else {
-        // Still in the middle of an atomic update
+    uint64_t state = atomic_load(&__atomicUpdateState);
+    uint32_t sequence = AEAtomicUpdateStateGetSequence(state);
+    if ( AEAtomicUpdateStateGetDepth(state) > 0
+            || ((sequence & 1) && !atomic_compare_exchange_strong(&__atomicUpdateState, &state, AEAtomicUpdateStateMake(0, sequence + 1))) ) {
+        // Still in the middle of an atomic update: values prior to the update are still in use, so
+        // don't pass the current epoch
         return;
     }
     
-    // Service any instances pending an update so we can mark the old value as ready for release
-    if ( os_unfair_lock_trylock(&__pendingInstancesMutex) ) {
-        linkedlistitem_t * lastEntry = NULL;
-        for ( linkedlistitem_t * entry = __pendingInstances; entry; lastEntry = entry, entry = entry->next ) {
-            AEManagedValueServiceReleaseQueue((__bridge AEManagedValue*)entry->data);
-        }
-        
-        if ( lastEntry ) {
-            // Move pending instances to serviced instances list, ready for cleanup on main thread
-            lastEntry->next = __servicedInstances;
-            __servicedInstances = __pendingInstances;
-            __pendingInstances = NULL;
-        }
-        os_unfair_lock_unlock(&__pendingInstancesMutex);
+    if ( slot != -1 ) {
+        // This thread no longer holds any values obtained during prior render cycles
+        atomic_store(&__participants[slot].epoch, epoch);
     }
+}
+
+void AEManagedValueMarkRenderThreadQuiescent(void) {
+    uint64_t epoch = atomic_load(&__epoch);
     
-    pthread_rwlock_unlock(&__atomicUpdateMutex);
+    int slot = AEManagedValueRegisterParticipant();
+    if ( slot == -1 ) {
+        return;
+    }
+    
+    if ( (AEAtomicUpdateStateGetSequence(atomic_load(&__atomicUpdateState)) & 1) && !AEManagedValueIsBypassingAtomicUpdate(nil) ) {
+        // Values prior to the atomic update may still be returned to this thread
+        return;
+    }
+    
+    atomic_store(&__participants[slot].epoch, epoch);
+}
+
+void AEManagedValueRegisterRenderThread(void) {
+    AEManagedValueRegisterParticipant();
+}
+
+void AEManagedValueUnregisterRenderThread(pthread_t thread) {
+    for ( int i=0; i<kParticipantTableSize; i++ ) {
+        if ( atomic_load(&__participants[i].thread) == thread ) {
+            // Empty slots always hold epoch 0, so a new occupant protects everything until it passes an epoch
+            atomic_store(&__participants[i].epoch, 0);
+            atomic_store(&__participants[i].thread, NULL);
+            break;
+        }
+    }
+    semaphore_signal(__reclamationThread.semaphore);
 }
 
 void * AEManagedValueGetValue(__unsafe_unretained AEManagedValue * THIS) {
     if ( !THIS ) return NULL;
     
     BOOL atomicBypass = AEManagedValueIsBypassingAtomicUpdate(THIS);
-    if ( !atomicBypass && (__atomicUpdateWaitingForCommit || pthread_rwlock_tryrdlock(&__atomicUpdateMutex) != 0) ) {
-        // Atomic update in progress - return previous value
-        return THIS->_atomicBatchUpdateLastValue;
+    uint32_t sequence = 0;
+    if ( !atomicBypass ) {
+        sequence = AEAtomicUpdateStateGetSequence(atomic_load_explicit(&__atomicUpdateState, memory_order_acquire));
+        if ( sequence & 1 ) {
+            // Atomic update in progress - return previous value
+            return THIS->_atomicBatchUpdateLastValue;
+        }
     }
     
     if ( !THIS->_usedOnAudioThread && !(pthread_main_np() == 1) ) {
@@ -399,58 +448,134 @@ void * AEManagedValueGetValue(__unsafe_unretained AEManagedValue * THIS) {
     void * value = THIS->_value;
     
     if ( !atomicBypass ) {
-        pthread_rwlock_unlock(&__atomicUpdateMutex);
+        atomic_thread_fence(memory_order_acquire);
+        if ( AEAtomicUpdateStateGetSequence(atomic_load_explicit(&__atomicUpdateState, memory_order_acquire)) != sequence ) {
+            // Atomic update began while we were reading - return previous value
+            return THIS->_atomicBatchUpdateLastValue;
+        }
     }
     
     return value;
 }
 
 void AEManagedValueServiceReleaseQueue(__unsafe_unretained AEManagedValue * THIS) {
-    linkedlistitem_t * release;
-    while ( (release = OSAtomicDequeue(&THIS->_pendingReleaseQueue, offsetof(linkedlistitem_t, next))) ) {
-        OSAtomicEnqueue(&THIS->_releaseQueue, release, offsetof(linkedlistitem_t, next));
+    if ( THIS->_usedOnAudioThread ) {
+        // Render threads take care of these from AEManagedValueCommitPendingUpdates
+        return;
+    }
+    
+    uint64_t epoch = atomic_load(&__epoch);
+    if ( AEAtomicUpdateStateGetSequence(atomic_load(&__atomicUpdateState)) & 1 ) {
+        // Values prior to the atomic update may still be returned
+        return;
+    }
+    
+    // The calling thread no longer holds any values it obtained from this instance previously. Wake
+    // the reclamation thread if that lets anything go, as it doesn't poll for these
+    if ( atomic_exchange(&THIS->_quiescentEpoch, epoch) != epoch ) {
+        semaphore_signal(__reclamationThread.semaphore);
     }
 }
 
-#pragma mark - Helpers
-
-- (void)pollReleaseList {
-    __strong typeof(self) strongSelf = self;
-    linkedlistitem_t * release;
-    while ( (release = OSAtomicDequeue(&_releaseQueue, offsetof(linkedlistitem_t, next))) ) {
-        if ( release->completionBlock ) {
-            release->completionBlock(release->data);
-            CFBridgingRelease((__bridge CFTypeRef)release->completionBlock);
-        }
-        if ( release->data ) {
-            NSAssert(_isObjectValue || release->data != _value, @"About to release value still in use");
-            [self releaseOldValue:release->data];
-        }
-        free(release);
-        _pendingReleaseCount--;
-    }
-    if ( _pendingReleaseCount == 0 ) {
-        [self.pollTimer invalidate];
-        self.pollTimer = nil;
-    }
-    
-    if ( self.usedOnAudioThread ) {
-        // Remove self from serviced instances list
-        os_unfair_lock_lock(&__pendingInstancesMutex);
-        for ( linkedlistitem_t * entry = __servicedInstances, * prior = NULL; entry; prior = entry, entry = entry->next ) {
-            if ( entry->data == (__bridge void*)self ) {
-                if ( prior ) {
-                    prior->next = entry->next;
-                } else {
-                    __servicedInstances = entry->next;
-                }
-                free(entry);
-                break;
+/*!
+ * Some comments about the implementation for reclamation of old values:
+ *
+ *  - Each old value is retired at the current value of a global epoch counter, which is then
+ *    advanced. Retired values go on a single global list; there's no per-instance timer.
+ *
+ *  - Each render thread, at the start of its render cycle (AEManagedValueCommitPendingUpdates), holds
+ *    no values from prior cycles. It records the epoch, as it was before checking for an atomic
+ *    update, in its slot in the participant table, marking a quiescent state. The first call
+ *    registers the thread, claiming an empty slot with a compare-and-swap, so this is realtime safe.
+ *
+ *  - A thread stays registered until it's unregistered with AEManagedValueUnregisterRenderThread, or
+ *    it exits. There's no timeout: a registered thread that stops rendering holds up reclamation, as
+ *    a stalled render thread may still be using old values. So threads that render for a while and
+ *    then do other work, like offline renders on a dispatch queue, unregister when done; they mark
+ *    quiescent states with AEManagedValueMarkRenderThreadQuiescent, which doesn't commit atomic
+ *    batch updates. If no thread is registered at all, nothing can be using an old value, so
+ *    retired values are released straight away.
+ *
+ *  - If the table is full, the thread can't be tracked, so values used on the audio thread aren't
+ *    released at all until it gets a slot on a later render cycle, or exits.
+ *
+ *  - A retired value can be released once every registered thread has recorded a later epoch than
+ *    the one it was retired at, as any subsequent AEManagedValueGetValue call will see the new value.
+ *    A single reclamation thread checks this, waking when values are retired or threads are
+ *    unregistered, and polling only while values are waiting on registered threads.
+ *
+ *  - Values of instances not used on the audio thread are instead tracked by the instance's own
+ *    epoch, recorded by AEManagedValueServiceReleaseQueue on the thread that uses it, which wakes
+ *    the reclamation thread when the epoch moves.
+ *
+ *  - While an atomic batch update awaits commit, readers still see values set before the update
+ *    began, so they don't pass the epoch.
+ *
+ *  - Plain buffers are freed directly on the reclamation thread. Values with a release block,
+ *    release notification block or completion block, and objects, are released on the main thread
+ *    as before, all of them from a single dispatch per reclamation pass.
+ *
+ *  - Instances that are deallocated release their outstanding values immediately.
+ */
+static int AEManagedValueRegisterParticipant(void) {
+    pthread_once(&__participantKeyOnce, AEManagedValueCreateParticipantKey);
+    
+    // The thread's slot, plus one, is kept in thread-specific data; check it's still ours
+    pthread_t thread = pthread_self();
+    intptr_t registration = (intptr_t)pthread_getspecific(__participantKey);
+    if ( registration > 0 && registration <= kParticipantTableSize
+            && atomic_load(&__participants[registration-1].thread) == thread ) {
+        return (int)registration - 1;
+    }
+    
+    // Claim an empty slot
+    for ( int i=((uintptr_t)thread)%kParticipantTableSize, j=0; j<kParticipantTableSize; j++, i=(i+1)%kParticipantTableSize ) {
+        pthread_t empty = NULL;
+        if ( atomic_load(&__participants[i].thread) == NULL
+                && atomic_compare_exchange_strong(&__participants[i].thread, &empty, thread) ) {
+            pthread_setspecific(__participantKey, (void *)(intptr_t)(i + 1));
+            if ( registration == kParticipantOverflow ) {
+                atomic_fetch_sub(&__unregisteredParticipantCount, 1);
             }
+            return i;
         }
-        os_unfair_lock_unlock(&__pendingInstancesMutex);
     }
-    (void)strongSelf;
+    
+    if ( registration != kParticipantOverflow ) {
+        #ifdef DEBUG
+        if ( AERateLimit() ) printf("%s: Too many render threads; old values won't be released\n", __FUNCTION__);
+        #endif
+        pthread_setspecific(__participantKey, (void *)kParticipantOverflow);
+        atomic_fetch_add(&__unregisteredParticipantCount, 1);
+    }
+    return -1;
+}
+
+static void AEManagedValueCreateParticipantKey(void) {
+    pthread_key_create(&__participantKey, AEManagedValueParticipantThreadExited);
+}
+
+static void AEManagedValueParticipantThreadExited(void * registration) {
+    if ( (intptr_t)registration == kParticipantOverflow ) {
+        atomic_fetch_sub(&__unregisteredParticipantCount, 1);
+        semaphore_signal(__reclamationThread.semaphore);
+    } else {
+        AEManagedValueUnregisterRenderThread(pthread_self());
+    }
+}
+
+#pragma mark - Helpers
+
+- (void)releaseRetiredValue:(retireditem_t *)item {
+    if ( item->completionBlock ) {
+        item->completionBlock(item->data);
+        CFBridgingRelease((__bridge CFTypeRef)item->completionBlock);
+    }
+    if ( item->data ) {
+        NSAssert(_isObjectValue || item->data != _value, @"About to release value still in use");
+        [self releaseOldValue:item->data];
+    }
+    free(item);
 }
 
 - (void)releaseOldValue:(void *)value {
@@ -481,4 +606,131 @@ static BOOL AEManagedValueIsBypassingAtomicUpdate(__unsafe_unretained AEManagedV
     return NO;
 }
 
+static BOOL AEManagedValueReclaimRetiredValues(void) {
+    // Find the earliest epoch any registered render thread has recorded. With none registered,
+    // nothing can be using an old value retired so far: a thread that registers after the scan
+    // below only reads values current from then on
+    uint64_t safeEpoch = atomic_load(&__epoch);
+    BOOL participants = NO;
+    if ( atomic_load(&__unregisteredParticipantCount) > 0 ) {
+        // There's a render thread we can't track; we'll be woken when it exits
+        safeEpoch = 0;
+    }
+    for ( int i=0; i<kParticipantTableSize && safeEpoch > 0; i++ ) {
+        if ( !atomic_load(&__participants[i].thread) ) continue;
+        safeEpoch = MIN(safeEpoch, atomic_load(&__participants[i].epoch));
+        participants = YES;
+    }
+    
+    // Take those values retired before then
+    retiredlist_t freeable = { NULL, NULL };
+    BOOL scheduleRelease = NO;
+    os_unfair_lock_lock(&__retiredValuesMutex);
+    retiredlist_t remaining = { NULL, NULL };
+    for ( retireditem_t * item = __retiredValues.head, * next; item; item = next ) {
+        next = item->next;
+        uint64_t itemSafeEpoch = item->usedOnAudioThread ? safeEpoch : atomic_load(&item->owner->_quiescentEpoch);
+        AEManagedValueListAppend(item->epoch >= itemSafeEpoch ? &remaining
+                                 : item->releaseOnMainThread ? &__reclaimedValues : &freeable, item);
+    }
+    __retiredValues = remaining;
+    if ( __reclaimedValues.head && !__reclaimedValuesReleaseScheduled ) {
+        __reclaimedValuesReleaseScheduled = YES;
+        scheduleRelease = YES;
+    }
+    // Registered render threads don't signal as they pass epochs, so poll while values wait on them
+    BOOL poll = NO;
+    for ( retireditem_t * item = __retiredValues.head; item && participants && !poll; item = item->next ) {
+        poll = item->usedOnAudioThread;
+    }
+    os_unfair_lock_unlock(&__retiredValuesMutex);
+    
+    // Free plain buffers here, and pass the rest to the main thread
+    for ( retireditem_t * item = freeable.head, * next; item; item = next ) {
+        next = item->next;
+        free(item->data);
+        free(item);
+    }
+    if ( scheduleRelease ) {
+        dispatch_async(dispatch_get_main_queue(), ^{ AEManagedValueReleaseReclaimedValues(); });
+    }
+    
+    return poll;
+}
+
+static void AEManagedValueReleaseReclaimedValues(void) {
+    while ( 1 ) {
+        // Take one at a time, as instances may be deallocated by the release of prior values
+        os_unfair_lock_lock(&__retiredValuesMutex);
+        retireditem_t * item = __reclaimedValues.head;
+        AEManagedValue * owner = nil;
+        if ( item ) {
+            __reclaimedValues.head = item->next;
+            if ( !__reclaimedValues.head ) __reclaimedValues.tail = NULL;
+            item->next = NULL;
+            
+            // Take hold of the owner while it can't claim the item for itself from dealloc
+            owner = item->owner;
+        } else {
+            __reclaimedValuesReleaseScheduled = NO;
+        }
+        os_unfair_lock_unlock(&__retiredValuesMutex);
+        
+        if ( !item ) break;
+        
+        [owner releaseRetiredValue:item];
+    }
+}
+
+static void AEManagedValueListAppend(retiredlist_t * list, retireditem_t * item) {
+    item->next = NULL;
+    if ( list->tail ) {
+        list->tail->next = item;
+    } else {
+        list->head = item;
+    }
+    list->tail = item;
+}
+
+@end
+
+#pragma mark - Reclamation thread
+
+@implementation AEManagedValueReclamationThread
+
+- (instancetype)init {
+    if ( !(self = [super init]) ) return nil;
+    semaphore_create(mach_task_self(), &_semaphore, SYNC_POLICY_FIFO, 0);
+    return self;
+}
+
+- (void)dealloc {
+    semaphore_destroy(mach_task_self(), _semaphore);
+}
+
+- (void)cancel {
+    [super cancel];
+    semaphore_signal(_semaphore);
+}
+
+- (void)main {
+    pthread_setname_np("AEManagedValueReclamation");
+    pthread_set_qos_class_self_np(QOS_CLASS_UTILITY, 0);
+    
+    while ( !self.cancelled ) {
+        BOOL poll;
+        @autoreleasepool {
+            poll = AEManagedValueReclaimRetiredValues();
+        }
+        
+        if ( poll ) {
+            // Poll until the render threads pass the outstanding values' epochs
+            mach_timespec_t interval = { 0, (clock_res_t)(kReclamationInterval * NSEC_PER_SEC) };
+            semaphore_timedwait(_semaphore, interval);
+        } else {
+            semaphore_wait(_semaphore);
+        }
+    }
+}
+
 @end
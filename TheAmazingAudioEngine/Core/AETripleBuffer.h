@@ -0,0 +1,117 @@
+//
+//  AETripleBuffer.h
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    
+#import <Foundation/Foundation.h>
+
+/*!
+ * Triple buffer
+ *
+ *  This class passes a fixed-size block of state from one writer thread to one reader thread,
+ *  latest-value-wins, without locks or allocations. Use it for state that changes continuously, like
+ *  filter coefficient sets, meter configurations or automation snapshots updated from the UI, where
+ *  AEManagedValue would allocate and release a new value for every update.
+ *
+ *  Three buffers are allocated up front: the writer fills one, the reader holds another, and the
+ *  third holds the most recently published value. Publishing and reading each swap a buffer with
+ *  the published one in a single atomic operation, so neither side ever waits for the other.
+ *  Intermediate values published between two reads are skipped.
+ *
+ *  There may be only one writer and one reader at a time. The Objective-C methods and
+ *  AETripleBufferGetWriteBuffer/AETripleBufferPublish make up the writer side; AETripleBufferRead
+ *  is the reader side, usually called on the audio thread.
+ */
+@interface AETripleBuffer : NSObject
+
+/*!
+ * Initializer
+ *
+ * @param size Size of the state, in bytes
+ * @param bytes Initial value, or NULL to start zero-filled
+ */
+- (instancetype _Nullable)initWithSize:(size_t)size initialValue:(const void * _Nullable)bytes;
+
+/*!
+ * Publish a new value, copied from the given bytes
+ *
+ * @param bytes Pointer to size bytes
+ */
+- (void)writeBytes:(const void * _Nonnull)bytes;
+
+/*!
+ * Publish a modified copy of the latest value
+ *
+ *  The block is given a buffer holding a copy of the last value published, which it can modify
+ *  in place. The result is published when the block returns.
+ *
+ * @param block Block to modify the value
+ */
+- (void)updateWithBlock:(void(^ _Nonnull)(void * _Nonnull buffer))block;
+
+/*!
+ * Get the buffer to write the next value into, for the writer thread
+ *
+ *  The contents of the buffer are unspecified, and should be overwritten entirely. Call
+ *  AETripleBufferPublish once done.
+ *
+ * @param buffer The instance
+ * @return Buffer of the instance's size, owned by the writer until published
+ */
+void * _Nonnull AETripleBufferGetWriteBuffer(__unsafe_unretained AETripleBuffer * _Nonnull buffer);
+
+/*!
+ * Publish the value in the write buffer, for the writer thread
+ *
+ *  Wait-free. The buffer returned by AETripleBufferGetWriteBuffer is no longer valid after this call.
+ *
+ * @param buffer The instance
+ */
+void AETripleBufferPublish(__unsafe_unretained AETripleBuffer * _Nonnull buffer);
+
+/*!
+ * Get the latest value, for the reader thread
+ *
+ *  Wait-free and realtime-safe. The value returned remains valid and unchanged until the next call
+ *  to this function. The first call reports a change, so the reader can set up any state derived from
+ *  the initial value.
+ *
+ * @param buffer The instance
+ * @param outChanged If not NULL, set to YES if a new value has been published since the last call
+ * @return Pointer to the latest value
+ */
+const void * _Nonnull AETripleBufferRead(__unsafe_unretained AETripleBuffer * _Nonnull buffer, BOOL * _Nullable outChanged);
+
+//! Size of the state, in bytes
+@property (nonatomic, readonly) size_t size;
+
+@end
+
+#ifdef __cplusplus
+}
+#endif
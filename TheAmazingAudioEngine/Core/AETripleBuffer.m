@@ -0,0 +1,113 @@
+//
+//  AETripleBuffer.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+#import "AETripleBuffer.h"
+#import <stdatomic.h>
+
+// Each buffer starts on its own cache line, so the reader and writer don't contend
+#define kCacheLineSize 64
+
+// The shared state holds the index of the published buffer, and whether the reader has yet to take it
+#define kPublishedIndexMask 0x3
+#define kPublishedNewFlag   0x4
+
+@interface AETripleBuffer () {
+    char * _storage;
+    size_t _stride;
+    _Atomic(uint32_t) _published;
+    int _writeIndex;            // Writer only
+    int _lastPublishedIndex;    // Writer only
+    int _readIndex;             // Reader only
+}
+@end
+
+@implementation AETripleBuffer
+
+- (instancetype)initWithSize:(size_t)size initialValue:(const void *)bytes {
+    if ( !(self = [super init]) ) return nil;
+    
+    _size = size;
+    _stride = MAX(kCacheLineSize, (size + kCacheLineSize - 1) & ~(size_t)(kCacheLineSize - 1));
+    if ( posix_memalign((void**)&_storage, kCacheLineSize, _stride * 3) != 0 ) return nil;
+    for ( int i=0; i<3; i++ ) {
+        if ( bytes ) {
+            memcpy(_storage + (_stride * i), bytes, size);
+        } else {
+            memset(_storage + (_stride * i), 0, size);
+        }
+    }
+    
+    // Start with the initial value published and unread
+    _readIndex = 0;
+    _lastPublishedIndex = 1;
+    _writeIndex = 2;
+    atomic_init(&_published, 1 | kPublishedNewFlag);
+    
+    return self;
+}
+
+- (void)dealloc {
+    free(_storage);
+}
+
+- (void)writeBytes:(const void *)bytes {
+    memcpy(AETripleBufferGetWriteBuffer(self), bytes, _size);
+    AETripleBufferPublish(self);
+}
+
+- (void)updateWithBlock:(void (^)(void * _Nonnull))block {
+    // The last published buffer is only ever read by the reader, so it's safe to copy from
+    void * buffer = AETripleBufferGetWriteBuffer(self);
+    memcpy(buffer, _storage + (_stride * _lastPublishedIndex), _size);
+    block(buffer);
+    AETripleBufferPublish(self);
+}
+
+void * AETripleBufferGetWriteBuffer(__unsafe_unretained AETripleBuffer * THIS) {
+    return THIS->_storage + (THIS->_stride * THIS->_writeIndex);
+}
+
+void AETripleBufferPublish(__unsafe_unretained AETripleBuffer * THIS) {
+    // Swap the write buffer for the published one: the reader holds neither, so whichever we get back is free
+    THIS->_lastPublishedIndex = THIS->_writeIndex;
+    uint32_t prior = atomic_exchange_explicit(&THIS->_published, (uint32_t)THIS->_writeIndex | kPublishedNewFlag,
+                                              memory_order_acq_rel);
+    THIS->_writeIndex = prior & kPublishedIndexMask;
+}
+
+const void * AETripleBufferRead(__unsafe_unretained AETripleBuffer * THIS, BOOL * outChanged) {
+    BOOL changed = NO;
+    if ( atomic_load_explicit(&THIS->_published, memory_order_relaxed) & kPublishedNewFlag ) {
+        // Swap the buffer we hold for the newly published one
+        uint32_t prior = atomic_exchange_explicit(&THIS->_published, (uint32_t)THIS->_readIndex, memory_order_acq_rel);
+        THIS->_readIndex = prior & kPublishedIndexMask;
+        changed = YES;
+    }
+    if ( outChanged ) *outChanged = changed;
+    return THIS->_storage + (THIS->_stride * THIS->_readIndex);
+}
+
+@end
@@ -0,0 +1,45 @@
+//
+//  TPCircularBuffer+MPSC.c
+//  Circular/Ring buffer implementation
+//
+//  https://github.com/michaeltyson/TPCircularBuffer
+//
+//  Created by Michael Tyson on 18/10/2026.
+//
+//  Copyright (C) 2026 A Tasty Pixel
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+#include "TPCircularBuffer+MPSC.h"
+
+bool TPMPSCBufferInit(TPMPSCBuffer *buffer, int32_t length) {
+    if (!TPCircularBufferInit(&buffer->storage, length)) {
+        return false;
+    }
+    // Messages are laid out on 8-byte boundaries, which the page-multiple length preserves
+    assert(buffer->storage.length % 8 == 0);
+    memset(buffer->storage.buffer, 0, buffer->storage.length);
+    atomic_init(&buffer->head, 0);
+    atomic_init(&buffer->tail, 0);
+    return true;
+}
+
+void TPMPSCBufferCleanup(TPMPSCBuffer *buffer) {
+    TPCircularBufferCleanup(&buffer->storage);
+}
@@ -0,0 +1,216 @@
+//
+//  TPCircularBuffer+MPSC.h
+//  Circular/Ring buffer implementation
+//
+//  https://github.com/michaeltyson/TPCircularBuffer
+//
+//  Created by Michael Tyson on 18/10/2026.
+//
+//  Copyright (C) 2026 A Tasty Pixel
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+#ifndef TPCircularBuffer_MPSC_h
+#define TPCircularBuffer_MPSC_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "TPCircularBuffer.h"
+#include <stdint.h>
+
+/*!
+ * Multi-producer, single-consumer message buffer
+ *
+ *  Any number of threads may write variable-length messages into this single shared buffer,
+ *  and one consumer reads them back in the order they were reserved. Unlike TPMultiProducerBuffer,
+ *  there are no per-thread buffers to claim, so producers never scan for their buffer, and the
+ *  consumer sees messages from different producers in a single order.
+ *
+ *  Producers call TPMPSCBufferReserve to claim space for a message, write it, then call
+ *  TPMPSCBufferCommit. Reserving takes one compare-and-swap, retried only when another producer
+ *  reserves at the same moment; it never waits for the consumer or for other producers to
+ *  commit. A reserved message must always be either committed, or given up with
+ *  TPMPSCBufferAbandon, as the consumer stops at the first message that is neither.
+ *
+ *  The consumer calls TPMPSCBufferNextMessage to access the next committed message, and
+ *  TPMPSCBufferConsume when done with it.
+ */
+typedef struct {
+    TPCircularBuffer storage;   // Provides the mirrored memory; its own head and tail are unused
+    atomic_ullong head;         // Total bytes reserved by producers
+    atomic_ullong tail;         // Total bytes consumed
+} TPMPSCBuffer;
+
+//! Message header
+typedef struct {
+    atomic_uint state;
+    uint32_t length;
+} TPMPSCBufferMessageHeader;
+
+//! Message states
+enum {
+    TPMPSCBufferMessageReserved = 0,
+    TPMPSCBufferMessageCommitted,
+    TPMPSCBufferMessageAbandoned
+};
+
+/*!
+ * Initialize a multi-producer, single-consumer buffer
+ *
+ *  As with TPCircularBuffer, the true length will be a multiple of the device page size.
+ *  Each message occupies 8 bytes more than its length, rounded up to a multiple of 8 bytes.
+ *
+ * @param buffer The buffer to initialize
+ * @param length The length of the buffer
+ * @return true if successful, false if insufficient memory
+ */
+bool TPMPSCBufferInit(TPMPSCBuffer *buffer, int32_t length);
+
+/*!
+ * Free resources
+ *
+ * @param buffer The buffer to clean up
+ */
+void TPMPSCBufferCleanup(TPMPSCBuffer *buffer);
+
+static __inline__ __attribute__((always_inline)) uint32_t _TPMPSCBufferMessageSize(uint32_t length) {
+    return (uint32_t)((sizeof(TPMPSCBufferMessageHeader) + length + 7) & ~7);
+}
+
+/*!
+ * Reserve space for a message
+ *
+ *  Safe to call from any number of threads at once. Write the message to the returned
+ *  space, then call TPMPSCBufferCommit.
+ *
+ * @param buffer The buffer
+ * @param length The length of the message, in bytes
+ * @return Pointer to the space for the message, aligned to 8 bytes, or NULL if there's not enough room
+ */
+static __inline__ __attribute__((always_inline)) void * TPMPSCBufferReserve(TPMPSCBuffer *buffer, uint32_t length) {
+    uint64_t size = _TPMPSCBufferMessageSize(length);
+    uint64_t head = atomic_load_explicit(&buffer->head, memory_order_relaxed);
+    do {
+        // A stale head may lag the tail; that's not a full buffer, and the exchange will refresh it
+        uint64_t tail = atomic_load_explicit(&buffer->tail, memory_order_acquire);
+        if ( (int64_t)(head + size - tail) > (int64_t)buffer->storage.length ) return NULL;
+    } while ( !atomic_compare_exchange_weak_explicit(&buffer->head, &head, head + size,
+                                                     memory_order_relaxed, memory_order_relaxed) );
+    
+    TPMPSCBufferMessageHeader *header =
+        (TPMPSCBufferMessageHeader*)((char*)buffer->storage.buffer + (head % (uint64_t)buffer->storage.length));
+    header->length = length;
+    return header + 1;
+}
+
+/*!
+ * Commit a message, making it available to the consumer
+ *
+ * @param buffer The buffer
+ * @param message The pointer returned from TPMPSCBufferReserve
+ */
+static __inline__ __attribute__((always_inline)) void TPMPSCBufferCommit(TPMPSCBuffer *buffer, void *message) {
+    TPMPSCBufferMessageHeader *header = (TPMPSCBufferMessageHeader*)message - 1;
+    atomic_store_explicit(&header->state, TPMPSCBufferMessageCommitted, memory_order_release);
+}
+
+/*!
+ * Abandon a reserved message
+ *
+ *  Use this instead of TPMPSCBufferCommit to give up a message after reserving it. The consumer
+ *  skips the message, and continues with those reserved after it.
+ *
+ * @param buffer The buffer
+ * @param message The pointer returned from TPMPSCBufferReserve
+ */
+static __inline__ __attribute__((always_inline)) void TPMPSCBufferAbandon(TPMPSCBuffer *buffer, void *message) {
+    TPMPSCBufferMessageHeader *header = (TPMPSCBufferMessageHeader*)message - 1;
+    atomic_store_explicit(&header->state, TPMPSCBufferMessageAbandoned, memory_order_release);
+}
+
+/*!
+ * Consume the message returned by TPMPSCBufferNextMessage
+ *
+ *  For use by the consumer only.
+ *
+ * @param buffer The buffer
+ */
+static __inline__ __attribute__((always_inline)) void TPMPSCBufferConsume(TPMPSCBuffer *buffer) {
+    uint64_t tail = atomic_load_explicit(&buffer->tail, memory_order_relaxed);
+    TPMPSCBufferMessageHeader *header =
+        (TPMPSCBufferMessageHeader*)((char*)buffer->storage.buffer + (tail % (uint64_t)buffer->storage.length));
+    uint32_t size = _TPMPSCBufferMessageSize(header->length);
+    
+    // Clear the whole message, as later headers may land anywhere within it. The state is cleared
+    // atomically, as TPMPSCBufferHasMessage may be reading it from another thread
+    memset((char*)header + sizeof(header->state), 0, size - sizeof(header->state));
+    atomic_store_explicit(&header->state, TPMPSCBufferMessageReserved, memory_order_relaxed);
+    atomic_store_explicit(&buffer->tail, tail + size, memory_order_release);
+}
+
+/*!
+ * Determine whether the next message is ready for the consumer
+ *
+ *  Safe to call from any thread. True if TPMPSCBufferNextMessage would find the next message
+ *  committed or abandoned; a message that has been reserved but not yet committed doesn't count.
+ *  When called from a thread other than the consumer, the answer may already be out of date.
+ *
+ * @param buffer The buffer
+ * @return Whether a message is ready
+ */
+static __inline__ __attribute__((always_inline)) bool TPMPSCBufferHasMessage(TPMPSCBuffer *buffer) {
+    uint64_t tail = atomic_load_explicit(&buffer->tail, memory_order_acquire);
+    if ( atomic_load_explicit(&buffer->head, memory_order_relaxed) == tail ) return false;
+    TPMPSCBufferMessageHeader *header =
+        (TPMPSCBufferMessageHeader*)((char*)buffer->storage.buffer + (tail % (uint64_t)buffer->storage.length));
+    return atomic_load_explicit(&header->state, memory_order_acquire) != TPMPSCBufferMessageReserved;
+}
+
+/*!
+ * Access the next message
+ *
+ *  For use by the consumer only. Abandoned messages are consumed along the way.
+ *
+ * @param buffer The buffer
+ * @param length On output, the length of the message
+ * @return Pointer to the message, or NULL if the next message hasn't been committed yet
+ */
+static __inline__ __attribute__((always_inline)) void * TPMPSCBufferNextMessage(TPMPSCBuffer *buffer, uint32_t *length) {
+    while ( 1 ) {
+        uint64_t tail = atomic_load_explicit(&buffer->tail, memory_order_relaxed);
+        TPMPSCBufferMessageHeader *header =
+            (TPMPSCBufferMessageHeader*)((char*)buffer->storage.buffer + (tail % (uint64_t)buffer->storage.length));
+        unsigned int state = atomic_load_explicit(&header->state, memory_order_acquire);
+        if ( state == TPMPSCBufferMessageReserved ) return NULL;
+        if ( state == TPMPSCBufferMessageAbandoned ) {
+            TPMPSCBufferConsume(buffer);
+            continue;
+        }
+        *length = header->length;
+        return header + 1;
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -34,6 +34,10 @@
 #include <stdio.h>
 #include <limits.h>
 
+// The buffer this thread last used, and its entry there, to skip the scan on repeat sends
+static __thread TPMultiProducerBuffer *__cachedBuffer = NULL;
+static __thread int __cachedIndex = 0;
+
 bool TPMultiProducerBufferInit(TPMultiProducerBuffer *mpBuffer, int32_t length, int maxProducerCount) {
     if (maxProducerCount <= 0) return false;
     mpBuffer->maxProducerCount = maxProducerCount;
@@ -45,6 +49,7 @@ bool TPMultiProducerBufferInit(TPMultiProducerBuffer *mpBuffer, int32_t length,
     for (int i = 0; i < maxProducerCount; i++) {
         mpBuffer->producerEntries[i].threadId = 0;  // unclaimed
         mpBuffer->producerEntries[i].lastUse = 0;
+        mpBuffer->producerEntries[i].recentlyUsed = false;
         if (!TPCircularBufferInit(&mpBuffer->producerEntries[i].buffer, length)) {
             // Cleanup any previously initialized buffers on error.
             for (int j = 0; j < i; j++) {
@@ -75,6 +80,19 @@ TPCircularBuffer * TPMultiProducerBufferGetProducerBuffer(TPMultiProducerBuffer
     }
     
     pthread_t currentThread = pthread_self();
+    
+    // Check the entry this thread used last time, which is still ours unless another thread took it over.
+    // Flag the entry as used; only when the flag was clear (once per takeover) read the clock to refresh
+    // its timestamp, so an active producer never ages behind idle ones
+    if (__cachedBuffer == mpBuffer && __cachedIndex < mpBuffer->maxProducerCount &&
+        pthread_equal(mpBuffer->producerEntries[__cachedIndex].threadId, currentThread)) {
+        if (!mpBuffer->producerEntries[__cachedIndex].recentlyUsed) {
+            mpBuffer->producerEntries[__cachedIndex].lastUse = mach_absolute_time();
+            mpBuffer->producerEntries[__cachedIndex].recentlyUsed = true;
+        }
+        return &mpBuffer->producerEntries[__cachedIndex].buffer;
+    }
+    
     uint64_t now = mach_absolute_time();
     
     // Scan the array for an entry already claimed by this thread
@@ -82,6 +100,9 @@ TPCircularBuffer * TPMultiProducerBufferGetProducerBuffer(TPMultiProducerBuffer
         if (mpBuffer->producerEntries[i].threadId &&
             pthread_equal(mpBuffer->producerEntries[i].threadId, currentThread)) {
             mpBuffer->producerEntries[i].lastUse = now;
+            mpBuffer->producerEntries[i].recentlyUsed = true;
+            __cachedBuffer = mpBuffer;
+            __cachedIndex = i;
             return &mpBuffer->producerEntries[i].buffer;
         }
     }
@@ -96,18 +117,26 @@ TPCircularBuffer * TPMultiProducerBufferGetProducerBuffer(TPMultiProducerBuffer
         }
     }
     
-    // Find the oldest entry
+    // Find the oldest entry not used since the last takeover, or failing that, the oldest entry.
+    // Clear the flags as we go, so each entry must be used again to be passed over next time
     int oldestIndex = -1;
     uint64_t oldestTime = UINT64_MAX;
+    int oldestUnusedIndex = -1;
+    uint64_t oldestUnusedTime = UINT64_MAX;
     if ( chosenIndex == -1 ) {
         for (int i = 0; i < mpBuffer->maxProducerCount; i++) {
+            if (!mpBuffer->producerEntries[i].recentlyUsed && mpBuffer->producerEntries[i].lastUse < oldestUnusedTime) {
+                oldestUnusedTime = mpBuffer->producerEntries[i].lastUse;
+                oldestUnusedIndex = i;
+            }
             if (mpBuffer->producerEntries[i].lastUse < oldestTime) {
                 oldestTime = mpBuffer->producerEntries[i].lastUse;
-                priorOwnerThread = mpBuffer->producerEntries[i].threadId;
                 oldestIndex = i;
             }
+            mpBuffer->producerEntries[i].recentlyUsed = false;
         }
-        chosenIndex = oldestIndex;
+        chosenIndex = oldestUnusedIndex != -1 ? oldestUnusedIndex : oldestIndex;
+        priorOwnerThread = mpBuffer->producerEntries[chosenIndex].threadId;
     }
     
     // Claim the entry
@@ -116,6 +145,9 @@ TPCircularBuffer * TPMultiProducerBufferGetProducerBuffer(TPMultiProducerBuffer
         return TPMultiProducerBufferGetProducerBuffer(mpBuffer);
     }
     mpBuffer->producerEntries[chosenIndex].lastUse = now;
+    mpBuffer->producerEntries[chosenIndex].recentlyUsed = true;
+    __cachedBuffer = mpBuffer;
+    __cachedIndex = chosenIndex;
     return &mpBuffer->producerEntries[chosenIndex].buffer;
 }
 
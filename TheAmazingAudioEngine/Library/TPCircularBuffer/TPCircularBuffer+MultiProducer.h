@@ -42,7 +42,8 @@ typedef struct {
     struct {
         pthread_t threadId;         // The thread that owns this buffer (zero if unclaimed)
         TPCircularBuffer buffer;    // The circular buffer for that thread
-        uint64_t lastUse;           // Timestamp (in ticks) when this buffer was last used
+        uint64_t lastUse;           // Timestamp (in ticks) when this buffer was last used with its flag clear
+        bool recentlyUsed;          // Whether this buffer has been used since another thread last took one over
     } * producerEntries;
 } TPMultiProducerBuffer;
 
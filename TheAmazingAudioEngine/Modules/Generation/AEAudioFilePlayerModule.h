@@ -31,7 +31,7 @@
 extern "C" {
 #endif
 
-#import "AEAudioUnitModule.h"
+#import "AEModule.h"
 #import "AETime.h"
 
 //! Completion/begin block
@@ -43,11 +43,23 @@ typedef void (^AEAudioFilePlayerModuleBlock)(void);
  *  This class allows you to play audio files, either as one-off samples, or looped.
  *  It will play any audio file format supported by iOS.
  *
+ *  Audio is streamed from disk with AEAudioFileStream: a shared background thread decodes
+ *  a short way ahead of each player's position, so memory use per player stays small and
+ *  hundreds of files can play at once. Seeking, region changes and skipping ahead to catch up
+ *  with a start time in the past are all constant-time operations on the audio thread, and
+ *  loops are seamless, sample-accurate joins from the end of the region to its start.
+ *
  *  When processing, it will push a buffer onto the stack containing audio from the
  *  playing file, or silence if not playing. The number of channels in the pushed buffer
  *  matches the channels from the audio file.
+ *
+ *  Note: this class used to be a subclass of AEAudioUnitModule, wrapping AUAudioFilePlayer.
+ *  It now derives directly from AEModule, so the AEAudioUnitModule API - `audioUnit`,
+ *  AEAudioUnitModuleGetAudioUnit, `componentDescription`, `wetDry`, `subrenderer` and the
+ *  parameter accessors - is no longer available. Code that configured the underlying audio
+ *  unit directly should use the properties below instead.
  */
-@interface AEAudioFilePlayerModule : AEAudioUnitModule
+@interface AEAudioFilePlayerModule : AEModule
 
 /*!
  * Default initialiser
@@ -113,6 +125,9 @@ BOOL AEAudioFilePlayerModuleGetPlaying(__unsafe_unretained AEAudioFilePlayerModu
 //! Original media path
 @property (nonatomic, strong, readonly) NSString * _Nullable path;
 
+//! Number of channels in the audio file
+@property (nonatomic, readonly) int numberOfChannels;
+
 //! Length of audio file, in seconds
 @property (nonatomic, readonly) AESeconds duration;
 
@@ -34,25 +34,26 @@
 #import "AEDSPUtilities.h"
 #import "AEManagedValue.h"
 #import "AEMainThreadEndpoint.h"
+#import "AEAudioFileStream.h"
+#import "AERenderer.h"
 
 static const UInt32 kNoValue = -1;
+static const AESeconds kStreamBufferDuration = 0.5;
 
 @interface AEAudioFilePlayerModule () {
-    AudioFileID _audioFile;
-    double      _fileSampleRate;
     int         _channels;
-    UInt32      _lengthInFrames;
+    AESeconds   _duration;
     AESeconds   _regionDuration;
     AESeconds   _regionStartTime;
     BOOL        _stopEventScheduled;
-    BOOL        _sequenceScheduled;
     AudioTimeStamp _startTime;
     AEHostTicks _anchorTime;
-    double      _playhead;
+    AESeconds   _playhead;
     UInt32      _remainingMicrofadeInFrames;
     UInt32      _remainingMicrofadeOutFrames;
 }
 @property (nonatomic, strong, readwrite) NSString * path;
+@property (nonatomic, strong) AEManagedValue * streamValue;
 @property (nonatomic, strong) AEManagedValue * mainThreadEndpointValue;
 @property (nonatomic, copy) void(^beginBlock)(void);
 @end
@@ -60,32 +61,30 @@ static const UInt32 kNoValue = -1;
 @implementation AEAudioFilePlayerModule
 
 - (instancetype)initWithRenderer:(AERenderer *)renderer path:(NSString *)path error:(NSError *__autoreleasing *)error {
-    if ( !(self = [super initWithRenderer:renderer componentDescription:
-                   AEAudioComponentDescriptionMake(kAudioUnitManufacturer_Apple,
-                                                   kAudioUnitType_Generator,
-                                                   kAudioUnitSubType_AudioFilePlayer)]) ) return nil;
+    if ( !(self = [super initWithRenderer:renderer]) ) return nil;
     
-    if ( ![self loadAudioFileWithPath:path error:error] ) {
+    AEAudioFileStream * stream = [[AEAudioFileStream alloc] initWithPath:path sampleRate:renderer.sampleRate
+                                                          bufferDuration:kStreamBufferDuration error:error];
+    if ( !stream ) {
         return nil;
     }
     
-    if ( ![self setup] ) return nil;
-    [self initialize];
+    _channels = stream.numberOfChannels;
+    _duration = (double)stream.length / stream.sampleRate;
+    _regionStartTime = 0;
+    _regionDuration = _duration;
+    self.path = path;
+    self.streamValue = [AEManagedValue new];
+    self.streamValue.objectValue = stream;
     
     self.processFunction = AEAudioFilePlayerModuleProcess;
-    self.isActiveFunction = AEAudioFilePlayerModuleGetPlaying;
+    self.isActiveFunction = AEAudioFilePlayerModuleIsActive;
     
     self.mainThreadEndpointValue = [AEManagedValue new];
     
     return self;
 }
 
-- (void)dealloc {
-    if ( _audioFile ) {
-        AudioFileClose(_audioFile);
-    }
-}
-
 - (void)setCompletionBlock:(void (^)(void))completionBlock {
     _completionBlock = completionBlock;
     
@@ -124,10 +123,6 @@ static const UInt32 kNoValue = -1;
         if ( (self.beginBlock || (self.completionBlock && !self.loop)) && !self.mainThreadEndpointValue.objectValue ) {
             [self setupMainThreadEndpoint];
         }
-        
-        if ( !_sequenceScheduled ) {
-            [self schedulePlayRegionFromPosition:_playhead];
-        }
     }
 }
 
@@ -135,8 +130,6 @@ static const UInt32 kNoValue = -1;
     self.beginBlock = nil;
     if ( _startTime.mFlags != 0 ) {
         // Not yet playing - just stop now
-        AECheckOSStatus(AudioUnitReset(self.audioUnit, kAudioUnitScope_Global, 0), "AudioUnitReset");
-        _sequenceScheduled = NO;
         _playing = NO;
         if ( self.completionBlock ) self.completionBlock();
         if ( self.mainThreadEndpointValue.objectValue ) {
@@ -150,8 +143,12 @@ static const UInt32 kNoValue = -1;
     }
 }
 
+- (int)numberOfChannels {
+    return _channels;
+}
+
 - (AESeconds)duration {
-    return (double)_lengthInFrames / (double)_fileSampleRate;
+    return _duration;
 }
 
 - (AESeconds)currentTime {
@@ -159,7 +156,7 @@ static const UInt32 kNoValue = -1;
 }
 
 - (void)setCurrentTime:(AESeconds)currentTime {
-    [self schedulePlayRegionFromPosition:round(currentTime * _fileSampleRate)];
+    [self seekToTime:currentTime];
 }
 
 - (void)setRegionDuration:(NSTimeInterval)regionDuration {
@@ -169,13 +166,13 @@ static const UInt32 kNoValue = -1;
         regionDuration = 0;
     }
     
-    if ( regionDuration > (_lengthInFrames / _fileSampleRate) - _regionStartTime ) {
-        regionDuration = (_lengthInFrames / _fileSampleRate) - _regionStartTime;
+    if ( regionDuration > _duration - _regionStartTime ) {
+        regionDuration = _duration - _regionStartTime;
     }
     
     _regionDuration = regionDuration;
     
-    [self schedulePlayRegionFromPosition:_playhead];
+    [self seekToTime:_playhead];
 }
 
 - (void)setRegionStartTime:(NSTimeInterval)regionStartTime {
@@ -185,35 +182,50 @@ static const UInt32 kNoValue = -1;
         regionStartTime = 0;
     }
     
-    if ( regionStartTime > _lengthInFrames / _fileSampleRate ) {
-        regionStartTime = _lengthInFrames / _fileSampleRate;
+    if ( regionStartTime > _duration ) {
+        regionStartTime = _duration;
     }
-    if ( _regionDuration > (_lengthInFrames / _fileSampleRate) - regionStartTime ) {
-        _regionDuration = (_lengthInFrames / _fileSampleRate) - regionStartTime;
+    if ( _regionDuration > _duration - regionStartTime ) {
+        _regionDuration = _duration - regionStartTime;
     }
     
     _regionStartTime = regionStartTime;
     
-    [self schedulePlayRegionFromPosition:round(_regionStartTime * _fileSampleRate)];
+    [self seekToTime:_regionStartTime];
 }
 
 - (void)setLoop:(BOOL)loop {
     _loop = loop;
+    ((AEAudioFileStream *)self.streamValue.objectValue).loop = loop;
     
     if ( !_loop && self.completionBlock && !self.mainThreadEndpointValue.objectValue ) {
         [self setupMainThreadEndpoint];
     }
 }
 
+- (void)rendererDidChangeSampleRate {
+    AEAudioFileStream * stream = self.streamValue.objectValue;
+    double sampleRate = self.renderer.sampleRate;
+    if ( !stream || sampleRate <= 0 || fabs(stream.sampleRate - sampleRate) < DBL_EPSILON ) return;
+    
+    // Reopen the stream to decode at the new rate, from the same position
+    stream = [[AEAudioFileStream alloc] initWithPath:self.path sampleRate:sampleRate
+                                      bufferDuration:kStreamBufferDuration error:NULL];
+    if ( !stream ) return;
+    
+    stream.loop = _loop;
+    [self seekStream:stream toTime:_playhead];
+    self.streamValue.objectValue = stream;
+}
+
 AESeconds AEAudioFilePlayerModuleGetPlayhead(__unsafe_unretained AEAudioFilePlayerModule * THIS, AEHostTicks time) {
     if ( !THIS->_playing || !THIS->_anchorTime ) {
-        return THIS->_playhead / THIS->_fileSampleRate;
+        return THIS->_playhead;
     }
     
-    AESeconds playhead = THIS->_playhead / THIS->_fileSampleRate;
     AESeconds offset = time > THIS->_anchorTime ? AESecondsFromHostTicks(time - THIS->_anchorTime)
                                                 : -AESecondsFromHostTicks(THIS->_anchorTime - time);
-    AESeconds timeline = playhead + offset;
+    AESeconds timeline = THIS->_playhead + offset;
     
     if ( !THIS->_loop ) {
         return MIN(timeline, THIS->_regionStartTime + THIS->_regionDuration);
@@ -226,6 +238,14 @@ BOOL AEAudioFilePlayerModuleGetPlaying(__unsafe_unretained AEAudioFilePlayerModu
     return THIS->_playing;
 }
 
+static BOOL AEAudioFilePlayerModuleIsActive(__unsafe_unretained AEAudioFilePlayerModule * THIS) {
+    if ( THIS->_playing ) return YES;
+    
+    // Stay active while stopped until a seek is picked up, so the stream can prefetch the new position
+    __unsafe_unretained AEAudioFileStream * stream = (__bridge AEAudioFileStream *)AEManagedValueGetValue(THIS->_streamValue);
+    return stream && AEAudioFileStreamHasPendingSeek(stream);
+}
+
 - (void)setupMainThreadEndpoint {
     __unsafe_unretained AEAudioFilePlayerModule * weakSelf = self;
     self.mainThreadEndpointValue.objectValue
@@ -240,182 +260,38 @@ BOOL AEAudioFilePlayerModuleGetPlaying(__unsafe_unretained AEAudioFilePlayerModu
         
         if ( weakSelf->_stopEventScheduled ) {
             weakSelf->_stopEventScheduled = NO;
-            AECheckOSStatus(AudioUnitReset(weakSelf.audioUnit, kAudioUnitScope_Global, 0), "AudioUnitReset");
-            weakSelf->_sequenceScheduled = NO;
-            weakSelf->_playing = NO;
+            [weakSelf seekToTime:weakSelf->_regionStartTime];
             if ( weakSelf.completionBlock ) weakSelf.completionBlock();
             weakSelf.mainThreadEndpointValue.objectValue = nil;
         }
     }];
 }
 
-- (BOOL)loadAudioFileWithPath:(NSString *)path error:(NSError**)error {
-    OSStatus result;
-    
-    // Open the file
-    result = AudioFileOpenURL((__bridge CFURLRef)[NSURL fileURLWithPath:path], kAudioFileReadPermission, 0, &_audioFile);
-    if ( !AECheckOSStatus(result, "AudioFileOpenURL") ) {
-        if ( error )
-        *error = [NSError errorWithDomain:NSOSStatusErrorDomain code:result
-                                 userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"Couldn't open the audio file", @"")}];
-        return NO;
-    }
-    
-    // Get the file data format
-    AudioStreamBasicDescription fileDescription;
-    UInt32 size = sizeof(fileDescription);
-    result = AudioFileGetProperty(_audioFile, kAudioFilePropertyDataFormat, &size, &fileDescription);
-    if ( !AECheckOSStatus(result, "AudioFileGetProperty(kAudioFilePropertyDataFormat)") ) {
-        if ( error )
-        *error = [NSError errorWithDomain:NSOSStatusErrorDomain code:result
-                                 userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"Couldn't read the audio file", @"")}];
-        AudioFileClose(_audioFile);
-        _audioFile = NULL;
-        return NO;
-    }
-    
-    // Determine length in frames (in original file's sample rate)
-    AudioFilePacketTableInfo packetInfo;
-    size = sizeof(packetInfo);
-    result = AudioFileGetProperty(_audioFile, kAudioFilePropertyPacketTableInfo, &size, &packetInfo);
-    if ( result != noErr ) {
-        size = 0;
-    }
-    
-    UInt64 fileLengthInFrames;
-    if ( size > 0 ) {
-        fileLengthInFrames = packetInfo.mNumberValidFrames;
-    } else {
-        UInt64 packetCount;
-        size = sizeof(packetCount);
-        result = AudioFileGetProperty(_audioFile, kAudioFilePropertyAudioDataPacketCount, &size, &packetCount);
-        if ( !AECheckOSStatus(result, "AudioFileGetProperty(kAudioFilePropertyAudioDataPacketCount)") ) {
-            if ( error )
-            *error = [NSError errorWithDomain:NSOSStatusErrorDomain code:result
-                                     userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"Couldn't read the audio file", @"")}];
-            AudioFileClose(_audioFile);
-            _audioFile = NULL;
-            return NO;
-        }
-        fileLengthInFrames = packetCount * fileDescription.mFramesPerPacket;
-    }
-    
-    if ( fileLengthInFrames == 0 ) {
-        if ( error )
-        *error = [NSError errorWithDomain:NSOSStatusErrorDomain code:-50
-                                 userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"This audio file is empty", @"")}];
-        AudioFileClose(_audioFile);
-        _audioFile = NULL;
-        return NO;
-    }
-    
-    _fileSampleRate = fileDescription.mSampleRate;
-    _channels = fileDescription.mChannelsPerFrame;
-    _lengthInFrames = (UInt32)fileLengthInFrames;
-    _regionStartTime = 0;
-    _regionDuration = (double)_lengthInFrames / _fileSampleRate;
-    self.path = path;
-    
-    return YES;
-}
-
-- (BOOL)setup {
-    if ( !_audioFile ) {
-        // Defer setup until loaded
-        return YES;
-    }
-    
-    return [super setup];
+- (void)seekToTime:(AESeconds)time {
+    [self seekStream:self.streamValue.objectValue toTime:time];
 }
 
-- (void)initialize {
-    if ( !_audioFile ) {
-        // Defer initialization until loaded
-        return;
-    }
-    
-    [super initialize];
-    [self schedulePlayRegionFromPosition:_playhead];
-}
-
-- (int)numberOfChannels {
-    return _channels;
-}
-
-- (void)schedulePlayRegionFromPosition:(UInt32)position {
-    // Note: "position" is in frames, in the input file's sample rate
-    AudioUnit audioUnit = self.audioUnit;
-    if ( !audioUnit || !_audioFile ) {
-        return;
-    }
+- (void)seekStream:(AEAudioFileStream *)stream toTime:(AESeconds)time {
+    if ( !stream ) return;
     
     // Make sure region is valid
-    if (self.regionStartTime > self.duration) {
-        _regionStartTime = self.duration;
+    if ( _regionStartTime > _duration ) {
+        _regionStartTime = _duration;
     }
-    if (self.regionStartTime + self.regionDuration > self.duration) {
-        _regionDuration = self.duration - self.regionStartTime;
+    if ( _regionStartTime + _regionDuration > _duration ) {
+        _regionDuration = _duration - _regionStartTime;
     }
     
-    UInt32 start = round(self.regionStartTime * _fileSampleRate);
-    UInt32 end = round((self.regionStartTime + self.regionDuration) * _fileSampleRate);
-    position = MIN(MAX(start, position), end);
-    
-    double sourceToOutputSampleRateScale = self.renderer.sampleRate / _fileSampleRate;
-    
-    // Reset the unit, to clear prior schedules
-    AECheckOSStatus(AudioUnitReset(audioUnit, kAudioUnitScope_Global, 0), "AudioUnitReset");
-    
-    // Set the file to play
-    UInt32 size = sizeof(_audioFile);
-    OSStatus result = AudioUnitSetProperty(self.audioUnit, kAudioUnitProperty_ScheduledFileIDs, kAudioUnitScope_Global,
-                                           0, &_audioFile, size);
-    AECheckOSStatus(result, "AudioUnitSetProperty(kAudioUnitProperty_ScheduledFileIDs)");
-    
-    Float64 mainRegionStartTime = 0;
-    if ( position > start ) {
-        // Schedule the remaining part of the audio
-        UInt32 framesToPlay = round((self.regionStartTime + self.regionDuration) * _fileSampleRate) - position;
-        ScheduledAudioFileRegion region = {
-            .mAudioFile = _audioFile,
-            .mStartFrame = position,
-            .mFramesToPlay = framesToPlay
-        };
-        OSStatus result = AudioUnitSetProperty(audioUnit, kAudioUnitProperty_ScheduledFileRegion, kAudioUnitScope_Global,
-                                               0, &region, sizeof(region));
-        AECheckOSStatus(result, "AudioUnitSetProperty(kAudioUnitProperty_ScheduledFileRegion)");
-        
-        mainRegionStartTime = (double)framesToPlay * sourceToOutputSampleRateScale;
-    }
+    double sampleRate = stream.sampleRate;
+    UInt64 regionStart = round(_regionStartTime * sampleRate);
+    UInt64 regionLength = round(_regionDuration * sampleRate);
+    UInt64 position = round(MAX(0, time) * sampleRate);
+    position = MIN(MAX(regionStart, position), regionStart + regionLength);
+    
+    [stream seekToFrame:position regionStart:regionStart regionLength:regionLength];
     
-    // Set the main file region to play
-    ScheduledAudioFileRegion region = {
-        .mTimeStamp = { .mFlags = kAudioTimeStampSampleTimeValid, .mSampleTime = mainRegionStartTime },
-        .mAudioFile = _audioFile,
-        .mStartFrame = round(_regionStartTime * _fileSampleRate),
-        // Always loop the unit, even if we're not actually looping, to avoid rescheduling when switching loop mode.
-        .mLoopCount = (UInt32)-1,
-        .mFramesToPlay = round(_regionDuration * _fileSampleRate)
-    };
-    result = AudioUnitSetProperty(audioUnit, kAudioUnitProperty_ScheduledFileRegion, kAudioUnitScope_Global, 0,
-                                  &region, sizeof(region));
-    AECheckOSStatus(result, "AudioUnitSetProperty(kAudioUnitProperty_ScheduledFileRegion)");
-    
-    // Prime the player
-    UInt32 primeFrames = 0;
-    result = AudioUnitSetProperty(audioUnit, kAudioUnitProperty_ScheduledFilePrime, kAudioUnitScope_Global, 0, &primeFrames,
-                                  sizeof(primeFrames));
-    AECheckOSStatus(result, "AudioUnitSetProperty(kAudioUnitProperty_ScheduledFilePrime)");
-    
-    // Set the start time
-    AudioTimeStamp startTime = { .mFlags = kAudioTimeStampSampleTimeValid, .mSampleTime = -1 /* ASAP */ };
-    result = AudioUnitSetProperty(audioUnit, kAudioUnitProperty_ScheduleStartTimeStamp, kAudioUnitScope_Global, 0,
-                                  &startTime, sizeof(startTime));
-    AECheckOSStatus(result, "AudioUnitSetProperty(kAudioUnitProperty_ScheduleStartTimeStamp)");
-    
-    _playhead = position;
+    _playhead = position / sampleRate;
     _anchorTime = 0;
-    _sequenceScheduled = YES;
 }
 
 static void AEAudioFilePlayerModuleProcess(__unsafe_unretained AEAudioFilePlayerModule * THIS,
@@ -424,14 +300,17 @@ static void AEAudioFilePlayerModuleProcess(__unsafe_unretained AEAudioFilePlayer
     const AudioBufferList * abl = AEBufferStackPushWithChannels(context->stack, 1, THIS->_channels);
     if ( !abl ) return;
     
-    if ( !THIS->_playing ) {
+    __unsafe_unretained AEAudioFileStream * stream = (__bridge AEAudioFileStream *)AEManagedValueGetValue(THIS->_streamValue);
+    if ( !THIS->_playing || !stream ) {
         AEAudioBufferListSilence(abl, 0, context->frames);
+        if ( stream ) {
+            // Pick up any seek, so the new position is ready to go when we start
+            AEAudioFileStreamSkip(stream, 0);
+        }
         return;
     }
     
-    AudioUnit audioUnit = AEAudioUnitModuleGetAudioUnit(THIS);
     AudioTimeStamp startTime = THIS->_startTime;
-    double playhead = THIS->_playhead;
     
     // Check start time
     AEHostTicks hostTimeAtBufferEnd
@@ -442,37 +321,17 @@ static void AEAudioFilePlayerModuleProcess(__unsafe_unretained AEAudioFilePlayer
            || (startTime.mFlags & kAudioTimeStampSampleTimeValid && startTime.mSampleTime > sampleTimeAtBufferEnd) ) {
         // Start time not yet reached: emit silence
         AEAudioBufferListSilence(abl, 0, context->frames);
+        AEAudioFileStreamSkip(stream, 0);
         return;
         
     } else if ( (startTime.mFlags & kAudioTimeStampHostTimeValid && startTime.mHostTime < context->timestamp->mHostTime)
            || (startTime.mFlags & kAudioTimeStampSampleTimeValid && startTime.mSampleTime < context->timestamp->mSampleTime) ) {
-        // Start time is in the past - we need to skip some frames
+        // Start time is in the past - skip ahead to catch up, without decoding
         UInt32 skipFrames =
             startTime.mFlags & kAudioTimeStampHostTimeValid ?
                 round(AESecondsFromHostTicks(context->timestamp->mHostTime - startTime.mHostTime) * context->sampleRate)
                 : context->timestamp->mSampleTime - startTime.mSampleTime;
-        playhead += (double)skipFrames * (THIS->_fileSampleRate / context->sampleRate);
-        AudioTimeStamp timestamp = {
-            .mFlags = startTime.mFlags | kAudioTimeStampSampleTimeValid,
-            .mSampleTime = context->timestamp->mSampleTime - skipFrames,
-            .mHostTime = startTime.mHostTime
-        };
-        
-        AEAudioBufferListCopyOnStack(scratch, abl, 0);
-        while ( skipFrames > 0 ) {
-            UInt32 framesToSkip = MIN(skipFrames, context->frames);
-            AudioUnitRenderActionFlags flags = 0;
-            AEAudioBufferListSetLength(scratch, framesToSkip);
-            OSStatus result = AudioUnitRender(audioUnit, &flags, &timestamp, 0, framesToSkip, scratch);
-            if ( !AECheckOSStatus(result, "AudioUnitRender") ) {
-                AEAudioBufferListSilence(abl, 0, context->frames);
-                return;
-            }
-            
-            skipFrames -= framesToSkip;
-            timestamp.mSampleTime += framesToSkip;
-            timestamp.mHostTime += AEHostTicksFromSeconds(round((double)framesToSkip / context->sampleRate));
-        }
+        AEAudioFileStreamSkip(stream, skipFrames);
     }
     
     THIS->_startTime = AETimeStampNone;
@@ -485,8 +344,8 @@ static void AEAudioFilePlayerModuleProcess(__unsafe_unretained AEAudioFilePlayer
         : (startTime.mFlags & kAudioTimeStampSampleTimeValid && startTime.mSampleTime > context->timestamp->mSampleTime)
          ? startTime.mSampleTime - context->timestamp->mSampleTime
         : 0;
+    silentFrames = MIN(silentFrames, frames);
     AEAudioBufferListCopyOnStack(mutableAbl, abl, silentFrames);
-    AudioTimeStamp adjustedTime = *context->timestamp;
     
     if ( silentFrames > 0 ) {
         // Start time is offset into this buffer - silence beginning of buffer
@@ -494,25 +353,17 @@ static void AEAudioFilePlayerModuleProcess(__unsafe_unretained AEAudioFilePlayer
         // Point buffer list to remaining frames
         abl = mutableAbl;
         frames -= silentFrames;
-        adjustedTime.mHostTime += AEHostTicksFromSeconds((double)silentFrames / context->sampleRate);
-        adjustedTime.mSampleTime += silentFrames;
     }
     
-    // Render
-    AudioUnitRenderActionFlags flags = 0;
-    OSStatus result = AudioUnitRender(audioUnit, &flags, &adjustedTime, 0, frames, mutableAbl);
-    if ( !AECheckOSStatus(result, "AudioUnitRender") ) {
-        AEAudioBufferListSilence(abl, 0, context->frames);
-        return;
+    // Read from the stream, then measure what remains from the start of this buffer; reading picks up
+    // any pending seek, so measuring beforehand would use the old position
+    UInt32 framesRead = AEAudioFileStreamRead(stream, abl, frames);
+    UInt64 remainingFrames = AEAudioFileStreamGetFramesRemainingInRegion(stream) + framesRead;
+    if ( framesRead < frames ) {
+        // Silence the rest of the buffer past the end
+        AEAudioBufferListSilence(abl, framesRead, frames - framesRead);
     }
     
-    // Examine playhead
-    UInt32 playheadInOutputRate = round(playhead * (context->sampleRate / THIS->_fileSampleRate));
-    UInt32 regionLength = round(THIS->_regionDuration * context->sampleRate);
-    UInt32 regionStartTime = round(THIS->_regionStartTime * context->sampleRate);
-    UInt32 playheadInRegion = playheadInOutputRate - regionStartTime;
-    UInt32 playheadInRegionAtBufferEnd = playheadInRegion + frames;
-    
     BOOL stopped = NO;
     if ( THIS->_remainingMicrofadeInFrames > 0 ) {
         // Fade in
@@ -533,44 +384,27 @@ static void AEAudioFilePlayerModuleProcess(__unsafe_unretained AEAudioFilePlayer
         THIS->_remainingMicrofadeOutFrames -= microfadeFrames;
         if ( THIS->_remainingMicrofadeOutFrames == 0 ) {
             // Silence rest of buffer and stop
-            for ( int i=0; i<abl->mNumberBuffers; i++) {
-                // Silence the rest of the buffer past the end
-                AEAudioBufferListSilence(abl, microfadeFrames, frames - microfadeFrames);
-            }
+            AEAudioBufferListSilence(abl, microfadeFrames, frames - microfadeFrames);
             stopped = YES;
         }
-    } else if ( !THIS->_loop && playheadInRegionAtBufferEnd >= regionLength-THIS->_microfadeFrames ) {
+    } else if ( !THIS->_loop && remainingFrames < (UInt64)frames + THIS->_microfadeFrames ) {
         // Fade out (ended)
-        UInt32 microfadeStartPoint = regionLength - THIS->_microfadeFrames;
-        UInt32 offset = microfadeStartPoint > playheadInRegion ? MIN(microfadeStartPoint - playheadInRegion, frames) : 0;
-        UInt32 microfadeFrames = MIN(playheadInRegionAtBufferEnd - microfadeStartPoint, THIS->_microfadeFrames);
-        microfadeFrames = MIN(microfadeFrames, frames);
+        UInt32 offset = remainingFrames > THIS->_microfadeFrames ? (UInt32)(remainingFrames - THIS->_microfadeFrames) : 0;
+        UInt32 microfadeFrames = (UInt32)MIN(frames - offset, MIN(remainingFrames, THIS->_microfadeFrames));
         if ( microfadeFrames > 0 ) {
-            float start = 1.0 - ((float)MIN((playheadInRegion+offset) - microfadeStartPoint, THIS->_microfadeFrames)
-                                 / THIS->_microfadeFrames);
+            float start = (float)(remainingFrames - offset) / THIS->_microfadeFrames;
             float step = -1.0 / (double)THIS->_microfadeFrames;
-            if ( offset > 0 ) {
-                AEAudioBufferListCopyOnStack(offsetAbl, abl, offset);
-                AEDSPApplyRamp(offsetAbl, &start, step, microfadeFrames, offsetAbl);
-            } else {
-                AEDSPApplyRamp(abl, &start, step, microfadeFrames, abl);
-            }
+            AEAudioBufferListCopyOnStack(offsetAbl, abl, offset);
+            AEDSPApplyRamp(offsetAbl, &start, step, microfadeFrames, offsetAbl);
         }
-        if ( playheadInRegionAtBufferEnd >= regionLength ) {
-            UInt32 finalFrames = MIN(regionLength - playheadInRegion, frames);
-            for ( int i=0; i<abl->mNumberBuffers; i++) {
-                // Silence the rest of the buffer past the end
-                AEAudioBufferListSilence(abl, finalFrames, frames - finalFrames);
-            }
+        if ( remainingFrames <= frames ) {
             stopped = YES;
         }
     }
     
     if ( stopped ) {
-        // Reset the unit, and cease playback
-        AECheckOSStatus(AudioUnitReset(audioUnit, kAudioUnitScope_Global, 0), "AudioUnitReset");
-        THIS->_playhead = round(THIS->_regionStartTime * THIS->_fileSampleRate);
-        THIS->_sequenceScheduled = NO;
+        // Cease playback; the stream is rewound on the main thread
+        THIS->_playhead = THIS->_regionStartTime;
         THIS->_stopEventScheduled = YES;
         THIS->_playing = NO;
         __unsafe_unretained AEMainThreadEndpoint * endpoint =
@@ -580,12 +414,9 @@ static void AEAudioFilePlayerModuleProcess(__unsafe_unretained AEAudioFilePlayer
         }
     } else {
         // Update the playhead
-        double regionStartTimeAtFileRate = THIS->_regionStartTime * THIS->_fileSampleRate;
-        double regionLengthAtFileRate = THIS->_regionDuration * THIS->_fileSampleRate;
         BOOL wasStarted = THIS->_anchorTime != 0;
         
-        THIS->_playhead = regionStartTimeAtFileRate +
-            fmod(playheadInRegionAtBufferEnd * (THIS->_fileSampleRate / context->sampleRate), regionLengthAtFileRate);
+        THIS->_playhead = AEAudioFileStreamGetPosition(stream) / context->sampleRate;
         THIS->_anchorTime = hostTimeAtBufferEnd;
         
         if ( !wasStarted ) {
@@ -0,0 +1,133 @@
+//
+//  AEGranularModule.h
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#import "AEModule.h"
+#import "AETime.h"
+
+@class AEAudioSample;
+
+/*!
+ * Grain window shapes
+ */
+typedef enum {
+    AEGranularWindowHann,     //!< Raised cosine
+    AEGranularWindowGaussian, //!< Gaussian, with a standard deviation of 1/6 of the grain
+    AEGranularWindowTukey,    //!< Flat top, with raised cosine tapers over the first and last quarter
+} AEGranularWindow;
+
+/*!
+ * Granular synthesis module
+ *
+ *  This module renders a cloud of short grains from a memory-resident sample, to stereo. Grains
+ *  are scheduled automatically, at the given density, from around the given position within the
+ *  sample; or they may be added individually from the render thread with AEGranularModuleAddGrain.
+ *  Either way, grains start on the exact frame they're scheduled for.
+ *
+ *  Grains are held in a pool allocated on initialization, and playing grains are kept packed at
+ *  the front of the pool, so the cost of a render follows the number of grains playing. Each
+ *  grain is rendered with inline, vectorizable loops: its envelope is interpolated between
+ *  lookups in a precomputed window table, and the sample is read with linear interpolation.
+ *  There are no function calls per grain, so many thousands of short grains may play at once.
+ *
+ *  Parameters may be changed from any thread, and are applied to grains as they're scheduled.
+ */
+@interface AEGranularModule : AEModule
+
+/*!
+ * Initializer
+ *
+ * @param renderer Owning renderer
+ * @param maximumGrains The size of the grain pool; grains scheduled while the pool is full are dropped
+ */
+- (instancetype _Nullable)initWithRenderer:(AERenderer * _Nullable)renderer maximumGrains:(int)maximumGrains;
+
+//! The sample to play grains from; mono or stereo, and not compact. Assignment is thread-safe.
+@property (nonatomic, strong) AEAudioSample * _Nullable sample;
+
+//! The number of grains scheduled per second. Zero (the default) disables automatic scheduling.
+@property (nonatomic) double density;
+
+//! The duration of each grain, in seconds, up to one second. Default is 0.05.
+@property (nonatomic) AESeconds grainDuration;
+
+//! The position grains start from, from 0 (the start of the sample) to 1 (the end). Default is 0.
+@property (nonatomic) double position;
+
+//! Random variation applied to each grain's start position, in seconds. Default is 0.
+@property (nonatomic) AESeconds positionJitter;
+
+//! The playback rate of each grain: 1.0 for the original pitch, up to 4.0. Default is 1.0.
+@property (nonatomic) double rate;
+
+//! Random variation applied to each grain's pitch, in semitones. Default is 0.
+@property (nonatomic) double rateJitter;
+
+//! The gain applied to each grain. Default is 1.0.
+@property (nonatomic) float gain;
+
+//! The range of random stereo positions, from 0 (centered) to 1 (full width). Default is 0.
+@property (nonatomic) float panSpread;
+
+//! The window shape for new grains. Default is AEGranularWindowHann.
+@property (nonatomic) AEGranularWindow window;
+
+//! The size of the grain pool
+@property (nonatomic, readonly) int maximumGrains;
+
+//! The number of grains playing, as of the last render
+@property (nonatomic, readonly) int activeGrainCount;
+
+//! The number of grains dropped because the pool was full
+@property (nonatomic, readonly) UInt64 droppedGrainCount;
+
+@end
+
+/*!
+ * Add a grain
+ *
+ *  For use on the render thread, from a module or block that runs before the granular module
+ *  within the same render. The grain uses the module's window shape.
+ *
+ * @param module The module
+ * @param position The grain's start position within the sample, in frames
+ * @param duration The grain's duration, in frames
+ * @param rate Playback rate, up to 4.0
+ * @param gain Linear gain
+ * @param pan Stereo position, from -1 (left) to 1 (right)
+ * @param offset The frame within the current render at which to start the grain
+ * @return YES if the grain was added, NO if the pool is full or the grain doesn't fit within the sample
+ */
+BOOL AEGranularModuleAddGrain(__unsafe_unretained AEGranularModule * _Nonnull module,
+                              double position, UInt32 duration, double rate, float gain, float pan, UInt32 offset);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,314 @@
+//
+//  AEGranularModule.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+
+#import "AEGranularModule.h"
+#import "AEAudioSampleCache.h"
+#import "AEManagedValue.h"
+#import "AEAudioBufferListUtilities.h"
+#import "AEBufferStack.h"
+
+static const int kWindowLength = 1024;
+static const int kWindowSegments = 64;
+static const float kMaxSegmentFrames = 64;
+static const int kWindowShapes = 3;
+static const double kMinRate = 1.0 / 256.0;
+static const double kMaxRate = 4.0;
+static const double kGuardFrames = 3;
+
+typedef struct {
+    UInt32 start;            // Source frame the grain's position is relative to, so positions remain precise in float
+    float position;          // Source position, relative to start
+    float rate;
+    float windowPosition;
+    float windowIncrement;
+    float gain[2];
+    UInt32 offset;           // Frames to wait, within the next render
+    const float * window;
+} AEGranularModuleGrain;
+
+@interface AEGranularModule () {
+    AEGranularModuleGrain * _grains;
+    int _grainCount;
+    float * _windows;
+    const AudioBufferList * _audio;
+    double _nextOnset;
+    UInt32 _random;
+}
+@property (nonatomic, strong) AEManagedValue * sampleValue;
+@end
+
+@implementation AEGranularModule
+
+- (instancetype)initWithRenderer:(AERenderer *)renderer maximumGrains:(int)maximumGrains {
+    if ( maximumGrains < 1 || !(self = [super initWithRenderer:renderer]) ) return nil;
+    
+    _maximumGrains = maximumGrains;
+    _grainDuration = 0.05;
+    _rate = 1.0;
+    _gain = 1.0;
+    _window = AEGranularWindowHann;
+    _grains = calloc(maximumGrains, sizeof(AEGranularModuleGrain));
+    _random = 0x9E3779B9;
+    
+    // Each table has two trailing zeros, so interpolation at the end of a grain stays within the table
+    _windows = calloc(kWindowShapes * (kWindowLength + 2), sizeof(float));
+    for ( int i=0; i<kWindowLength; i++ ) {
+        double x = (double)i / kWindowLength;
+        float * hann = _windows + AEGranularWindowHann * (kWindowLength + 2);
+        float * gaussian = _windows + AEGranularWindowGaussian * (kWindowLength + 2);
+        float * tukey = _windows + AEGranularWindowTukey * (kWindowLength + 2);
+        
+        hann[i] = 0.5 - 0.5 * cos(2.0 * M_PI * x);
+        
+        // Offset and scaled so the window starts and ends at zero
+        double edge = exp(-0.5 * 9.0);
+        gaussian[i] = (exp(-0.5 * pow((x - 0.5) * 6.0, 2.0)) - edge) / (1.0 - edge);
+        
+        double taper = MIN(x, 1.0 - x);
+        tukey[i] = taper < 0.25 ? 0.5 - 0.5 * cos(M_PI * taper / 0.25) : 1.0;
+    }
+    
+    self.sampleValue = [AEManagedValue new];
+    
+    self.processFunction = AEGranularModuleProcess;
+    self.resetFunction = AEGranularModuleReset;
+    
+    return self;
+}
+
+- (void)dealloc {
+    free(_grains);
+    free(_windows);
+}
+
+- (AEAudioSample *)sample {
+    return self.sampleValue.objectValue;
+}
+
+- (void)setSample:(AEAudioSample *)sample {
+    NSAssert(!sample || !sample.compact, @"Compact samples aren't supported");
+    self.sampleValue.objectValue = sample;
+}
+
+- (int)activeGrainCount {
+    return _grainCount;
+}
+
+static const AudioBufferList * AEGranularModuleGetAudio(__unsafe_unretained AEGranularModule * THIS, UInt32 * length) {
+    __unsafe_unretained AEAudioSample * sample = (__bridge AEAudioSample *)AEManagedValueGetValue(THIS->_sampleValue);
+    const AudioBufferList * audio = sample ? AEAudioSampleGetAudio(sample) : NULL;
+    if ( audio != THIS->_audio ) {
+        // Grains refer to positions within the sample, so they can't continue with a new one
+        THIS->_grainCount = 0;
+        THIS->_audio = audio;
+    }
+    *length = audio ? AEAudioSampleGetLength(sample) : 0;
+    return audio;
+}
+
+static BOOL AEGranularModuleStartGrain(__unsafe_unretained AEGranularModule * THIS, UInt32 length,
+                                       double position, UInt32 duration, double rate, float gain, float pan, UInt32 offset) {
+    if ( THIS->_grainCount == THIS->_maximumGrains ) {
+        THIS->_droppedGrainCount++;
+        return NO;
+    }
+    
+    duration = MAX(1, duration);
+    rate = MAX(kMinRate, MIN(kMaxRate, rate));
+    double span = duration * rate + kGuardFrames;
+    if ( span >= length || isnan(position) ) return NO;
+    position = MAX(0.0, MIN(length - span, position));
+    
+    AEGranularModuleGrain * grain = &THIS->_grains[THIS->_grainCount++];
+    grain->start = (UInt32)position;
+    grain->position = position - grain->start;
+    grain->rate = rate;
+    grain->windowPosition = 0;
+    grain->windowIncrement = (float)kWindowLength / duration;
+    
+    // Equal-power panning
+    float angle = (MAX(-1.0f, MIN(1.0f, pan)) + 1.0f) * (float)M_PI_4;
+    grain->gain[0] = gain * cosf(angle);
+    grain->gain[1] = gain * sinf(angle);
+    
+    grain->offset = offset;
+    grain->window = THIS->_windows + MIN((int)THIS->_window, kWindowShapes-1) * (kWindowLength + 2);
+    return YES;
+}
+
+BOOL AEGranularModuleAddGrain(__unsafe_unretained AEGranularModule * THIS,
+                              double position, UInt32 duration, double rate, float gain, float pan, UInt32 offset) {
+    UInt32 length;
+    if ( !AEGranularModuleGetAudio(THIS, &length) ) return NO;
+    return AEGranularModuleStartGrain(THIS, length, position, duration, rate, gain, pan, offset);
+}
+
+static inline float AEGranularModuleRandom(UInt32 * state) {
+    // xorshift32, scaled to -1...1
+    UInt32 x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return (float)((double)x / UINT32_MAX * 2.0 - 1.0);
+}
+
+static void AEGranularModuleSchedule(__unsafe_unretained AEGranularModule * THIS, UInt32 length,
+                                     double sampleRate, UInt32 frames) {
+    const double density = THIS->_density;
+    if ( density <= 0 ) {
+        THIS->_nextOnset = 0;
+        return;
+    }
+    
+    const double interval = sampleRate / density;
+    const UInt32 duration = (UInt32)(MAX(0.0, MIN(1.0, THIS->_grainDuration)) * sampleRate);
+    const double position = MAX(0.0, MIN(1.0, THIS->_position)) * length;
+    const double positionJitter = THIS->_positionJitter * sampleRate;
+    const double rateJitter = THIS->_rateJitter / 12.0;
+    
+    while ( THIS->_nextOnset < frames ) {
+        double start = position + (positionJitter > 0 ? AEGranularModuleRandom(&THIS->_random) * positionJitter : 0);
+        double rate = THIS->_rate * (rateJitter > 0 ? exp2(AEGranularModuleRandom(&THIS->_random) * rateJitter) : 1.0);
+        float pan = THIS->_panSpread > 0 ? AEGranularModuleRandom(&THIS->_random) * THIS->_panSpread : 0;
+        AEGranularModuleStartGrain(THIS, length, start, duration, rate, THIS->_gain, pan, (UInt32)THIS->_nextOnset);
+        THIS->_nextOnset += interval;
+    }
+    THIS->_nextOnset -= frames;
+}
+
+static inline float AEGranularModuleWindowValue(const float * window, float position) {
+    int index = (int)position;
+    return window[index] + (position - index) * (window[index+1] - window[index]);
+}
+
+static inline void AEGranularModuleRenderGrain(AEGranularModuleGrain * grain, const AudioBufferList * audio,
+                                               float * restrict left, float * restrict right, UInt32 frames) {
+    const BOOL stereo = audio->mNumberBuffers > 1;
+    const float * restrict sourceLeft = (const float *)audio->mBuffers[0].mData + grain->start;
+    const float * restrict sourceRight = (const float *)audio->mBuffers[stereo ? 1 : 0].mData + grain->start;
+    const float rate = grain->rate;
+    const float windowIncrement = grain->windowIncrement;
+    const float gainLeft = grain->gain[0];
+    const float gainRight = grain->gain[1];
+    float position = grain->position;
+    float windowPosition = grain->windowPosition;
+    
+    // The envelope is interpolated linearly between window table lookups, made at least
+    // kWindowSegments times per grain, so that the inner loops are free of table reads and vectorize
+    const UInt32 segmentFrames = (UInt32)MAX(1.0f, MIN(kMaxSegmentFrames, (kWindowLength / kWindowSegments) / windowIncrement));
+    
+    for ( UInt32 offset = 0; offset < frames; offset += segmentFrames ) {
+        const UInt32 count = MIN(segmentFrames, frames - offset);
+        const float envelope = AEGranularModuleWindowValue(grain->window, windowPosition);
+        const float envelopeEnd = AEGranularModuleWindowValue(grain->window, MIN(kWindowLength, windowPosition + count * windowIncrement));
+        const float envelopeStep = (envelopeEnd - envelope) / count;
+        float * restrict outputLeft = left + offset;
+        float * restrict outputRight = right + offset;
+        
+        if ( stereo ) {
+            for ( UInt32 i=0; i<count; i++ ) {
+                float x = position + i * rate;
+                int index = (int)x;
+                float fraction = x - index;
+                float gain = envelope + i * envelopeStep;
+                outputLeft[i] += (sourceLeft[index] + fraction * (sourceLeft[index+1] - sourceLeft[index])) * gain * gainLeft;
+                outputRight[i] += (sourceRight[index] + fraction * (sourceRight[index+1] - sourceRight[index])) * gain * gainRight;
+            }
+        } else if ( rate == 1.0f ) {
+            // At the original pitch, the interpolation fraction is constant and reads are contiguous
+            const int index = (int)position;
+            const float fraction = position - index;
+            const float * restrict source = sourceLeft + index;
+            for ( UInt32 i=0; i<count; i++ ) {
+                float value = (source[i] + fraction * (source[i+1] - source[i])) * (envelope + i * envelopeStep);
+                outputLeft[i] += value * gainLeft;
+                outputRight[i] += value * gainRight;
+            }
+        } else {
+            for ( UInt32 i=0; i<count; i++ ) {
+                float x = position + i * rate;
+                int index = (int)x;
+                float value = (sourceLeft[index] + (x - index) * (sourceLeft[index+1] - sourceLeft[index])) * (envelope + i * envelopeStep);
+                outputLeft[i] += value * gainLeft;
+                outputRight[i] += value * gainRight;
+            }
+        }
+        
+        position += count * rate;
+        windowPosition += count * windowIncrement;
+    }
+    
+    grain->position = position;
+    grain->windowPosition = windowPosition;
+}
+
+static void AEGranularModuleProcess(__unsafe_unretained AEGranularModule * THIS, const AERenderContext * _Nonnull context) {
+    const AudioBufferList * abl = AEBufferStackPushWithChannels(context->stack, 1, 2);
+    if ( !abl ) return;
+    AEAudioBufferListSilence(abl, 0, context->frames);
+    
+    UInt32 length;
+    const AudioBufferList * audio = AEGranularModuleGetAudio(THIS, &length);
+    if ( !audio ) {
+        THIS->_nextOnset = 0;
+        return;
+    }
+    
+    AEGranularModuleSchedule(THIS, length, context->sampleRate, context->frames);
+    
+    float * left = (float *)abl->mBuffers[0].mData;
+    float * right = (float *)abl->mBuffers[1].mData;
+    for ( int i=0; i<THIS->_grainCount; ) {
+        AEGranularModuleGrain * grain = &THIS->_grains[i];
+        if ( grain->offset >= context->frames ) {
+            grain->offset -= context->frames;
+            i++;
+            continue;
+        }
+        
+        UInt32 available = context->frames - grain->offset;
+        UInt32 remaining = (UInt32)MAX(0.0f, ceilf((kWindowLength - grain->windowPosition) / grain->windowIncrement));
+        UInt32 frames = MIN(available, remaining);
+        AEGranularModuleRenderGrain(grain, audio, left + grain->offset, right + grain->offset, frames);
+        grain->offset = 0;
+        
+        if ( frames == remaining ) {
+            // Finished: keep the pool packed by moving the last grain into this slot
+            *grain = THIS->_grains[--THIS->_grainCount];
+        } else {
+            i++;
+        }
+    }
+}
+
+static void AEGranularModuleReset(__unsafe_unretained AEGranularModule * THIS) {
+    THIS->_grainCount = 0;
+    THIS->_nextOnset = 0;
+}
+
+@end
@@ -65,6 +65,8 @@ extern "C" {
 /*!
  * Remove a module
  *
+ *  If the module was added more than once, all occurrences are removed.
+ *
  * @param module The module to remove
  */
 - (void)removeModule:(AEModule * _Nonnull)module;
@@ -67,17 +67,17 @@ typedef struct {
 }
 
 - (void)addModule:(AEModule *)module volume:(float)volume balance:(float)balance {
-    [self.array updateWithContentsOfArray:[self.array.allValues arrayByAddingObject:module]
-                            customMapping:^void * _Nonnull(id  _Nonnull item, int index) {
-                                // Use a custom mapping to apply volume and balance to new entry
-                                return [self newEntryForModule:item volume:volume balance:balance];
-                            }];
+    [self.array addObject:module customMapping:^void * _Nonnull(id  _Nonnull item, int index) {
+        // Use a custom mapping to apply volume and balance to new entry
+        return [self newEntryForModule:item volume:volume balance:balance];
+    }];
 }
 
 - (void)removeModule:(AEModule *)module {
-    NSMutableArray * array = self.array.allValues.mutableCopy;
-    [array removeObject:module];
-    [self.array updateWithContentsOfArray:array];
+    // Remove every occurrence, as the module may have been added more than once
+    while ( [self.array containsObject:module pointerValue:NULL] ) {
+        [self.array removeObject:module];
+    }
 }
 
 - (NSArray *)modules {
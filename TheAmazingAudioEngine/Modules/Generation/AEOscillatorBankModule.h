@@ -0,0 +1,142 @@
+//
+//  AEOscillatorBankModule.h
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#import "AEModule.h"
+
+/*!
+ * Oscillator waveforms
+ */
+typedef enum {
+    AEOscillatorWaveformSine,      //!< Sine wave
+    AEOscillatorWaveformSaw,       //!< Rising sawtooth, band-limited with polyBLEP
+    AEOscillatorWaveformSquare,    //!< Square wave, band-limited with polyBLEP
+    AEOscillatorWaveformTriangle,  //!< Triangle wave, band-limited with polyBLAMP
+    AEOscillatorWaveformWavetable, //!< The module's wavetable, band-limited per octave
+} AEOscillatorWaveform;
+
+/*!
+ * Oscillator bank module
+ *
+ *  This module renders a fixed number of oscillators, mixed to a single channel. It's designed for
+ *  additive synthesis and test-signal generation with hundreds of oscillators per instance: each
+ *  oscillator is rendered a block of frames at a time with vector operations, and oscillators
+ *  with zero amplitude are skipped.
+ *
+ *  Phase is accumulated in double precision, so frequency remains accurate over long runs.
+ *  Frequency and amplitude changes are smoothed, to avoid clicks: frequency approaches its target
+ *  exponentially, with a time constant given by frequencySmoothingTime, and amplitude ramps to its
+ *  target over one render cycle.
+ *
+ *  Oscillator parameters may be set from any thread, including the render thread, with the C
+ *  functions below. All oscillators start with zero amplitude.
+ */
+@interface AEOscillatorBankModule : AEModule
+
+/*!
+ * Initializer
+ *
+ * @param renderer Owning renderer
+ * @param numberOfOscillators Number of oscillators in the bank
+ */
+- (instancetype _Nullable)initWithRenderer:(AERenderer * _Nullable)renderer numberOfOscillators:(int)numberOfOscillators;
+
+/*!
+ * Set the wavetable used by oscillators with AEOscillatorWaveformWavetable
+ *
+ *  The table holds a single cycle. A band-limited copy is prepared for each octave, so that
+ *  oscillators don't alias at any frequency. Assignment is thread-safe.
+ *
+ * @param samples Single-cycle waveform
+ * @param length Length of the waveform; a power of two from 32 to 65536
+ * @return YES on success, NO if the length isn't supported
+ */
+- (BOOL)setWavetable:(const float * _Nonnull)samples length:(int)length;
+
+//! The number of oscillators
+@property (nonatomic, readonly) int numberOfOscillators;
+
+//! Frequency smoothing time constant, in seconds. Default is 0.005.
+@property (nonatomic) double frequencySmoothingTime;
+
+@end
+
+/*!
+ * Set an oscillator's waveform
+ *
+ *  This function is realtime-safe, and may be called from any thread.
+ *
+ * @param module The module
+ * @param index Oscillator index
+ * @param waveform The waveform
+ */
+void AEOscillatorBankModuleSetWaveform(__unsafe_unretained AEOscillatorBankModule * _Nonnull module,
+                                       int index, AEOscillatorWaveform waveform);
+
+/*!
+ * Set an oscillator's frequency
+ *
+ *  This function is realtime-safe, and may be called from any thread.
+ *
+ * @param module The module
+ * @param index Oscillator index
+ * @param frequency Frequency, in Hz; negative values are treated as zero
+ */
+void AEOscillatorBankModuleSetFrequency(__unsafe_unretained AEOscillatorBankModule * _Nonnull module,
+                                        int index, double frequency);
+
+/*!
+ * Set an oscillator's amplitude
+ *
+ *  This function is realtime-safe, and may be called from any thread.
+ *
+ * @param module The module
+ * @param index Oscillator index
+ * @param amplitude Amplitude, as a linear gain; zero disables the oscillator
+ */
+void AEOscillatorBankModuleSetAmplitude(__unsafe_unretained AEOscillatorBankModule * _Nonnull module,
+                                        int index, float amplitude);
+
+/*!
+ * Set an oscillator's phase
+ *
+ *  Takes effect immediately, at the start of the next render. This function is realtime-safe,
+ *  and may be called from any thread.
+ *
+ * @param module The module
+ * @param index Oscillator index
+ * @param phase Phase, in cycles, from 0 to 1
+ */
+void AEOscillatorBankModuleSetPhase(__unsafe_unretained AEOscillatorBankModule * _Nonnull module,
+                                    int index, double phase);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,371 @@
+//
+//  AEOscillatorBankModule.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+
+#import "AEOscillatorBankModule.h"
+#import "AEManagedValue.h"
+#import "AEDSPUtilities.h"
+#import <Accelerate/Accelerate.h>
+#import <stdatomic.h>
+
+static const UInt32 kBlockFrames = 256;
+
+typedef struct {
+    int length;
+    int levels;
+    float * tables; // 'levels' tables of length+1 samples; level k holds harmonics up to length/2 >> k
+} AEOscillatorBankWavetable;
+
+@interface AEOscillatorBankModule () {
+    double * _phase;
+    double * _increment;
+    double * _targetFrequency;
+    _Atomic(double) * _pendingPhase;
+    atomic_bool _phasePending;
+    float * _amplitude;
+    float * _targetAmplitude;
+    AEOscillatorWaveform * _waveform;
+    double * _ramp;
+    double * _triangularRamp;
+    double * _phases;
+    float * _positions;
+    float * _shifted;
+    float * _samples;
+    float * _scratch;
+}
+@property (nonatomic, strong) AEManagedValue * wavetableValue;
+@end
+
+@implementation AEOscillatorBankModule
+
+- (instancetype)initWithRenderer:(AERenderer *)renderer numberOfOscillators:(int)numberOfOscillators {
+    if ( numberOfOscillators < 1 || !(self = [super initWithRenderer:renderer]) ) return nil;
+    
+    _numberOfOscillators = numberOfOscillators;
+    _frequencySmoothingTime = 0.005;
+    _phase = calloc(numberOfOscillators, sizeof(double));
+    _increment = calloc(numberOfOscillators, sizeof(double));
+    _targetFrequency = calloc(numberOfOscillators, sizeof(double));
+    _pendingPhase = malloc(sizeof(_Atomic(double)) * numberOfOscillators);
+    for ( int i=0; i<numberOfOscillators; i++ ) {
+        atomic_init(&_pendingPhase[i], NAN);
+    }
+    atomic_init(&_phasePending, false);
+    _amplitude = calloc(numberOfOscillators, sizeof(float));
+    _targetAmplitude = calloc(numberOfOscillators, sizeof(float));
+    _waveform = calloc(numberOfOscillators, sizeof(AEOscillatorWaveform));
+    
+    // Phase within a block is phase0 + i*increment + i(i-1)/2 * delta, for an increment that changes by
+    // delta each frame; precompute the ramps
+    _ramp = malloc(sizeof(double) * kBlockFrames);
+    _triangularRamp = malloc(sizeof(double) * kBlockFrames);
+    for ( int i=0; i<kBlockFrames; i++ ) {
+        _ramp[i] = i;
+        _triangularRamp[i] = i * (i - 1) / 2.0;
+    }
+    _phases = malloc(sizeof(double) * kBlockFrames);
+    _positions = malloc(sizeof(float) * kBlockFrames);
+    _shifted = malloc(sizeof(float) * kBlockFrames);
+    _samples = malloc(sizeof(float) * kBlockFrames);
+    _scratch = malloc(sizeof(float) * kBlockFrames * 2);
+    
+    self.wavetableValue = [AEManagedValue new];
+    self.wavetableValue.releaseBlock = ^(void * value) {
+        AEOscillatorBankWavetable * wavetable = (AEOscillatorBankWavetable *)value;
+        free(wavetable->tables);
+        free(wavetable);
+    };
+    
+    self.processFunction = AEOscillatorBankModuleProcess;
+    self.resetFunction = AEOscillatorBankModuleReset;
+    
+    return self;
+}
+
+- (void)dealloc {
+    free(_phase);
+    free(_increment);
+    free(_targetFrequency);
+    free(_pendingPhase);
+    free(_amplitude);
+    free(_targetAmplitude);
+    free(_waveform);
+    free(_ramp);
+    free(_triangularRamp);
+    free(_phases);
+    free(_positions);
+    free(_shifted);
+    free(_samples);
+    free(_scratch);
+}
+
+- (BOOL)setWavetable:(const float *)samples length:(int)length {
+    if ( length < 32 || length > 65536 || (length & (length-1)) != 0 ) return NO;
+    AEDSPFFT * fft = AEDSPFFTInit(length);
+    if ( !fft ) return NO;
+    
+    AEOscillatorBankWavetable * wavetable = calloc(1, sizeof(AEOscillatorBankWavetable));
+    wavetable->length = length;
+    wavetable->levels = (int)log2(length / 2) + 1;
+    wavetable->tables = malloc(sizeof(float) * (length+1) * wavetable->levels);
+    
+    int bins = length / 2;
+    float * real = malloc(sizeof(float) * bins);
+    float * imag = malloc(sizeof(float) * bins);
+    float * levelReal = malloc(sizeof(float) * bins);
+    float * levelImag = malloc(sizeof(float) * bins);
+    AEDSPFFTForward(fft, samples, real, imag);
+    imag[0] = 0; // Discard the Nyquist component
+    
+    // Prepare one table per octave, with harmonics above the octave's limit removed
+    float scale = 1.0 / (2.0 * length);
+    for ( int level=0; level<wavetable->levels; level++ ) {
+        int harmonics = bins >> level;
+        memcpy(levelReal, real, sizeof(float) * bins);
+        memcpy(levelImag, imag, sizeof(float) * bins);
+        if ( harmonics+1 < bins ) {
+            vDSP_vclr(levelReal + harmonics + 1, 1, bins - harmonics - 1);
+            vDSP_vclr(levelImag + harmonics + 1, 1, bins - harmonics - 1);
+        }
+        float * table = wavetable->tables + level * (length+1);
+        AEDSPFFTInverse(fft, levelReal, levelImag, table);
+        vDSP_vsmul(table, 1, &scale, table, 1, length);
+        table[length] = table[0]; // Wrap, for interpolation
+    }
+    
+    free(real);
+    free(imag);
+    free(levelReal);
+    free(levelImag);
+    AEDSPFFTDealloc(fft);
+    
+    self.wavetableValue.pointerValue = wavetable;
+    return YES;
+}
+
+void AEOscillatorBankModuleSetWaveform(__unsafe_unretained AEOscillatorBankModule * THIS, int index, AEOscillatorWaveform waveform) {
+    if ( index < 0 || index >= THIS->_numberOfOscillators ) return;
+    THIS->_waveform[index] = waveform;
+}
+
+void AEOscillatorBankModuleSetFrequency(__unsafe_unretained AEOscillatorBankModule * THIS, int index, double frequency) {
+    if ( index < 0 || index >= THIS->_numberOfOscillators ) return;
+    THIS->_targetFrequency[index] = MAX(0.0, frequency);
+}
+
+void AEOscillatorBankModuleSetAmplitude(__unsafe_unretained AEOscillatorBankModule * THIS, int index, float amplitude) {
+    if ( index < 0 || index >= THIS->_numberOfOscillators ) return;
+    THIS->_targetAmplitude[index] = amplitude;
+}
+
+void AEOscillatorBankModuleSetPhase(__unsafe_unretained AEOscillatorBankModule * THIS, int index, double phase) {
+    if ( index < 0 || index >= THIS->_numberOfOscillators ) return;
+    atomic_store_explicit(&THIS->_pendingPhase[index], phase - floor(phase), memory_order_relaxed);
+    atomic_store_explicit(&THIS->_phasePending, true, memory_order_release);
+}
+
+static void AEOscillatorBankModulePolyBLEP(const float * t, float dt, float * output, float * scratch, UInt32 frames) {
+    // Band-limiting residual for a falling step at t=0: b² - a², where a = 1 - t/dt in the first sample of
+    // the cycle, and b = 1 + (t-1)/dt in the last, each clipped to zero elsewhere
+    float zero = 0.0, one = 1.0;
+    float scaleA = -1.0 / dt;
+    float scaleB = 1.0 / dt, offsetB = 1.0 - 1.0 / dt;
+    vDSP_vsmsa(t, 1, &scaleA, &one, output, 1, frames);
+    vDSP_vthr(output, 1, &zero, output, 1, frames);
+    vDSP_vsq(output, 1, output, 1, frames);
+    vDSP_vsmsa(t, 1, &scaleB, &offsetB, scratch, 1, frames);
+    vDSP_vthr(scratch, 1, &zero, scratch, 1, frames);
+    vDSP_vsq(scratch, 1, scratch, 1, frames);
+    vDSP_vsub(output, 1, scratch, 1, output, 1, frames);
+}
+
+static void AEOscillatorBankModulePolyBLAMP(const float * t, float dt, float * output, float * scratch, UInt32 frames) {
+    // Band-limiting residual for a corner at t=0 where the slope rises by 2 per frame (the integral of the
+    // polyBLEP residual): (a³ + b³)/3
+    float zero = 0.0, one = 1.0, third = 1.0 / 3.0;
+    float scaleA = -1.0 / dt;
+    float scaleB = 1.0 / dt, offsetB = 1.0 - 1.0 / dt;
+    vDSP_vsmsa(t, 1, &scaleA, &one, output, 1, frames);
+    vDSP_vthr(output, 1, &zero, output, 1, frames);
+    vDSP_vsmsa(t, 1, &scaleB, &offsetB, scratch, 1, frames);
+    vDSP_vthr(scratch, 1, &zero, scratch, 1, frames);
+    vDSP_vmul(output, 1, output, 1, scratch + frames, 1, frames);
+    vDSP_vmul(output, 1, scratch + frames, 1, output, 1, frames);
+    vDSP_vmul(scratch, 1, scratch, 1, scratch + frames, 1, frames);
+    vDSP_vma(scratch, 1, scratch + frames, 1, output, 1, output, 1, frames);
+    vDSP_vsmul(output, 1, &third, output, 1, frames);
+}
+
+static void AEOscillatorBankModuleSaw(const float * t, float dt, float * output, float * scratch, UInt32 frames) {
+    // Naive 2t - 1, minus the step residual
+    float two = 2.0, minusOne = -1.0;
+    AEOscillatorBankModulePolyBLEP(t, dt, output, scratch, frames);
+    vDSP_vsmsb(t, 1, &two, output, 1, output, 1, frames);
+    vDSP_vsadd(output, 1, &minusOne, output, 1, frames);
+}
+
+static void AEOscillatorBankModuleRenderWaveform(__unsafe_unretained AEOscillatorBankModule * THIS,
+                                                 AEOscillatorWaveform waveform,
+                                                 const AEOscillatorBankWavetable * wavetable,
+                                                 float * t, float dt, float * output, UInt32 frames) {
+    float * scratch = THIS->_scratch;
+    switch ( waveform ) {
+        case AEOscillatorWaveformSine: {
+            float two = 2.0;
+            int count = frames;
+            vDSP_vsmul(t, 1, &two, output, 1, frames);
+            vvsinpif(output, output, &count);
+            break;
+        }
+        case AEOscillatorWaveformSaw:
+            AEOscillatorBankModuleSaw(t, dt, output, scratch, frames);
+            break;
+        case AEOscillatorWaveformSquare: {
+            // Difference of two saws, half a cycle apart
+            float half = 0.5;
+            float * shifted = THIS->_shifted;
+            AEOscillatorBankModuleSaw(t, dt, output, scratch, frames);
+            vDSP_vsadd(t, 1, &half, t, 1, frames);
+            vDSP_vfrac(t, 1, t, 1, frames);
+            AEOscillatorBankModuleSaw(t, dt, shifted, scratch, frames);
+            vDSP_vsub(output, 1, shifted, 1, output, 1, frames);
+            break;
+        }
+        case AEOscillatorWaveformTriangle: {
+            // Naive 1 - 4|t' - 1/2|, with t' a quarter cycle ahead so the wave starts at zero, then the corners at
+            // t'=0 and t'=1/2 smoothed, scaling the residual by the change in slope per frame (±8dt) over 2
+            float quarter = 0.25, half = 0.5, minusHalf = -0.5, minusFour = -4.0, one = 1.0;
+            float * shifted = THIS->_shifted;
+            float slopeChange = 4.0 * dt, minusSlopeChange = -slopeChange;
+            vDSP_vsadd(t, 1, &quarter, t, 1, frames);
+            vDSP_vfrac(t, 1, t, 1, frames);
+            vDSP_vsadd(t, 1, &minusHalf, output, 1, frames);
+            vDSP_vabs(output, 1, output, 1, frames);
+            vDSP_vsmsa(output, 1, &minusFour, &one, output, 1, frames);
+            AEOscillatorBankModulePolyBLAMP(t, dt, shifted, scratch, frames);
+            vDSP_vsma(shifted, 1, &slopeChange, output, 1, output, 1, frames);
+            vDSP_vsadd(t, 1, &half, t, 1, frames);
+            vDSP_vfrac(t, 1, t, 1, frames);
+            AEOscillatorBankModulePolyBLAMP(t, dt, shifted, scratch, frames);
+            vDSP_vsma(shifted, 1, &minusSlopeChange, output, 1, output, 1, frames);
+            break;
+        }
+        case AEOscillatorWaveformWavetable: {
+            if ( !wavetable ) {
+                vDSP_vclr(output, 1, frames);
+                break;
+            }
+            
+            // Use the table with as many harmonics as fit below Nyquist
+            int level = 0;
+            while ( level < wavetable->levels-1 && ((wavetable->length/2) >> level) * dt > 0.5 ) level++;
+            float length = wavetable->length;
+            vDSP_vsmul(t, 1, &length, t, 1, frames);
+            vDSP_vlint(wavetable->tables + level * (wavetable->length+1), t, 1, output, 1, frames, wavetable->length+1);
+            break;
+        }
+    }
+}
+
+static void AEOscillatorBankModuleProcess(__unsafe_unretained AEOscillatorBankModule * THIS, const AERenderContext * _Nonnull context) {
+    const AudioBufferList * abl = AEBufferStackPushWithChannels(context->stack, 1, 1);
+    if ( !abl ) return;
+    
+    float * output = (float*)abl->mBuffers[0].mData;
+    vDSP_vclr(output, 1, context->frames);
+    
+    if ( atomic_exchange_explicit(&THIS->_phasePending, false, memory_order_acquire) ) {
+        for ( int i=0; i<THIS->_numberOfOscillators; i++ ) {
+            double phase = atomic_exchange_explicit(&THIS->_pendingPhase[i], NAN, memory_order_relaxed);
+            if ( !isnan(phase) ) THIS->_phase[i] = phase;
+        }
+    }
+    
+    const AEOscillatorBankWavetable * wavetable = (const AEOscillatorBankWavetable *)AEManagedValueGetValue(THIS->_wavetableValue);
+    const double sampleRate = context->sampleRate;
+    const double smoothing = THIS->_frequencySmoothingTime > 0.0 ? exp(-1.0 / (THIS->_frequencySmoothingTime * sampleRate)) : 0.0;
+    
+    for ( int i=0; i<THIS->_numberOfOscillators; i++ ) {
+        double phase = THIS->_phase[i];
+        double increment = THIS->_increment[i];
+        const double targetIncrement = THIS->_targetFrequency[i] / sampleRate;
+        const float amplitude = THIS->_amplitude[i];
+        const float targetAmplitude = THIS->_targetAmplitude[i];
+        const AEOscillatorWaveform waveform = THIS->_waveform[i];
+        
+        if ( amplitude == 0.0 && targetAmplitude == 0.0 ) {
+            // Silent: just advance
+            THIS->_increment[i] = targetIncrement;
+            THIS->_phase[i] = fmod(phase + targetIncrement * context->frames, 1.0);
+            continue;
+        }
+        
+        if ( amplitude == 0.0 ) {
+            // Starting from silence, so there's no need to glide to the new frequency
+            increment = targetIncrement;
+        }
+        
+        // Amplitude ramps to its target over the render
+        float gain = amplitude;
+        float gainStep = (targetAmplitude - amplitude) / context->frames;
+        
+        for ( UInt32 offset = 0; offset < context->frames; offset += kBlockFrames ) {
+            UInt32 frames = MIN(kBlockFrames, context->frames - offset);
+            
+            // Frequency approaches its target exponentially, block by block, ramping linearly within the block
+            double endIncrement = targetIncrement + (increment - targetIncrement) * pow(smoothing, frames);
+            if ( fabs(endIncrement - targetIncrement) < 1.0e-12 ) endIncrement = targetIncrement;
+            double delta = (endIncrement - increment) / frames;
+            
+            // Calculate phases in double precision, then wrap and convert for waveform generation
+            vDSP_vsmsmaD(THIS->_ramp, 1, &increment, THIS->_triangularRamp, 1, &delta, THIS->_phases, 1, frames);
+            vDSP_vsaddD(THIS->_phases, 1, &phase, THIS->_phases, 1, frames);
+            vDSP_vfracD(THIS->_phases, 1, THIS->_phases, 1, frames);
+            vDSP_vdpsp(THIS->_phases, 1, THIS->_positions, 1, frames);
+            
+            phase += frames * increment + (frames * (frames - 1) / 2.0) * delta;
+            phase -= floor(phase);
+            float dt = MAX(1.0e-9, MIN(0.5, 0.5 * (increment + endIncrement)));
+            increment = endIncrement;
+            
+            AEOscillatorBankModuleRenderWaveform(THIS, waveform, wavetable, THIS->_positions, dt, THIS->_samples, frames);
+            vDSP_vrampmuladd(THIS->_samples, 1, &gain, &gainStep, output + offset, 1, frames);
+        }
+        
+        THIS->_phase[i] = phase;
+        THIS->_increment[i] = increment;
+        THIS->_amplitude[i] = targetAmplitude;
+    }
+}
+
+static void AEOscillatorBankModuleReset(__unsafe_unretained AEOscillatorBankModule * THIS) {
+    for ( int i=0; i<THIS->_numberOfOscillators; i++ ) {
+        THIS->_phase[i] = 0.0;
+        THIS->_increment[i] = 0.0;
+    }
+}
+
+@end
@@ -0,0 +1,194 @@
+//
+//  AESamplerModule.h
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#import "AEModule.h"
+
+@class AEAudioSample;
+@class AEStreamingSample;
+@class AEStreamingSampleStore;
+
+/*!
+ * Voice stealing policies
+ */
+typedef enum {
+    AESamplerVoiceStealingOldest,   //!< Replace the voice that started longest ago
+    AESamplerVoiceStealingQuietest, //!< Replace the voice with the lowest gain
+    AESamplerVoiceStealingNone,     //!< Drop the new note
+} AESamplerVoiceStealing;
+
+/*!
+ * Sampler module
+ *
+ *  This module plays samples polyphonically, from a fixed pool of voices allocated on
+ *  initialization. Samples may be memory-resident (AEAudioSample, from an AEAudioSampleCache,
+ *  including compact samples) or streamed from disk (AEStreamingSample, from an
+ *  AEStreamingSampleStore given on initialization). Triggering a note performs no allocation,
+ *  so the module can sustain thousands of notes per second.
+ *
+ *  All voice state is held in one contiguous array. Each voice is rendered a block of frames
+ *  at a time with vector operations: positions are generated with a ramp, and the sample is
+ *  read with linear interpolation, so each note may play at its own pitch. Samples should be
+ *  loaded at the renderer's sample rate.
+ *
+ *  When all voices are busy, a new note replaces a playing voice according to the voiceStealing
+ *  policy. The replaced voice is faded out over a few milliseconds, to avoid a click.
+ *
+ *  Samples aren't retained by the module: keep them referenced for as long as they may be
+ *  played.
+ */
+@interface AESamplerModule : AEModule
+
+/*!
+ * Initializer
+ *
+ * @param renderer Owning renderer
+ * @param voiceCount Number of voices
+ * @param numberOfChannels Number of channels to output; 1 or 2
+ */
+- (instancetype _Nullable)initWithRenderer:(AERenderer * _Nullable)renderer
+                                voiceCount:(int)voiceCount
+                          numberOfChannels:(int)numberOfChannels;
+
+/*!
+ * Initializer, with a store for streamed samples
+ *
+ *  Each of the module's voices uses the store voice with the same index, so the store must have
+ *  at least as many voices, and the same number of channels. The store should only be used by
+ *  this module.
+ *
+ * @param renderer Owning renderer
+ * @param voiceCount Number of voices
+ * @param numberOfChannels Number of channels to output; 1 or 2
+ * @param streamingStore Store providing streamed samples
+ */
+- (instancetype _Nullable)initWithRenderer:(AERenderer * _Nullable)renderer
+                                voiceCount:(int)voiceCount
+                          numberOfChannels:(int)numberOfChannels
+                            streamingStore:(AEStreamingSampleStore * _Nullable)streamingStore;
+
+/*!
+ * Play a memory-resident sample
+ *
+ *  The note starts at the beginning of the next render. For sample-accurate timing, use
+ *  AESamplerModulePlaySample from the render thread.
+ *
+ * @param sample The sample
+ * @param rate Playback rate: 1.0 for the original pitch, 2.0 for an octave up; up to 4.0
+ * @param gain Linear gain
+ * @return YES if the note was queued, NO if the trigger queue is full
+ */
+- (BOOL)playSample:(AEAudioSample * _Nonnull)sample rate:(double)rate gain:(float)gain;
+
+/*!
+ * Play a streamed sample
+ *
+ *  As playSample:rate:gain:, for a sample from the module's streaming store.
+ *
+ * @param sample The sample
+ * @param rate Playback rate, up to 4.0
+ * @param gain Linear gain
+ * @return YES if the note was queued, NO if the trigger queue is full
+ */
+- (BOOL)playStreamingSample:(AEStreamingSample * _Nonnull)sample rate:(double)rate gain:(float)gain;
+
+/*!
+ * Stop all voices, at the start of the next render
+ */
+- (void)stopAllVoices;
+
+//! The number of voices
+@property (nonatomic, readonly) int voiceCount;
+
+//! The number of channels output
+@property (nonatomic, readonly) int numberOfChannels;
+
+//! The store providing streamed samples, if any
+@property (nonatomic, strong, readonly) AEStreamingSampleStore * _Nullable streamingStore;
+
+//! The voice stealing policy, used when all voices are busy. Default is AESamplerVoiceStealingOldest.
+@property (nonatomic) AESamplerVoiceStealing voiceStealing;
+
+//! The number of voices playing, as of the last render
+@property (nonatomic, readonly) int activeVoiceCount;
+
+//! The number of notes which replaced a playing voice
+@property (nonatomic, readonly) UInt64 stolenVoiceCount;
+
+//! The number of notes dropped because all voices were busy
+@property (nonatomic, readonly) UInt64 droppedNoteCount;
+
+@end
+
+/*!
+ * Play a memory-resident sample
+ *
+ *  For use on the render thread, from a module or block that runs before the sampler within the
+ *  same render.
+ *
+ * @param sampler The module
+ * @param sample The sample
+ * @param rate Playback rate: 1.0 for the original pitch, 2.0 for an octave up; up to 4.0
+ * @param gain Linear gain
+ * @param offset The frame within the current render at which to start the note
+ * @return YES if a voice was assigned, NO if the note was dropped
+ */
+BOOL AESamplerModulePlaySample(__unsafe_unretained AESamplerModule * _Nonnull sampler,
+                               __unsafe_unretained AEAudioSample * _Nonnull sample,
+                               double rate, float gain, UInt32 offset);
+
+/*!
+ * Play a streamed sample
+ *
+ *  For use on the render thread, as AESamplerModulePlaySample.
+ *
+ * @param sampler The module
+ * @param sample The sample, from the module's streaming store
+ * @param rate Playback rate, up to 4.0
+ * @param gain Linear gain
+ * @param offset The frame within the current render at which to start the note
+ * @return YES if a voice was assigned, NO if the note was dropped
+ */
+BOOL AESamplerModulePlayStreamingSample(__unsafe_unretained AESamplerModule * _Nonnull sampler,
+                                        __unsafe_unretained AEStreamingSample * _Nonnull sample,
+                                        double rate, float gain, UInt32 offset);
+
+/*!
+ * Stop all voices immediately
+ *
+ *  For use on the render thread.
+ *
+ * @param sampler The module
+ */
+void AESamplerModuleStopAllVoices(__unsafe_unretained AESamplerModule * _Nonnull sampler);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,350 @@
+//
+//  AESamplerModule.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+
+#import "AESamplerModule.h"
+#import "AEAudioSampleCache.h"
+#import "AEStreamingSampleStore.h"
+#import "AEAudioThreadEndpoint.h"
+#import "AEAudioBufferListUtilities.h"
+#import "AEBufferStack.h"
+#import <Accelerate/Accelerate.h>
+
+#define kMaxChannels 2
+#define kGuardFrames 3
+static const UInt32 kBlockFrames = 256;
+static const double kMaxRate = 4.0;
+static const double kMinRate = 1.0 / 256.0;
+static const UInt32 kWindowFrames = 1024 + 4*kGuardFrames; // kBlockFrames * kMaxRate, plus guard frames
+static const UInt32 kStealFadeFrames = 128;
+static const size_t kTriggerQueueCapacity = 32768;
+
+typedef struct {
+    __unsafe_unretained AEAudioSample * sample;
+    __unsafe_unretained AEStreamingSample * streamingSample;
+    double rate;
+    float gain;
+    UInt32 offset;
+} AESamplerModuleNote;
+
+typedef struct {
+    AESamplerModuleNote note;
+    AESamplerModuleNote pending;
+    BOOL active;
+    BOOL hasPending;
+    UInt64 serial;
+    UInt32 length;
+    double position;
+    double rate;
+    UInt64 fetched;
+    float history[kMaxChannels][kGuardFrames];
+} AESamplerModuleVoice;
+
+static BOOL AESamplerModuleStartNote(__unsafe_unretained AESamplerModule * THIS, const AESamplerModuleNote * note);
+static void AESamplerModuleEndVoice(__unsafe_unretained AESamplerModule * THIS, AESamplerModuleVoice * voice);
+
+@interface AESamplerModule () {
+    AESamplerModuleVoice * _voices;
+    AudioBufferList * _window;
+    float * _positions;
+    float * _samples;
+    UInt64 _serial;
+}
+@property (nonatomic, strong, readwrite) AEStreamingSampleStore * streamingStore;
+@property (nonatomic, strong) AEAudioThreadEndpoint * triggerEndpoint;
+@end
+
+@implementation AESamplerModule
+
+- (instancetype)initWithRenderer:(AERenderer *)renderer voiceCount:(int)voiceCount numberOfChannels:(int)numberOfChannels {
+    return [self initWithRenderer:renderer voiceCount:voiceCount numberOfChannels:numberOfChannels streamingStore:nil];
+}
+
+- (instancetype)initWithRenderer:(AERenderer *)renderer voiceCount:(int)voiceCount numberOfChannels:(int)numberOfChannels
+                  streamingStore:(AEStreamingSampleStore *)streamingStore {
+    if ( voiceCount < 1 || numberOfChannels < 1 || numberOfChannels > kMaxChannels ) return nil;
+    if ( streamingStore && (streamingStore.voiceCount < voiceCount || streamingStore.numberOfChannels != numberOfChannels) ) {
+        return nil;
+    }
+    if ( !(self = [super initWithRenderer:renderer]) ) return nil;
+    
+    _voiceCount = voiceCount;
+    _numberOfChannels = numberOfChannels;
+    _streamingStore = streamingStore;
+    _voiceStealing = AESamplerVoiceStealingOldest;
+    _voices = calloc(voiceCount, sizeof(AESamplerModuleVoice));
+    _window = AEAudioBufferListCreateWithFormat(AEAudioDescriptionWithChannelsAndRate(numberOfChannels, 0), kWindowFrames);
+    _positions = malloc(sizeof(float) * kBlockFrames);
+    _samples = malloc(sizeof(float) * kBlockFrames);
+    
+    // Main thread notes arrive via the endpoint; a note with no sample stops all voices
+    __unsafe_unretained typeof(self) weakSelf = self;
+    self.triggerEndpoint = [[AEAudioThreadEndpoint alloc] initWithHandler:^(const void * data, size_t length) {
+        const AESamplerModuleNote * note = (const AESamplerModuleNote *)data;
+        if ( note->sample || note->streamingSample ) {
+            AESamplerModuleStartNote(weakSelf, note);
+        } else {
+            AESamplerModuleStopAllVoices(weakSelf);
+        }
+    } bufferCapacity:kTriggerQueueCapacity];
+    
+    self.processFunction = AESamplerModuleProcess;
+    self.resetFunction = AESamplerModuleReset;
+    
+    return self;
+}
+
+- (void)dealloc {
+    free(_voices);
+    AEAudioBufferListFree(_window);
+    free(_positions);
+    free(_samples);
+}
+
+- (BOOL)playSample:(AEAudioSample *)sample rate:(double)rate gain:(float)gain {
+    AESamplerModuleNote note = { .sample = sample, .rate = rate, .gain = gain };
+    return [self.triggerEndpoint sendBytes:&note length:sizeof(note)];
+}
+
+- (BOOL)playStreamingSample:(AEStreamingSample *)sample rate:(double)rate gain:(float)gain {
+    NSAssert(self.streamingStore, @"No streaming store");
+    AESamplerModuleNote note = { .streamingSample = sample, .rate = rate, .gain = gain };
+    return [self.triggerEndpoint sendBytes:&note length:sizeof(note)];
+}
+
+- (void)stopAllVoices {
+    AESamplerModuleNote note = { .sample = nil };
+    [self.triggerEndpoint sendBytes:&note length:sizeof(note)];
+}
+
+- (int)activeVoiceCount {
+    int count = 0;
+    for ( int i=0; i<_voiceCount; i++ ) {
+        if ( _voices[i].active ) count++;
+    }
+    return count;
+}
+
+BOOL AESamplerModulePlaySample(__unsafe_unretained AESamplerModule * THIS, __unsafe_unretained AEAudioSample * sample,
+                               double rate, float gain, UInt32 offset) {
+    AESamplerModuleNote note = { .sample = sample, .rate = rate, .gain = gain, .offset = offset };
+    return AESamplerModuleStartNote(THIS, &note);
+}
+
+BOOL AESamplerModulePlayStreamingSample(__unsafe_unretained AESamplerModule * THIS,
+                                        __unsafe_unretained AEStreamingSample * sample,
+                                        double rate, float gain, UInt32 offset) {
+    if ( !THIS->_streamingStore ) return NO;
+    AESamplerModuleNote note = { .streamingSample = sample, .rate = rate, .gain = gain, .offset = offset };
+    return AESamplerModuleStartNote(THIS, &note);
+}
+
+void AESamplerModuleStopAllVoices(__unsafe_unretained AESamplerModule * THIS) {
+    for ( int i=0; i<THIS->_voiceCount; i++ ) {
+        AESamplerModuleVoice * voice = &THIS->_voices[i];
+        voice->hasPending = NO;
+        if ( voice->active ) AESamplerModuleEndVoice(THIS, voice);
+    }
+}
+
+static BOOL AESamplerModuleStartNote(__unsafe_unretained AESamplerModule * THIS, const AESamplerModuleNote * note) {
+    // Notes are assigned to a voice here, and start at the voice's next render
+    AESamplerModuleVoice * target = NULL;
+    for ( int i=0; i<THIS->_voiceCount && !target; i++ ) {
+        if ( !THIS->_voices[i].active && !THIS->_voices[i].hasPending ) target = &THIS->_voices[i];
+    }
+    
+    if ( !target ) {
+        if ( THIS->_voiceStealing == AESamplerVoiceStealingNone ) {
+            THIS->_droppedNoteCount++;
+            return NO;
+        }
+        
+        // Prefer voices which aren't already being replaced within this render
+        for ( int pass=0; pass<2 && !target; pass++ ) {
+            for ( int i=0; i<THIS->_voiceCount; i++ ) {
+                AESamplerModuleVoice * voice = &THIS->_voices[i];
+                if ( pass == 0 && voice->hasPending ) continue;
+                if ( !target ) {
+                    target = voice;
+                } else if ( THIS->_voiceStealing == AESamplerVoiceStealingOldest ) {
+                    if ( voice->serial < target->serial ) target = voice;
+                } else {
+                    float gain = fabsf(voice->hasPending ? voice->pending.gain : voice->note.gain);
+                    float targetGain = fabsf(target->hasPending ? target->pending.gain : target->note.gain);
+                    if ( gain < targetGain ) target = voice;
+                }
+            }
+        }
+        THIS->_stolenVoiceCount++;
+    }
+    
+    target->pending = *note;
+    target->hasPending = YES;
+    target->serial = ++THIS->_serial;
+    return YES;
+}
+
+static void AESamplerModuleBeginVoice(__unsafe_unretained AESamplerModule * THIS, AESamplerModuleVoice * voice) {
+    voice->note = voice->pending;
+    voice->hasPending = NO;
+    voice->position = 0;
+    voice->fetched = 0;
+    memset(voice->history, 0, sizeof(voice->history));
+    
+    if ( voice->note.sample ) {
+        voice->length = AEAudioSampleGetLength(voice->note.sample);
+    } else {
+        // The end of a streamed sample is found when the store's reads come up short
+        voice->length = UINT32_MAX;
+        AEStreamingSampleStoreStartVoice(THIS->_streamingStore, (int)(voice - THIS->_voices), voice->note.streamingSample);
+    }
+    
+    voice->rate = isnan(voice->note.rate) ? 1.0 : MAX(kMinRate, MIN(kMaxRate, voice->note.rate));
+    voice->active = voice->length > 0;
+}
+
+static void AESamplerModuleEndVoice(__unsafe_unretained AESamplerModule * THIS, AESamplerModuleVoice * voice) {
+    if ( voice->note.streamingSample ) {
+        AEStreamingSampleStoreStopVoice(THIS->_streamingStore, (int)(voice - THIS->_voices));
+    }
+    voice->active = NO;
+}
+
+static void AESamplerModuleFetch(__unsafe_unretained AESamplerModule * THIS, AESamplerModuleVoice * voice,
+                                 UInt64 start, UInt32 span, const float ** source) {
+    const AudioBufferList * window = THIS->_window;
+    
+    if ( voice->note.sample ) {
+        // Resident: read the span directly, silent past the end
+        UInt32 read = AEAudioSampleRead(voice->note.sample, window, (UInt32)MIN(start, UINT32_MAX), span);
+        if ( read < span ) AEAudioBufferListSilence(window, read, span - read);
+        for ( int i=0; i<THIS->_numberOfChannels; i++ ) {
+            source[i] = (const float *)window->mBuffers[i].mData;
+        }
+        return;
+    }
+    
+    // Streamed: reads are sequential, so the window holds the last few frames already fetched,
+    // which the span may overlap, followed by new frames from the store
+    const SInt64 base = (SInt64)voice->fetched - kGuardFrames;
+    const UInt64 end = start + span;
+    const UInt32 fresh = end > voice->fetched ? (UInt32)(end - voice->fetched) : 0;
+    for ( int i=0; i<THIS->_numberOfChannels; i++ ) {
+        memcpy(window->mBuffers[i].mData, voice->history[i], sizeof(voice->history[i]));
+    }
+    if ( fresh > 0 ) {
+        AEAudioBufferListCopyOnStack(target, window, kGuardFrames);
+        UInt32 read = AEStreamingSampleStoreReadVoice(THIS->_streamingStore, (int)(voice - THIS->_voices), target, fresh);
+        if ( read < fresh ) {
+            AEAudioBufferListSilence(window, kGuardFrames + read, fresh - read);
+            voice->length = (UInt32)MIN(voice->length, voice->fetched + read);
+        }
+        voice->fetched = end;
+        for ( int i=0; i<THIS->_numberOfChannels; i++ ) {
+            memcpy(voice->history[i], (const float *)window->mBuffers[i].mData + fresh, sizeof(voice->history[i]));
+        }
+    }
+    for ( int i=0; i<THIS->_numberOfChannels; i++ ) {
+        source[i] = (const float *)window->mBuffers[i].mData + (start - base);
+    }
+}
+
+static void AESamplerModuleRenderVoice(__unsafe_unretained AESamplerModule * THIS, AESamplerModuleVoice * voice,
+                                       const AudioBufferList * abl, UInt32 offset, UInt32 frames,
+                                       float gain, float gainStep) {
+    const double rate = voice->rate;
+    while ( frames > 0 ) {
+        double remaining = ceil((voice->length - voice->position) / rate);
+        if ( remaining <= 0 ) break;
+        UInt32 block = (UInt32)MIN(MIN(kBlockFrames, frames), remaining);
+        
+        // The source span covers every position in the block, plus the following frame for interpolation,
+        // with a guard against rounding in the single-precision position ramp
+        UInt64 start = (UInt64)voice->position;
+        UInt32 span = (UInt32)((UInt64)(voice->position + (block - 1) * rate) - start) + kGuardFrames;
+        const float * source[kMaxChannels];
+        AESamplerModuleFetch(THIS, voice, start, span, source);
+        
+        float first = voice->position - start;
+        float step = rate;
+        vDSP_vramp(&first, &step, THIS->_positions, 1, block);
+        for ( int i=0; i<THIS->_numberOfChannels; i++ ) {
+            vDSP_vlint(source[i], THIS->_positions, 1, THIS->_samples, 1, block, span);
+            float channelGain = gain;
+            vDSP_vrampmuladd(THIS->_samples, 1, &channelGain, &gainStep, (float *)abl->mBuffers[i].mData + offset, 1, block);
+        }
+        
+        gain += gainStep * block;
+        voice->position += block * rate;
+        offset += block;
+        frames -= block;
+    }
+    
+    if ( voice->position >= voice->length ) {
+        AESamplerModuleEndVoice(THIS, voice);
+    }
+}
+
+static void AESamplerModuleProcess(__unsafe_unretained AESamplerModule * THIS, const AERenderContext * _Nonnull context) {
+    AEAudioThreadEndpointPoll(THIS->_triggerEndpoint);
+    
+    const AudioBufferList * abl = AEBufferStackPushWithChannels(context->stack, 1, THIS->_numberOfChannels);
+    if ( !abl ) return;
+    AEAudioBufferListSilence(abl, 0, context->frames);
+    
+    for ( int i=0; i<THIS->_voiceCount; i++ ) {
+        AESamplerModuleVoice * voice = &THIS->_voices[i];
+        
+        if ( voice->hasPending ) {
+            if ( voice->active ) {
+                // Fade out the note being replaced, if it has started, then start the new one
+                if ( voice->note.offset == 0 ) {
+                    UInt32 fadeFrames = MIN(kStealFadeFrames, context->frames);
+                    AESamplerModuleRenderVoice(THIS, voice, abl, 0, fadeFrames, voice->note.gain, -voice->note.gain / fadeFrames);
+                }
+                if ( voice->active ) AESamplerModuleEndVoice(THIS, voice);
+            }
+            AESamplerModuleBeginVoice(THIS, voice);
+        }
+        
+        if ( !voice->active ) continue;
+        
+        if ( voice->note.offset >= context->frames ) {
+            voice->note.offset -= context->frames;
+            continue;
+        }
+        UInt32 offset = voice->note.offset;
+        voice->note.offset = 0;
+        AESamplerModuleRenderVoice(THIS, voice, abl, offset, context->frames - offset, voice->note.gain, 0);
+    }
+}
+
+static void AESamplerModuleReset(__unsafe_unretained AESamplerModule * THIS) {
+    AESamplerModuleStopAllVoices(THIS);
+}
+
+@end
@@ -0,0 +1,71 @@
+//
+//  AESampleRateConverterModule.h
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#import "AEModule.h"
+#import "AEResampler.h"
+
+/*!
+ * Sample rate converter module
+ *
+ *  This module runs a sub-renderer at its own sample rate, and converts its output to the
+ *  owning renderer's sample rate, using AEResampler.
+ *
+ *  Unlike AESubrendererModule, the sub-renderer's sample rate is not changed to match the owning
+ *  renderer; you may change it at any time, and the converter will be updated to match.
+ *
+ *  The sub-renderer is rendered in blocks sized to produce exactly the number of frames requested
+ *  of this module, so the number of frames it receives will vary from cycle to cycle.
+ */
+@interface AESampleRateConverterModule : AEModule
+
+/*!
+ * Initializer
+ *
+ * @param renderer Owning renderer
+ * @param subrenderer Sub-renderer to use to provide input
+ */
+- (instancetype _Nullable)initWithRenderer:(AERenderer * _Nullable)renderer
+                               subrenderer:(AERenderer * _Nullable)subrenderer;
+
+//! The sub-renderer. You may change this value at any time; assignment is thread-safe.
+@property (nonatomic, strong) AERenderer * _Nullable subrenderer;
+
+//! The conversion quality. Default is AEResamplerQualityHigh
+@property (nonatomic) AEResamplerQuality quality;
+
+//! The number of channels to use, or zero to track the owning renderer's channel count. Default is 2 (stereo)
+@property (nonatomic) int numberOfOutputChannels;
+
+@end
+
+#ifdef __cplusplus
+}
+#endif
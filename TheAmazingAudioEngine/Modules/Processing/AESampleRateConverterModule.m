@@ -0,0 +1,203 @@
+//
+//  AESampleRateConverterModule.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+
+#import "AESampleRateConverterModule.h"
+#import "AERenderer.h"
+#import "AEManagedValue.h"
+#import "AEAudioBufferListUtilities.h"
+#import "AETypes.h"
+
+static void * kSubrendererSampleRateChanged = &kSubrendererSampleRateChanged;
+
+typedef struct {
+    AEResampler * resampler;
+    AudioBufferList * buffer;
+    UInt32 bufferCapacity;
+    double sampleTime;
+} AESampleRateConverterModuleState;
+
+@interface AESampleRateConverterModule ()
+@property (nonatomic, strong) AEManagedValue * subrendererValue;
+@property (nonatomic, strong) AEManagedValue * stateValue;
+@end
+
+@implementation AESampleRateConverterModule
+@dynamic subrenderer;
+
+- (instancetype)initWithRenderer:(AERenderer *)renderer subrenderer:(AERenderer *)subrenderer {
+    if ( !(self = [super initWithRenderer:renderer]) ) return nil;
+    
+    _quality = AEResamplerQualityHigh;
+    _numberOfOutputChannels = 2;
+    self.subrendererValue = [AEManagedValue new];
+    self.stateValue = [AEManagedValue new];
+    self.stateValue.releaseBlock = ^(void * value) {
+        AESampleRateConverterModuleState * state = (AESampleRateConverterModuleState *)value;
+        AEResamplerFree(state->resampler);
+        AEAudioBufferListFree(state->buffer);
+        free(state);
+    };
+    self.subrenderer = subrenderer;
+    self.processFunction = AESampleRateConverterModuleProcess;
+    self.resetFunction = AESampleRateConverterModuleReset;
+    
+    return self;
+}
+
+- (void)dealloc {
+    self.subrenderer = nil;
+}
+
+- (void)setSubrenderer:(AERenderer *)subrenderer {
+    AERenderer * oldSubrenderer = self.subrendererValue.objectValue;
+    if ( oldSubrenderer == subrenderer ) return;
+    
+    if ( oldSubrenderer ) {
+        [oldSubrenderer removeObserver:self forKeyPath:NSStringFromSelector(@selector(sampleRate))
+                               context:kSubrendererSampleRateChanged];
+    }
+    
+    // Prepare the converter before the new sub-renderer goes live
+    [self updateStateWithSubrenderer:subrenderer];
+    self.subrendererValue.objectValue = subrenderer;
+    
+    if ( subrenderer ) {
+        [subrenderer addObserver:self forKeyPath:NSStringFromSelector(@selector(sampleRate)) options:0
+                         context:kSubrendererSampleRateChanged];
+    }
+}
+
+- (AERenderer *)subrenderer {
+    return self.subrendererValue.objectValue;
+}
+
+- (void)setQuality:(AEResamplerQuality)quality {
+    if ( _quality == quality ) return;
+    _quality = quality;
+    [self updateState];
+}
+
+- (void)setNumberOfOutputChannels:(int)numberOfOutputChannels {
+    if ( _numberOfOutputChannels == numberOfOutputChannels ) return;
+    _numberOfOutputChannels = numberOfOutputChannels;
+    [self updateState];
+}
+
+- (void)rendererDidChangeSampleRate {
+    [self updateState];
+}
+
+- (void)rendererDidChangeNumberOfChannels {
+    if ( _numberOfOutputChannels == 0 ) {
+        [self updateState];
+    }
+}
+
+- (void)observeValueForKeyPath:(NSString *)keyPath ofObject:(id)object change:(NSDictionary *)change context:(void *)context {
+    if ( context == kSubrendererSampleRateChanged ) {
+        [self updateState];
+    } else {
+        [super observeValueForKeyPath:keyPath ofObject:object change:change context:context];
+    }
+}
+
+static void AESampleRateConverterModuleProcess(__unsafe_unretained AESampleRateConverterModule * THIS,
+                                               const AERenderContext * _Nonnull context) {
+    
+    const AudioBufferList * abl = AEBufferStackPushWithChannels(context->stack, 1, THIS->_numberOfOutputChannels == 0 ? context->output->mNumberBuffers : THIS->_numberOfOutputChannels);
+    if ( !abl ) return;
+    
+    __unsafe_unretained AERenderer * renderer = (__bridge AERenderer*)AEManagedValueGetValue(THIS->_subrendererValue);
+    AESampleRateConverterModuleState * state = (AESampleRateConverterModuleState *)AEManagedValueGetValue(THIS->_stateValue);
+    if ( !renderer || !state ) {
+        AEAudioBufferListSilence(abl, 0, context->frames);
+        return;
+    }
+    
+    UInt32 produced = 0;
+    while ( produced < context->frames ) {
+        // Determine how much to pull from the sub-renderer, within the capacity of our buffer
+        UInt32 outputFrames = context->frames - produced;
+        UInt32 inputFrames = AEResamplerGetInputFramesRequired(state->resampler, outputFrames);
+        while ( inputFrames > state->bufferCapacity ) {
+            outputFrames = MAX(1, outputFrames / 2);
+            inputFrames = AEResamplerGetInputFramesRequired(state->resampler, outputFrames);
+        }
+        
+        if ( inputFrames > 0 ) {
+            AEAudioBufferListSetLength(state->buffer, inputFrames);
+            AudioTimeStamp timestamp = *context->timestamp;
+            timestamp.mSampleTime = state->sampleTime;
+            timestamp.mFlags |= kAudioTimeStampSampleTimeValid;
+            AERendererRun(renderer, state->buffer, inputFrames, &timestamp);
+            state->sampleTime += inputFrames;
+        }
+        
+        AEAudioBufferListCopyOnStack(output, abl, produced);
+        AEResamplerProcess(state->resampler, state->buffer, &inputFrames, output, &outputFrames);
+        produced += outputFrames;
+    }
+}
+
+static void AESampleRateConverterModuleReset(__unsafe_unretained AESampleRateConverterModule * THIS) {
+    AESampleRateConverterModuleState * state = (AESampleRateConverterModuleState *)AEManagedValueGetValue(THIS->_stateValue);
+    if ( state ) {
+        AEResamplerReset(state->resampler);
+        state->sampleTime = 0;
+    }
+}
+
+- (void)updateState {
+    [self updateStateWithSubrenderer:self.subrenderer];
+}
+
+- (void)updateStateWithSubrenderer:(AERenderer *)subrenderer {
+    double outputRate = self.renderer.sampleRate;
+    double inputRate = subrenderer.sampleRate;
+    int channels = _numberOfOutputChannels == 0 ? self.renderer.numberOfOutputChannels : _numberOfOutputChannels;
+    if ( !subrenderer || outputRate <= 0 || inputRate <= 0 || channels < 1 ) {
+        self.stateValue.pointerValue = NULL;
+        return;
+    }
+    
+    AEResampler * resampler = AEResamplerNew(inputRate, outputRate, channels, _quality);
+    if ( !resampler ) {
+        self.stateValue.pointerValue = NULL;
+        return;
+    }
+
+    AESampleRateConverterModuleState * state = calloc(1, sizeof(AESampleRateConverterModuleState));
+    state->resampler = resampler;
+
+    // Size the input buffer to cover a full slice at the output rate, plus the filter length
+    state->bufferCapacity = (UInt32)ceil(AEGetMaxFramesPerSlice() * (inputRate / outputRate)) + 2*AEResamplerGetLatency(state->resampler) + 1;
+    state->buffer = AEAudioBufferListCreateWithFormat(AEAudioDescriptionWithChannelsAndRate(channels, inputRate), state->bufferCapacity);
+    
+    self.stateValue.pointerValue = state;
+}
+
+@end
@@ -0,0 +1,78 @@
+//
+//  AETimePitchModule.h
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#import "AEModule.h"
+#import "AETimeStretcher.h"
+
+/*!
+ * Time/pitch module
+ *
+ *  This module runs a sub-renderer, and changes the rate and pitch of its output independently,
+ *  using AETimeStretcher. It is a native alternative to AENewTimePitchModule, with lower CPU cost,
+ *  and a choice of algorithm: use AETimeStretchAlgorithmWSOLA when running many stretched sources
+ *  at once.
+ *
+ *  The sub-renderer's sample rate tracks the owning renderer's sample rate, and it is flagged with
+ *  AERendererContextFlagIsVariableRate. It is rendered in blocks sized to produce exactly the number
+ *  of frames requested of this module, so the number of frames it receives will vary from cycle
+ *  to cycle.
+ */
+@interface AETimePitchModule : AEModule
+
+/*!
+ * Initializer
+ *
+ * @param renderer Owning renderer
+ * @param subrenderer Sub-renderer to use to provide input
+ */
+- (instancetype _Nullable)initWithRenderer:(AERenderer * _Nullable)renderer
+                               subrenderer:(AERenderer * _Nullable)subrenderer;
+
+//! The sub-renderer. You may change this value at any time; assignment is thread-safe.
+@property (nonatomic, strong) AERenderer * _Nullable subrenderer;
+
+//! Playback rate, from 1/32 to 32.0. Default is 1.0.
+@property (nonatomic) double rate;
+
+//! Pitch shift, from -2400 cents to 2400 cents. Default is 0.0 cents.
+@property (nonatomic) double pitch;
+
+//! The time stretch algorithm. Default is AETimeStretchAlgorithmPhaseVocoder.
+@property (nonatomic) AETimeStretchAlgorithm algorithm;
+
+//! The number of channels to use, or zero to track the owning renderer's channel count. Default is 2 (stereo)
+@property (nonatomic) int numberOfOutputChannels;
+
+@end
+
+#ifdef __cplusplus
+}
+#endif
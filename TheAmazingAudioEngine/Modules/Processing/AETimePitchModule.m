@@ -0,0 +1,183 @@
+//
+//  AETimePitchModule.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+
+#import "AETimePitchModule.h"
+#import "AERenderer.h"
+#import "AEManagedValue.h"
+#import "AEAudioBufferListUtilities.h"
+#import "AETypes.h"
+
+static const UInt32 kInputBufferSlices = 4;
+
+typedef struct {
+    AETimeStretcher * stretcher;
+    AudioBufferList * buffer;
+    UInt32 bufferCapacity;
+    double sampleTime;
+} AETimePitchModuleState;
+
+@interface AETimePitchModule ()
+@property (nonatomic, strong) AEManagedValue * subrendererValue;
+@property (nonatomic, strong) AEManagedValue * stateValue;
+@end
+
+@implementation AETimePitchModule
+@dynamic subrenderer;
+
+- (instancetype)initWithRenderer:(AERenderer *)renderer subrenderer:(AERenderer *)subrenderer {
+    if ( !(self = [super initWithRenderer:renderer]) ) return nil;
+    
+    _rate = 1.0;
+    _pitch = 0.0;
+    _algorithm = AETimeStretchAlgorithmPhaseVocoder;
+    _numberOfOutputChannels = 2;
+    self.subrendererValue = [AEManagedValue new];
+    self.stateValue = [AEManagedValue new];
+    self.stateValue.releaseBlock = ^(void * value) {
+        AETimePitchModuleState * state = (AETimePitchModuleState *)value;
+        AETimeStretcherFree(state->stretcher);
+        AEAudioBufferListFree(state->buffer);
+        free(state);
+    };
+    self.subrenderer = subrenderer;
+    [self updateState];
+    self.processFunction = AETimePitchModuleProcess;
+    self.resetFunction = AETimePitchModuleReset;
+    
+    return self;
+}
+
+- (void)setSubrenderer:(AERenderer *)subrenderer {
+    subrenderer.sampleRate = self.renderer.sampleRate;
+    subrenderer.flags |= AERendererContextFlagIsVariableRate;
+    self.subrendererValue.objectValue = subrenderer;
+}
+
+- (AERenderer *)subrenderer {
+    return self.subrendererValue.objectValue;
+}
+
+- (void)setAlgorithm:(AETimeStretchAlgorithm)algorithm {
+    if ( _algorithm == algorithm ) return;
+    _algorithm = algorithm;
+    [self updateState];
+}
+
+- (void)setNumberOfOutputChannels:(int)numberOfOutputChannels {
+    if ( _numberOfOutputChannels == numberOfOutputChannels ) return;
+    _numberOfOutputChannels = numberOfOutputChannels;
+    [self updateState];
+}
+
+- (void)rendererDidChangeSampleRate {
+    self.subrenderer.sampleRate = self.renderer.sampleRate;
+    [self updateState];
+}
+
+- (void)rendererDidChangeNumberOfChannels {
+    if ( _numberOfOutputChannels == 0 ) {
+        [self updateState];
+    }
+}
+
+static void AETimePitchModuleProcess(__unsafe_unretained AETimePitchModule * THIS, const AERenderContext * _Nonnull context) {
+    
+    const AudioBufferList * abl = AEBufferStackPushWithChannels(context->stack, 1, THIS->_numberOfOutputChannels == 0 ? context->output->mNumberBuffers : THIS->_numberOfOutputChannels);
+    if ( !abl ) return;
+    
+    __unsafe_unretained AERenderer * renderer = (__bridge AERenderer*)AEManagedValueGetValue(THIS->_subrendererValue);
+    AETimePitchModuleState * state = (AETimePitchModuleState *)AEManagedValueGetValue(THIS->_stateValue);
+    if ( !renderer || !state ) {
+        AEAudioBufferListSilence(abl, 0, context->frames);
+        return;
+    }
+    
+    AETimeStretcherSetRate(state->stretcher, THIS->_rate);
+    AETimeStretcherSetPitch(state->stretcher, THIS->_pitch);
+    
+    UInt32 produced = 0;
+    while ( produced < context->frames ) {
+        // Determine how much to pull from the sub-renderer, within the capacity of our buffer
+        UInt32 outputFrames = context->frames - produced;
+        UInt32 inputFrames = AETimeStretcherGetInputFramesRequired(state->stretcher, outputFrames);
+        while ( inputFrames > state->bufferCapacity && outputFrames > 1 ) {
+            outputFrames /= 2;
+            inputFrames = AETimeStretcherGetInputFramesRequired(state->stretcher, outputFrames);
+        }
+        
+        // At the fastest rates, a single hop can span more than our buffer: the time stretcher will then
+        // consume this input without output, and we'll pull again
+        inputFrames = MIN(inputFrames, state->bufferCapacity);
+        
+        if ( inputFrames > 0 ) {
+            AEAudioBufferListSetLength(state->buffer, inputFrames);
+            AudioTimeStamp timestamp = *context->timestamp;
+            timestamp.mSampleTime = state->sampleTime;
+            timestamp.mFlags |= kAudioTimeStampSampleTimeValid;
+            AERendererRun(renderer, state->buffer, inputFrames, &timestamp);
+            state->sampleTime += inputFrames;
+        }
+        
+        AEAudioBufferListCopyOnStack(output, abl, produced);
+        AETimeStretcherProcess(state->stretcher, state->buffer, &inputFrames, output, &outputFrames);
+        produced += outputFrames;
+    }
+}
+
+static void AETimePitchModuleReset(__unsafe_unretained AETimePitchModule * THIS) {
+    AETimePitchModuleState * state = (AETimePitchModuleState *)AEManagedValueGetValue(THIS->_stateValue);
+    if ( state ) {
+        AETimeStretcherReset(state->stretcher);
+        state->sampleTime = 0;
+    }
+}
+
+- (void)updateState {
+    double sampleRate = self.renderer.sampleRate;
+    int channels = _numberOfOutputChannels == 0 ? self.renderer.numberOfOutputChannels : _numberOfOutputChannels;
+    if ( !self.stateValue ) return;
+    if ( sampleRate <= 0 || channels < 1 ) {
+        self.stateValue.pointerValue = NULL;
+        return;
+    }
+    
+    AETimeStretcher * stretcher = AETimeStretcherNew(channels, sampleRate, _algorithm);
+    if ( !stretcher ) {
+        self.stateValue.pointerValue = NULL;
+        return;
+    }
+    
+    // Fast rates pull a lot of input per slice; larger pulls are broken up into multiple renders
+    AETimePitchModuleState * state = calloc(1, sizeof(AETimePitchModuleState));
+    state->stretcher = stretcher;
+    state->bufferCapacity = AEGetMaxFramesPerSlice() * kInputBufferSlices;
+    state->buffer = AEAudioBufferListCreateWithFormat(AEAudioDescriptionWithChannelsAndRate(channels, sampleRate), state->bufferCapacity);
+    
+    self.stateValue.pointerValue = state;
+}
+
+@end
@@ -29,18 +29,58 @@ extern "C" {
 #endif
     
 #import <Foundation/Foundation.h>
-#import "AEAudioUnitModule.h"
+#import "AEModule.h"
+#import "AEResampler.h"
 
-@interface AEVarispeedModule : AEAudioUnitModule
+/*!
+ * Varispeed module
+ *
+ *  This module runs a sub-renderer at a variable rate, changing its speed and pitch together, like
+ *  a tape or turntable. It's implemented with AEResampler, with a choice of linear, cubic or
+ *  band-limited sinc interpolation.
+ *
+ *  The sub-renderer is pulled for exactly the number of frames needed to produce each render,
+ *  so it never renders ahead. Its sample rate tracks the owning renderer's sample rate, and it is
+ *  flagged with AERendererContextFlagIsVariableRate, as the number of frames it receives will vary
+ *  from cycle to cycle.
+ *
+ *  Rate changes glide across the following render cycle, so the rate can be driven continuously,
+ *  such as from a touch gesture for scratching. The cheaper interpolation qualities make it
+ *  practical to run many instances at once.
+ *
+ *  Note: this class used to be a subclass of AEAudioUnitModule, wrapping the AUVarispeed audio
+ *  unit. It now derives directly from AEModule, so the AEAudioUnitModule API - `audioUnit`,
+ *  AEAudioUnitModuleGetAudioUnit, `componentDescription`, `wetDry` and the parameter
+ *  accessors - is no longer available, and the sub-renderer is set up by this class rather than
+ *  through the audio unit's render callback. The effective rate, combining `playbackRate` and
+ *  `playbackCents`, is clamped to the range 0 to 8; negative (reverse) rates are not supported.
+ */
+@interface AEVarispeedModule : AEModule
 
-- (instancetype _Nullable)initWithRenderer:(AERenderer * _Nullable)renderer subrenderer:(AERenderer * _Nonnull)subrenderer;
+/*!
+ * Initializer
+ *
+ * @param renderer Owning renderer
+ * @param subrenderer Sub-renderer to use to provide input
+ */
+- (instancetype _Nullable)initWithRenderer:(AERenderer * _Nullable)renderer subrenderer:(AERenderer * _Nullable)subrenderer;
 
-//! documented range is from 0.25 to 4.0, but empircal testing shows it to be 0.25 to 2.0. Default is 1.0.
+//! The sub-renderer. You may change this value at any time; assignment is thread-safe.
+@property (nonatomic, strong) AERenderer * _Nullable subrenderer;
+
+//! Playback rate, from 0.0 to 8.0. Negative (reverse) rates are not supported. Default is 1.0.
 @property (nonatomic) double playbackRate;
 
-//! range is from -2400 to 2400. Default is 0.0.
+//! Additional rate change, in cents, from -2400 to 2400. Default is 0.0.
 @property (nonatomic) double playbackCents;
 
+//! Interpolation quality. Default is AEResamplerQualityCubic. The sinc tiers lower their cutoff
+//! as the rate increases, to avoid aliasing.
+@property (nonatomic) AEResamplerQuality quality;
+
+//! The number of channels to use, or zero to track the owning renderer's channel count. Default is 2 (stereo)
+@property (nonatomic) int numberOfOutputChannels;
+
 @end
 
 #ifdef __cplusplus
@@ -25,36 +25,189 @@
 //
 
 #import "AEVarispeedModule.h"
+#import "AERenderer.h"
+#import "AEManagedValue.h"
+#import "AEAudioBufferListUtilities.h"
+#import "AETypes.h"
+
+static const double kMinimumRate = 1.0e-6;
+static const double kMaximumRate = 8.0;
+static const UInt32 kRateGlideFrames = 64;
+
+typedef struct {
+    AEResampler * resampler;
+    AudioBufferList * buffer;
+    UInt32 bufferCapacity;
+    double rate;
+    double sampleTime;
+} AEVarispeedModuleState;
+
+@interface AEVarispeedModule () {
+    double _rate;
+}
+@property (nonatomic, strong) AEManagedValue * subrendererValue;
+@property (nonatomic, strong) AEManagedValue * stateValue;
+@end
 
 @implementation AEVarispeedModule
+@dynamic subrenderer;
 
 - (instancetype)initWithRenderer:(AERenderer *)renderer subrenderer:(AERenderer *)subrenderer {
-    return [super initWithRenderer:renderer componentDescription:(AudioComponentDescription) {
-        kAudioUnitType_FormatConverter, kAudioUnitSubType_Varispeed, kAudioUnitManufacturer_Apple
-    } subrenderer:subrenderer];
+    if ( !(self = [super initWithRenderer:renderer]) ) return nil;
+    
+    _playbackRate = 1.0;
+    _playbackCents = 0.0;
+    _rate = 1.0;
+    _quality = AEResamplerQualityCubic;
+    _numberOfOutputChannels = 2;
+    self.subrendererValue = [AEManagedValue new];
+    self.stateValue = [AEManagedValue new];
+    self.stateValue.releaseBlock = ^(void * value) {
+        AEVarispeedModuleState * state = (AEVarispeedModuleState *)value;
+        AEResamplerFree(state->resampler);
+        AEAudioBufferListFree(state->buffer);
+        free(state);
+    };
+    self.subrenderer = subrenderer;
+    [self updateState];
+    self.processFunction = AEVarispeedModuleProcess;
+    self.resetFunction = AEVarispeedModuleReset;
+    
+    return self;
 }
 
-#pragma mark - Getters
+- (void)setSubrenderer:(AERenderer *)subrenderer {
+    subrenderer.sampleRate = self.renderer.sampleRate;
+    subrenderer.flags |= AERendererContextFlagIsVariableRate;
+    self.subrendererValue.objectValue = subrenderer;
+}
 
-- (double)playbackRate {
-    return [self getParameterValueForId:kVarispeedParam_PlaybackRate];
+- (AERenderer *)subrenderer {
+    return self.subrendererValue.objectValue;
 }
 
-- (double)playbackCents {
-    return [self getParameterValueForId:kVarispeedParam_PlaybackCents];
+- (void)setPlaybackRate:(double)playbackRate {
+    _playbackRate = playbackRate;
+    [self updateRate];
 }
 
+- (void)setPlaybackCents:(double)playbackCents {
+    _playbackCents = playbackCents;
+    [self updateRate];
+}
 
-#pragma mark - Setters
+- (void)setQuality:(AEResamplerQuality)quality {
+    if ( _quality == quality ) return;
+    _quality = quality;
+    [self updateState];
+}
 
-- (void)setPlaybackRate:(double)playbackRate {
-    [self setParameterValue: playbackRate
-                      forId: kVarispeedParam_PlaybackRate];
+- (void)setNumberOfOutputChannels:(int)numberOfOutputChannels {
+    if ( _numberOfOutputChannels == numberOfOutputChannels ) return;
+    _numberOfOutputChannels = numberOfOutputChannels;
+    [self updateState];
 }
 
-- (void)setPlaybackCents:(double)playbackCents {
-    [self setParameterValue: playbackCents
-                      forId: kVarispeedParam_PlaybackCents];
+- (void)rendererDidChangeSampleRate {
+    self.subrenderer.sampleRate = self.renderer.sampleRate;
+    [self updateState];
+}
+
+- (void)rendererDidChangeNumberOfChannels {
+    if ( _numberOfOutputChannels == 0 ) {
+        [self updateState];
+    }
+}
+
+static void AEVarispeedModuleProcess(__unsafe_unretained AEVarispeedModule * THIS, const AERenderContext * _Nonnull context) {
+    
+    const AudioBufferList * abl = AEBufferStackPushWithChannels(context->stack, 1, THIS->_numberOfOutputChannels == 0 ? context->output->mNumberBuffers : THIS->_numberOfOutputChannels);
+    if ( !abl ) return;
+    
+    __unsafe_unretained AERenderer * renderer = (__bridge AERenderer*)AEManagedValueGetValue(THIS->_subrendererValue);
+    AEVarispeedModuleState * state = (AEVarispeedModuleState *)AEManagedValueGetValue(THIS->_stateValue);
+    if ( !renderer || !state ) {
+        AEAudioBufferListSilence(abl, 0, context->frames);
+        return;
+    }
+    
+    double initialRate = state->rate;
+    double targetRate = THIS->_rate;
+    
+    UInt32 produced = 0;
+    while ( produced < context->frames ) {
+        UInt32 outputFrames = context->frames - produced;
+        if ( targetRate != initialRate ) {
+            // Glide to the new rate over the course of this render, in short segments
+            outputFrames = MIN(outputFrames, kRateGlideFrames);
+            AEResamplerSetRatio(state->resampler,
+                                initialRate + (targetRate - initialRate) * (double)(produced + outputFrames) / context->frames);
+        }
+        
+        // Determine how much to pull from the sub-renderer, within the capacity of our buffer
+        UInt32 inputFrames = AEResamplerGetInputFramesRequired(state->resampler, outputFrames);
+        while ( inputFrames > state->bufferCapacity && outputFrames > 1 ) {
+            outputFrames /= 2;
+            inputFrames = AEResamplerGetInputFramesRequired(state->resampler, outputFrames);
+        }
+        inputFrames = MIN(inputFrames, state->bufferCapacity);
+        
+        if ( inputFrames > 0 ) {
+            AEAudioBufferListSetLength(state->buffer, inputFrames);
+            AudioTimeStamp timestamp = *context->timestamp;
+            timestamp.mSampleTime = state->sampleTime;
+            timestamp.mFlags |= kAudioTimeStampSampleTimeValid;
+            AERendererRun(renderer, state->buffer, inputFrames, &timestamp);
+            state->sampleTime += inputFrames;
+        }
+        
+        AEAudioBufferListCopyOnStack(output, abl, produced);
+        AEResamplerProcess(state->resampler, state->buffer, &inputFrames, output, &outputFrames);
+        produced += outputFrames;
+    }
+    
+    if ( targetRate != initialRate ) {
+        AEResamplerSetRatio(state->resampler, targetRate);
+        state->rate = targetRate;
+    }
+}
+
+static void AEVarispeedModuleReset(__unsafe_unretained AEVarispeedModule * THIS) {
+    AEVarispeedModuleState * state = (AEVarispeedModuleState *)AEManagedValueGetValue(THIS->_stateValue);
+    if ( state ) {
+        AEResamplerReset(state->resampler);
+        state->sampleTime = 0;
+    }
+}
+
+- (void)updateRate {
+    _rate = MAX(kMinimumRate, MIN(kMaximumRate, _playbackRate * pow(2.0, _playbackCents / 1200.0)));
+}
+
+- (void)updateState {
+    double sampleRate = self.renderer.sampleRate;
+    int channels = _numberOfOutputChannels == 0 ? self.renderer.numberOfOutputChannels : _numberOfOutputChannels;
+    if ( !self.stateValue ) return;
+    if ( sampleRate <= 0 || channels < 1 ) {
+        self.stateValue.pointerValue = NULL;
+        return;
+    }
+    
+    AEResampler * resampler = AEResamplerNewWithVariableRatio(_rate, kMaximumRate, channels, _quality);
+    if ( !resampler ) {
+        self.stateValue.pointerValue = NULL;
+        return;
+    }
+    
+    AEVarispeedModuleState * state = calloc(1, sizeof(AEVarispeedModuleState));
+    state->resampler = resampler;
+    state->rate = _rate;
+    
+    // Size the input buffer to cover a full slice at the maximum rate, plus the filter length
+    state->bufferCapacity = (UInt32)ceil(AEGetMaxFramesPerSlice() * kMaximumRate) + 2*AEResamplerGetLatency(resampler) + 1;
+    state->buffer = AEAudioBufferListCreateWithFormat(AEAudioDescriptionWithChannelsAndRate(channels, sampleRate), state->bufferCapacity);
+    
+    self.stateValue.pointerValue = state;
 }
 
 @end
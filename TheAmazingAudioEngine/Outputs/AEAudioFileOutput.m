@@ -115,6 +115,7 @@ static const UInt32 kFramesPerSlice = 1024;
             
             // Run renderer
             [AEManagedValue performBlockBypassingAtomicBatchUpdate:^{
+                AEManagedValueMarkRenderThreadQuiescent();
                 AERendererRun(self.renderer, abl, frames, &self->_timestamp);
             }];
             
@@ -147,6 +148,9 @@ static const UInt32 kFramesPerSlice = 1024;
         
         AEAudioBufferListFree(abl);
         
+        // This dispatch queue thread is done rendering; don't hold up the release of old values
+        AEManagedValueUnregisterRenderThread(pthread_self());
+        
         dispatch_async(dispatch_get_main_queue(), ^{
             NSError * error = nil;
             if ( status != noErr ) {
@@ -174,6 +178,7 @@ static const UInt32 kFramesPerSlice = 1024;
             UInt32 frames = kFramesPerSlice;
             
             // Run renderer
+            AEManagedValueMarkRenderThreadQuiescent();
             AERendererRun(self.renderer, abl, kFramesPerSlice, &self->_timestamp);
             
             // Write to file
@@ -188,6 +193,9 @@ static const UInt32 kFramesPerSlice = 1024;
         
         AEAudioBufferListFree(abl);
         
+        // This dispatch queue thread is done rendering; don't hold up the release of old values
+        AEManagedValueUnregisterRenderThread(pthread_self());
+        
         dispatch_async(dispatch_get_main_queue(), ^{
             NSError * error = nil;
             if ( status != noErr ) {
@@ -177,6 +177,10 @@ static const AESeconds kRenderBudgetWarningInitialDelay = 4.0; // Seconds to wai
     if ( !self.ioUnit.audioUnit ) return;
     [self.ioUnit stop];
     
+    // The render thread no longer holds any values, so it needn't hold up their release
+    if ( AERealtimeThreadIdentifier ) {
+        AEManagedValueUnregisterRenderThread(AERealtimeThreadIdentifier);
+    }
     AERealtimeThreadIdentifier = nil;
 }
 
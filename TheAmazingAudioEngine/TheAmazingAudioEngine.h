@@ -38,6 +38,9 @@ extern "C" {
 #import "AEAudioUnitInputModule.h"
 #import "AEAudioFilePlayerModule.h"
 #import "AEOscillatorModule.h"
+#import "AEOscillatorBankModule.h"
+#import "AESamplerModule.h"
+#import "AEGranularModule.h"
 #import "AEMixerModule.h"
 #import "AESplitterModule.h"
 #import "AEBandpassModule.h"
@@ -52,6 +55,8 @@ extern "C" {
 #import "AEParametricEqModule.h"
 #import "AEPeakLimiterModule.h"
 #import "AEVarispeedModule.h"
+#import "AESampleRateConverterModule.h"
+#import "AETimePitchModule.h"
 #import "AEAudioFileRecorderModule.h"
 #import "AEAudioPasteboard.h"
 
@@ -65,14 +70,25 @@ extern "C" {
 #import "TPCircularBuffer.h"
 #import "AECircularBuffer.h"
 #import "AEDSPUtilities.h"
+#import "AEResampler.h"
+#import "AETimeStretcher.h"
 #import "AEMainThreadEndpoint.h"
 #import "AEAudioThreadEndpoint.h"
+#import "AEAudioThreadParameterEndpoint.h"
 #import "AEMessageQueue.h"
 #import "AETime.h"
 #import "AEArray.h"
 #import "AEManagedValue.h"
+#import "AETripleBuffer.h"
 #import "AEIOAudioUnit.h"
 #import "AEAudioFileReader.h"
+#import "AEAudioFileStream.h"
+#import "AEMappedAudioFile.h"
+#import "AECompactAudio.h"
+#import "AEAudioSampleCache.h"
+#import "AEAudioDiskCache.h"
+#import "AEProgressiveAudioFileLoader.h"
+#import "AEStreamingSampleStore.h"
 #import "AEWeakRetainingProxy.h"
 #import "AELevelsAnalyzer.h"
 
@@ -165,6 +181,11 @@ extern "C" {
     <td>Manage a list of objects or pointers in a thread-safe way. Use this to manage lists of modules that can
         be manipulated at any time, or use it to map between model objects in your app and C structures that you use
         for rendering or analysis tasks.</td>
+ </tr>
+ <tr>
+    <th>AETripleBuffer</th>
+    <td>Pass continuously changing state, like filter coefficients or automation snapshots, to the audio thread
+        with no locks, allocations or releases. The audio thread always sees the latest complete value.</td>
  </tr>
   <tr>
     <th>[AEAudioBufferListUtilities](@ref AEAudioBufferListUtilities.h)</th>
@@ -185,6 +206,7 @@ extern "C" {
         data and more. The message queue is built from:
  - AEMainThreadEndpoint: A simple facility for sending messages to the main thread from the audio thread.
  - AEAudioThreadEndpoint: A simple facility for sending messages to the audio thread from the main thread.
+ - AEAudioThreadParameterEndpoint: Sends parameter updates to the audio thread, delivering only the latest value for each parameter.
     </td>
  </tr>
  <tr>
@@ -0,0 +1,130 @@
+//
+//  AEAudioDiskCache.h
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#import <Foundation/Foundation.h>
+#import <AudioToolbox/AudioToolbox.h>
+
+/*!
+ * Persistent decoded audio cache
+ *
+ *  This class stores decoded audio on disk, so that compressed files (such as AAC) need only be
+ *  decoded once, rather than on every launch. Entries are keyed by a hash of the source file's
+ *  contents and the target sample rate and channel count, so a cached entry is found again
+ *  regardless of where the file lives, and is never used once the file changes.
+ *
+ *  Audio is stored in the standard non-interleaved float format (AEAudioDescription), one
+ *  channel after another, so that a cached entry can be memory-mapped and presented directly as
+ *  an AudioBufferList: loading performs no decoding and no copying, and pages are brought in by
+ *  the system as the audio is first played.
+ *
+ *  Assign an instance to AEAudioSampleCache's diskCache property to use it for loaded samples.
+ *  The methods of this class perform file I/O, and should be called on a background thread.
+ */
+@interface AEAudioDiskCache : NSObject
+
+/*!
+ * Default initializer
+ *
+ * @param directory The directory in which to store cached audio; created if necessary
+ */
+- (instancetype _Nonnull)initWithDirectory:(NSString * _Nonnull)directory;
+
+/*!
+ * Determine whether a target audio format can be cached
+ *
+ * @param audioDescription The target audio format
+ * @return YES if the format is non-interleaved 32-bit float, with a defined sample rate
+ */
++ (BOOL)canCacheAudioDescription:(AudioStreamBasicDescription)audioDescription;
+
+/*!
+ * Get the cache key for a file
+ *
+ *  This hashes the file's contents, which is much faster than decoding it.
+ *
+ * @param path Path to the source file
+ * @param audioDescription The target audio format
+ * @param error If not NULL, the error on output
+ * @return The key, or nil if the file couldn't be read or the format can't be cached
+ */
+- (NSString * _Nullable)keyForFileAtPath:(NSString * _Nonnull)path
+                        audioDescription:(AudioStreamBasicDescription)audioDescription
+                                   error:(NSError * _Nullable * _Nullable)error;
+
+/*!
+ * Map cached audio
+ *
+ *  The returned buffer list refers to read-only mapped memory: do not write to it. Release it with
+ *  AEAudioDiskCacheFreeMappedAudio, not AEAudioBufferListFree.
+ *
+ * @param key The key for the entry
+ * @param length On output, the length of the audio, in frames
+ * @return The mapped audio, or NULL if there's no valid entry for the key
+ */
+- (AudioBufferList * _Nullable)mapAudioForKey:(NSString * _Nonnull)key length:(UInt32 * _Nonnull)length;
+
+/*!
+ * Store decoded audio
+ *
+ *  The entry is written to a temporary file and moved into place, so a partially-written entry
+ *  is never seen by readers.
+ *
+ * @param audio The decoded audio, in the format given when the key was created
+ * @param length The length of the audio, in frames
+ * @param key The key for the entry
+ * @param error If not NULL, the error on output
+ * @return YES on success
+ */
+- (BOOL)storeAudio:(const AudioBufferList * _Nonnull)audio
+            length:(UInt32)length
+            forKey:(NSString * _Nonnull)key
+             error:(NSError * _Nullable * _Nullable)error;
+
+/*!
+ * Remove all cached audio
+ */
+- (void)removeAllCachedAudio;
+
+//! The directory in which cached audio is stored
+@property (nonatomic, strong, readonly) NSString * _Nonnull directory;
+
+@end
+
+/*!
+ * Release audio returned from mapAudioForKey:length:
+ *
+ * @param audio The mapped audio
+ */
+void AEAudioDiskCacheFreeMappedAudio(AudioBufferList * _Nonnull audio);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,261 @@
+//
+//  AEAudioDiskCache.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+
+#import "AEAudioDiskCache.h"
+#import <CommonCrypto/CommonDigest.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
+#import <fcntl.h>
+#import <unistd.h>
+#import <stddef.h>
+
+static const UInt32 kMagic = 'AEdc';
+static const UInt32 kVersion = 1;
+static const size_t kHashReadSize = 1024 * 1024;
+static NSString * const kFileExtension = @"aedc";
+
+typedef struct {
+    UInt32 magic;
+    UInt32 version;
+    UInt32 numberOfChannels;
+    UInt32 length;
+    UInt64 channelStride;
+} AEAudioDiskCacheHeader;
+
+typedef struct {
+    void * mapping;
+    size_t size;
+    AudioBufferList audio; // Must be last, as it's variable-length
+} AEAudioDiskCacheMapping;
+
+// Channel data follows the header, each channel aligned for vector access
+#define kAlignment 64
+#define kDataOffset AEAudioDiskCacheAlign(sizeof(AEAudioDiskCacheHeader))
+
+static size_t AEAudioDiskCacheAlign(size_t size) {
+    return (size + kAlignment - 1) & ~(size_t)(kAlignment - 1);
+}
+
+static BOOL AEAudioDiskCacheWrite(int fd, const void * bytes, size_t size) {
+    while ( size > 0 ) {
+        ssize_t written = write(fd, bytes, size);
+        if ( written < 0 ) {
+            if ( errno == EINTR ) continue;
+            return NO;
+        }
+        bytes = (const char *)bytes + written;
+        size -= written;
+    }
+    return YES;
+}
+
+@implementation AEAudioDiskCache
+
+- (instancetype)initWithDirectory:(NSString *)directory {
+    if ( !(self = [super init]) ) return nil;
+    _directory = directory;
+    [[NSFileManager defaultManager] createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:NULL];
+    return self;
+}
+
++ (BOOL)canCacheAudioDescription:(AudioStreamBasicDescription)audioDescription {
+    return audioDescription.mFormatID == kAudioFormatLinearPCM
+        && (audioDescription.mFormatFlags & kAudioFormatFlagIsFloat)
+        && (audioDescription.mFormatFlags & kAudioFormatFlagIsNonInterleaved)
+        && audioDescription.mBitsPerChannel == 32
+        && audioDescription.mChannelsPerFrame > 0
+        && audioDescription.mSampleRate > DBL_EPSILON;
+}
+
+- (NSString *)keyForFileAtPath:(NSString *)path audioDescription:(AudioStreamBasicDescription)audioDescription
+                         error:(NSError **)error {
+    
+    if ( ![AEAudioDiskCache canCacheAudioDescription:audioDescription] ) {
+        if ( error ) *error = [NSError errorWithDomain:NSOSStatusErrorDomain code:kAudioFormatUnsupportedDataFormatError
+                                              userInfo:@{NSLocalizedDescriptionKey: @"Unsupported audio format for cache"}];
+        return nil;
+    }
+    
+    int fd = open(path.fileSystemRepresentation, O_RDONLY);
+    if ( fd < 0 ) {
+        if ( error ) *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno
+                                              userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"Couldn't open the audio file", @"")}];
+        return nil;
+    }
+    
+    // Hash the file contents
+    CC_SHA256_CTX context;
+    CC_SHA256_Init(&context);
+    void * buffer = malloc(kHashReadSize);
+    ssize_t bytes;
+    while ( (bytes = read(fd, buffer, kHashReadSize)) != 0 ) {
+        if ( bytes < 0 ) {
+            if ( errno == EINTR ) continue;
+            break;
+        }
+        CC_SHA256_Update(&context, buffer, (CC_LONG)bytes);
+    }
+    int readError = bytes < 0 ? errno : 0;
+    free(buffer);
+    close(fd);
+    
+    if ( readError ) {
+        if ( error ) *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:readError
+                                              userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"Couldn't read the audio file", @"")}];
+        return nil;
+    }
+    
+    unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+    CC_SHA256_Final(digest, &context);
+    
+    NSMutableString * key = [NSMutableString stringWithCapacity:CC_SHA256_DIGEST_LENGTH*2 + 16];
+    for ( int i=0; i<CC_SHA256_DIGEST_LENGTH; i++ ) {
+        [key appendFormat:@"%02x", digest[i]];
+    }
+    [key appendFormat:@"-%g-%u", audioDescription.mSampleRate, (unsigned int)audioDescription.mChannelsPerFrame];
+    return key;
+}
+
+- (AudioBufferList *)mapAudioForKey:(NSString *)key length:(UInt32 *)length {
+    int fd = open([self pathForKey:key].fileSystemRepresentation, O_RDONLY);
+    if ( fd < 0 ) return NULL;
+    
+    struct stat info;
+    if ( fstat(fd, &info) != 0 || info.st_size < (off_t)kDataOffset ) {
+        close(fd);
+        return NULL;
+    }
+    
+    size_t size = (size_t)info.st_size;
+    void * mapping = mmap(NULL, size, PROT_READ, MAP_FILE | MAP_SHARED, fd, 0);
+    close(fd);
+    if ( mapping == MAP_FAILED ) return NULL;
+    
+    // Validate the entry before trusting its layout
+    const AEAudioDiskCacheHeader * header = (const AEAudioDiskCacheHeader *)mapping;
+    if ( header->magic != kMagic
+            || header->version != kVersion
+            || header->numberOfChannels == 0
+            || header->channelStride != AEAudioDiskCacheAlign((size_t)header->length * sizeof(float))
+            || kDataOffset + header->numberOfChannels * header->channelStride != size ) {
+        munmap(mapping, size);
+        return NULL;
+    }
+    
+    AEAudioDiskCacheMapping * result = malloc(offsetof(AEAudioDiskCacheMapping, audio)
+                                              + offsetof(AudioBufferList, mBuffers)
+                                              + header->numberOfChannels * sizeof(AudioBuffer));
+    result->mapping = mapping;
+    result->size = size;
+    result->audio.mNumberBuffers = header->numberOfChannels;
+    for ( int i=0; i<header->numberOfChannels; i++ ) {
+        result->audio.mBuffers[i].mNumberChannels = 1;
+        result->audio.mBuffers[i].mDataByteSize = header->length * sizeof(float);
+        result->audio.mBuffers[i].mData = (char *)mapping + kDataOffset + i * header->channelStride;
+    }
+    
+    *length = header->length;
+    return &result->audio;
+}
+
+- (BOOL)storeAudio:(const AudioBufferList *)audio length:(UInt32)length forKey:(NSString *)key error:(NSError **)error {
+    for ( int i=0; i<audio->mNumberBuffers; i++ ) {
+        if ( audio->mBuffers[i].mNumberChannels != 1 || audio->mBuffers[i].mDataByteSize < length * sizeof(float) ) {
+            if ( error ) *error = [NSError errorWithDomain:NSOSStatusErrorDomain code:kAudioFormatUnsupportedDataFormatError
+                                                  userInfo:@{NSLocalizedDescriptionKey: @"Unsupported audio format for cache"}];
+            return NO;
+        }
+    }
+    
+    NSString * path = [self pathForKey:key];
+    NSString * temporaryPath = [path stringByAppendingFormat:@".%@.tmp", [NSUUID UUID].UUIDString];
+    int fd = open(temporaryPath.fileSystemRepresentation, O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if ( fd < 0 ) {
+        if ( error ) *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno
+                                              userInfo:@{NSLocalizedDescriptionKey: @"Couldn't create cache file"}];
+        return NO;
+    }
+    
+    static const char padding[kAlignment] = {0};
+    
+    AEAudioDiskCacheHeader header = {
+        .magic = kMagic,
+        .version = kVersion,
+        .numberOfChannels = audio->mNumberBuffers,
+        .length = length,
+        .channelStride = AEAudioDiskCacheAlign((size_t)length * sizeof(float)),
+    };
+    
+    BOOL success = AEAudioDiskCacheWrite(fd, &header, sizeof(header))
+        && AEAudioDiskCacheWrite(fd, padding, kDataOffset - sizeof(header));
+    for ( int i=0; i<audio->mNumberBuffers && success; i++ ) {
+        success = AEAudioDiskCacheWrite(fd, audio->mBuffers[i].mData, length * sizeof(float))
+            && AEAudioDiskCacheWrite(fd, padding, header.channelStride - length * sizeof(float));
+    }
+    int writeError = success ? 0 : errno;
+    
+    if ( close(fd) != 0 && success ) {
+        success = NO;
+        writeError = errno;
+    }
+    
+    // Move into place atomically
+    if ( success && rename(temporaryPath.fileSystemRepresentation, path.fileSystemRepresentation) != 0 ) {
+        success = NO;
+        writeError = errno;
+    }
+    
+    if ( !success ) {
+        unlink(temporaryPath.fileSystemRepresentation);
+        if ( error ) *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:writeError
+                                              userInfo:@{NSLocalizedDescriptionKey: @"Couldn't write cache file"}];
+    }
+    
+    return success;
+}
+
+- (void)removeAllCachedAudio {
+    NSFileManager * fileManager = [NSFileManager defaultManager];
+    for ( NSString * name in [fileManager contentsOfDirectoryAtPath:_directory error:NULL] ) {
+        if ( [name rangeOfString:[@"." stringByAppendingString:kFileExtension]].location != NSNotFound ) {
+            [fileManager removeItemAtPath:[_directory stringByAppendingPathComponent:name] error:NULL];
+        }
+    }
+}
+
+- (NSString *)pathForKey:(NSString *)key {
+    return [_directory stringByAppendingPathComponent:[key stringByAppendingPathExtension:kFileExtension]];
+}
+
+@end
+
+void AEAudioDiskCacheFreeMappedAudio(AudioBufferList * audio) {
+    AEAudioDiskCacheMapping * mapping =
+        (AEAudioDiskCacheMapping *)((char *)audio - offsetof(AEAudioDiskCacheMapping, audio));
+    munmap(mapping->mapping, mapping->size);
+    free(mapping);
+}
@@ -66,7 +66,9 @@ typedef void (^AEAudioFileReaderCompletionBlock)(NSError * _Nullable error);
  *  file completely into memory in a single operation, or to incrementally read pieces of
  *  the file.
  *
- *  Loading is done on a background thread.
+ *  Loading is done on a background thread. Uncompressed WAV, RF64, CAF and AIFF files being
+ *  loaded to a non-interleaved float format are read directly via AEMappedAudioFile, rather
+ *  than through ExtAudioFile.
  *
  *  Note that for live playback, you should use AEAudioFilePlayerModule.
  */
@@ -93,7 +95,8 @@ typedef void (^AEAudioFileReaderCompletionBlock)(NSError * _Nullable error);
  *  the completion block on the main thread when finished.
  *
  *  Note that this is not suitable for large audio files, as the entire file
- *  will be loaded into memory.
+ *  will be loaded into memory. To share loaded files between multiple users,
+ *  use AEAudioSampleCache.
  *
  * @param path Path to the file to load
  * @param targetAudioDescription The audio description for the loaded audio (e.g. AEAudioDescription)
@@ -103,6 +106,22 @@ typedef void (^AEAudioFileReaderCompletionBlock)(NSError * _Nullable error);
                  targetAudioDescription:(AudioStreamBasicDescription)targetAudioDescription
                         completionBlock:(AEAudioFileReaderLoadBlock _Nonnull)block;
 
+/*!
+ * Load the start of a file into memory
+ *
+ *  As loadFileAtPath:targetAudioDescription:completionBlock:, but reads no more than the given
+ *  number of frames from the start of the file.
+ *
+ * @param path Path to the file to load
+ * @param targetAudioDescription The audio description for the loaded audio (e.g. AEAudioDescription)
+ * @param maximumLength The maximum number of frames to load, at the target sample rate, or 0 for the whole file
+ * @param block Block to call when load has finished
+ */
++ (instancetype _Nonnull)loadFileAtPath:(NSString * _Nonnull)path
+                 targetAudioDescription:(AudioStreamBasicDescription)targetAudioDescription
+                          maximumLength:(UInt32)maximumLength
+                        completionBlock:(AEAudioFileReaderLoadBlock _Nonnull)block;
+
 /*!
  * Read file incrementally, with a read block
  *
@@ -140,9 +159,101 @@ typedef void (^AEAudioFileReaderCompletionBlock)(NSError * _Nullable error);
 
 /*!
  * Cancel a load operation
+ *
+ *  Takes effect between blocks of a read, so a load in progress stops part-way through the file.
+ *  The completion block will not be called.
  */
 - (void)cancel;
 
+//! The fraction of the file read so far, from 0 to 1
+@property (atomic, readonly) double progress;
+
+@end
+
+/*!
+ * Load priority
+ */
+typedef enum {
+    AEAudioFileLoadPriorityBackground, //!< Loaded when no playback-critical loads are waiting, at utility QoS
+    AEAudioFileLoadPriorityPlayback,   //!< Playback-critical: loaded ahead of all background loads, at user-initiated QoS
+} AEAudioFileLoadPriority;
+
+/*!
+ * Batch progress block
+ *
+ * @param progress The overall progress of the batch, from 0 to 1
+ * @param completedLoads The number of loads finished, failed or cancelled
+ * @param totalLoads The number of loads in the batch
+ */
+typedef void (^AEAudioFileBatchLoaderProgressBlock)(double progress, int completedLoads, int totalLoads);
+
+/*!
+ * Audio file batch loader
+ *
+ *  This class loads many files into memory with a bounded number of concurrent loads, rather than
+ *  starting an independent job for every file as AEAudioFileReader's loadFileAtPath:... does, so
+ *  that loading a large sample library doesn't thrash the disk or starve playback.
+ *
+ *  Waiting loads are started in order of priority, then in the order they were added.
+ *  Background loads may occupy all but one of the worker slots, so a playback-critical load never
+ *  waits behind a full set of background loads, and run at a lower QoS, whose disk I/O the system
+ *  throttles in favour of other work.
+ *
+ *  Loads are grouped into batches for progress reporting: a batch begins when a load is added to an
+ *  idle loader, and ends when all its loads are finished.
+ */
+@interface AEAudioFileBatchLoader : NSObject
+
+/*!
+ * Initialize with a default number of concurrent loads
+ */
+- (instancetype _Nonnull)init;
+
+/*!
+ * Initialize
+ *
+ * @param maximumConcurrentLoads The number of files to load at once
+ */
+- (instancetype _Nonnull)initWithMaximumConcurrentLoads:(int)maximumConcurrentLoads;
+
+/*!
+ * Add a file to load
+ *
+ *  The completion block is called on the main thread once the file is loaded, as with
+ *  AEAudioFileReader's loadFileAtPath:targetAudioDescription:completionBlock:. Use the returned
+ *  reader to cancel the load, whether or not it has started yet.
+ *
+ * @param path Path to the file to load
+ * @param targetAudioDescription The audio description for the loaded audio (e.g. AEAudioDescription)
+ * @param priority The priority of the load
+ * @param block Block to call when load has finished
+ * @return The reader which will perform the load
+ */
+- (AEAudioFileReader * _Nonnull)loadFileAtPath:(NSString * _Nonnull)path
+                        targetAudioDescription:(AudioStreamBasicDescription)targetAudioDescription
+                                      priority:(AEAudioFileLoadPriority)priority
+                               completionBlock:(AEAudioFileReaderLoadBlock _Nonnull)block;
+
+/*!
+ * Cancel all waiting and in-progress loads
+ */
+- (void)cancelAllLoads;
+
+//! The number of files loaded at once
+@property (nonatomic, readonly) int maximumConcurrentLoads;
+
+//! Block called on the main thread each time a load in the current batch finishes
+@property (copy) AEAudioFileBatchLoaderProgressBlock _Nullable progressBlock;
+
+//! The overall progress of the current batch, including partially-read files, from 0 to 1
+@property (readonly) double progress;
+
+//! The number of loads finished in the current batch
+@property (readonly) int completedLoads;
+
+//! The number of loads in the current batch
+@property (readonly) int totalLoads;
+
 @end
 
 #ifdef __cplusplus
@@ -26,9 +26,14 @@
 #import "AEAudioFileReader.h"
 #import "AEUtilities.h"
 #import "AEAudioBufferListUtilities.h"
+#import "AEResampler.h"
+#import "AEMappedAudioFile.h"
+#import <pthread.h>
 
 static const UInt32 kDefaultReadSize = 4096;
 static const UInt32 kMaxAudioFileReadSize = 16384;
+static const int kDefaultMaximumConcurrentLoads = 4;
+static const UInt32 kResamplerMarginFrames = 64;
 
 @interface AEAudioFileReader ()
 @property (nonatomic, strong) NSString * path;
@@ -37,7 +42,10 @@ static const UInt32 kMaxAudioFileReadSize = 16384;
 @property (nonatomic, copy) AEAudioFileReaderIncrementalReadBlock readBlock;
 @property (nonatomic, copy) AEAudioFileReaderCompletionBlock readCompletionBlock;
 @property (nonatomic) UInt32 readBlockSize;
+@property (nonatomic) UInt32 maximumLength;
 @property (nonatomic) BOOL cancelled;
+@property (atomic, readwrite) double progress;
+- (void)read;
 @end
 
 @implementation AEAudioFileReader
@@ -101,6 +109,21 @@ static const UInt32 kMaxAudioFileReadSize = 16384;
     return reader;
 }
 
++ (instancetype)loadFileAtPath:(NSString *)path
+        targetAudioDescription:(AudioStreamBasicDescription)targetAudioDescription
+                 maximumLength:(UInt32)maximumLength
+               completionBlock:(AEAudioFileReaderLoadBlock _Nonnull)block {
+    AEAudioFileReader * reader = [AEAudioFileReader new];
+    reader.path = path;
+    reader.targetAudioDescription = targetAudioDescription;
+    reader.maximumLength = maximumLength;
+    reader.loadBlock = block;
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        [reader read];
+    });
+    return reader;
+}
+
 + (instancetype)readFileAtPath:(NSString *)path
         targetAudioDescription:(AudioStreamBasicDescription)targetAudioDescription
                      readBlock:(AEAudioFileReaderIncrementalReadBlock)readBlock
@@ -136,6 +159,10 @@ static const UInt32 kMaxAudioFileReadSize = 16384;
 }
 
 - (void)read {
+    if ( [self readMappedFile] ) {
+        return;
+    }
+    
     ExtAudioFileRef audioFile;
     OSStatus status;
     
@@ -163,7 +190,19 @@ static const UInt32 kMaxAudioFileReadSize = 16384;
         _targetAudioDescription.mSampleRate = fileAudioDescription.mSampleRate;
     }
     
-    status = ExtAudioFileSetProperty(audioFile, kExtAudioFileProperty_ClientDataFormat, sizeof(_targetAudioDescription), &_targetAudioDescription);
+    // When loading a whole file to our own float format, read at the file's rate and convert the rate natively
+    AudioStreamBasicDescription clientAudioDescription = _targetAudioDescription;
+    BOOL useResampler = !_readBlock
+        && fabs(_targetAudioDescription.mSampleRate - fileAudioDescription.mSampleRate) > DBL_EPSILON
+        && _targetAudioDescription.mFormatID == kAudioFormatLinearPCM
+        && (_targetAudioDescription.mFormatFlags & kAudioFormatFlagIsFloat)
+        && (_targetAudioDescription.mFormatFlags & kAudioFormatFlagIsNonInterleaved)
+        && _targetAudioDescription.mBitsPerChannel == 32;
+    if ( useResampler ) {
+        clientAudioDescription.mSampleRate = fileAudioDescription.mSampleRate;
+    }
+    
+    status = ExtAudioFileSetProperty(audioFile, kExtAudioFileProperty_ClientDataFormat, sizeof(clientAudioDescription), &clientAudioDescription);
     if ( !AECheckOSStatus(status, "ExtAudioFileSetProperty(kExtAudioFileProperty_ClientDataFormat)") ) {
         ExtAudioFileDispose(audioFile);
         int fourCC = CFSwapInt32HostToBig(status);
@@ -174,17 +213,17 @@ static const UInt32 kMaxAudioFileReadSize = 16384;
         return;
     }
     
-    if ( _targetAudioDescription.mChannelsPerFrame > fileAudioDescription.mChannelsPerFrame ) {
+    if ( clientAudioDescription.mChannelsPerFrame > fileAudioDescription.mChannelsPerFrame ) {
         // More channels in target format than file format - set up a map to duplicate channel
         SInt32 channelMap[8];
         AudioConverterRef converter;
         AECheckOSStatus(ExtAudioFileGetProperty(audioFile, kExtAudioFileProperty_AudioConverter, &size, &converter),
                     "ExtAudioFileGetProperty(kExtAudioFileProperty_AudioConverter)");
-        for ( int outChannel=0, inChannel=0; outChannel < _targetAudioDescription.mChannelsPerFrame; outChannel++ ) {
+        for ( int outChannel=0, inChannel=0; outChannel < clientAudioDescription.mChannelsPerFrame; outChannel++ ) {
             channelMap[outChannel] = inChannel;
             if ( inChannel+1 < fileAudioDescription.mChannelsPerFrame ) inChannel++;
         }
-        AECheckOSStatus(AudioConverterSetProperty(converter, kAudioConverterChannelMap, sizeof(SInt32)*_targetAudioDescription.mChannelsPerFrame, channelMap),
+        AECheckOSStatus(AudioConverterSetProperty(converter, kAudioConverterChannelMap, sizeof(SInt32)*clientAudioDescription.mChannelsPerFrame, channelMap),
                     "AudioConverterSetProperty(kAudioConverterChannelMap)");
         CFArrayRef config = NULL;
         AECheckOSStatus(ExtAudioFileSetProperty(audioFile, kExtAudioFileProperty_ConverterConfig, sizeof(CFArrayRef), &config),
@@ -203,10 +242,12 @@ static const UInt32 kMaxAudioFileReadSize = 16384;
     }
     
     // Calculate the true length in frames, given the original and target sample rates
-    fileLengthInFrames = ceil(fileLengthInFrames * (_targetAudioDescription.mSampleRate / fileAudioDescription.mSampleRate));
+    fileLengthInFrames = ceil(fileLengthInFrames * (clientAudioDescription.mSampleRate / fileAudioDescription.mSampleRate));
+    fileLengthInFrames = MIN(fileLengthInFrames, [self clientLengthLimitWithClientSampleRate:clientAudioDescription.mSampleRate
+                                                                               useResampler:useResampler]);
     
     // Prepare buffer
-    AudioBufferList *bufferList = AEAudioBufferListCreateWithFormat(_targetAudioDescription,
+    AudioBufferList *bufferList = AEAudioBufferListCreateWithFormat(clientAudioDescription,
                                     _readBlock ? _readBlockSize : (UInt32)fileLengthInFrames);
     if ( !bufferList ) {
         ExtAudioFileDispose(audioFile);
@@ -220,7 +261,7 @@ static const UInt32 kMaxAudioFileReadSize = 16384;
     AEAudioBufferListCopyOnStack(scratchBufferList, bufferList, 0);
     while ( readFrames < fileLengthInFrames && !_cancelled ) {
         UInt32 blockSize = MIN(_readBlock ? _readBlockSize : kMaxAudioFileReadSize, (UInt32)fileLengthInFrames - readFrames);
-        AEAudioBufferListAssignWithFormat(scratchBufferList, bufferList, _targetAudioDescription,
+        AEAudioBufferListAssignWithFormat(scratchBufferList, bufferList, clientAudioDescription,
                                           _readBlock ? 0 : readFrames, blockSize);
         
         // Perform read
@@ -247,6 +288,7 @@ static const UInt32 kMaxAudioFileReadSize = 16384;
         }
         
         readFrames += blockSize;
+        self.progress = (double)readFrames / fileLengthInFrames;
     }
     
     if ( _readBlock || _cancelled ) {
@@ -257,6 +299,99 @@ static const UInt32 kMaxAudioFileReadSize = 16384;
     // Clean up        
     ExtAudioFileDispose(audioFile);
     
+    [self finishWithBufferList:bufferList length:readFrames clientAudioDescription:clientAudioDescription
+                  useResampler:useResampler];
+}
+
+- (BOOL)readMappedFile {
+    // Uncompressed files are converted straight from a mapping of the file, when loading to our own float format
+    if ( _targetAudioDescription.mFormatID != kAudioFormatLinearPCM
+            || !(_targetAudioDescription.mFormatFlags & kAudioFormatFlagIsFloat)
+            || !(_targetAudioDescription.mFormatFlags & kAudioFormatFlagIsNonInterleaved)
+            || _targetAudioDescription.mBitsPerChannel != 32 ) {
+        return NO;
+    }
+    
+    AEMappedAudioFile * file = AEMappedAudioFileOpen(self.path, NULL);
+    if ( !file ) {
+        return NO;
+    }
+    
+    // Fall back to ExtAudioFile for downmixing, and for rate conversion while reading incrementally
+    double fileSampleRate = AEMappedAudioFileGetSampleRate(file);
+    double targetSampleRate = _targetAudioDescription.mSampleRate < DBL_EPSILON ? fileSampleRate : _targetAudioDescription.mSampleRate;
+    BOOL useResampler = fabs(targetSampleRate - fileSampleRate) > DBL_EPSILON;
+    if ( _targetAudioDescription.mChannelsPerFrame < AEMappedAudioFileGetNumberOfChannels(file)
+            || (useResampler && _readBlock)
+            || AEMappedAudioFileGetLength(file) > UINT32_MAX ) {
+        AEMappedAudioFileClose(file);
+        return NO;
+    }
+    
+    _targetAudioDescription.mSampleRate = targetSampleRate;
+    AudioStreamBasicDescription clientAudioDescription = _targetAudioDescription;
+    clientAudioDescription.mSampleRate = fileSampleRate;
+    
+    UInt32 length = (UInt32)MIN(AEMappedAudioFileGetLength(file),
+                                [self clientLengthLimitWithClientSampleRate:fileSampleRate useResampler:useResampler]);
+    AudioBufferList * bufferList = AEAudioBufferListCreateWithFormat(clientAudioDescription, _readBlock ? _readBlockSize : length);
+    if ( !bufferList ) {
+        AEMappedAudioFileClose(file);
+        [self reportError:[NSError errorWithDomain:NSPOSIXErrorDomain code:ENOMEM
+                            userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"Not enough memory to open file", @"")}]];
+        return YES;
+    }
+    
+    AEMappedAudioFileSetAccessPattern(file, AEMappedAudioFileAccessSequential);
+    
+    UInt32 readFrames = 0;
+    AEAudioBufferListCopyOnStack(scratchBufferList, bufferList, 0);
+    while ( readFrames < length && !_cancelled ) {
+        UInt32 blockSize = MIN(_readBlock ? _readBlockSize : kMaxAudioFileReadSize, length - readFrames);
+        AEAudioBufferListAssignWithFormat(scratchBufferList, bufferList, clientAudioDescription,
+                                          _readBlock ? 0 : readFrames, blockSize);
+        blockSize = AEMappedAudioFileRead(file, scratchBufferList, readFrames, blockSize);
+        if ( blockSize == 0 ) break;
+        if ( _readBlock ) {
+            _readBlock(bufferList, blockSize);
+        }
+        readFrames += blockSize;
+        self.progress = (double)readFrames / length;
+    }
+    
+    AEMappedAudioFileClose(file);
+    
+    if ( _readBlock || _cancelled ) {
+        AEAudioBufferListFree(bufferList);
+        bufferList = NULL;
+    }
+    
+    [self finishWithBufferList:bufferList length:readFrames clientAudioDescription:clientAudioDescription
+                  useResampler:useResampler];
+    return YES;
+}
+
+- (void)finishWithBufferList:(AudioBufferList *)bufferList length:(UInt32)readFrames
+      clientAudioDescription:(AudioStreamBasicDescription)clientAudioDescription useResampler:(BOOL)useResampler {
+    
+    if ( bufferList && useResampler ) {
+        // Convert to the target rate
+        AudioBufferList * resampledBufferList =
+            AEResamplerCreateResampledBufferList(bufferList, readFrames, clientAudioDescription.mSampleRate,
+                                                 _targetAudioDescription.mSampleRate, AEResamplerQualityHigh, &readFrames);
+        AEAudioBufferListFree(bufferList);
+        bufferList = resampledBufferList;
+        if ( !bufferList ) {
+            [self reportError:[NSError errorWithDomain:NSPOSIXErrorDomain code:ENOMEM
+                                userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"Not enough memory to open file", @"")}]];
+            return;
+        }
+    }
+    
+    if ( _maximumLength ) {
+        readFrames = MIN(readFrames, _maximumLength);
+    }
+    
     // Call completion blocks
     if ( !_cancelled ) {
         dispatch_async(dispatch_get_main_queue(), ^{
@@ -276,6 +411,14 @@ static const UInt32 kMaxAudioFileReadSize = 16384;
     }
 }
 
+- (UInt64)clientLengthLimitWithClientSampleRate:(double)clientSampleRate useResampler:(BOOL)useResampler {
+    if ( !_maximumLength ) return UINT64_MAX;
+    if ( !useResampler ) return _maximumLength;
+    
+    // Read a little beyond the limit, so the resampler's output is complete up to it
+    return (UInt64)ceil(_maximumLength * (clientSampleRate / _targetAudioDescription.mSampleRate)) + kResamplerMarginFrames;
+}
+
 - (void)reportError:(NSError *)error {
     dispatch_async(dispatch_get_main_queue(), ^{
         if ( self.loadBlock ) {
@@ -287,3 +430,162 @@ static const UInt32 kMaxAudioFileReadSize = 16384;
 }
 
 @end
+
+@interface AEAudioFileBatchLoader () {
+    pthread_mutex_t _mutex;
+    NSMutableArray<AEAudioFileReader *> * _waitingLoads[2];
+    NSMutableArray<AEAudioFileReader *> * _activeLoads;
+    int _activeBackgroundLoads;
+    int _completedLoads;
+    int _totalLoads;
+}
+@end
+
+@implementation AEAudioFileBatchLoader
+
+- (instancetype)init {
+    return [self initWithMaximumConcurrentLoads:kDefaultMaximumConcurrentLoads];
+}
+
+- (instancetype)initWithMaximumConcurrentLoads:(int)maximumConcurrentLoads {
+    if ( !(self = [super init]) ) return nil;
+    _maximumConcurrentLoads = MAX(1, maximumConcurrentLoads);
+    _waitingLoads[AEAudioFileLoadPriorityBackground] = [NSMutableArray array];
+    _waitingLoads[AEAudioFileLoadPriorityPlayback] = [NSMutableArray array];
+    _activeLoads = [NSMutableArray array];
+    pthread_mutex_init(&_mutex, NULL);
+    return self;
+}
+
+- (void)dealloc {
+    pthread_mutex_destroy(&_mutex);
+}
+
+- (AEAudioFileReader *)loadFileAtPath:(NSString *)path
+               targetAudioDescription:(AudioStreamBasicDescription)targetAudioDescription
+                             priority:(AEAudioFileLoadPriority)priority
+                      completionBlock:(AEAudioFileReaderLoadBlock)block {
+    AEAudioFileReader * reader = [AEAudioFileReader new];
+    reader.path = path;
+    reader.targetAudioDescription = targetAudioDescription;
+    reader.loadBlock = block;
+    
+    pthread_mutex_lock(&_mutex);
+    if ( [self isIdle] ) {
+        // Begin a new batch
+        _completedLoads = 0;
+        _totalLoads = 0;
+    }
+    _totalLoads++;
+    [_waitingLoads[priority] addObject:reader];
+    [self startWaitingLoads];
+    pthread_mutex_unlock(&_mutex);
+    
+    return reader;
+}
+
+- (void)cancelAllLoads {
+    pthread_mutex_lock(&_mutex);
+    for ( int priority = AEAudioFileLoadPriorityBackground; priority <= AEAudioFileLoadPriorityPlayback; priority++ ) {
+        for ( AEAudioFileReader * reader in _waitingLoads[priority] ) {
+            [reader cancel];
+        }
+        _completedLoads += (int)_waitingLoads[priority].count;
+        [_waitingLoads[priority] removeAllObjects];
+    }
+    for ( AEAudioFileReader * reader in _activeLoads ) {
+        [reader cancel];
+    }
+    [self reportProgress];
+    pthread_mutex_unlock(&_mutex);
+}
+
+- (double)progress {
+    pthread_mutex_lock(&_mutex);
+    double progress = [self currentProgress];
+    pthread_mutex_unlock(&_mutex);
+    return progress;
+}
+
+- (int)completedLoads {
+    pthread_mutex_lock(&_mutex);
+    int completedLoads = _completedLoads;
+    pthread_mutex_unlock(&_mutex);
+    return completedLoads;
+}
+
+- (int)totalLoads {
+    pthread_mutex_lock(&_mutex);
+    int totalLoads = _totalLoads;
+    pthread_mutex_unlock(&_mutex);
+    return totalLoads;
+}
+
+#pragma mark - Helpers (called with the mutex held)
+
+- (BOOL)isIdle {
+    return _activeLoads.count == 0
+        && _waitingLoads[AEAudioFileLoadPriorityBackground].count == 0
+        && _waitingLoads[AEAudioFileLoadPriorityPlayback].count == 0;
+}
+
+- (void)startWaitingLoads {
+    while ( (int)_activeLoads.count < _maximumConcurrentLoads ) {
+        // Take the next playback-critical load, or else a background load if that leaves a slot free for playback
+        AEAudioFileLoadPriority priority;
+        if ( _waitingLoads[AEAudioFileLoadPriorityPlayback].count > 0 ) {
+            priority = AEAudioFileLoadPriorityPlayback;
+        } else if ( _waitingLoads[AEAudioFileLoadPriorityBackground].count > 0
+                       && (_activeBackgroundLoads < _maximumConcurrentLoads - 1 || _maximumConcurrentLoads == 1) ) {
+            priority = AEAudioFileLoadPriorityBackground;
+        } else {
+            break;
+        }
+        
+        AEAudioFileReader * reader = _waitingLoads[priority].firstObject;
+        [_waitingLoads[priority] removeObjectAtIndex:0];
+        if ( reader.cancelled ) {
+            _completedLoads++;
+            [self reportProgress];
+            continue;
+        }
+        
+        [_activeLoads addObject:reader];
+        if ( priority == AEAudioFileLoadPriorityBackground ) _activeBackgroundLoads++;
+        
+        qos_class_t qos = priority == AEAudioFileLoadPriorityPlayback ? QOS_CLASS_USER_INITIATED : QOS_CLASS_UTILITY;
+        dispatch_async(dispatch_get_global_queue(qos, 0), ^{
+            [reader read];
+            
+            pthread_mutex_lock(&self->_mutex);
+            [self->_activeLoads removeObjectIdenticalTo:reader];
+            if ( priority == AEAudioFileLoadPriorityBackground ) self->_activeBackgroundLoads--;
+            self->_completedLoads++;
+            [self reportProgress];
+            [self startWaitingLoads];
+            pthread_mutex_unlock(&self->_mutex);
+        });
+    }
+}
+
+- (double)currentProgress {
+    if ( _totalLoads == 0 ) return 1.0;
+    double progress = _completedLoads;
+    for ( AEAudioFileReader * reader in _activeLoads ) {
+        progress += reader.progress;
+    }
+    return MIN(1.0, progress / _totalLoads);
+}
+
+- (void)reportProgress {
+    AEAudioFileBatchLoaderProgressBlock block = self.progressBlock;
+    if ( !block ) return;
+    double progress = [self currentProgress];
+    int completedLoads = _completedLoads;
+    int totalLoads = _totalLoads;
+    dispatch_async(dispatch_get_main_queue(), ^{
+        block(progress, completedLoads, totalLoads);
+    });
+}
+
+@end
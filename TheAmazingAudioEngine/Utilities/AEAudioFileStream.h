@@ -0,0 +1,177 @@
+//
+//  AEAudioFileStream.h
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#import <Foundation/Foundation.h>
+#import <AudioToolbox/AudioToolbox.h>
+#import "AETime.h"
+
+/*!
+ * Audio file stream
+ *
+ *  This utility streams decoded audio from a file on disk, for playback on the realtime thread
+ *  without holding the whole file in memory. A single I/O thread, shared by all streams, decodes
+ *  ahead of each stream's read position into a per-stream lock-free ring, servicing the emptiest
+ *  rings first. Memory use per stream is bounded by the buffer duration, so hundreds of files may
+ *  be streamed simultaneously.
+ *
+ *  Audio is provided in the standard non-interleaved float format, with the file's channel count,
+ *  at the sample rate given on initialization (sample rate conversion is performed on the I/O thread).
+ *
+ *  Seeking is performed by posting a request, which is picked up by both the I/O thread and the
+ *  realtime thread without locks; audio prefetched for a prior request is discarded as it reaches
+ *  the front of the ring. A stream plays within a region of the file, and when looping, the I/O
+ *  thread reads straight through from the end of the region to its start, so loops are seamless.
+ *
+ *  Positions are always measured in frames at the stream's sample rate. The realtime read position
+ *  keeps time while audio is unavailable (such as just after a seek): missing frames are
+ *  replaced with silence, so that playback stays in sync with the timeline.
+ */
+@interface AEAudioFileStream : NSObject
+
+/*!
+ * Default initializer
+ *
+ * @param path Path to the audio file to stream
+ * @param sampleRate The sample rate to provide audio at, or 0 to use the file's own rate
+ * @param bufferDuration How far ahead of the read position to decode, in seconds; this determines
+ *  the stream's memory use, and how long the I/O thread may stall before audio drops out
+ * @param error If not NULL, the error on output
+ */
+- (instancetype _Nullable)initWithPath:(NSString * _Nonnull)path
+                            sampleRate:(double)sampleRate
+                        bufferDuration:(AESeconds)bufferDuration
+                                 error:(NSError * _Nullable * _Nullable)error;
+
+/*!
+ * Seek
+ *
+ *  Requests a new read position and play region. The request takes effect the next time the
+ *  stream is read or skipped on the realtime thread; the I/O thread begins decoding at the
+ *  new position immediately.
+ *
+ *  Use this method on the main thread only.
+ *
+ * @param frame The position to read from, in frames
+ * @param regionStart Start of the play region, in frames
+ * @param regionLength Length of the play region, in frames
+ */
+- (void)seekToFrame:(UInt64)frame regionStart:(UInt64)regionStart regionLength:(UInt64)regionLength;
+
+/*!
+ * Read audio
+ *
+ *  Copies audio from the current read position, and advances the read position. If the
+ *  stream is not looping, reading stops at the end of the play region. Frames which have not been
+ *  prefetched in time are replaced with silence.
+ *
+ *  For use on the realtime thread.
+ *
+ * @param stream The stream
+ * @param bufferList The buffer list to write audio to, or NULL to discard
+ * @param frames The number of frames to read
+ * @return The number of frames the read position was advanced by; less than requested only when
+ *  the end of the play region is reached
+ */
+UInt32 AEAudioFileStreamRead(__unsafe_unretained AEAudioFileStream * _Nonnull stream,
+                             const AudioBufferList * _Nullable bufferList, UInt32 frames);
+
+/*!
+ * Skip audio
+ *
+ *  Advances the read position without copying any audio, in constant time. Pass 0 frames
+ *  to simply pick up any pending seek request and release space occupied by audio prefetched for
+ *  an earlier request; use this while not otherwise reading, to let the I/O thread prepare the
+ *  new position in advance.
+ *
+ *  For use on the realtime thread.
+ *
+ * @param stream The stream
+ * @param frames The number of frames to skip
+ * @return The number of frames the read position was advanced by
+ */
+UInt32 AEAudioFileStreamSkip(__unsafe_unretained AEAudioFileStream * _Nonnull stream, UInt32 frames);
+
+/*!
+ * Get the read position
+ *
+ *  For use on the realtime thread.
+ *
+ * @param stream The stream
+ * @return The read position within the file, in frames
+ */
+UInt64 AEAudioFileStreamGetPosition(__unsafe_unretained AEAudioFileStream * _Nonnull stream);
+
+/*!
+ * Get the number of frames until the end of the play region
+ *
+ *  For use on the realtime thread.
+ *
+ * @param stream The stream
+ * @return The frames between the read position and the end of the play region
+ */
+UInt64 AEAudioFileStreamGetFramesRemainingInRegion(__unsafe_unretained AEAudioFileStream * _Nonnull stream);
+
+/*!
+ * Determine if a seek request is waiting to be picked up by the realtime thread
+ *
+ * @param stream The stream
+ * @return Whether a seek request is pending
+ */
+BOOL AEAudioFileStreamHasPendingSeek(__unsafe_unretained AEAudioFileStream * _Nonnull stream);
+
+//! The path of the file
+@property (nonatomic, strong, readonly) NSString * _Nonnull path;
+
+//! The number of channels provided (the file's channel count)
+@property (nonatomic, readonly) int numberOfChannels;
+
+//! The sample rate audio is provided at
+@property (nonatomic, readonly) double sampleRate;
+
+//! The file's own sample rate
+@property (nonatomic, readonly) double fileSampleRate;
+
+//! The length of the file, in frames at the stream's sample rate
+@property (nonatomic, readonly) UInt64 length;
+
+//! How far ahead of the read position the I/O thread decodes, in seconds
+@property (nonatomic, readonly) AESeconds bufferDuration;
+
+//! The read position (or the requested position, if a seek is pending), in frames
+@property (nonatomic, readonly) UInt64 position;
+
+//! Whether to loop the play region (default NO)
+@property (nonatomic) BOOL loop;
+
+@end
+
+#ifdef __cplusplus
+}
+#endif
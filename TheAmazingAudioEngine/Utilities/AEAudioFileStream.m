@@ -0,0 +1,515 @@
+//
+//  AEAudioFileStream.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+#import "AEAudioFileStream.h"
+#import "AEUtilities.h"
+#import "AETypes.h"
+#import "AECircularBuffer.h"
+#import "AEAudioBufferListUtilities.h"
+#import <stdatomic.h>
+#import <mach/semaphore.h>
+#import <mach/task.h>
+#import <mach/mach_init.h>
+#import <pthread.h>
+
+static const UInt32 kMaxReadFrames = 4096;
+static const UInt32 kMinReadFrames = 512;
+static const AESeconds kServiceInterval = 0.01;
+static const UInt64 kNoGeneration = UINT64_MAX;
+
+typedef struct {
+    UInt64 position;
+    UInt64 regionStart;
+    UInt64 regionLength;
+} AEAudioFileStreamRequest;
+
+// Service order entry for the I/O thread
+typedef struct {
+    UInt32 space;
+    UInt32 index;
+} AEAudioFileStreamServiceEntry;
+
+@class AEAudioFileStreamThread;
+
+static AEAudioFileStreamThread * __sharedThread = nil;
+
+@interface AEAudioFileStream () {
+    ExtAudioFileRef _audioFile;
+    AECircularBuffer _buffer;
+    
+    // Seek request, guarded by a sequence counter: odd while the request is being written,
+    // and the even value identifies the request (its generation) once written
+    AEAudioFileStreamRequest _request;
+    atomic_uint_fast64_t _requestSequence;
+    atomic_bool _loop;
+    
+    // I/O thread state
+    UInt64 _producerGeneration;
+    AEAudioFileStreamRequest _producerRequest;
+    UInt64 _producerIndex;
+    UInt64 _producerPosition;
+    
+    // Realtime thread state; the index counts frames read since the request was picked up
+    UInt64 _consumerGeneration;
+    AEAudioFileStreamRequest _consumerRequest;
+    UInt64 _consumerIndex;
+}
+@property (nonatomic, strong, readwrite) NSString * path;
+@property (nonatomic, strong) AEAudioFileStreamThread * thread;
+- (BOOL)service;
+- (UInt32)availableSpace;
+@end
+
+@interface AEAudioFileStreamThread : NSThread
+- (void)addStream:(AEAudioFileStream *)stream;
+- (void)removeStream:(AEAudioFileStream *)stream;
+- (void)wake;
+@end
+
+static UInt64 AEAudioFileStreamLoadRequest(__unsafe_unretained AEAudioFileStream * THIS,
+                                           AEAudioFileStreamRequest * request);
+static BOOL AEAudioFileStreamTryLoadRequest(__unsafe_unretained AEAudioFileStream * THIS,
+                                           AEAudioFileStreamRequest * request, UInt64 * generation);
+static UInt64 AEAudioFileStreamGetOffsetInRegion(__unsafe_unretained AEAudioFileStream * THIS);
+static UInt32 AEAudioFileStreamPrepareRead(__unsafe_unretained AEAudioFileStream * THIS, UInt32 frames);
+static void AEAudioFileStreamDiscard(__unsafe_unretained AEAudioFileStream * THIS);
+
+@implementation AEAudioFileStream
+
++ (AEAudioFileStreamThread *)sharedThread {
+    @synchronized ( self ) {
+        if ( !__sharedThread ) {
+            __sharedThread = [AEAudioFileStreamThread new];
+            [__sharedThread start];
+        }
+    }
+    
+    return __sharedThread;
+}
+
+- (instancetype)initWithPath:(NSString *)path sampleRate:(double)sampleRate bufferDuration:(AESeconds)bufferDuration
+                       error:(NSError **)error {
+    if ( !(self = [super init]) ) return nil;
+    
+    // Open the file, reading in our own format
+    AudioStreamBasicDescription clientFormat;
+    UInt64 fileLength;
+    _audioFile = AEExtAudioFileOpen([NSURL fileURLWithPath:path], &clientFormat, &fileLength, error);
+    if ( !_audioFile ) return nil;
+    
+    if ( fileLength == 0 ) {
+        if ( error )
+        *error = [NSError errorWithDomain:NSOSStatusErrorDomain code:-50
+                                 userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"This audio file is empty", @"")}];
+        ExtAudioFileDispose(_audioFile);
+        _audioFile = NULL;
+        return nil;
+    }
+    
+    _fileSampleRate = clientFormat.mSampleRate;
+    _sampleRate = sampleRate > 0 ? sampleRate : _fileSampleRate;
+    _numberOfChannels = clientFormat.mChannelsPerFrame;
+    _length = fabs(_sampleRate - _fileSampleRate) > DBL_EPSILON
+        ? (UInt64)ceil(fileLength * (_sampleRate / _fileSampleRate)) : fileLength;
+    _bufferDuration = bufferDuration;
+    
+    if ( fabs(_sampleRate - _fileSampleRate) > DBL_EPSILON ) {
+        // Have the file's converter perform sample rate conversion, on the I/O thread
+        clientFormat.mSampleRate = _sampleRate;
+        OSStatus result = ExtAudioFileSetProperty(_audioFile, kExtAudioFileProperty_ClientDataFormat,
+                                                  sizeof(clientFormat), &clientFormat);
+        if ( !AECheckOSStatus(result, "ExtAudioFileSetProperty(kExtAudioFileProperty_ClientDataFormat)") ) {
+            if ( error )
+            *error = [NSError errorWithDomain:NSOSStatusErrorDomain code:result
+                                     userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"Couldn't convert the audio file", @"")}];
+            ExtAudioFileDispose(_audioFile);
+            _audioFile = NULL;
+            return nil;
+        }
+    }
+    
+    UInt32 capacity = MAX(kMaxReadFrames, (UInt32)ceil(bufferDuration * _sampleRate));
+    if ( !AECircularBufferInit(&_buffer, capacity, _numberOfChannels, _sampleRate) ) {
+        if ( error )
+        *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:ENOMEM
+                                 userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"Not enough memory to open file", @"")}];
+        ExtAudioFileDispose(_audioFile);
+        _audioFile = NULL;
+        return nil;
+    }
+    
+    self.path = path;
+    _request = (AEAudioFileStreamRequest){ .position = 0, .regionStart = 0, .regionLength = _length };
+    atomic_init(&_requestSequence, 0);
+    atomic_init(&_loop, NO);
+    _producerGeneration = kNoGeneration;
+    _consumerGeneration = kNoGeneration;
+    
+    self.thread = [AEAudioFileStream sharedThread];
+    [self.thread addStream:self];
+    [self.thread wake];
+    
+    return self;
+}
+
+- (void)dealloc {
+    [self.thread removeStream:self];
+    if ( _audioFile ) {
+        ExtAudioFileDispose(_audioFile);
+        AECircularBufferCleanup(&_buffer);
+    }
+}
+
+- (void)seekToFrame:(UInt64)frame regionStart:(UInt64)regionStart regionLength:(UInt64)regionLength {
+    regionStart = MIN(regionStart, _length);
+    regionLength = MIN(regionLength, _length - regionStart);
+    frame = MIN(MAX(regionStart, frame), regionStart + regionLength);
+    
+    uint_fast64_t sequence = atomic_load_explicit(&_requestSequence, memory_order_relaxed);
+    atomic_store_explicit(&_requestSequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    _request = (AEAudioFileStreamRequest){ .position = frame, .regionStart = regionStart, .regionLength = regionLength };
+    atomic_store_explicit(&_requestSequence, sequence + 2, memory_order_release);
+    
+    [self.thread wake];
+}
+
+- (BOOL)loop {
+    return atomic_load_explicit(&_loop, memory_order_relaxed);
+}
+
+- (void)setLoop:(BOOL)loop {
+    atomic_store_explicit(&_loop, loop, memory_order_relaxed);
+    [self.thread wake];
+}
+
+- (UInt64)position {
+    if ( AEAudioFileStreamHasPendingSeek(self) ) {
+        AEAudioFileStreamRequest request;
+        AEAudioFileStreamLoadRequest(self, &request);
+        return request.position;
+    }
+    return AEAudioFileStreamGetPosition(self);
+}
+
+#pragma mark - Realtime
+
+UInt32 AEAudioFileStreamRead(__unsafe_unretained AEAudioFileStream * THIS,
+                             const AudioBufferList * bufferList, UInt32 frames) {
+    
+    frames = AEAudioFileStreamPrepareRead(THIS, frames);
+    
+    UInt32 filled = 0;
+    AudioTimeStamp timestamp;
+    AudioBufferList * chunk;
+    while ( filled < frames && (chunk = AECircularBufferNextBufferList(&THIS->_buffer, &timestamp, NULL)) ) {
+        UInt64 index = THIS->_consumerIndex + filled;
+        UInt64 chunkIndex = (UInt64)timestamp.mSampleTime;
+        if ( chunkIndex > index ) {
+            // Audio is missing ahead of this chunk
+            UInt32 gap = (UInt32)MIN(chunkIndex - index, frames - filled);
+            if ( bufferList ) AEAudioBufferListSilence(bufferList, filled, gap);
+            filled += gap;
+            continue;
+        }
+        
+        UInt32 offset = (UInt32)(index - chunkIndex);
+        UInt32 count = MIN((UInt32)(chunk->mBuffers[0].mDataByteSize / sizeof(float)) - offset, frames - filled);
+        if ( bufferList ) AEAudioBufferListCopyContents(bufferList, chunk, filled, offset, count);
+        AECircularBufferConsumeNextBufferListPartial(&THIS->_buffer, offset + count);
+        filled += count;
+    }
+    
+    if ( filled < frames && bufferList ) {
+        // Underrun: keep time, and fill with silence
+        AEAudioBufferListSilence(bufferList, filled, frames - filled);
+    }
+    
+    THIS->_consumerIndex += frames;
+    return frames;
+}
+
+UInt32 AEAudioFileStreamSkip(__unsafe_unretained AEAudioFileStream * THIS, UInt32 frames) {
+    frames = AEAudioFileStreamPrepareRead(THIS, frames);
+    THIS->_consumerIndex += frames;
+    AEAudioFileStreamDiscard(THIS);
+    return frames;
+}
+
+UInt64 AEAudioFileStreamGetPosition(__unsafe_unretained AEAudioFileStream * THIS) {
+    if ( THIS->_consumerGeneration == kNoGeneration ) {
+        return 0;
+    }
+    return THIS->_consumerRequest.regionStart + AEAudioFileStreamGetOffsetInRegion(THIS);
+}
+
+UInt64 AEAudioFileStreamGetFramesRemainingInRegion(__unsafe_unretained AEAudioFileStream * THIS) {
+    if ( THIS->_consumerGeneration == kNoGeneration ) {
+        return THIS->_length;
+    }
+    return THIS->_consumerRequest.regionLength - AEAudioFileStreamGetOffsetInRegion(THIS);
+}
+
+BOOL AEAudioFileStreamHasPendingSeek(__unsafe_unretained AEAudioFileStream * THIS) {
+    return atomic_load_explicit(&THIS->_requestSequence, memory_order_acquire) != THIS->_consumerGeneration;
+}
+
+static BOOL AEAudioFileStreamTryLoadRequest(__unsafe_unretained AEAudioFileStream * THIS,
+                                           AEAudioFileStreamRequest * request, UInt64 * generation) {
+    uint_fast64_t sequence = atomic_load_explicit(&THIS->_requestSequence, memory_order_acquire);
+    if ( sequence & 1 ) return NO;
+    AEAudioFileStreamRequest copy = THIS->_request;
+    atomic_thread_fence(memory_order_acquire);
+    if ( atomic_load_explicit(&THIS->_requestSequence, memory_order_relaxed) != sequence ) return NO;
+    *request = copy;
+    *generation = sequence;
+    return YES;
+}
+
+static UInt64 AEAudioFileStreamLoadRequest(__unsafe_unretained AEAudioFileStream * THIS,
+                                           AEAudioFileStreamRequest * request) {
+    // Not for the realtime thread, which must not wait on a seek in progress
+    UInt64 generation;
+    while ( !AEAudioFileStreamTryLoadRequest(THIS, request, &generation) );
+    return generation;
+}
+
+static UInt64 AEAudioFileStreamGetOffsetInRegion(__unsafe_unretained AEAudioFileStream * THIS) {
+    const AEAudioFileStreamRequest * request = &THIS->_consumerRequest;
+    if ( request->regionLength == 0 ) return 0;
+    UInt64 offset = (request->position - request->regionStart) + THIS->_consumerIndex;
+    if ( atomic_load_explicit(&THIS->_loop, memory_order_relaxed) ) {
+        return offset % request->regionLength;
+    } else {
+        // Land on the region end, rather than wrapping to its start, once reached
+        return offset == 0 ? 0 : ((offset - 1) % request->regionLength) + 1;
+    }
+}
+
+static UInt32 AEAudioFileStreamPrepareRead(__unsafe_unretained AEAudioFileStream * THIS, UInt32 frames) {
+    AEAudioFileStreamRequest request;
+    UInt64 generation;
+    if ( AEAudioFileStreamHasPendingSeek(THIS) && AEAudioFileStreamTryLoadRequest(THIS, &request, &generation) ) {
+        // Pick up the new request; audio prefetched for the old one is discarded below. If a seek is
+        // being written right now, carry on with the current request and pick it up next time.
+        THIS->_consumerRequest = request;
+        THIS->_consumerGeneration = generation;
+        THIS->_consumerIndex = 0;
+    }
+    
+    if ( !atomic_load_explicit(&THIS->_loop, memory_order_relaxed) ) {
+        frames = (UInt32)MIN(frames, AEAudioFileStreamGetFramesRemainingInRegion(THIS));
+    }
+    
+    AEAudioFileStreamDiscard(THIS);
+    return frames;
+}
+
+static void AEAudioFileStreamDiscard(__unsafe_unretained AEAudioFileStream * THIS) {
+    // Drop audio from earlier requests, or which the read position has already passed
+    AudioTimeStamp timestamp;
+    AudioBufferList * chunk;
+    while ( (chunk = AECircularBufferNextBufferList(&THIS->_buffer, &timestamp, NULL)) ) {
+        UInt64 chunkIndex = (UInt64)timestamp.mSampleTime;
+        UInt64 chunkEnd = chunkIndex + (chunk->mBuffers[0].mDataByteSize / sizeof(float));
+        if ( timestamp.mWordClockTime != THIS->_consumerGeneration || chunkEnd <= THIS->_consumerIndex ) {
+            AECircularBufferConsumeNextBufferList(&THIS->_buffer);
+        } else {
+            if ( chunkIndex < THIS->_consumerIndex ) {
+                AECircularBufferConsumeNextBufferListPartial(&THIS->_buffer, (UInt32)(THIS->_consumerIndex - chunkIndex));
+            }
+            break;
+        }
+    }
+}
+
+#pragma mark - I/O thread
+
+- (UInt32)availableSpace {
+    return AECircularBufferGetAvailableSpace(&_buffer);
+}
+
+- (BOOL)service {
+    AEAudioFileStreamRequest request;
+    UInt64 generation = AEAudioFileStreamLoadRequest(self, &request);
+    if ( generation != _producerGeneration ) {
+        _producerGeneration = generation;
+        _producerRequest = request;
+        _producerIndex = 0;
+        [self seekFileToFrame:request.position];
+    }
+    
+    BOOL produced = NO;
+    UInt64 regionEnd = _producerRequest.regionStart + _producerRequest.regionLength;
+    while ( atomic_load_explicit(&_requestSequence, memory_order_relaxed) == _producerGeneration ) {
+        if ( _producerPosition >= regionEnd ) {
+            if ( !atomic_load_explicit(&_loop, memory_order_relaxed) || _producerRequest.regionLength == 0 ) break;
+            [self seekFileToFrame:_producerRequest.regionStart];
+        }
+        
+        // Decode a block into the ring
+        UInt32 space = AECircularBufferGetAvailableSpace(&_buffer);
+        UInt32 frames = (UInt32)MIN(MIN(space, kMaxReadFrames), regionEnd - _producerPosition);
+        if ( frames < MIN(kMinReadFrames, regionEnd - _producerPosition) ) break;
+        
+        AudioTimeStamp timestamp = {
+            .mFlags = kAudioTimeStampSampleTimeValid | kAudioTimeStampWordClockTimeValid,
+            .mSampleTime = _producerIndex,
+            .mWordClockTime = _producerGeneration,
+        };
+        AudioBufferList * bufferList = AECircularBufferPrepareEmptyAudioBufferList(&_buffer, frames, &timestamp);
+        if ( !bufferList ) break;
+        
+        UInt32 readFrames = frames;
+        OSStatus result = ExtAudioFileRead(_audioFile, &readFrames, bufferList);
+        if ( !AECheckOSStatus(result, "ExtAudioFileRead") || readFrames == 0 ) {
+            // The file ended early (length estimates can be short by a few frames): keep time with silence
+            AEAudioBufferListSetLength(bufferList, frames);
+            AEAudioBufferListSilence(bufferList, 0, frames);
+            readFrames = frames;
+        }
+        
+        AECircularBufferProduceAudioBufferList(&_buffer, NULL);
+        _producerIndex += readFrames;
+        _producerPosition += readFrames;
+        produced = YES;
+        
+        // One block per pass, so the streaming thread can share its time fairly between streams
+        break;
+    }
+    
+    return produced;
+}
+
+- (void)seekFileToFrame:(UInt64)frame {
+    // Seek positions are given at the file's own rate
+    SInt64 fileFrame = fabs(_sampleRate - _fileSampleRate) > DBL_EPSILON
+        ? (SInt64)round(frame * (_fileSampleRate / _sampleRate)) : (SInt64)frame;
+    AECheckOSStatus(ExtAudioFileSeek(_audioFile, fileFrame), "ExtAudioFileSeek");
+    _producerPosition = frame;
+}
+
+@end
+
+#pragma mark - Streaming thread
+
+@interface AEAudioFileStreamThread () {
+    pthread_mutex_t _mutex;
+    AEAudioFileStreamServiceEntry * _serviceOrder;
+    NSUInteger _serviceOrderCapacity;
+}
+@property (nonatomic) semaphore_t semaphore;
+@property (nonatomic, strong) NSHashTable * streams;
+@end
+
+@implementation AEAudioFileStreamThread
+
+- (instancetype)init {
+    if ( !(self = [super init]) ) return nil;
+    semaphore_create(mach_task_self(), &_semaphore, SYNC_POLICY_FIFO, 0);
+    self.streams = [NSHashTable weakObjectsHashTable];
+    pthread_mutex_init(&_mutex, NULL);
+    return self;
+}
+
+- (void)dealloc {
+    semaphore_destroy(mach_task_self(), _semaphore);
+    pthread_mutex_destroy(&_mutex);
+    free(_serviceOrder);
+}
+
+- (void)cancel {
+    [super cancel];
+    semaphore_signal(_semaphore);
+}
+
+- (void)addStream:(AEAudioFileStream *)stream {
+    pthread_mutex_lock(&_mutex);
+    [self.streams addObject:stream];
+    pthread_mutex_unlock(&_mutex);
+    semaphore_signal(_semaphore);
+}
+
+- (void)removeStream:(AEAudioFileStream *)stream {
+    pthread_mutex_lock(&_mutex);
+    [self.streams removeObject:stream];
+    pthread_mutex_unlock(&_mutex);
+}
+
+- (void)wake {
+    semaphore_signal(_semaphore);
+}
+
+static int AEAudioFileStreamCompareServiceEntries(const void * a, const void * b) {
+    // Most available space (emptiest ring) first
+    UInt32 spaceA = ((const AEAudioFileStreamServiceEntry *)a)->space;
+    UInt32 spaceB = ((const AEAudioFileStreamServiceEntry *)b)->space;
+    return spaceA > spaceB ? -1 : spaceA < spaceB ? 1 : 0;
+}
+
+- (void)main {
+    pthread_setname_np("AEAudioFileStream");
+    pthread_set_qos_class_self_np(QOS_CLASS_USER_INTERACTIVE, 0);
+    
+    while ( !self.cancelled ) {
+        BOOL produced = NO;
+        NSUInteger count;
+        @autoreleasepool {
+            // Get list of streams (protected by mutex)
+            pthread_mutex_lock(&_mutex);
+            NSArray <AEAudioFileStream *> * streams = self.streams.allObjects;
+            pthread_mutex_unlock(&_mutex);
+            
+            // Service the emptiest rings first
+            count = streams.count;
+            if ( count > _serviceOrderCapacity ) {
+                _serviceOrderCapacity = MAX(count, _serviceOrderCapacity * 2);
+                _serviceOrder = realloc(_serviceOrder, sizeof(AEAudioFileStreamServiceEntry) * _serviceOrderCapacity);
+            }
+            for ( NSUInteger i=0; i<count; i++ ) {
+                _serviceOrder[i] = (AEAudioFileStreamServiceEntry){ .space = [streams[i] availableSpace], .index = (UInt32)i };
+            }
+            qsort(_serviceOrder, count, sizeof(AEAudioFileStreamServiceEntry), AEAudioFileStreamCompareServiceEntries);
+            
+            // Give each stream one block per pass, then re-sort, until all rings are full
+            for ( NSUInteger i=0; i<count; i++ ) {
+                if ( [streams[_serviceOrder[i].index] service] ) {
+                    produced = YES;
+                }
+            }
+        }
+        
+        if ( count == 0 ) {
+            // Nothing to do until a stream is added
+            semaphore_wait(_semaphore);
+        } else if ( !produced ) {
+            // Wait for a seek, or for the realtime thread to free up some space
+            semaphore_timedwait(_semaphore, (mach_timespec_t){ 0, (clock_res_t)(kServiceInterval * NSEC_PER_SEC) });
+        }
+    }
+}
+
+@end
@@ -0,0 +1,212 @@
+//
+//  AEAudioSampleCache.h
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#import <Foundation/Foundation.h>
+#import <AudioToolbox/AudioToolbox.h>
+#import "AETime.h"
+
+@class AEAudioSample;
+@class AEAudioDiskCache;
+
+/*!
+ * Load block
+ *
+ * @param sample The loaded sample, or nil if an error occurred. The sample's audio remains valid
+ *  for as long as you hold a strong reference to this object.
+ * @param error The error, if one occurred
+ */
+typedef void (^AEAudioSampleCacheLoadBlock)(AEAudioSample * _Nullable sample, NSError * _Nullable error);
+
+/*!
+ * Audio sample cache
+ *
+ *  This class provides a process-wide store of decoded audio files, so that the same file
+ *  loaded into many players occupies memory only once. Entries are keyed by the file's path,
+ *  its modification date and size, and the target audio format; if a file changes on disk, the
+ *  next load will decode it afresh.
+ *
+ *  Each load yields an AEAudioSample, which keeps the decoded audio alive: an entry is
+ *  referenced for as long as any sample object for it exists. Once an entry is unreferenced
+ *  it remains cached, so that it can be handed out again without decoding, until the total
+ *  size of cached audio exceeds the byte budget, at which point the least recently used
+ *  unreferenced entries are evicted. Referenced entries are never evicted, so the resident
+ *  size may exceed the budget while many samples are in use.
+ *
+ *  Loading is performed on a background thread, via AEAudioFileReader. Multiple requests for
+ *  the same entry while it is loading are coalesced into a single decode, and all are answered
+ *  together.
+ *
+ *  If a disk cache is assigned, decoded audio is also persisted, and later loads of the same
+ *  file map the stored audio rather than decoding it again.
+ *
+ *  With compactStorage enabled, non-interleaved float audio is held in block floating-point
+ *  format (see AECompactAudio), at a little over half the memory; such samples are read with
+ *  AEAudioSampleRead, which decodes on the fly.
+ *
+ *  The methods of this class may be used from any thread, except the realtime thread; load
+ *  completion blocks are called on the main thread.
+ */
+@interface AEAudioSampleCache : NSObject
+
+/*!
+ * The shared cache
+ */
++ (AEAudioSampleCache * _Nonnull)sharedCache;
+
+/*!
+ * Initializer, to create an independent cache
+ *
+ * @param byteBudget The budget for cached audio, in bytes
+ */
+- (instancetype _Nonnull)initWithByteBudget:(size_t)byteBudget;
+
+/*!
+ * Load a sample
+ *
+ *  If the sample is already cached, the completion block is called on the next main thread
+ *  run loop pass; otherwise, the file is loaded in the background, or an existing load for the
+ *  same entry is joined.
+ *
+ * @param path Path to the file to load
+ * @param targetAudioDescription The audio description for the loaded audio (e.g. AEAudioDescription)
+ * @param block Block to call on the main thread when load has finished
+ */
+- (void)loadSampleAtPath:(NSString * _Nonnull)path
+  targetAudioDescription:(AudioStreamBasicDescription)targetAudioDescription
+         completionBlock:(AEAudioSampleCacheLoadBlock _Nonnull)block;
+
+/*!
+ * Get a sample, only if it's already loaded
+ *
+ * @param path Path to the file
+ * @param targetAudioDescription The audio description for the loaded audio
+ * @return The sample, or nil if it's not in the cache or is still loading
+ */
+- (AEAudioSample * _Nullable)cachedSampleAtPath:(NSString * _Nonnull)path
+                         targetAudioDescription:(AudioStreamBasicDescription)targetAudioDescription;
+
+/*!
+ * Evict all unreferenced entries
+ *
+ *  You may wish to call this in response to a memory warning.
+ */
+- (void)removeUnreferencedSamples;
+
+//! The budget for cached audio, in bytes (default for the shared cache is 128MB)
+@property (nonatomic) size_t byteBudget;
+
+//! The total size of the audio in the cache, referenced or not, in bytes
+@property (nonatomic, readonly) size_t residentBytes;
+
+//! The total size of the audio currently referenced by sample objects, in bytes
+@property (nonatomic, readonly) size_t referencedBytes;
+
+//! Persistent cache for decoded audio, used for non-interleaved float formats (default nil)
+@property (nonatomic, strong) AEAudioDiskCache * _Nullable diskCache;
+
+//! Whether to hold newly loaded non-interleaved float audio in compact form (default NO)
+@property (nonatomic) BOOL compactStorage;
+
+@end
+
+/*!
+ * Audio sample
+ *
+ *  A reference to decoded audio in an AEAudioSampleCache. The audio is shared with every other
+ *  user of the same file, so it must be treated as read-only.
+ *
+ *  To use a sample on the realtime thread, hold it in an AEManagedValue, and read its audio with
+ *  AEAudioSampleRead, which works for both compact and uncompressed samples. Uncompressed audio
+ *  may also be accessed directly, with AEAudioSampleGetAudio.
+ */
+@interface AEAudioSample : NSObject
+
+/*!
+ * Get the sample's audio
+ *
+ *  This function is safe for use on the realtime thread.
+ *
+ * @param sample The sample
+ * @return The audio buffer list, or NULL if the sample is held in compact form
+ */
+const AudioBufferList * _Nullable AEAudioSampleGetAudio(__unsafe_unretained AEAudioSample * _Nonnull sample);
+
+/*!
+ * Read the sample's audio
+ *
+ *  Copies, or for compact samples decodes, audio into each buffer of the given buffer list. If the
+ *  buffer list has more buffers than the sample has channels, the last channel is repeated in the
+ *  remaining buffers. For samples in non-interleaved float format only.
+ *
+ *  This function is safe for use on the realtime thread.
+ *
+ * @param sample The sample
+ * @param bufferList The output buffer list, in non-interleaved float format
+ * @param frame The first frame to read
+ * @param frames The number of frames to read
+ * @return The number of frames read, which is less than requested at the end of the sample
+ */
+UInt32 AEAudioSampleRead(__unsafe_unretained AEAudioSample * _Nonnull sample, const AudioBufferList * _Nonnull bufferList,
+                         UInt32 frame, UInt32 frames);
+
+/*!
+ * Get the sample's length, in frames
+ *
+ *  This function is safe for use on the realtime thread.
+ *
+ * @param sample The sample
+ * @return The length, in frames
+ */
+UInt32 AEAudioSampleGetLength(__unsafe_unretained AEAudioSample * _Nonnull sample);
+
+//! The path to the file
+@property (nonatomic, strong, readonly) NSString * _Nonnull path;
+
+//! The audio format of the decoded audio
+@property (nonatomic, readonly) AudioStreamBasicDescription audioDescription;
+
+//! The decoded audio (read-only), or NULL if the sample is held in compact form
+@property (nonatomic, readonly) const AudioBufferList * _Nullable audio;
+
+//! Whether the sample is held in compact form
+@property (nonatomic, readonly) BOOL compact;
+
+//! The length of the audio, in frames
+@property (nonatomic, readonly) UInt32 length;
+
+//! The duration of the audio, in seconds
+@property (nonatomic, readonly) AESeconds duration;
+
+@end
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,490 @@
+//
+//  AEAudioSampleCache.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+
+#import "AEAudioSampleCache.h"
+#import "AEAudioFileReader.h"
+#import "AEAudioDiskCache.h"
+#import "AECompactAudio.h"
+#import "AEAudioBufferListUtilities.h"
+#import <pthread.h>
+#import <sys/stat.h>
+
+static const size_t kDefaultByteBudget = 128 * 1024 * 1024;
+
+@interface AEAudioSampleCacheEntry : NSObject {
+  @public
+    NSString * _key;
+    NSString * _path;
+    AudioStreamBasicDescription _audioDescription;
+    AudioBufferList * _audio;
+    AECompactAudio * _compactAudio;
+    BOOL _mapped;           // Whether the audio is mapped from the disk cache
+    BOOL _compact;          // Whether the audio is to be held in compact form
+    UInt32 _length;
+    size_t _bytes;
+    NSUInteger _references;
+    BOOL _cached;           // Whether the entry is still in the cache's table
+    NSMutableArray * _waiters; // Load blocks waiting on the entry, or nil once loaded
+    
+    // Neighbours in the cache's list of unreferenced entries, least recently used first
+    __unsafe_unretained AEAudioSampleCacheEntry * _previous;
+    __unsafe_unretained AEAudioSampleCacheEntry * _next;
+}
+@end
+
+@interface AEAudioSampleCache ()
+- (void)releaseEntry:(AEAudioSampleCacheEntry *)entry;
+@end
+
+@interface AEAudioSample () {
+    AEAudioSampleCacheEntry * _entry;
+    AEAudioSampleCache * _cache;
+    const AudioBufferList * _audio;
+    const AECompactAudio * _compactAudio;
+    UInt32 _length;
+}
+- (instancetype)initWithEntry:(AEAudioSampleCacheEntry *)entry cache:(AEAudioSampleCache *)cache;
+@end
+
+@interface AEAudioSampleCache () {
+    pthread_mutex_t _mutex;
+    NSMutableDictionary<NSString *, AEAudioSampleCacheEntry *> * _entries;
+    __unsafe_unretained AEAudioSampleCacheEntry * _leastRecentlyUsed;
+    __unsafe_unretained AEAudioSampleCacheEntry * _mostRecentlyUsed;
+    size_t _byteBudget;
+    size_t _residentBytes;
+    size_t _referencedBytes;
+}
+@end
+
+@implementation AEAudioSampleCache
+
++ (AEAudioSampleCache *)sharedCache {
+    static AEAudioSampleCache * cache;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        cache = [[AEAudioSampleCache alloc] initWithByteBudget:kDefaultByteBudget];
+    });
+    return cache;
+}
+
+- (instancetype)init {
+    return [self initWithByteBudget:kDefaultByteBudget];
+}
+
+- (instancetype)initWithByteBudget:(size_t)byteBudget {
+    if ( !(self = [super init]) ) return nil;
+    _byteBudget = byteBudget;
+    _entries = [NSMutableDictionary dictionary];
+    pthread_mutex_init(&_mutex, NULL);
+    return self;
+}
+
+- (void)dealloc {
+    pthread_mutex_destroy(&_mutex);
+}
+
+- (void)loadSampleAtPath:(NSString *)path
+  targetAudioDescription:(AudioStreamBasicDescription)targetAudioDescription
+         completionBlock:(AEAudioSampleCacheLoadBlock)block {
+    
+    path = path.stringByStandardizingPath;
+    BOOL compact = [self shouldCompactAudioDescription:targetAudioDescription];
+    NSError * keyError = nil;
+    NSString * key = [self keyForPath:path audioDescription:&targetAudioDescription compact:compact error:&keyError];
+    if ( !key ) {
+        dispatch_async(dispatch_get_main_queue(), ^{ block(nil, keyError); });
+        return;
+    }
+    
+    pthread_mutex_lock(&_mutex);
+    AEAudioSampleCacheEntry * entry = _entries[key];
+    if ( entry && !entry->_waiters ) {
+        // Already loaded
+        AEAudioSample * sample = [self sampleForEntry:entry];
+        pthread_mutex_unlock(&_mutex);
+        dispatch_async(dispatch_get_main_queue(), ^{ block(sample, nil); });
+        return;
+    }
+    
+    if ( entry ) {
+        // Join the load in progress
+        [entry->_waiters addObject:[block copy]];
+        pthread_mutex_unlock(&_mutex);
+        return;
+    }
+    
+    // Start a new load, replacing any entries for prior versions of the file
+    entry = [AEAudioSampleCacheEntry new];
+    entry->_key = key;
+    entry->_path = path;
+    entry->_audioDescription = targetAudioDescription;
+    entry->_compact = compact;
+    entry->_waiters = [NSMutableArray arrayWithObject:[block copy]];
+    [self removeEntriesSupersededBy:entry];
+    _entries[key] = entry;
+    entry->_cached = YES;
+    pthread_mutex_unlock(&_mutex);
+    
+    [self startLoadingEntry:entry];
+}
+
+- (AEAudioSample *)cachedSampleAtPath:(NSString *)path
+               targetAudioDescription:(AudioStreamBasicDescription)targetAudioDescription {
+    path = path.stringByStandardizingPath;
+    BOOL compact = [self shouldCompactAudioDescription:targetAudioDescription];
+    NSString * key = [self keyForPath:path audioDescription:&targetAudioDescription compact:compact error:NULL];
+    if ( !key ) return nil;
+    
+    pthread_mutex_lock(&_mutex);
+    AEAudioSampleCacheEntry * entry = _entries[key];
+    AEAudioSample * sample = entry && !entry->_waiters ? [self sampleForEntry:entry] : nil;
+    pthread_mutex_unlock(&_mutex);
+    return sample;
+}
+
+- (void)removeUnreferencedSamples {
+    pthread_mutex_lock(&_mutex);
+    while ( _leastRecentlyUsed ) {
+        [self removeEntry:_leastRecentlyUsed];
+    }
+    pthread_mutex_unlock(&_mutex);
+}
+
+- (void)setByteBudget:(size_t)byteBudget {
+    pthread_mutex_lock(&_mutex);
+    _byteBudget = byteBudget;
+    [self trim];
+    pthread_mutex_unlock(&_mutex);
+}
+
+- (size_t)byteBudget {
+    pthread_mutex_lock(&_mutex);
+    size_t value = _byteBudget;
+    pthread_mutex_unlock(&_mutex);
+    return value;
+}
+
+- (size_t)residentBytes {
+    pthread_mutex_lock(&_mutex);
+    size_t value = _residentBytes;
+    pthread_mutex_unlock(&_mutex);
+    return value;
+}
+
+- (size_t)referencedBytes {
+    pthread_mutex_lock(&_mutex);
+    size_t value = _referencedBytes;
+    pthread_mutex_unlock(&_mutex);
+    return value;
+}
+
+#pragma mark - Helpers
+
+- (BOOL)shouldCompactAudioDescription:(AudioStreamBasicDescription)audioDescription {
+    return _compactStorage
+        && audioDescription.mFormatID == kAudioFormatLinearPCM
+        && (audioDescription.mFormatFlags & kAudioFormatFlagIsFloat)
+        && (audioDescription.mFormatFlags & kAudioFormatFlagIsNonInterleaved)
+        && audioDescription.mBitsPerChannel == 32;
+}
+
+- (NSString *)keyForPath:(NSString *)path audioDescription:(AudioStreamBasicDescription *)audioDescription
+                 compact:(BOOL)compact error:(NSError **)error {
+    
+    struct stat info;
+    if ( stat(path.fileSystemRepresentation, &info) != 0 ) {
+        if ( error ) *error = [NSError errorWithDomain:NSOSStatusErrorDomain code:kAudio_FileNotFoundError
+                                              userInfo:@{NSLocalizedDescriptionKey: @"No such file"}];
+        return nil;
+    }
+    
+    if ( audioDescription->mSampleRate < DBL_EPSILON ) {
+        // Resolve the file's own rate, so that requests for it by either name share an entry
+        AudioStreamBasicDescription fileAudioDescription;
+        if ( ![AEAudioFileReader infoForFileAtPath:path audioDescription:&fileAudioDescription length:NULL error:error] ) {
+            return nil;
+        }
+        audioDescription->mSampleRate = fileAudioDescription.mSampleRate;
+    }
+    audioDescription->mReserved = 0;
+    
+    return [NSString stringWithFormat:@"%@:%lld.%09ld:%lld:%f:%u:%u:%u:%u:%u:%u:%u%@",
+            path, (long long)info.st_mtimespec.tv_sec, (long)info.st_mtimespec.tv_nsec, (long long)info.st_size,
+            audioDescription->mSampleRate, (unsigned int)audioDescription->mFormatID,
+            (unsigned int)audioDescription->mFormatFlags, (unsigned int)audioDescription->mBytesPerPacket,
+            (unsigned int)audioDescription->mFramesPerPacket, (unsigned int)audioDescription->mBytesPerFrame,
+            (unsigned int)audioDescription->mChannelsPerFrame, (unsigned int)audioDescription->mBitsPerChannel,
+            compact ? @":compact" : @""];
+}
+
+- (void)startLoadingEntry:(AEAudioSampleCacheEntry *)entry {
+    AEAudioDiskCache * diskCache = self.diskCache;
+    if ( !diskCache || ![AEAudioDiskCache canCacheAudioDescription:entry->_audioDescription] ) {
+        [self decodeEntry:entry diskCache:nil key:nil];
+        return;
+    }
+    
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        // Use the decoded audio from a previous run, if we have it
+        NSString * key = [diskCache keyForFileAtPath:entry->_path audioDescription:entry->_audioDescription error:NULL];
+        UInt32 length = 0;
+        AudioBufferList * audio = key ? [diskCache mapAudioForKey:key length:&length] : NULL;
+        if ( audio && entry->_compact ) {
+            AECompactAudio * compactAudio = AECompactAudioCreate(audio, length);
+            AEAudioDiskCacheFreeMappedAudio(audio);
+            dispatch_async(dispatch_get_main_queue(), ^{
+                [self finishLoadingEntry:entry audio:NULL compactAudio:compactAudio mapped:NO length:length
+                                   error:compactAudio ? nil : [self outOfMemoryError]];
+            });
+        } else if ( audio ) {
+            dispatch_async(dispatch_get_main_queue(), ^{
+                [self finishLoadingEntry:entry audio:audio compactAudio:NULL mapped:YES length:length error:nil];
+            });
+        } else {
+            [self decodeEntry:entry diskCache:key ? diskCache : nil key:key];
+        }
+    });
+}
+
+- (void)decodeEntry:(AEAudioSampleCacheEntry *)entry diskCache:(AEAudioDiskCache *)diskCache key:(NSString *)key {
+    [AEAudioFileReader loadFileAtPath:entry->_path targetAudioDescription:entry->_audioDescription
+                      completionBlock:^(AudioBufferList * audio, UInt32 length, NSError * error) {
+        if ( audio && entry->_compact ) {
+            // Persist, then encode, in the background
+            dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+                if ( diskCache ) {
+                    [diskCache storeAudio:audio length:length forKey:key error:NULL];
+                }
+                AECompactAudio * compactAudio = AECompactAudioCreate(audio, length);
+                AEAudioBufferListFree(audio);
+                dispatch_async(dispatch_get_main_queue(), ^{
+                    [self finishLoadingEntry:entry audio:NULL compactAudio:compactAudio mapped:NO length:length
+                                       error:compactAudio ? nil : [self outOfMemoryError]];
+                });
+            });
+            return;
+        }
+        
+        [self finishLoadingEntry:entry audio:audio compactAudio:NULL mapped:NO length:length error:error];
+        if ( audio && diskCache ) {
+            // Persist for next time; the entry keeps the audio alive meanwhile
+            dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+                [diskCache storeAudio:entry->_audio length:entry->_length forKey:key error:NULL];
+            });
+        }
+    }];
+}
+
+- (void)finishLoadingEntry:(AEAudioSampleCacheEntry *)entry audio:(AudioBufferList *)audio
+              compactAudio:(AECompactAudio *)compactAudio mapped:(BOOL)mapped length:(UInt32)length error:(NSError *)error {
+    
+    pthread_mutex_lock(&_mutex);
+    NSArray * waiters = entry->_waiters;
+    entry->_waiters = nil;
+    NSMutableArray * samples = [[NSMutableArray alloc] initWithCapacity:waiters.count];
+    BOOL loaded = audio || compactAudio;
+    
+    if ( loaded ) {
+        entry->_audio = audio;
+        entry->_compactAudio = compactAudio;
+        entry->_mapped = mapped;
+        entry->_length = length;
+        if ( compactAudio ) {
+            entry->_bytes = AECompactAudioGetByteSize(compactAudio);
+        } else {
+            for ( int i=0; i<audio->mNumberBuffers; i++ ) {
+                entry->_bytes += audio->mBuffers[i].mDataByteSize;
+            }
+        }
+        _residentBytes += entry->_bytes;
+        for ( int i=0; i<waiters.count; i++ ) {
+            [samples addObject:[self sampleForEntry:entry]];
+        }
+    } else if ( entry->_cached ) {
+        [self removeEntry:entry];
+    }
+    pthread_mutex_unlock(&_mutex);
+    
+    for ( int i=0; i<waiters.count; i++ ) {
+        AEAudioSampleCacheLoadBlock block = waiters[i];
+        block(loaded ? samples[i] : nil, error);
+    }
+}
+
+- (NSError *)outOfMemoryError {
+    return [NSError errorWithDomain:NSPOSIXErrorDomain code:ENOMEM
+                           userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"Not enough memory to open file", @"")}];
+}
+
+// The following methods must be called with the mutex held
+
+- (AEAudioSample *)sampleForEntry:(AEAudioSampleCacheEntry *)entry {
+    if ( entry->_references++ == 0 ) {
+        if ( entry->_cached ) {
+            [self unlinkEntry:entry];
+        }
+        _referencedBytes += entry->_bytes;
+    }
+    return [[AEAudioSample alloc] initWithEntry:entry cache:self];
+}
+
+- (void)releaseEntry:(AEAudioSampleCacheEntry *)entry {
+    pthread_mutex_lock(&_mutex);
+    if ( --entry->_references == 0 ) {
+        _referencedBytes -= entry->_bytes;
+        if ( entry->_cached ) {
+            // Retain for reuse, as the most recently used entry
+            entry->_previous = _mostRecentlyUsed;
+            entry->_next = nil;
+            if ( _mostRecentlyUsed ) {
+                _mostRecentlyUsed->_next = entry;
+            } else {
+                _leastRecentlyUsed = entry;
+            }
+            _mostRecentlyUsed = entry;
+            [self trim];
+        } else {
+            _residentBytes -= entry->_bytes;
+        }
+    }
+    pthread_mutex_unlock(&_mutex);
+}
+
+- (void)trim {
+    while ( _residentBytes > _byteBudget && _leastRecentlyUsed ) {
+        [self removeEntry:_leastRecentlyUsed];
+    }
+}
+
+- (void)removeEntriesSupersededBy:(AEAudioSampleCacheEntry *)newEntry {
+    for ( AEAudioSampleCacheEntry * entry in _entries.allValues ) {
+        if ( [entry->_path isEqualToString:newEntry->_path]
+                && memcmp(&entry->_audioDescription, &newEntry->_audioDescription, sizeof(AudioStreamBasicDescription)) == 0 ) {
+            [self removeEntry:entry];
+        }
+    }
+}
+
+- (void)removeEntry:(AEAudioSampleCacheEntry *)entry {
+    // Samples still referencing the entry keep its audio alive, but it will no longer be handed out
+    if ( entry->_references == 0 ) {
+        [self unlinkEntry:entry];
+        _residentBytes -= entry->_bytes;
+    }
+    entry->_cached = NO;
+    [_entries removeObjectForKey:entry->_key];
+}
+
+- (void)unlinkEntry:(AEAudioSampleCacheEntry *)entry {
+    if ( entry->_previous ) {
+        entry->_previous->_next = entry->_next;
+    } else if ( _leastRecentlyUsed == entry ) {
+        _leastRecentlyUsed = entry->_next;
+    }
+    if ( entry->_next ) {
+        entry->_next->_previous = entry->_previous;
+    } else if ( _mostRecentlyUsed == entry ) {
+        _mostRecentlyUsed = entry->_previous;
+    }
+    entry->_previous = entry->_next = nil;
+}
+
+@end
+
+@implementation AEAudioSampleCacheEntry
+
+- (void)dealloc {
+    if ( _audio && _mapped ) {
+        AEAudioDiskCacheFreeMappedAudio(_audio);
+    } else if ( _audio ) {
+        AEAudioBufferListFree(_audio);
+    }
+    if ( _compactAudio ) {
+        AECompactAudioFree(_compactAudio);
+    }
+}
+
+@end
+
+@implementation AEAudioSample
+
+- (instancetype)initWithEntry:(AEAudioSampleCacheEntry *)entry cache:(AEAudioSampleCache *)cache {
+    if ( !(self = [super init]) ) return nil;
+    _entry = entry;
+    _cache = cache;
+    _audio = entry->_audio;
+    _compactAudio = entry->_compactAudio;
+    _length = entry->_length;
+    return self;
+}
+
+- (void)dealloc {
+    [_cache releaseEntry:_entry];
+}
+
+const AudioBufferList * AEAudioSampleGetAudio(__unsafe_unretained AEAudioSample * sample) {
+    return sample->_audio;
+}
+
+UInt32 AEAudioSampleGetLength(__unsafe_unretained AEAudioSample * sample) {
+    return sample->_length;
+}
+
+UInt32 AEAudioSampleRead(__unsafe_unretained AEAudioSample * sample, const AudioBufferList * bufferList,
+                         UInt32 frame, UInt32 frames) {
+    if ( sample->_compactAudio ) {
+        return AECompactAudioRead(sample->_compactAudio, bufferList, frame, frames);
+    }
+    
+    if ( frame >= sample->_length ) return 0;
+    frames = MIN(frames, sample->_length - frame);
+    const AudioBufferList * audio = sample->_audio;
+    for ( int i=0; i<bufferList->mNumberBuffers; i++ ) {
+        const float * source = (const float *)audio->mBuffers[MIN(i, audio->mNumberBuffers-1)].mData + frame;
+        memcpy(bufferList->mBuffers[i].mData, source, frames * sizeof(float));
+    }
+    return frames;
+}
+
+- (BOOL)compact {
+    return _compactAudio != NULL;
+}
+
+- (NSString *)path {
+    return _entry->_path;
+}
+
+- (AudioStreamBasicDescription)audioDescription {
+    return _entry->_audioDescription;
+}
+
+- (AESeconds)duration {
+    return (AESeconds)_length / _entry->_audioDescription.mSampleRate;
+}
+
+@end
@@ -35,7 +35,8 @@ typedef void (^AEAudioThreadEndpointHandler)(const void * _Nullable data, size_t
  *  Use this utility to perform synchronization across the audio and main threads.
  *
  *  You can also use the AEMainThreadEndpoint class to perform messaging in the reverse
- *  direction.
+ *  direction. For frequently-changing parameters where only the latest value matters, use
+ *  AEAudioThreadParameterEndpoint.
  */
 @interface AEAudioThreadEndpoint : NSObject
 
@@ -94,6 +95,25 @@ void AEAudioThreadEndpointPoll(__unsafe_unretained AEAudioThreadEndpoint * _Nonn
  */
 - (void)dispatchMessage;
 
+/*!
+ * Prepare a new message (C function variant)
+ *
+ *  Equivalent to createMessageWithLength:, for use from C code or hot paths where
+ *  Objective-C message dispatch is undesirable. Call only on the main thread.
+ *
+ * @param endpoint The endpoint instance
+ * @param length Length of message data
+ * @return A pointer to message bytes ready for writing, or NULL if there was insufficient buffer space
+ */
+void * _Nullable AEAudioThreadEndpointCreateMessage(__unsafe_unretained AEAudioThreadEndpoint * _Nonnull endpoint, size_t length);
+
+/*!
+ * Dispatch a message created with AEAudioThreadEndpointCreateMessage (C function variant)
+ *
+ * @param endpoint The endpoint instance
+ */
+void AEAudioThreadEndpointDispatchMessage(__unsafe_unretained AEAudioThreadEndpoint * _Nonnull endpoint);
+
 /*!
  * Begins a group of messages to be performed consecutively.
  *
@@ -60,7 +60,7 @@ void AEAudioThreadEndpointPoll(__unsafe_unretained AEAudioThreadEndpoint * _Nonn
 
 - (BOOL)sendBytes:(const void *)bytes length:(size_t)length {
     // Prepare message
-    void * message = [self createMessageWithLength:length];
+    void * message = AEAudioThreadEndpointCreateMessage(self, length);
     if ( !message ) {
         return NO;
     }
@@ -71,23 +71,31 @@ void AEAudioThreadEndpointPoll(__unsafe_unretained AEAudioThreadEndpoint * _Nonn
     }
     
     // Dispatch
-    [self dispatchMessage];
+    AEAudioThreadEndpointDispatchMessage(self);
     
     return YES;
 }
 
 - (void *)createMessageWithLength:(size_t)length {
+    return AEAudioThreadEndpointCreateMessage(self, length);
+}
+
+-(void)dispatchMessage {
+    AEAudioThreadEndpointDispatchMessage(self);
+}
+
+void * AEAudioThreadEndpointCreateMessage(__unsafe_unretained AEAudioThreadEndpoint * THIS, size_t length) {
     // Get pointer to writable bytes
     int32_t size = (int32_t)(length + sizeof(size_t));
     int32_t availableBytes;
-    void * head = TPCircularBufferHead(&_buffer, &availableBytes);
-    if ( availableBytes < size + (_groupNestCount > 0 ? _groupLength : 0) ) {
-        return nil;
+    void * head = TPCircularBufferHead(&THIS->_buffer, &availableBytes);
+    if ( availableBytes < size + (THIS->_groupNestCount > 0 ? THIS->_groupLength : 0) ) {
+        return NULL;
     }
     
-    if ( _groupNestCount > 0 ) {
+    if ( THIS->_groupNestCount > 0 ) {
         // If we're grouping messages, write to end of group
-        head += _groupLength;
+        head += THIS->_groupLength;
     }
     
     // Write to buffer: the length of the message, and the message data
@@ -97,21 +105,21 @@ void AEAudioThreadEndpointPoll(__unsafe_unretained AEAudioThreadEndpoint * _Nonn
     return head + sizeof(size_t);
 }
 
--(void)dispatchMessage {
+void AEAudioThreadEndpointDispatchMessage(__unsafe_unretained AEAudioThreadEndpoint * THIS) {
     // Get pointer to writable bytes
     int32_t availableBytes;
-    void * head = TPCircularBufferHead(&_buffer, &availableBytes);
-    if ( _groupNestCount > 0 ) {
+    void * head = TPCircularBufferHead(&THIS->_buffer, &availableBytes);
+    if ( THIS->_groupNestCount > 0 ) {
         // If we're grouping messages, write to end of group
-        head += _groupLength;
+        head += THIS->_groupLength;
     }
     
     size_t size = *((size_t*)head) + sizeof(size_t);
     
-    if ( _groupNestCount == 0 ) {
-        TPCircularBufferProduce(&_buffer, (int32_t)size);
+    if ( THIS->_groupNestCount == 0 ) {
+        TPCircularBufferProduce(&THIS->_buffer, (int32_t)size);
     } else {
-        _groupLength += size;
+        THIS->_groupLength += size;
     }
 }
 
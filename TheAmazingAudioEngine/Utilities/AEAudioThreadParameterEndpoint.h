@@ -0,0 +1,126 @@
+//
+//  AEAudioThreadParameterEndpoint.h
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    
+#import <Foundation/Foundation.h>
+
+/*!
+ * Parameter key
+ *
+ *  Identifies one parameter of one module; use AEAudioThreadParameterKeyMake to create one.
+ */
+typedef uint64_t AEAudioThreadParameterKey;
+
+/*!
+ * Create a parameter key
+ *
+ * @param moduleIdentifier An identifier for the module that owns the parameter
+ * @param parameterIdentifier An identifier for the parameter within the module
+ * @return The key
+ */
+static inline AEAudioThreadParameterKey AEAudioThreadParameterKeyMake(uint32_t moduleIdentifier, uint32_t parameterIdentifier) {
+    return ((uint64_t)moduleIdentifier << 32) | parameterIdentifier;
+}
+
+/*!
+ * Parameter handler block
+ *
+ *  Called on the audio thread with the latest value for each key that has changed.
+ *
+ * @param key The parameter key
+ * @param value The latest value set for the key
+ */
+typedef void (^AEAudioThreadParameterEndpointHandler)(AEAudioThreadParameterKey key, double value);
+
+/*!
+ * Audio thread parameter endpoint
+ *
+ *  This class delivers parameter updates from the main thread to the audio thread, last writer
+ *  wins. Where AEAudioThreadEndpoint delivers every message in order, this endpoint gives each key
+ *  a single slot: setting a value replaces any value not yet seen by the audio thread, and
+ *  AEAudioThreadParameterEndpointPoll calls the handler at most once per changed key. Dragging a
+ *  fader that sends hundreds of updates between two render cycles thus costs the audio thread one
+ *  handler call, not hundreds.
+ *
+ *  Slots are assigned to keys on first use, up to the capacity given at initialization, and
+ *  are never released.
+ *
+ *  Use AEAudioThreadEndpoint or AEMessageQueue for messages that must all be delivered.
+ */
+@interface AEAudioThreadParameterEndpoint : NSObject
+
+/*!
+ * Default initializer
+ *
+ *  Provides for up to 256 distinct keys.
+ *
+ * @param handler The handler block to use for parameter updates
+ */
+- (instancetype _Nullable)initWithHandler:(AEAudioThreadParameterEndpointHandler _Nonnull)handler;
+
+/*!
+ * Initializer with custom capacity
+ *
+ * @param handler The handler block to use for parameter updates
+ * @param capacity The maximum number of distinct keys; must be greater than zero
+ * @return The new endpoint, or nil if the capacity is invalid or memory could not be allocated
+ */
+- (instancetype _Nullable)initWithHandler:(AEAudioThreadParameterEndpointHandler _Nonnull)handler capacity:(int)capacity;
+
+/*!
+ * Poll for parameter updates
+ *
+ *  Call this once per render cycle on the audio thread. The handler is called once for every
+ *  key set since the last poll, with its latest value.
+ *
+ * @param endpoint The endpoint instance
+ */
+void AEAudioThreadParameterEndpointPoll(__unsafe_unretained AEAudioThreadParameterEndpoint * _Nonnull endpoint);
+
+/*!
+ * Set a parameter value
+ *
+ *  Use this on the main thread. The value will be delivered at the next poll interval,
+ *  unless replaced by a later value for the same key first.
+ *
+ * @param value The new value
+ * @param key The parameter key
+ * @return YES on success, or NO if the key is new and all slots are in use, or if the value
+ *  could not be queued for delivery
+ */
+- (BOOL)setValue:(double)value forKey:(AEAudioThreadParameterKey)key;
+
+//! The maximum number of distinct keys
+@property (nonatomic, readonly) int capacity;
+
+@end
+
+#ifdef __cplusplus
+}
+#endif
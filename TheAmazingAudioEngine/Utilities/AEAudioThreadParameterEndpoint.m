@@ -0,0 +1,136 @@
+//
+//  AEAudioThreadParameterEndpoint.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+#import "AEAudioThreadParameterEndpoint.h"
+#import "TPCircularBuffer.h"
+#import <stdatomic.h>
+
+// A slot holds the latest value for one key, and whether the audio thread has yet to see it
+typedef struct {
+    AEAudioThreadParameterKey key;
+    _Atomic(double) value;
+    atomic_bool pending;
+} parameter_slot_t;
+
+@interface AEAudioThreadParameterEndpoint () {
+    parameter_slot_t * _slots;
+    int _slotCount;
+    int32_t * _index;           // Main thread only: open-addressed map of key to slot number + 1
+    uint32_t _indexMask;
+    TPCircularBuffer _pending;  // Numbers of slots with pending values
+}
+@property (nonatomic, copy) AEAudioThreadParameterEndpointHandler handler;
+@end
+
+@implementation AEAudioThreadParameterEndpoint
+
+- (instancetype)initWithHandler:(AEAudioThreadParameterEndpointHandler)handler {
+    return [self initWithHandler:handler capacity:256];
+}
+
+- (instancetype)initWithHandler:(AEAudioThreadParameterEndpointHandler)handler capacity:(int)capacity {
+    // The queue of pending slots holds two entries per slot, and its length must fit in an int32_t
+    if ( capacity <= 0 || capacity > INT32_MAX / (int)(2 * sizeof(int32_t)) ) return nil;
+    
+    if ( !(self = [super init]) ) return nil;
+    
+    self.handler = handler;
+    _capacity = capacity;
+    
+    // Keep the index at most half full
+    uint32_t indexSize = 2;
+    while ( indexSize < (uint32_t)capacity * 2 ) indexSize <<= 1;
+    _indexMask = indexSize - 1;
+    
+    _slots = calloc(capacity, sizeof(parameter_slot_t));
+    _index = calloc(indexSize, sizeof(int32_t));
+    // A slot is queued at most once while pending, plus once more if set again while a poll is
+    // underway, before its earlier entry is consumed
+    if ( !_slots || !_index || !TPCircularBufferInit(&_pending, (int32_t)(2 * capacity * sizeof(int32_t))) ) {
+        return nil;
+    }
+    
+    return self;
+}
+
+- (void)dealloc {
+    free(_slots);
+    free(_index);
+    TPCircularBufferCleanup(&_pending);
+}
+
+void AEAudioThreadParameterEndpointPoll(__unsafe_unretained AEAudioThreadParameterEndpoint * THIS) {
+    // Take only the slots queued so far; any queued while we run are picked up next time
+    int32_t availableBytes;
+    const int32_t * slotNumbers = TPCircularBufferTail(&THIS->_pending, &availableBytes);
+    if ( !slotNumbers ) return;
+    int count = availableBytes / sizeof(int32_t);
+    
+    for ( int i=0; i<count; i++ ) {
+        parameter_slot_t * slot = &THIS->_slots[slotNumbers[i]];
+        
+        // Clear the flag before reading, so a value set from here on queues the slot again
+        atomic_exchange_explicit(&slot->pending, false, memory_order_acq_rel);
+        double value = atomic_load_explicit(&slot->value, memory_order_relaxed);
+        
+        THIS->_handler(slot->key, value);
+    }
+    
+    TPCircularBufferConsume(&THIS->_pending, count * sizeof(int32_t));
+}
+
+- (BOOL)setValue:(double)value forKey:(AEAudioThreadParameterKey)key {
+    // Find the key's slot, assigning a new one if needed
+    uint32_t i = (uint32_t)((key * 0x9E3779B97F4A7C15ULL) >> 32) & _indexMask;
+    while ( _index[i] && _slots[_index[i]-1].key != key ) {
+        i = (i + 1) & _indexMask;
+    }
+    if ( !_index[i] ) {
+        if ( _slotCount == _capacity ) {
+            return NO;
+        }
+        _slots[_slotCount].key = key;
+        _index[i] = ++_slotCount;
+    }
+    int32_t slotNumber = _index[i] - 1;
+    parameter_slot_t * slot = &_slots[slotNumber];
+    
+    // Store the value, then queue the slot unless it's already waiting
+    atomic_store_explicit(&slot->value, value, memory_order_relaxed);
+    if ( !atomic_exchange_explicit(&slot->pending, true, memory_order_acq_rel) ) {
+        if ( !TPCircularBufferProduceBytes(&_pending, &slotNumber, sizeof(int32_t)) ) {
+            // The queue is sized so this can't happen; but if it does, don't leave the slot marked
+            // as queued, or no later value for this key would ever be delivered
+            assert(!"Parameter endpoint queue full");
+            atomic_store_explicit(&slot->pending, false, memory_order_release);
+            return NO;
+        }
+    }
+    
+    return YES;
+}
+
+@end
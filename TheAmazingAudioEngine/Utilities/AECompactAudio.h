@@ -0,0 +1,111 @@
+//
+//  AECompactAudio.h
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#import <Foundation/Foundation.h>
+#import <AudioToolbox/AudioToolbox.h>
+
+/*!
+ * Compact audio
+ *
+ *  A memory-resident store for audio in block floating-point format, at a little over half the size
+ *  of float audio. Each channel is divided into blocks of 128 frames, and each block is held as
+ *  16-bit integers relative to a per-block scale factor derived from the block's peak, so quiet
+ *  passages keep their full 16-bit resolution. Quantization error in each block is at most half a
+ *  step, or around 96dB below the block's peak.
+ *
+ *  Decoding is performed with vDSP, block by block, straight into the output buffers. Reads may
+ *  start at any frame, allocate no memory and take no locks, so they may be performed on the
+ *  realtime thread.
+ *
+ *  AEAudioSampleCache can keep samples in this format: see its compactStorage property.
+ */
+typedef struct AECompactAudio_t AECompactAudio;
+
+/*!
+ * Encode audio
+ *
+ * @param audio The audio to encode, in non-interleaved float format
+ * @param length The length of the audio, in frames
+ * @return The encoded audio, or NULL if there was not enough memory
+ */
+AECompactAudio * _Nullable AECompactAudioCreate(const AudioBufferList * _Nonnull audio, UInt32 length);
+
+/*!
+ * Free encoded audio
+ *
+ * @param audio The encoded audio
+ */
+void AECompactAudioFree(AECompactAudio * _Nonnull audio);
+
+/*!
+ * Get the length
+ *
+ * @param audio The encoded audio
+ * @return The length, in frames
+ */
+UInt32 AECompactAudioGetLength(const AECompactAudio * _Nonnull audio);
+
+/*!
+ * Get the number of channels
+ *
+ * @param audio The encoded audio
+ * @return The number of channels
+ */
+int AECompactAudioGetNumberOfChannels(const AECompactAudio * _Nonnull audio);
+
+/*!
+ * Get the memory occupied by the encoded audio
+ *
+ * @param audio The encoded audio
+ * @return The size, in bytes
+ */
+size_t AECompactAudioGetByteSize(const AECompactAudio * _Nonnull audio);
+
+/*!
+ * Decode audio
+ *
+ *  Decodes into each buffer of the given buffer list. If the buffer list has more buffers than
+ *  there are channels, the last channel is repeated in the remaining buffers.
+ *
+ *  This function is safe for use on the realtime thread.
+ *
+ * @param audio The encoded audio
+ * @param bufferList The output buffer list, in non-interleaved float format
+ * @param frame The first frame to read
+ * @param frames The number of frames to read
+ * @return The number of frames read, which is less than requested at the end of the audio
+ */
+UInt32 AECompactAudioRead(const AECompactAudio * _Nonnull audio, const AudioBufferList * _Nonnull bufferList,
+                          UInt32 frame, UInt32 frames);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,130 @@
+//
+//  AECompactAudio.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+
+#import "AECompactAudio.h"
+#import <Accelerate/Accelerate.h>
+
+static const UInt32 kBlockFrames = 128;
+static const float kMaxSampleValue = 32767.0f;
+
+struct AECompactAudio_t {
+    UInt32 length;
+    int channels;
+    UInt32 blockCount;
+    size_t byteSize;
+    SInt16 * samples; // Each channel in turn, padded to a whole number of blocks
+    float * scales;   // The scale of each block, for each channel in turn
+};
+
+AECompactAudio * AECompactAudioCreate(const AudioBufferList * audio, UInt32 length) {
+    UInt32 blockCount = (UInt32)(((UInt64)length + kBlockFrames - 1) / kBlockFrames);
+    int channels = audio->mNumberBuffers;
+    
+    AECompactAudio * compact = calloc(1, sizeof(AECompactAudio));
+    if ( !compact ) return NULL;
+    compact->length = length;
+    compact->channels = channels;
+    compact->blockCount = blockCount;
+    compact->samples = calloc((size_t)channels * blockCount * kBlockFrames, sizeof(SInt16));
+    compact->scales = calloc((size_t)channels * blockCount, sizeof(float));
+    if ( !compact->samples || !compact->scales ) {
+        AECompactAudioFree(compact);
+        return NULL;
+    }
+    compact->byteSize = sizeof(AECompactAudio)
+        + ((size_t)channels * blockCount * kBlockFrames * sizeof(SInt16))
+        + ((size_t)channels * blockCount * sizeof(float));
+    
+    float scratch[kBlockFrames];
+    float minValue = -kMaxSampleValue;
+    float maxValue = kMaxSampleValue;
+    for ( int channel=0; channel<channels; channel++ ) {
+        const float * input = audio->mBuffers[channel].mData;
+        SInt16 * samples = compact->samples + (size_t)channel * blockCount * kBlockFrames;
+        float * scales = compact->scales + (size_t)channel * blockCount;
+        for ( UInt32 block=0; block<blockCount; block++ ) {
+            UInt32 start = block * kBlockFrames;
+            UInt32 frames = MIN(kBlockFrames, length - start);
+            
+            // Scale the block so its peak meets full scale
+            float peak;
+            vDSP_maxmgv(input + start, 1, &peak, frames);
+            if ( !(peak > 0) ) continue;
+            float scale = peak / kMaxSampleValue;
+            float inverse = 1.0f / scale;
+            scales[block] = scale;
+            vDSP_vsmul(input + start, 1, &inverse, scratch, 1, frames);
+            vDSP_vclip(scratch, 1, &minValue, &maxValue, scratch, 1, frames);
+            vDSP_vfixr16(scratch, 1, samples + start, 1, frames);
+        }
+    }
+    
+    return compact;
+}
+
+void AECompactAudioFree(AECompactAudio * audio) {
+    free(audio->samples);
+    free(audio->scales);
+    free(audio);
+}
+
+UInt32 AECompactAudioGetLength(const AECompactAudio * audio) {
+    return audio->length;
+}
+
+int AECompactAudioGetNumberOfChannels(const AECompactAudio * audio) {
+    return audio->channels;
+}
+
+size_t AECompactAudioGetByteSize(const AECompactAudio * audio) {
+    return audio->byteSize;
+}
+
+UInt32 AECompactAudioRead(const AECompactAudio * audio, const AudioBufferList * bufferList, UInt32 frame, UInt32 frames) {
+    if ( frame >= audio->length ) return 0;
+    frames = MIN(frames, audio->length - frame);
+    
+    for ( int i=0; i<bufferList->mNumberBuffers; i++ ) {
+        int channel = MIN(i, audio->channels-1);
+        const SInt16 * samples = audio->samples + (size_t)channel * audio->blockCount * kBlockFrames;
+        const float * scales = audio->scales + (size_t)channel * audio->blockCount;
+        float * output = bufferList->mBuffers[i].mData;
+        
+        // Convert the whole range to float, then apply each block's scale
+        vDSP_vflt16(samples + frame, 1, output, 1, frames);
+        UInt32 position = frame;
+        UInt32 end = frame + frames;
+        while ( position < end ) {
+            UInt32 block = position / kBlockFrames;
+            UInt32 run = MIN(end, (block + 1) * kBlockFrames) - position;
+            vDSP_vsmul(output + (position - frame), 1, &scales[block], output + (position - frame), 1, run);
+            position += run;
+        }
+    }
+    
+    return frames;
+}
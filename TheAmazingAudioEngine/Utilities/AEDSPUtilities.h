@@ -249,6 +249,55 @@ double AEDSPFaderPositionToDecibels(double position, double minDb, double midDb,
  */
 double AEDSPDecibelsToFaderPosition(double decibels, double minDb, double midDb, double maxDb);
 
+/*!
+ * Structure for real FFT
+ */
+typedef struct AEDSPFFT_t AEDSPFFT;
+
+/*!
+ * Initialize a real FFT
+ *
+ *  Results are in packed format: for an FFT of length N, real[0] holds the DC component and
+ *  imag[0] holds the Nyquist component, with bins 1 to N/2-1 in the remaining elements. As with
+ *  vDSP, forward results are scaled by 2, and inverse results are not scaled, so a forward
+ *  transform followed by an inverse one scales the signal by 2N.
+ *
+ * @param length FFT length; use AEDSPFFTConvolutionCalculateFFTLength to obtain a supported length
+ * @returns Allocated setup structure
+ */
+AEDSPFFT * AEDSPFFTInit(int length);
+
+/*!
+ * Deallocate real FFT resources
+ *
+ * @param setup Setup structure
+ */
+void AEDSPFFTDealloc(AEDSPFFT * setup);
+
+/*!
+ * Perform a forward real FFT
+ *
+ *  This function is realtime-safe.
+ *
+ * @param setup Setup structure
+ * @param input Input signal, of the FFT length
+ * @param real Output real components, of half the FFT length
+ * @param imag Output imaginary components, of half the FFT length
+ */
+void AEDSPFFTForward(AEDSPFFT * setup, const float * input, float * real, float * imag);
+
+/*!
+ * Perform an inverse real FFT
+ *
+ *  This function is realtime-safe.
+ *
+ * @param setup Setup structure
+ * @param real Input real components, of half the FFT length
+ * @param imag Input imaginary components, of half the FFT length
+ * @param output Output signal, of the FFT length
+ */
+void AEDSPFFTInverse(AEDSPFFT * setup, const float * real, const float * imag, float * output);
+
 /*!
  * Structure for FFT convolution
  */
@@ -351,6 +400,87 @@ void AEDSPFFTConvolutionExecuteContinuous(AEDSPFFTConvolution * setup, float * i
  */
 void AEDSPFFTConvolutionReset(AEDSPFFTConvolution * setup);
 
+/*!
+ * Structure for batched, multi-channel FFT convolution
+ */
+typedef struct AEDSPFFTConvolutionBatch_t AEDSPFFTConvolutionBatch;
+
+/*!
+ * Initialize batched FFT convolution
+ *
+ *  This is a multi-channel counterpart to AEDSPFFTConvolution, for continuous operation on
+ *  several signals at once. Each call transforms all channels together, with spectra for all
+ *  channels stored contiguously, so that the complex multiplication for all channels is performed
+ *  in a single pass. Filters may be shared between all channels (the filter is transformed once),
+ *  or provided per-channel, for multi-channel impulse responses.
+ *
+ *  Choose a length as for AEDSPFFTConvolutionInit: the filter length, plus the processing block size.
+ *
+ * @param length Block length (this utility will select an appropriate FFT size at least this length)
+ * @param channels Number of channels to process per call
+ * @returns Allocated setup structure
+ */
+AEDSPFFTConvolutionBatch * AEDSPFFTConvolutionBatchInit(int length, int channels);
+
+/*!
+ * Deallocate batched FFT convolution resources
+ *
+ * @param setup Setup structure
+ */
+void AEDSPFFTConvolutionBatchDealloc(AEDSPFFTConvolutionBatch * setup);
+
+/*!
+ * Prepare batched convolution for execution on continuous signals
+ *
+ *  Pass a single filter to share it between all channels, or one filter per channel. All filters
+ *  must be the same length (zero-pad shorter ones).
+ *
+ *  You may call this function during use to update the filters without affecting continuous operation.
+ *
+ * @param setup Setup structure
+ * @param filters Array of filter signals
+ * @param filterCount Number of filters: 1 to share one filter between all channels, or the channel count
+ * @param filterLength Length of each filter signal (must be less than the setup length)
+ * @param operation Operation to perform
+ */
+void AEDSPFFTConvolutionBatchPrepareContinuous(AEDSPFFTConvolutionBatch * setup, float ** filters, int filterCount, int filterLength, AEDSPFFTConvolutionOperation operation);
+
+/*!
+ * Process continuous signals, one per channel
+ *
+ * @param setup Setup structure
+ * @param inputs Array of input signals, one per channel
+ * @param inputLength Length of each input signal
+ * @param outputs Array of output buffers, one per channel (can be same as inputs, for in-place processing)
+ * @param outputLength Length of each output
+ */
+void AEDSPFFTConvolutionBatchExecuteContinuous(AEDSPFFTConvolutionBatch * setup, float ** inputs, int inputLength, float ** outputs, int outputLength);
+
+/*!
+ * Process continuous signals, summing the results of all channels into one output
+ *
+ *  This performs a complex multiply-accumulate of all channels in the frequency domain, so only one
+ *  inverse transform is needed, regardless of the channel count. Use this to render several sources
+ *  through their own impulse responses to one bus, for example.
+ *
+ *  Don't mix calls to this function and AEDSPFFTConvolutionBatchExecuteContinuous without calling
+ *  AEDSPFFTConvolutionBatchReset in between.
+ *
+ * @param setup Setup structure
+ * @param inputs Array of input signals, one per channel
+ * @param inputLength Length of each input signal
+ * @param output Output buffer
+ * @param outputLength Length of output
+ */
+void AEDSPFFTConvolutionBatchExecuteContinuousSummed(AEDSPFFTConvolutionBatch * setup, float ** inputs, int inputLength, float * output, int outputLength);
+
+/*!
+ * Reset internal buffers before processing new continuous signals
+ *
+ * @param setup Setup structure
+ */
+void AEDSPFFTConvolutionBatchReset(AEDSPFFTConvolutionBatch * setup);
+
 /*!
  * Identify the peaks in a distribution
  *
@@ -295,6 +295,50 @@ double AEDSPDecibelsToFaderPosition(double decibels, double minDb, double midDb,
     }
 }
 
+#pragma mark - FFT
+
+typedef struct AEDSPFFT_t {
+    int length;
+    float * real;
+    float * imag;
+    vDSP_DFT_Setup forward;
+    vDSP_DFT_Setup inverse;
+} AEDSPFFT;
+
+AEDSPFFT * AEDSPFFTInit(int length) {
+    AEDSPFFT * setup = calloc(1, sizeof(AEDSPFFT));
+    setup->length = length;
+    setup->real = malloc(sizeof(float) * length/2);
+    setup->imag = malloc(sizeof(float) * length/2);
+    setup->forward = vDSP_DFT_zrop_CreateSetup(0, length, vDSP_DFT_FORWARD);
+    setup->inverse = vDSP_DFT_zrop_CreateSetup(setup->forward, length, vDSP_DFT_INVERSE);
+    if ( !setup->forward || !setup->inverse ) {
+        AEDSPFFTDealloc(setup);
+        return NULL;
+    }
+    return setup;
+}
+
+void AEDSPFFTDealloc(AEDSPFFT * setup) {
+    free(setup->real);
+    free(setup->imag);
+    if ( setup->forward ) vDSP_DFT_DestroySetup(setup->forward);
+    if ( setup->inverse ) vDSP_DFT_DestroySetup(setup->inverse);
+    free(setup);
+}
+
+void AEDSPFFTForward(AEDSPFFT * setup, const float * input, float * real, float * imag) {
+    DSPSplitComplex split = { .realp = real, .imagp = imag };
+    vDSP_ctoz((const DSPComplex *)input, 2, &split, 1, setup->length/2);
+    vDSP_DFT_Execute(setup->forward, real, imag, real, imag);
+}
+
+void AEDSPFFTInverse(AEDSPFFT * setup, const float * real, const float * imag, float * output) {
+    vDSP_DFT_Execute(setup->inverse, real, imag, setup->real, setup->imag);
+    DSPSplitComplex split = { .realp = setup->real, .imagp = setup->imag };
+    vDSP_ztoc(&split, 1, (DSPComplex *)output, 2, setup->length/2);
+}
+
 #pragma mark - FFT Convolution
 
 typedef struct AEDSPFFTConvolution_t {
@@ -491,6 +535,229 @@ void AEDSPFFTConvolutionExecute(AEDSPFFTConvolution * setup, float * input, int
 }
 
 
+#pragma mark - Batched FFT Convolution
+
+typedef struct AEDSPFFTConvolutionBatch_t {
+    int length;
+    int channels;
+    vDSP_DFT_Setup forward;
+    vDSP_DFT_Setup inverse;
+    float * inputR;
+    float * inputI;
+    float * nyquist;
+    float * filterR;
+    float * filterI;
+    float * filterNyquist;
+    int filterCount;
+    int filterLength;
+    float * overflow;
+    int overflowLength;
+    float * temp;
+    AEDSPFFTConvolutionOperation operation;
+} AEDSPFFTConvolutionBatch;
+
+AEDSPFFTConvolutionBatch * AEDSPFFTConvolutionBatchInit(int length, int channels) {
+    int fftLength = AEDSPFFTConvolutionCalculateFFTLength(length);
+    
+    // Spectra and time-domain buffers for each channel are stored end-to-end, so that operations
+    // common to all channels can be performed in a single pass
+    AEDSPFFTConvolutionBatch * setup = calloc(1, sizeof(AEDSPFFTConvolutionBatch));
+    setup->length = fftLength;
+    setup->channels = channels;
+    setup->inputR = malloc(sizeof(float) * (fftLength/2) * channels);
+    setup->inputI = malloc(sizeof(float) * (fftLength/2) * channels);
+    setup->nyquist = malloc(sizeof(float) * channels);
+    setup->filterR = calloc((fftLength/2) * channels, sizeof(float));
+    setup->filterI = calloc((fftLength/2) * channels, sizeof(float));
+    setup->filterNyquist = calloc(channels, sizeof(float));
+    setup->filterCount = 1;
+    setup->overflow = malloc(sizeof(float) * fftLength * channels);
+    setup->temp = malloc(sizeof(float) * fftLength * channels);
+    setup->forward = vDSP_DFT_zrop_CreateSetup(0, fftLength, vDSP_DFT_FORWARD);
+    setup->inverse = vDSP_DFT_zrop_CreateSetup(setup->forward, fftLength, vDSP_DFT_INVERSE);
+    return setup;
+}
+
+void AEDSPFFTConvolutionBatchDealloc(AEDSPFFTConvolutionBatch * setup) {
+    free(setup->inputR);
+    free(setup->inputI);
+    free(setup->nyquist);
+    free(setup->filterR);
+    free(setup->filterI);
+    free(setup->filterNyquist);
+    free(setup->overflow);
+    free(setup->temp);
+    vDSP_DFT_DestroySetup(setup->forward);
+    vDSP_DFT_DestroySetup(setup->inverse);
+    free(setup);
+}
+
+void AEDSPFFTConvolutionBatchPrepareContinuous(AEDSPFFTConvolutionBatch * setup, float ** filters, int filterCount, int filterLength, AEDSPFFTConvolutionOperation operation) {
+    assert(filterLength < setup->length);
+    assert(filterCount == 1 || filterCount == setup->channels);
+    int half = setup->length/2;
+    BOOL reverse = operation == AEDSPFFTConvolutionOperation_Correlation || operation == AEDSPFFTConvolutionOperation_CorrelationFull;
+    
+    // Perform forward FFT of each filter signal. The Nyquist values are moved out of imag[0] up front,
+    // so the filter spectra can be multiplied as-is during execution
+    for ( int i=0; i<filterCount; i++ ) {
+        float * real = setup->filterR + i*half;
+        float * imag = setup->filterI + i*half;
+        AEDSPFFTConvolutionInterleaveAndPad(filters[i], real, imag, filterLength, setup->length, reverse);
+        vDSP_DFT_Execute(setup->forward, real, imag, real, imag);
+        setup->filterNyquist[i] = imag[0];
+        imag[0] = 0;
+    }
+    
+    setup->operation = operation;
+    setup->filterLength = filterLength;
+    setup->filterCount = filterCount;
+}
+
+void AEDSPFFTConvolutionBatchReset(AEDSPFFTConvolutionBatch * setup) {
+    setup->overflowLength = 0;
+}
+
+static void _AEDSPFFTConvolutionBatchExecute(AEDSPFFTConvolutionBatch * setup, float ** inputs, int inputLength, float ** outputs, int outputLength, BOOL summed) {
+    int filterLength = setup->filterLength;
+    int length = setup->length;
+    int half = length/2;
+    int channels = setup->channels;
+    int outputChannels = summed ? 1 : channels;
+    BOOL sharedFilter = setup->filterCount == 1;
+    
+    // When summing through a shared filter, the sum can be taken before the transform: then only one
+    // forward and one inverse transform are needed in total
+    BOOL sumBeforeTransform = summed && sharedFilter;
+    int transformedChannels = sumBeforeTransform ? 1 : channels;
+    
+    int outputElementsToSkip = 0;
+    if ( setup->operation == AEDSPFFTConvolutionOperation_Convolution || setup->operation == AEDSPFFTConvolutionOperation_Correlation ) {
+        // Skip filterLength-1 frames from start
+        outputElementsToSkip = filterLength - 1;
+    }
+    
+    DSPSplitComplex inputSplit = { .realp = setup->inputR, .imagp = setup->inputI };
+    DSPSplitComplex filterSplit = { .realp = setup->filterR, .imagp = setup->filterI };
+    int inputOffset = 0;
+    int outputOffset = 0;
+    
+    while ( inputLength > 0 ) {
+        int blockLength = MIN(length - filterLength + 1, inputLength);
+        
+        // Perform forward FFT of input signals
+        if ( sumBeforeTransform ) {
+            memcpy(setup->temp, inputs[0] + inputOffset, sizeof(float) * blockLength);
+            for ( int c=1; c<channels; c++ ) {
+                vDSP_vadd(inputs[c] + inputOffset, 1, setup->temp, 1, setup->temp, 1, blockLength);
+            }
+            AEDSPFFTConvolutionInterleaveAndPad(setup->temp, setup->inputR, setup->inputI, blockLength, length, NO);
+            vDSP_DFT_Execute(setup->forward, setup->inputR, setup->inputI, setup->inputR, setup->inputI);
+        } else {
+            for ( int c=0; c<channels; c++ ) {
+                float * real = setup->inputR + c*half;
+                float * imag = setup->inputI + c*half;
+                AEDSPFFTConvolutionInterleaveAndPad(inputs[c] + inputOffset, real, imag, blockLength, length, NO);
+                vDSP_DFT_Execute(setup->forward, real, imag, real, imag);
+            }
+        }
+        
+        // Multiply signals. The Nyquist value is stored in imag[0] of each channel, so treat that differently
+        for ( int c=0; c<transformedChannels; c++ ) {
+            setup->nyquist[c] = setup->inputI[c*half] * setup->filterNyquist[sharedFilter ? 0 : c];
+            setup->inputI[c*half] = 0;
+        }
+        
+        if ( summed && !sharedFilter ) {
+            // Multiply-accumulate all channels into the first
+            vDSP_zvmul(&inputSplit, 1, &filterSplit, 1, &inputSplit, 1, half, 1);
+            for ( int c=1; c<channels; c++ ) {
+                DSPSplitComplex channelSplit = { .realp = setup->inputR + c*half, .imagp = setup->inputI + c*half };
+                DSPSplitComplex channelFilterSplit = { .realp = setup->filterR + c*half, .imagp = setup->filterI + c*half };
+                vDSP_zvma(&channelSplit, 1, &channelFilterSplit, 1, &inputSplit, 1, &inputSplit, 1, half);
+                setup->nyquist[0] += setup->nyquist[c];
+            }
+        } else if ( sharedFilter ) {
+            for ( int c=0; c<transformedChannels; c++ ) {
+                DSPSplitComplex channelSplit = { .realp = setup->inputR + c*half, .imagp = setup->inputI + c*half };
+                vDSP_zvmul(&channelSplit, 1, &filterSplit, 1, &channelSplit, 1, half, 1);
+            }
+        } else {
+            // Per-channel filter spectra are laid out the same way as the input spectra: multiply all in one pass
+            vDSP_zvmul(&inputSplit, 1, &filterSplit, 1, &inputSplit, 1, half*channels, 1);
+        }
+        
+        // Perform inverse FFT, and de-interleave to time domain
+        for ( int c=0; c<outputChannels; c++ ) {
+            float * real = setup->inputR + c*half;
+            float * imag = setup->inputI + c*half;
+            imag[0] = setup->nyquist[c];
+            vDSP_DFT_Execute(setup->inverse, real, imag, real, imag);
+            DSPSplitComplex channelSplit = { .realp = real, .imagp = imag };
+            vDSP_ztoc(&channelSplit, 1, (DSPComplex *)(setup->temp + c*length), 2, half);
+        }
+        
+        // Scale according to API convention (undo x2 scale for each forward transform, and xN scale for inverse)
+        float scale = 1.0 / (2*2*length);
+        vDSP_vsmul(setup->temp, 1, &scale, setup->temp, 1, length*outputChannels);
+        
+        for ( int c=0; c<outputChannels; c++ ) {
+            float * temp = setup->temp + c*length;
+            float * overflow = setup->overflow + c*length;
+            
+            if ( setup->overflowLength > 0 ) {
+                // Add overflow from last block
+                vDSP_vadd(temp, 1, overflow, 1, temp, 1, setup->overflowLength);
+            }
+            
+            // Save overflow
+            memcpy(overflow, temp + blockLength, sizeof(float) * (filterLength - 1));
+        }
+        setup->overflowLength = filterLength - 1;
+        
+        // Save output
+        int skippedElements = MIN(outputElementsToSkip, blockLength);
+        int blockOutputLength = MIN(outputLength, blockLength - skippedElements);
+        for ( int c=0; c<outputChannels; c++ ) {
+            memcpy(outputs[c] + outputOffset, setup->temp + c*length + skippedElements, sizeof(float) * blockOutputLength);
+        }
+        
+        // Advance
+        inputLength -= blockLength;
+        inputOffset += blockLength;
+        outputLength -= blockOutputLength;
+        outputOffset += blockOutputLength;
+        outputElementsToSkip -= skippedElements;
+    }
+    
+    if ( outputLength > 0 && setup->overflowLength > 0 ) {
+        int remaining = MIN(outputLength, setup->overflowLength);
+        int skippedElements = MIN(outputElementsToSkip, remaining);
+        remaining -= skippedElements;
+        for ( int c=0; c<outputChannels; c++ ) {
+            memcpy(outputs[c] + outputOffset, setup->overflow + c*length + skippedElements, remaining * sizeof(float));
+        }
+        outputOffset += remaining;
+        outputLength -= remaining;
+        setup->overflowLength -= remaining+skippedElements;
+    }
+    
+    if ( outputLength > 0 ) {
+        for ( int c=0; c<outputChannels; c++ ) {
+            vDSP_vclr(outputs[c] + outputOffset, 1, outputLength);
+        }
+    }
+}
+
+void AEDSPFFTConvolutionBatchExecuteContinuous(AEDSPFFTConvolutionBatch * setup, float ** inputs, int inputLength, float ** outputs, int outputLength) {
+    _AEDSPFFTConvolutionBatchExecute(setup, inputs, inputLength, outputs, outputLength, NO);
+}
+
+void AEDSPFFTConvolutionBatchExecuteContinuousSummed(AEDSPFFTConvolutionBatch * setup, float ** inputs, int inputLength, float * output, int outputLength) {
+    _AEDSPFFTConvolutionBatchExecute(setup, inputs, inputLength, &output, outputLength, YES);
+}
+
+
 int AEDSPFindPeaksInDistribution(float * distribution, int start, int end, float leadingDelta, float trailingDelta, int minimumSeparation, BOOL sort, int * peaks, int maxPeaks) {
     int bufferSize = 128;
     struct { int index; float score; } * results = sort ? malloc(sizeof(*results) * bufferSize) : NULL;
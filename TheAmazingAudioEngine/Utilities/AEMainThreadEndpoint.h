@@ -37,7 +37,7 @@ extern "C" {
  *  Provide a block matching this description to the initializer to handle incoming
  *  messages. It will be called on the main thread.
  *
- * @param data Message data (or NULL)
+ * @param data Message data (or NULL), read in place from the buffer and valid only until the handler returns
  * @param length Length of message
  */
 typedef void (^AEMainThreadEndpointHandler)(const void * _Nullable data, size_t length);
@@ -69,22 +69,31 @@ typedef void (^AEMainThreadEndpointHandler)(const void * _Nullable data, size_t
  *
  * @param handler The handler block to use for incoming messages
  * @param bufferCapacity The buffer capacity, in bytes (default is 8192 bytes).  Note that
- *  due to the underlying implementation, actual capacity may be larger.
+ *  due to the underlying implementation, actual capacity may be larger. Messages occupy the
+ *  buffer until they have been handled on the main thread, so allow for the backlog that may
+ *  build up while the main thread is busy.
  */
 - (instancetype _Nullable)initWithHandler:(AEMainThreadEndpointHandler _Nonnull)handler bufferCapacity:(size_t)bufferCapacity;
 
 /*!
  * Initializer with custom buffer capacity, and multiple producer support
  *
+ *  Deprecated: any number of threads may send to any endpoint, so there is no longer a
+ *  producer count to give. Use initWithHandler:bufferCapacity: instead.
+ *
  * @param handler The handler block to use for incoming messages
  * @param bufferCapacity The buffer capacity, in bytes (default is 8192 bytes).  Note that
  *  due to the underlying implementation, actual capacity may be larger.
- * @param producerCount The maximum number of producers that can send messages to this endpoint (default 1)
+ * @param producerCount Ignored
  */
-- (instancetype _Nullable)initWithHandler:(AEMainThreadEndpointHandler _Nonnull)handler bufferCapacity:(size_t)bufferCapacity producerCount:(int)producerCount;
+- (instancetype _Nullable)initWithHandler:(AEMainThreadEndpointHandler _Nonnull)handler bufferCapacity:(size_t)bufferCapacity producerCount:(int)producerCount
+    __deprecated_msg("any number of threads may send to an endpoint; use initWithHandler:bufferCapacity:");
 
 /*!
  * Service any pending messages
+ *
+ *  On the main thread, this handles waiting messages immediately; elsewhere, it schedules
+ *  them to be handled on the main thread.
  */
 - (void)serviceMessages;
 
@@ -107,21 +116,54 @@ BOOL AEMainThreadEndpointSend(__unsafe_unretained AEMainThreadEndpoint * _Nonnul
  *
  *  Use this function to gain access to a writable message buffer of the given length,
  *  to assemble the message in multiple parts. Then call AEMainThreadEndpointDispatchMessage to
- *  dispatch.
+ *  dispatch, or AEMainThreadEndpointCancelMessage to give it up, on the same thread. Messages sent
+ *  after it by other threads are held back until you do. If you create another message for the
+ *  same endpoint first, the earlier one is abandoned; messages in progress for other endpoints
+ *  are unaffected. Up to 16 threads may have a message in progress for an endpoint at once.
  *
  * @param endpoint The endpoint instance
  * @param length Length of message data
- * @return A pointer to message bytes ready for writing, or NULL if there was insufficient buffer space
+ * @return A pointer to message bytes ready for writing, or NULL if there was insufficient buffer space,
+ *  or too many other threads had a message in progress
  */
 void * _Nullable AEMainThreadEndpointCreateMessage(__unsafe_unretained AEMainThreadEndpoint * _Nonnull endpoint, size_t length);
 
 /*!
  * Dispatch a message created with AEMainThreadEndpointCreateMessage
  *
+ *  Does nothing if this thread has no message created for this endpoint waiting to be dispatched.
+ *
  * @param endpoint The endpoint instance
  */
 void AEMainThreadEndpointDispatchMessage(__unsafe_unretained AEMainThreadEndpoint * _Nonnull endpoint);
 
+/*!
+ * Cancel a message created with AEMainThreadEndpointCreateMessage
+ *
+ *  Use this instead of AEMainThreadEndpointDispatchMessage if you can't complete the message.
+ *  Does nothing if this thread has no message created for this endpoint waiting to be dispatched.
+ *
+ * @param endpoint The endpoint instance
+ */
+void AEMainThreadEndpointCancelMessage(__unsafe_unretained AEMainThreadEndpoint * _Nonnull endpoint);
+
+/*!
+ * Get the number of messages dropped for lack of buffer space
+ *
+ *  Counts every message that AEMainThreadEndpointSend or AEMainThreadEndpointCreateMessage
+ *  could not accept because the endpoint's buffer, which all producer threads share, was full.
+ *  The count covers all producers together. Producers can compare it against an earlier reading
+ *  to detect and react to backpressure. Safe to call on any thread.
+ *
+ * @param endpoint The endpoint instance
+ * @return The number of dropped messages since initialization
+ */
+uint64_t AEMainThreadEndpointGetDroppedMessageCount(__unsafe_unretained AEMainThreadEndpoint * _Nonnull endpoint);
+
+//! The number of messages dropped for lack of buffer space, across all producer threads
+//! (see AEMainThreadEndpointGetDroppedMessageCount)
+@property (nonatomic, readonly) uint64_t droppedMessageCount;
+
 /*!
  * Total number of registered endpoints
  *
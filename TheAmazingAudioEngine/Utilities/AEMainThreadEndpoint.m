@@ -25,30 +25,42 @@
 //
 
 #import "AEMainThreadEndpoint.h"
-#import "TPCircularBuffer+MultiProducer.h"
+#import "AEUtilities.h"
+#import "TPCircularBuffer+MPSC.h"
 #import <mach/semaphore.h>
 #import <mach/task.h>
 #import <mach/mach_init.h>
 #import <pthread.h>
+#import <stdatomic.h>
 
 static const int kMaxMessagesEachService = 20;
+#define kMaxPendingMessages 16
 
 @class AEMainThreadEndpointThread;
 
 static AEMainThreadEndpointThread * __sharedThread = nil;
 
+// A message created on a thread but not yet dispatched
+typedef struct {
+    _Atomic(pthread_t) thread;  // The creating thread, or NULL if the slot is free
+    void * message;
+} pending_message_t;
+
 @interface AEMainThreadEndpoint () {
-    TPMultiProducerBuffer _buffer;
-    BOOL _hasPendingMainThreadMessages;
-    pthread_mutex_t _mutex;
-    BOOL _mutexHeldByMainThread;
+    TPMPSCBuffer _buffer;
+    pending_message_t _pendingMessages[kMaxPendingMessages];
+    atomic_bool _wakePending;
+    atomic_bool _serviceScheduled;
+    BOOL _servicing;
+    _Atomic(uint64_t) _droppedMessageCount;
 }
 @property (nonatomic, copy) AEMainThreadEndpointHandler handler;
 @property (nonatomic) semaphore_t semaphore;
 @property (nonatomic, strong) AEMainThreadEndpointThread * thread;
-@property (nonatomic, strong) NSMutableArray <void (^)(void)> * mainThreadBlocks;
 @end
 
+static void AEMainThreadEndpointScheduleService(__unsafe_unretained AEMainThreadEndpoint * THIS);
+
 @interface AEMainThreadEndpointThread : NSThread
 - (void)addEndpoint:(AEMainThreadEndpoint *)endpoint;
 - (void)removeEndpoint:(AEMainThreadEndpoint *)endpoint;
@@ -72,15 +84,11 @@ static AEMainThreadEndpointThread * __sharedThread = nil;
 }
 
 - (instancetype)initWithHandler:(AEMainThreadEndpointHandler)handler bufferCapacity:(size_t)bufferCapacity {
-    return [self initWithHandler:handler bufferCapacity:bufferCapacity producerCount:1];
-}
-
-- (instancetype)initWithHandler:(AEMainThreadEndpointHandler)handler bufferCapacity:(size_t)bufferCapacity producerCount:(int)producerCount {
     if ( !(self = [super init]) ) return nil;
     
     self.handler = handler;
     
-    if ( !TPMultiProducerBufferInit(&_buffer, (int32_t)bufferCapacity, producerCount) ) {
+    if ( !TPMPSCBufferInit(&_buffer, (int32_t)bufferCapacity) ) {
         return nil;
     }
     
@@ -88,16 +96,18 @@ static AEMainThreadEndpointThread * __sharedThread = nil;
     [self.thread addEndpoint:self];
     self.semaphore = self.thread.semaphore;
     
-    self.mainThreadBlocks = [NSMutableArray array];
-    pthread_mutex_init(&_mutex, NULL);
-    
     return self;
 }
 
+- (instancetype)initWithHandler:(AEMainThreadEndpointHandler)handler bufferCapacity:(size_t)bufferCapacity producerCount:(int)producerCount {
+    // producerCount is no longer needed: any number of threads may send to the shared buffer
+    return [self initWithHandler:handler bufferCapacity:bufferCapacity];
+}
+
 - (void)dealloc {
     [self.thread removeEndpoint:self];
-    TPMultiProducerBufferCleanup(&_buffer);
-    pthread_mutex_destroy(&_mutex);
+    memset(_pendingMessages, 0, sizeof(_pendingMessages));
+    TPMPSCBufferCleanup(&_buffer);
 }
 
 BOOL AEMainThreadEndpointSend(__unsafe_unretained AEMainThreadEndpoint * THIS, const void * data, size_t length) {
@@ -119,128 +129,185 @@ BOOL AEMainThreadEndpointSend(__unsafe_unretained AEMainThreadEndpoint * THIS, c
     return YES;
 }
 
+static void AEMainThreadEndpointWakeServiceThread(__unsafe_unretained AEMainThreadEndpoint * THIS) {
+    // Signal, unless a wake for this endpoint is already on its way
+    if ( !atomic_exchange_explicit(&THIS->_wakePending, true, memory_order_acq_rel) ) {
+        semaphore_signal(THIS->_semaphore);
+    }
+}
+
+static pending_message_t * AEMainThreadEndpointGetPendingMessage(__unsafe_unretained AEMainThreadEndpoint * THIS) {
+    // Only the creating thread writes its own identifier into a slot, so it can't be missed here
+    pthread_t thread = pthread_self();
+    for ( int i=0; i<kMaxPendingMessages; i++ ) {
+        if ( atomic_load_explicit(&THIS->_pendingMessages[i].thread, memory_order_relaxed) == thread ) {
+            return &THIS->_pendingMessages[i];
+        }
+    }
+    return NULL;
+}
+
+static void AEMainThreadEndpointReleasePendingMessage(pending_message_t * pending) {
+    pending->message = NULL;
+    atomic_store_explicit(&pending->thread, NULL, memory_order_release);
+}
+
 void * AEMainThreadEndpointCreateMessage(__unsafe_unretained AEMainThreadEndpoint * THIS, size_t length) {
     
-    // Get pointer to writable bytes
-    TPCircularBuffer * buffer = TPMultiProducerBufferGetProducerBuffer(&THIS->_buffer);
-    int32_t size = (int32_t)(length + sizeof(size_t));
-    int32_t availableBytes;
-    void * head = TPCircularBufferHead(buffer, &availableBytes);
-    if ( availableBytes < size ) {
+    pending_message_t * pending = AEMainThreadEndpointGetPendingMessage(THIS);
+    if ( pending ) {
+        // Give up the message this thread created earlier but never dispatched, which would
+        // otherwise hold back every message sent after it, and reuse its slot
+        #ifdef DEBUG
+        if ( AERateLimit() ) printf("AEMainThreadEndpoint: Abandoning undispatched message\n");
+        #endif
+        TPMPSCBufferAbandon(&THIS->_buffer, pending->message);
+        pending->message = NULL;
+        AEMainThreadEndpointWakeServiceThread(THIS);
+    } else {
+        // Claim a slot to remember the message in until it's dispatched
+        pthread_t thread = pthread_self();
+        for ( int i=0; i<kMaxPendingMessages && !pending; i++ ) {
+            pthread_t expected = NULL;
+            if ( atomic_compare_exchange_strong_explicit(&THIS->_pendingMessages[i].thread, &expected, thread,
+                                                         memory_order_acquire, memory_order_relaxed) ) {
+                pending = &THIS->_pendingMessages[i];
+            }
+        }
+        if ( !pending ) {
+            #ifdef DEBUG
+            if ( AERateLimit() ) printf("AEMainThreadEndpoint: Too many threads creating messages at once\n");
+            #endif
+            atomic_fetch_add_explicit(&THIS->_droppedMessageCount, 1, memory_order_relaxed);
+            return NULL;
+        }
+    }
+    
+    // Reserve space in the shared buffer
+    void * message = TPMPSCBufferReserve(&THIS->_buffer, (uint32_t)length);
+    if ( !message ) {
+        AEMainThreadEndpointReleasePendingMessage(pending);
+        atomic_fetch_add_explicit(&THIS->_droppedMessageCount, 1, memory_order_relaxed);
         return NULL;
     }
     
-    // Write the length of the message
-    *((size_t*)head) = length;
+    // Remember it for AEMainThreadEndpointDispatchMessage
+    pending->message = message;
     
-    // Return the following region ready for writing
-    return head + sizeof(size_t);
+    return message;
 }
 
 void AEMainThreadEndpointDispatchMessage(__unsafe_unretained AEMainThreadEndpoint * THIS) {
-
-    // Get pointer to writable bytes
-    TPCircularBuffer * buffer = TPMultiProducerBufferGetProducerBuffer(&THIS->_buffer);
-    int32_t availableBytes;
-    void * head = TPCircularBufferHead(buffer, &availableBytes);
-    size_t size = *((size_t*)head) + sizeof(size_t);
-    if ( availableBytes < size ) {
-        // Not enough space to write the message
+    
+    pending_message_t * pending = AEMainThreadEndpointGetPendingMessage(THIS);
+    if ( !pending ) {
+        #ifdef DEBUG
+        if ( AERateLimit() ) printf("AEMainThreadEndpoint: No message created on this thread to dispatch\n");
+        #endif
         return;
     }
     
     // Mark as ready to read
-    TPCircularBufferProduce(buffer, (int32_t)size);
-    semaphore_signal(THIS->_semaphore);
+    TPMPSCBufferCommit(&THIS->_buffer, pending->message);
+    AEMainThreadEndpointReleasePendingMessage(pending);
+    
+    // Wake the service thread
+    AEMainThreadEndpointWakeServiceThread(THIS);
 }
 
-- (void)serviceMessages {
-    BOOL isMainThread = NSThread.isMainThread;
+void AEMainThreadEndpointCancelMessage(__unsafe_unretained AEMainThreadEndpoint * THIS) {
     
-    if ( isMainThread ) {
-        [self serviceBlockQueue];
+    pending_message_t * pending = AEMainThreadEndpointGetPendingMessage(THIS);
+    if ( !pending ) {
+        return;
     }
     
-    BOOL alreadyHeld = isMainThread && _mutexHeldByMainThread;
-    if ( !alreadyHeld ) {
-        pthread_mutex_lock(&_mutex);
-        if ( isMainThread ) _mutexHeldByMainThread = YES;
+    // Have the consumer skip over the message, and any it was holding back
+    TPMPSCBufferAbandon(&THIS->_buffer, pending->message);
+    AEMainThreadEndpointReleasePendingMessage(pending);
+    AEMainThreadEndpointWakeServiceThread(THIS);
+}
+
+uint64_t AEMainThreadEndpointGetDroppedMessageCount(__unsafe_unretained AEMainThreadEndpoint * THIS) {
+    return atomic_load_explicit(&THIS->_droppedMessageCount, memory_order_relaxed);
+}
+
+- (uint64_t)droppedMessageCount {
+    return AEMainThreadEndpointGetDroppedMessageCount(self);
+}
+
+
+static void AEMainThreadEndpointServiceMessages(__unsafe_unretained AEMainThreadEndpoint * THIS) {
+    if ( THIS->_servicing ) {
+        // Called from within a handler; the outer pass will continue with the remaining messages
+        return;
     }
+    THIS->_servicing = YES;
     
-    TPCircularBuffer * buffer;
-    for ( int i=0; i<kMaxMessagesEachService; i++ ) {
-        int byteCount = 0;
-        
-        TPMultiProducerBufferIterateBuffers(&_buffer, buffer) {
-            // Get pointer to readable bytes
-            int32_t availableBytes;
-            void * tail = TPCircularBufferTail(buffer, &availableBytes);
-            if ( availableBytes < sizeof(size_t) ) {
-                continue;
-            }
-            byteCount += availableBytes;
-            
-            // Get length and data
-            size_t length = *((size_t*)tail);
-            void * data = length > 0 ? (tail + sizeof(size_t)) : NULL;
-            
-            if ( length > availableBytes - sizeof(size_t) ) {
-                NSLog(@"Invalid length: %zu (available: %d)", length, availableBytes);
-                TPCircularBufferConsume(buffer, availableBytes);
-                break;
-            }
-            
-            // Make local copy of data
-            void * dataCopy = malloc(length);
-            memcpy(dataCopy, data, length);
-            
-            // Mark as read
-            TPCircularBufferConsume(buffer, (int32_t)(sizeof(size_t) + length));
-            
-            if ( isMainThread ) {
-                self.handler(dataCopy, length);
-                free(dataCopy);
-            } else {
-                __weak typeof(self) weakSelf = self;
-                [self.mainThreadBlocks addObject:^{
-                    // Run handler
-                    weakSelf.handler(dataCopy, length);
-                    free(dataCopy);
-                }];
-                dispatch_async(dispatch_get_main_queue(), ^{ [self serviceBlockQueue]; });
-            }
+    for ( int i=0; ; i++ ) {
+        // Get the next message, in the order sent across all producers
+        uint32_t length;
+        void * data = TPMPSCBufferNextMessage(&THIS->_buffer, &length);
+        if ( !data ) {
+            break;
         }
         
-        if ( byteCount == 0 ) {
+        if ( i == kMaxMessagesEachService ) {
+            // Let other main queue work run, and continue afterwards
+            AEMainThreadEndpointScheduleService(THIS);
             break;
         }
+        
+        // Handle the message in place, then mark it as read
+        THIS->_handler(data, length);
+        TPMPSCBufferConsume(&THIS->_buffer);
     }
     
-    if ( !alreadyHeld ) {
-        if ( isMainThread ) _mutexHeldByMainThread = NO;
-        pthread_mutex_unlock(&_mutex);
-    }
+    THIS->_servicing = NO;
 }
 
-- (void)serviceBlockQueue {
-    BOOL isMainThread = NSThread.isMainThread;
-    BOOL alreadyHeld = isMainThread && _mutexHeldByMainThread;
-    if ( !alreadyHeld ) {
-        pthread_mutex_lock(&_mutex);
-        if ( isMainThread ) _mutexHeldByMainThread = YES;
-    }
+static void AEMainThreadEndpointScheduledService(void * context) {
+    __unsafe_unretained AEMainThreadEndpoint * THIS = (__bridge AEMainThreadEndpoint *)context;
     
-    NSArray <void (^)(void)> * mainThreadBlocks = self.mainThreadBlocks.copy;
-    [self.mainThreadBlocks removeAllObjects];
+    // Clear before servicing: anything committed from here on is either seen below, or schedules again
+    atomic_exchange_explicit(&THIS->_serviceScheduled, false, memory_order_acq_rel);
     
-    if ( !alreadyHeld ) {
-        if ( isMainThread ) _mutexHeldByMainThread = NO;
-        pthread_mutex_unlock(&_mutex);
+    AEMainThreadEndpointServiceMessages(THIS);
+    
+    // Balance the retain taken when scheduling, which kept the endpoint alive through its handlers
+    CFRelease(context);
+}
+
+static void AEMainThreadEndpointScheduleService(__unsafe_unretained AEMainThreadEndpoint * THIS) {
+    // One main queue hop at a time per endpoint, however many messages are waiting
+    if ( atomic_exchange_explicit(&THIS->_serviceScheduled, true, memory_order_acq_rel) ) {
+        return;
+    }
+    dispatch_async_f(dispatch_get_main_queue(), (void *)CFBridgingRetain(THIS), AEMainThreadEndpointScheduledService);
+}
+
+static void AEMainThreadEndpointHandleWake(__unsafe_unretained AEMainThreadEndpoint * THIS) {
+    // Clear the wake flag before checking: anything dispatched from here on signals again
+    if ( !atomic_exchange_explicit(&THIS->_wakePending, false, memory_order_acq_rel) ) {
+        return;
     }
     
-    for ( void (^block)(void) in mainThreadBlocks ) {
-        block();
+    // Have the main thread service the endpoint, if the next message is ready. If it's still being
+    // written, the wake that follows its dispatch will bring us back here
+    if ( TPMPSCBufferHasMessage(&THIS->_buffer) ) {
+        AEMainThreadEndpointScheduleService(THIS);
+    }
+}
+
+- (void)serviceMessages {
+    if ( !NSThread.isMainThread ) {
+        AEMainThreadEndpointScheduleService(self);
+        return;
     }
+    
+    CFRetain((__bridge CFTypeRef)self);
+    AEMainThreadEndpointServiceMessages(self);
+    CFRelease((__bridge CFTypeRef)self);
 }
 
 + (int)totalEndpointCount {
@@ -299,9 +366,9 @@ void AEMainThreadEndpointDispatchMessage(__unsafe_unretained AEMainThreadEndpoin
             NSArray <AEMainThreadEndpoint *> * endpoints = self.endpoints.allObjects;
             pthread_mutex_unlock(&_mutex);
             
-            // Service endpoints
+            // Check the endpoints that have signalled
             for ( AEMainThreadEndpoint * endpoint in endpoints ) {
-                [endpoint serviceMessages];
+                AEMainThreadEndpointHandleWake(endpoint);
             }
         }
         
@@ -0,0 +1,173 @@
+//
+//  AEMappedAudioFile.h
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#import <Foundation/Foundation.h>
+#import <AudioToolbox/AudioToolbox.h>
+
+/*!
+ * Access pattern hints
+ *
+ *  These are passed to the system via madvise, to tune read-ahead for the mapped file.
+ */
+typedef enum {
+    AEMappedAudioFileAccessNormal,     //!< Default read-ahead
+    AEMappedAudioFileAccessSequential, //!< Aggressive read-ahead; pages behind the read position may be freed early
+    AEMappedAudioFileAccessRandom,     //!< No read-ahead, for scattered access such as granular playback
+} AEMappedAudioFileAccess;
+
+/*!
+ * Memory-mapped audio file
+ *
+ *  This utility provides direct access to the samples of uncompressed WAV, RF64, CAF and AIFF/AIFC
+ *  files, without ExtAudioFile. The file's container is parsed in plain C, and its audio data is
+ *  memory-mapped, so that it is paged in by the system as it is used.
+ *
+ *  Files containing native-endian 32-bit float audio are exposed directly: the interleaved frames
+ *  returned by AEMappedAudioFileGetInterleavedFrames point into the mapping, with no copy. Other
+ *  sample formats (8, 16, 24 and 32-bit integer, big-endian float and 64-bit float) are converted
+ *  to float with vector routines. Interleaved access converts the file lazily, block by block,
+ *  into a converted image of the file the first time each block is touched; non-interleaved reads
+ *  with AEMappedAudioFileRead convert straight into the output buffers.
+ *
+ *  Reads allocate no memory and take no locks, but may page in audio from disk, or (for interleaved
+ *  access to files that aren't zero-copy) convert blocks on demand. Use AEMappedAudioFilePrepare
+ *  off the realtime thread to bring a range in ahead of time.
+ */
+typedef struct AEMappedAudioFile_t AEMappedAudioFile;
+
+/*!
+ * Open a file
+ *
+ * @param path Path to the file
+ * @param error If not NULL, the error on output
+ * @return The file, or NULL if it couldn't be opened, or isn't an uncompressed PCM file of a supported type
+ */
+AEMappedAudioFile * _Nullable AEMappedAudioFileOpen(NSString * _Nonnull path, NSError * _Nullable * _Nullable error);
+
+/*!
+ * Close a file
+ *
+ * @param file The file
+ */
+void AEMappedAudioFileClose(AEMappedAudioFile * _Nonnull file);
+
+/*!
+ * Get the file's data format
+ *
+ * @param file The file
+ * @return The interleaved linear PCM format of the audio in the file
+ */
+AudioStreamBasicDescription AEMappedAudioFileGetFileFormat(const AEMappedAudioFile * _Nonnull file);
+
+/*!
+ * Get the file's sample rate
+ *
+ * @param file The file
+ * @return The sample rate
+ */
+double AEMappedAudioFileGetSampleRate(const AEMappedAudioFile * _Nonnull file);
+
+/*!
+ * Get the file's channel count
+ *
+ * @param file The file
+ * @return The number of channels
+ */
+int AEMappedAudioFileGetNumberOfChannels(const AEMappedAudioFile * _Nonnull file);
+
+/*!
+ * Get the file's length
+ *
+ * @param file The file
+ * @return The length, in frames
+ */
+UInt64 AEMappedAudioFileGetLength(const AEMappedAudioFile * _Nonnull file);
+
+/*!
+ * Determine whether the file's audio is exposed without conversion
+ *
+ * @param file The file
+ * @return YES if the file contains native-endian 32-bit float audio, which is accessed in place
+ */
+BOOL AEMappedAudioFileIsZeroCopy(const AEMappedAudioFile * _Nonnull file);
+
+/*!
+ * Get interleaved float frames
+ *
+ *  For zero-copy files, this returns a pointer into the mapped file. Otherwise, any blocks of
+ *  the range not yet converted are converted first, and a pointer into the converted image of the
+ *  file is returned. The memory is read-only.
+ *
+ * @param file The file
+ * @param frame The first frame
+ * @param frames The number of frames to be accessed
+ * @return Pointer to the interleaved frames, or NULL if the range is outside the file
+ */
+const float * _Nullable AEMappedAudioFileGetInterleavedFrames(AEMappedAudioFile * _Nonnull file, UInt64 frame, UInt32 frames);
+
+/*!
+ * Read frames into a non-interleaved float buffer
+ *
+ *  If the buffer list has more buffers than the file has channels, the last channel is repeated
+ *  in the remaining buffers, so a mono file fills both sides of a stereo buffer.
+ *
+ * @param file The file
+ * @param bufferList The output buffer list, in non-interleaved float format
+ * @param frame The first frame to read
+ * @param frames The number of frames to read
+ * @return The number of frames read, which is less than requested at the end of the file
+ */
+UInt32 AEMappedAudioFileRead(AEMappedAudioFile * _Nonnull file, const AudioBufferList * _Nonnull bufferList,
+                             UInt64 frame, UInt32 frames);
+
+/*!
+ * Set the access pattern hint
+ *
+ * @param file The file
+ * @param access The expected access pattern
+ */
+void AEMappedAudioFileSetAccessPattern(AEMappedAudioFile * _Nonnull file, AEMappedAudioFileAccess access);
+
+/*!
+ * Prepare a range for access
+ *
+ *  Asks the system to read the range in, and for files that aren't zero-copy, converts it for
+ *  interleaved access. Use this off the realtime thread, ahead of playback.
+ *
+ * @param file The file
+ * @param frame The first frame
+ * @param frames The number of frames
+ */
+void AEMappedAudioFilePrepare(AEMappedAudioFile * _Nonnull file, UInt64 frame, UInt64 frames);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,579 @@
+//
+//  AEMappedAudioFile.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+
+#import "AEMappedAudioFile.h"
+#import <Accelerate/Accelerate.h>
+#import <libkern/OSByteOrder.h>
+#import <stdatomic.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
+#import <fcntl.h>
+#import <unistd.h>
+
+static const UInt32 kConversionBlockFrames = 4096;
+static const UInt32 kReadScratchSamples = 4096;
+static const int kMaxChannels = 1024;
+
+typedef enum {
+    AEMappedAudioFileSampleInt8,
+    AEMappedAudioFileSampleUInt8,
+    AEMappedAudioFileSampleInt16,
+    AEMappedAudioFileSampleInt24,
+    AEMappedAudioFileSampleInt32,
+    AEMappedAudioFileSampleFloat32,
+    AEMappedAudioFileSampleFloat64,
+} AEMappedAudioFileSampleType;
+
+enum {
+    AEMappedAudioFileBlockUnconverted,
+    AEMappedAudioFileBlockConverting,
+    AEMappedAudioFileBlockConverted,
+};
+
+typedef struct {
+    double sampleRate;
+    int channels;
+    AEMappedAudioFileSampleType type;
+    BOOL bigEndian;
+    int bytesPerSample;
+    UInt64 dataOffset;
+    UInt64 dataSize;
+    UInt64 length; // Frame count declared by the container, or UINT64_MAX if none
+} AEMappedAudioFileFormat;
+
+struct AEMappedAudioFile_t {
+    void * mapping;
+    size_t mappingSize;
+    const UInt8 * data;
+    AEMappedAudioFileFormat format;
+    UInt64 length;
+    size_t bytesPerFrame;
+    BOOL zeroCopy;
+    float * converted;
+    size_t convertedSize;
+    atomic_uchar * blockStates;
+};
+
+static void AEMappedAudioFileConvertBlock(AEMappedAudioFile * file, UInt64 block);
+static void AEMappedAudioFileConvert(const AEMappedAudioFile * file, const UInt8 * source, float * output, UInt32 count);
+static void AEMappedAudioFileDeinterleave(const float * source, int channels, const AudioBufferList * bufferList,
+                                          UInt32 offset, UInt32 frames);
+static BOOL AEMappedAudioFileParse(const UInt8 * bytes, UInt64 size, AEMappedAudioFileFormat * format);
+static void AEMappedAudioFileSetError(NSError ** error, NSString * domain, NSInteger code, NSString * description);
+
+AEMappedAudioFile * AEMappedAudioFileOpen(NSString * path, NSError ** error) {
+    int fd = open(path.fileSystemRepresentation, O_RDONLY);
+    if ( fd < 0 ) {
+        AEMappedAudioFileSetError(error, NSPOSIXErrorDomain, errno, NSLocalizedString(@"Couldn't open the audio file", @""));
+        return NULL;
+    }
+    
+    struct stat info;
+    if ( fstat(fd, &info) != 0 || info.st_size == 0 ) {
+        close(fd);
+        AEMappedAudioFileSetError(error, NSOSStatusErrorDomain, kAudioFileInvalidFileError,
+                                  NSLocalizedString(@"Couldn't read the audio file", @""));
+        return NULL;
+    }
+    
+    size_t size = (size_t)info.st_size;
+    void * mapping = mmap(NULL, size, PROT_READ, MAP_FILE | MAP_SHARED, fd, 0);
+    close(fd);
+    if ( mapping == MAP_FAILED ) {
+        AEMappedAudioFileSetError(error, NSPOSIXErrorDomain, errno, NSLocalizedString(@"Couldn't read the audio file", @""));
+        return NULL;
+    }
+    
+    AEMappedAudioFileFormat format;
+    if ( !AEMappedAudioFileParse(mapping, size, &format) ) {
+        munmap(mapping, size);
+        AEMappedAudioFileSetError(error, NSOSStatusErrorDomain, kAudioFileUnsupportedFileTypeError,
+                                  NSLocalizedString(@"Not an uncompressed audio file", @""));
+        return NULL;
+    }
+    
+    AEMappedAudioFile * file = calloc(1, sizeof(AEMappedAudioFile));
+    file->mapping = mapping;
+    file->mappingSize = size;
+    file->format = format;
+    file->data = (const UInt8 *)mapping + format.dataOffset;
+    file->bytesPerFrame = (size_t)format.bytesPerSample * format.channels;
+    file->length = MIN(format.dataSize / file->bytesPerFrame, format.length);
+    
+    // Native-endian float data that's suitably aligned is used in place (all supported platforms are little-endian)
+    file->zeroCopy = format.type == AEMappedAudioFileSampleFloat32 && !format.bigEndian && ((uintptr_t)file->data & 3) == 0;
+    
+    if ( !file->zeroCopy ) {
+        // Reserve the converted image; pages are only committed as blocks are converted
+        file->convertedSize = MAX(file->length * format.channels * sizeof(float), 1);
+        file->converted = mmap(NULL, file->convertedSize, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE, -1, 0);
+        UInt64 blocks = (file->length + kConversionBlockFrames - 1) / kConversionBlockFrames;
+        file->blockStates = calloc(MAX(blocks, 1), sizeof(atomic_uchar));
+        if ( file->converted == MAP_FAILED || !file->blockStates ) {
+            if ( file->converted == MAP_FAILED ) file->converted = NULL;
+            AEMappedAudioFileClose(file);
+            AEMappedAudioFileSetError(error, NSPOSIXErrorDomain, ENOMEM, NSLocalizedString(@"Not enough memory to open file", @""));
+            return NULL;
+        }
+    }
+    
+    return file;
+}
+
+void AEMappedAudioFileClose(AEMappedAudioFile * file) {
+    munmap(file->mapping, file->mappingSize);
+    if ( file->converted ) munmap(file->converted, file->convertedSize);
+    free(file->blockStates);
+    free(file);
+}
+
+AudioStreamBasicDescription AEMappedAudioFileGetFileFormat(const AEMappedAudioFile * file) {
+    const AEMappedAudioFileFormat * format = &file->format;
+    BOOL isFloat = format->type == AEMappedAudioFileSampleFloat32 || format->type == AEMappedAudioFileSampleFloat64;
+    return (AudioStreamBasicDescription) {
+        .mSampleRate = format->sampleRate,
+        .mFormatID = kAudioFormatLinearPCM,
+        .mFormatFlags = kAudioFormatFlagIsPacked
+            | (isFloat ? kAudioFormatFlagIsFloat : format->type != AEMappedAudioFileSampleUInt8 ? kAudioFormatFlagIsSignedInteger : 0)
+            | (format->bigEndian ? kAudioFormatFlagIsBigEndian : 0),
+        .mBytesPerPacket = (UInt32)file->bytesPerFrame,
+        .mFramesPerPacket = 1,
+        .mBytesPerFrame = (UInt32)file->bytesPerFrame,
+        .mChannelsPerFrame = format->channels,
+        .mBitsPerChannel = format->bytesPerSample * 8,
+    };
+}
+
+double AEMappedAudioFileGetSampleRate(const AEMappedAudioFile * file) {
+    return file->format.sampleRate;
+}
+
+int AEMappedAudioFileGetNumberOfChannels(const AEMappedAudioFile * file) {
+    return file->format.channels;
+}
+
+UInt64 AEMappedAudioFileGetLength(const AEMappedAudioFile * file) {
+    return file->length;
+}
+
+BOOL AEMappedAudioFileIsZeroCopy(const AEMappedAudioFile * file) {
+    return file->zeroCopy;
+}
+
+const float * AEMappedAudioFileGetInterleavedFrames(AEMappedAudioFile * file, UInt64 frame, UInt32 frames) {
+    if ( frame >= file->length || frames > file->length - frame ) return NULL;
+    
+    if ( file->zeroCopy ) {
+        return (const float *)file->data + frame * file->format.channels;
+    }
+    
+    if ( frames > 0 ) {
+        UInt64 lastBlock = (frame + frames - 1) / kConversionBlockFrames;
+        for ( UInt64 block = frame / kConversionBlockFrames; block <= lastBlock; block++ ) {
+            AEMappedAudioFileConvertBlock(file, block);
+        }
+    }
+    return file->converted + frame * file->format.channels;
+}
+
+UInt32 AEMappedAudioFileRead(AEMappedAudioFile * file, const AudioBufferList * bufferList, UInt64 frame, UInt32 frames) {
+    if ( frame >= file->length ) return 0;
+    frames = (UInt32)MIN((UInt64)frames, file->length - frame);
+    
+    int channels = file->format.channels;
+    if ( file->zeroCopy ) {
+        AEMappedAudioFileDeinterleave((const float *)file->data + frame * channels, channels, bufferList, 0, frames);
+        return frames;
+    }
+    
+    // Convert via the stack, a chunk at a time
+    float scratch[kReadScratchSamples];
+    UInt32 framesPerChunk = kReadScratchSamples / channels;
+    for ( UInt32 offset = 0; offset < frames; ) {
+        UInt32 chunk = MIN(framesPerChunk, frames - offset);
+        AEMappedAudioFileConvert(file, file->data + (frame + offset) * file->bytesPerFrame, scratch, chunk * channels);
+        AEMappedAudioFileDeinterleave(scratch, channels, bufferList, offset, chunk);
+        offset += chunk;
+    }
+    return frames;
+}
+
+void AEMappedAudioFileSetAccessPattern(AEMappedAudioFile * file, AEMappedAudioFileAccess access) {
+    int advice = access == AEMappedAudioFileAccessSequential ? MADV_SEQUENTIAL
+               : access == AEMappedAudioFileAccessRandom ? MADV_RANDOM
+               : MADV_NORMAL;
+    madvise(file->mapping, file->mappingSize, advice);
+}
+
+void AEMappedAudioFilePrepare(AEMappedAudioFile * file, UInt64 frame, UInt64 frames) {
+    if ( frame >= file->length ) return;
+    frames = MIN(frames, file->length - frame);
+    if ( frames == 0 ) return;
+    
+    uintptr_t pageSize = (uintptr_t)getpagesize();
+    uintptr_t start = (uintptr_t)(file->data + frame * file->bytesPerFrame) & ~(pageSize - 1);
+    uintptr_t end = (uintptr_t)(file->data + (frame + frames) * file->bytesPerFrame);
+    madvise((void *)start, end - start, MADV_WILLNEED);
+    
+    if ( !file->zeroCopy ) {
+        UInt64 lastBlock = (frame + frames - 1) / kConversionBlockFrames;
+        for ( UInt64 block = frame / kConversionBlockFrames; block <= lastBlock; block++ ) {
+            AEMappedAudioFileConvertBlock(file, block);
+        }
+    }
+}
+
+#pragma mark - Conversion
+
+static void AEMappedAudioFileConvertBlock(AEMappedAudioFile * file, UInt64 block) {
+    atomic_uchar * state = &file->blockStates[block];
+    if ( atomic_load_explicit(state, memory_order_acquire) == AEMappedAudioFileBlockConverted ) return;
+    
+    unsigned char expected = AEMappedAudioFileBlockUnconverted;
+    if ( atomic_compare_exchange_strong_explicit(state, &expected, AEMappedAudioFileBlockConverting,
+                                                 memory_order_acquire, memory_order_acquire) ) {
+        UInt64 start = block * kConversionBlockFrames;
+        UInt32 frames = (UInt32)MIN((UInt64)kConversionBlockFrames, file->length - start);
+        AEMappedAudioFileConvert(file, file->data + start * file->bytesPerFrame,
+                                 file->converted + start * file->format.channels, frames * file->format.channels);
+        atomic_store_explicit(state, AEMappedAudioFileBlockConverted, memory_order_release);
+    } else {
+        // Another thread is converting this block, which takes a few microseconds
+        while ( atomic_load_explicit(state, memory_order_acquire) != AEMappedAudioFileBlockConverted );
+    }
+}
+
+static void AEMappedAudioFileConvert(const AEMappedAudioFile * file, const UInt8 * source, float * output, UInt32 count) {
+    // Aligned little-endian data goes through vDSP; byte-swapped or unaligned data through loops the compiler vectorizes
+    const BOOL swap = file->format.bigEndian;
+    float scale = 1.0f;
+    switch ( file->format.type ) {
+        case AEMappedAudioFileSampleInt8:
+            vDSP_vflt8((const char *)source, 1, output, 1, count);
+            scale = 1.0f / 128.0f;
+            break;
+            
+        case AEMappedAudioFileSampleUInt8: {
+            vDSP_vfltu8(source, 1, output, 1, count);
+            float offset = -128.0f;
+            vDSP_vsadd(output, 1, &offset, output, 1, count);
+            scale = 1.0f / 128.0f;
+            break;
+        }
+            
+        case AEMappedAudioFileSampleInt16:
+            if ( !swap && ((uintptr_t)source & 1) == 0 ) {
+                vDSP_vflt16((const short *)source, 1, output, 1, count);
+            } else {
+                for ( UInt32 i=0; i<count; i++ ) {
+                    UInt16 value;
+                    memcpy(&value, source + i*2, sizeof(value));
+                    output[i] = (SInt16)(swap ? OSSwapInt16(value) : value);
+                }
+            }
+            scale = 1.0f / 32768.0f;
+            break;
+            
+        case AEMappedAudioFileSampleInt24:
+            for ( UInt32 i=0; i<count; i++ ) {
+                const UInt8 * sample = source + i*3;
+                UInt32 value = swap
+                    ? ((UInt32)sample[0] << 24) | ((UInt32)sample[1] << 16) | ((UInt32)sample[2] << 8)
+                    : ((UInt32)sample[2] << 24) | ((UInt32)sample[1] << 16) | ((UInt32)sample[0] << 8);
+                output[i] = (SInt32)value;
+            }
+            scale = 1.0f / 2147483648.0f;
+            break;
+            
+        case AEMappedAudioFileSampleInt32:
+            if ( !swap && ((uintptr_t)source & 3) == 0 ) {
+                vDSP_vflt32((const int *)source, 1, output, 1, count);
+            } else {
+                for ( UInt32 i=0; i<count; i++ ) {
+                    UInt32 value;
+                    memcpy(&value, source + i*4, sizeof(value));
+                    output[i] = (SInt32)(swap ? OSSwapInt32(value) : value);
+                }
+            }
+            scale = 1.0f / 2147483648.0f;
+            break;
+            
+        case AEMappedAudioFileSampleFloat32:
+            if ( !swap ) {
+                memcpy(output, source, count * sizeof(float));
+            } else {
+                for ( UInt32 i=0; i<count; i++ ) {
+                    UInt32 value;
+                    memcpy(&value, source + i*4, sizeof(value));
+                    value = OSSwapInt32(value);
+                    memcpy(&output[i], &value, sizeof(value));
+                }
+            }
+            break;
+            
+        case AEMappedAudioFileSampleFloat64:
+            if ( !swap && ((uintptr_t)source & 7) == 0 ) {
+                vDSP_vdpsp((const double *)source, 1, output, 1, count);
+            } else {
+                for ( UInt32 i=0; i<count; i++ ) {
+                    UInt64 value;
+                    memcpy(&value, source + i*8, sizeof(value));
+                    if ( swap ) value = OSSwapInt64(value);
+                    double sample;
+                    memcpy(&sample, &value, sizeof(sample));
+                    output[i] = (float)sample;
+                }
+            }
+            break;
+    }
+    
+    if ( scale != 1.0f ) {
+        vDSP_vsmul(output, 1, &scale, output, 1, count);
+    }
+}
+
+static void AEMappedAudioFileDeinterleave(const float * source, int channels, const AudioBufferList * bufferList,
+                                          UInt32 offset, UInt32 frames) {
+    int i = 0;
+    if ( channels == 2 && bufferList->mNumberBuffers >= 2 ) {
+        DSPSplitComplex split = {
+            (float *)bufferList->mBuffers[0].mData + offset,
+            (float *)bufferList->mBuffers[1].mData + offset
+        };
+        vDSP_ctoz((const DSPComplex *)source, 2, &split, 1, frames);
+        i = 2;
+    }
+    
+    for ( ; i<bufferList->mNumberBuffers; i++ ) {
+        // Extra output buffers repeat the last channel
+        int channel = MIN(i, channels-1);
+        float * output = (float *)bufferList->mBuffers[i].mData + offset;
+        if ( channels == 1 ) {
+            memcpy(output, source, frames * sizeof(float));
+        } else {
+            cblas_scopy(frames, source + channel, channels, output, 1);
+        }
+    }
+}
+
+#pragma mark - Container parsing
+
+static inline UInt16 ReadLE16(const UInt8 * p) { return (UInt16)(p[0] | (p[1] << 8)); }
+static inline UInt32 ReadLE32(const UInt8 * p) { return (UInt32)ReadLE16(p) | ((UInt32)ReadLE16(p + 2) << 16); }
+static inline UInt64 ReadLE64(const UInt8 * p) { return (UInt64)ReadLE32(p) | ((UInt64)ReadLE32(p + 4) << 32); }
+static inline UInt16 ReadBE16(const UInt8 * p) { return (UInt16)((p[0] << 8) | p[1]); }
+static inline UInt32 ReadBE32(const UInt8 * p) { return ((UInt32)ReadBE16(p) << 16) | (UInt32)ReadBE16(p + 2); }
+static inline UInt64 ReadBE64(const UInt8 * p) { return ((UInt64)ReadBE32(p) << 32) | (UInt64)ReadBE32(p + 4); }
+
+static double ReadExtended(const UInt8 * p) {
+    // 80-bit IEEE 754 extended precision, as used by AIFF for the sample rate
+    int exponent = ((p[0] & 0x7F) << 8) | p[1];
+    UInt64 mantissa = ReadBE64(p + 2);
+    if ( exponent == 0 && mantissa == 0 ) return 0;
+    double value = ldexp((double)mantissa, exponent - 16383 - 63);
+    return (p[0] & 0x80) ? -value : value;
+}
+
+static BOOL AEMappedAudioFileSetSampleType(AEMappedAudioFileFormat * format, BOOL isFloat, int bytesPerSample, BOOL isUnsigned) {
+    format->bytesPerSample = bytesPerSample;
+    if ( isFloat ) {
+        switch ( bytesPerSample ) {
+            case 4: format->type = AEMappedAudioFileSampleFloat32; return YES;
+            case 8: format->type = AEMappedAudioFileSampleFloat64; return YES;
+            default: return NO;
+        }
+    }
+    switch ( bytesPerSample ) {
+        case 1: format->type = isUnsigned ? AEMappedAudioFileSampleUInt8 : AEMappedAudioFileSampleInt8; return YES;
+        case 2: format->type = AEMappedAudioFileSampleInt16; return YES;
+        case 3: format->type = AEMappedAudioFileSampleInt24; return YES;
+        case 4: format->type = AEMappedAudioFileSampleInt32; return YES;
+        default: return NO;
+    }
+}
+
+static BOOL AEMappedAudioFileParseWAV(const UInt8 * bytes, UInt64 size, AEMappedAudioFileFormat * format) {
+    if ( size < 12 || (memcmp(bytes, "RIFF", 4) != 0 && memcmp(bytes, "RF64", 4) != 0) || memcmp(bytes + 8, "WAVE", 4) != 0 ) {
+        return NO;
+    }
+    
+    BOOL haveFormat = NO, haveData = NO;
+    int formatTag = 0, blockAlign = 0, bitsPerSample = 0;
+    UInt64 ds64DataSize = 0;
+    UInt64 offset = 12;
+    while ( offset + 8 <= size && !(haveFormat && haveData) ) {
+        const UInt8 * chunk = bytes + offset;
+        const UInt8 * body = chunk + 8;
+        UInt64 chunkSize = ReadLE32(chunk + 4);
+        UInt64 available = size - offset - 8;
+        
+        if ( memcmp(chunk, "ds64", 4) == 0 && chunkSize >= 16 && available >= 16 ) {
+            // RF64 sizes
+            ds64DataSize = ReadLE64(body + 8);
+        } else if ( memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16 && available >= 16 ) {
+            formatTag = ReadLE16(body);
+            format->channels = ReadLE16(body + 2);
+            format->sampleRate = ReadLE32(body + 4);
+            blockAlign = ReadLE16(body + 12);
+            bitsPerSample = ReadLE16(body + 14);
+            if ( formatTag == 0xFFFE && chunkSize >= 40 && available >= 40 ) {
+                // WAVE_FORMAT_EXTENSIBLE: the format tag leads the sub-format GUID
+                formatTag = ReadLE16(body + 24);
+            }
+            haveFormat = YES;
+        } else if ( memcmp(chunk, "data", 4) == 0 ) {
+            if ( chunkSize == 0xFFFFFFFF && ds64DataSize ) chunkSize = ds64DataSize;
+            format->dataOffset = offset + 8;
+            format->dataSize = MIN(chunkSize, available);
+            haveData = YES;
+        }
+        
+        offset += 8 + chunkSize + (chunkSize & 1);
+    }
+    
+    if ( !haveFormat || !haveData || format->channels == 0 ) return NO;
+    
+    format->bigEndian = NO;
+    format->length = UINT64_MAX;
+    int bytesPerSample = blockAlign ? blockAlign / format->channels : (bitsPerSample + 7) / 8;
+    switch ( formatTag ) {
+        case 1: return AEMappedAudioFileSetSampleType(format, NO, bytesPerSample, bytesPerSample == 1);
+        case 3: return AEMappedAudioFileSetSampleType(format, YES, bytesPerSample, NO);
+        default: return NO;
+    }
+}
+
+static BOOL AEMappedAudioFileParseAIFF(const UInt8 * bytes, UInt64 size, AEMappedAudioFileFormat * format) {
+    if ( size < 12 || memcmp(bytes, "FORM", 4) != 0 ) return NO;
+    BOOL aifc = memcmp(bytes + 8, "AIFC", 4) == 0;
+    if ( !aifc && memcmp(bytes + 8, "AIFF", 4) != 0 ) return NO;
+    
+    BOOL haveFormat = NO, haveData = NO, isFloat = NO;
+    int bitsPerSample = 0;
+    format->bigEndian = YES;
+    UInt64 offset = 12;
+    while ( offset + 8 <= size && !(haveFormat && haveData) ) {
+        const UInt8 * chunk = bytes + offset;
+        const UInt8 * body = chunk + 8;
+        UInt64 chunkSize = ReadBE32(chunk + 4);
+        UInt64 available = size - offset - 8;
+        
+        if ( memcmp(chunk, "COMM", 4) == 0 && chunkSize >= 18 && available >= 18 ) {
+            format->channels = ReadBE16(body);
+            format->length = ReadBE32(body + 2);
+            bitsPerSample = ReadBE16(body + 6);
+            format->sampleRate = ReadExtended(body + 8);
+            if ( aifc && chunkSize >= 22 && available >= 22 ) {
+                const UInt8 * compression = body + 18;
+                if ( memcmp(compression, "sowt", 4) == 0 ) {
+                    format->bigEndian = NO;
+                } else if ( memcmp(compression, "fl32", 4) == 0 || memcmp(compression, "FL32", 4) == 0 ) {
+                    isFloat = YES;
+                    bitsPerSample = 32;
+                } else if ( memcmp(compression, "fl64", 4) == 0 || memcmp(compression, "FL64", 4) == 0 ) {
+                    isFloat = YES;
+                    bitsPerSample = 64;
+                } else if ( memcmp(compression, "NONE", 4) != 0 && memcmp(compression, "twos", 4) != 0 ) {
+                    return NO;
+                }
+            }
+            haveFormat = YES;
+        } else if ( memcmp(chunk, "SSND", 4) == 0 && chunkSize >= 8 && available >= 8 ) {
+            UInt64 dataOffset = ReadBE32(body);
+            if ( dataOffset > chunkSize - 8 || dataOffset > available - 8 ) return NO;
+            format->dataOffset = offset + 16 + dataOffset;
+            format->dataSize = MIN(chunkSize - 8, available - 8) - dataOffset;
+            haveData = YES;
+        }
+        
+        offset += 8 + chunkSize + (chunkSize & 1);
+    }
+    
+    if ( !haveFormat || !haveData || format->channels == 0 ) return NO;
+    return AEMappedAudioFileSetSampleType(format, isFloat, (bitsPerSample + 7) / 8, NO);
+}
+
+static BOOL AEMappedAudioFileParseCAF(const UInt8 * bytes, UInt64 size, AEMappedAudioFileFormat * format) {
+    if ( size < 8 || memcmp(bytes, "caff", 4) != 0 || ReadBE16(bytes + 4) != 1 ) return NO;
+    
+    BOOL haveFormat = NO, haveData = NO, isFloat = NO;
+    int bytesPerSample = 0;
+    UInt64 offset = 8;
+    while ( offset + 12 <= size && !(haveFormat && haveData) ) {
+        const UInt8 * chunk = bytes + offset;
+        const UInt8 * body = chunk + 12;
+        SInt64 chunkSize = (SInt64)ReadBE64(chunk + 4);
+        UInt64 available = size - offset - 12;
+        
+        if ( memcmp(chunk, "desc", 4) == 0 && chunkSize >= 32 && available >= 32 ) {
+            UInt64 sampleRateBits = ReadBE64(body);
+            memcpy(&format->sampleRate, &sampleRateBits, sizeof(double));
+            UInt32 formatID = ReadBE32(body + 8);
+            UInt32 flags = ReadBE32(body + 12);
+            UInt32 bytesPerPacket = ReadBE32(body + 16);
+            UInt32 framesPerPacket = ReadBE32(body + 20);
+            UInt32 channels = ReadBE32(body + 24);
+            if ( formatID != kAudioFormatLinearPCM || framesPerPacket != 1 || channels == 0 || channels > kMaxChannels ) return NO;
+            format->channels = channels;
+            isFloat = (flags & kCAFLinearPCMFormatFlagIsFloat) != 0;
+            format->bigEndian = (flags & kCAFLinearPCMFormatFlagIsLittleEndian) == 0;
+            bytesPerSample = bytesPerPacket / channels;
+            haveFormat = YES;
+        } else if ( memcmp(chunk, "data", 4) == 0 && available >= 4 ) {
+            // Audio follows a 4-byte edit count; a size of -1 means the data runs to the end of the file
+            format->dataOffset = offset + 12 + 4;
+            format->dataSize = chunkSize < 4 ? available - 4 : MIN((UInt64)chunkSize, available) - 4;
+            haveData = YES;
+        }
+        
+        if ( chunkSize < 0 ) break;
+        offset += 12 + (UInt64)chunkSize;
+    }
+    
+    if ( !haveFormat || !haveData ) return NO;
+    format->length = UINT64_MAX;
+    return AEMappedAudioFileSetSampleType(format, isFloat, bytesPerSample, NO);
+}
+
+static BOOL AEMappedAudioFileParse(const UInt8 * bytes, UInt64 size, AEMappedAudioFileFormat * format) {
+    BOOL (*parsers[])(const UInt8 *, UInt64, AEMappedAudioFileFormat *) = {
+        AEMappedAudioFileParseWAV,
+        AEMappedAudioFileParseAIFF,
+        AEMappedAudioFileParseCAF,
+    };
+    for ( int i=0; i<sizeof(parsers)/sizeof(parsers[0]); i++ ) {
+        memset(format, 0, sizeof(AEMappedAudioFileFormat));
+        if ( parsers[i](bytes, size, format) ) {
+            return format->sampleRate > 0 && format->channels > 0 && format->channels <= kMaxChannels;
+        }
+    }
+    return NO;
+}
+
+static void AEMappedAudioFileSetError(NSError ** error, NSString * domain, NSInteger code, NSString * description) {
+    if ( error ) *error = [NSError errorWithDomain:domain code:code userInfo:@{NSLocalizedDescriptionKey: description}];
+}
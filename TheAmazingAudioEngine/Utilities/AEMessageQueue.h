@@ -109,6 +109,26 @@ extern AEArgument AEArgumentNone;
 //! Block
 typedef void (^AEMessageQueueBlock)(void);
 
+/*!
+ * Message channel identifier
+ *
+ *  Identifies a handler registered with registerMainThreadChannelWithHandler:context: or
+ *  registerAudioThreadChannelWithHandler:context:. Zero is never a valid channel.
+ */
+typedef uint16_t AEMessageQueueChannel;
+
+/*!
+ * Message channel handler
+ *
+ *  Called with a pointer to the copy of the payload that was sent, which is only valid for
+ *  the duration of the call.
+ *
+ * @param context The context pointer given at registration
+ * @param payload The message payload (or NULL if none was sent)
+ * @param length Length of the payload, in bytes
+ */
+typedef void (*AEMessageQueueChannelHandler)(void * _Nullable context, const void * _Nullable payload, size_t length);
+
 /*!
  * Message Queue
  *
@@ -121,6 +141,8 @@ typedef void (^AEMessageQueueBlock)(void);
  *
  *  Then, use AEMessageQueuePerformSelectorOnMainThread from the audio thread, or
  *  performBlockOnAudioThread: or performBlockOnAudioThread:completionBlock: from the main thread.
+ *  For high-rate messaging, register a message channel with a C handler function and send
+ *  with AEMessageQueueSendToMainThread or AEMessageQueueSendToAudioThread instead.
  */
 @interface AEMessageQueue : NSObject
 
@@ -183,6 +205,72 @@ BOOL AEMessageQueuePerformSelectorOnMainThread(__unsafe_unretained AEMessageQueu
                                                SEL _Nonnull selector,
                                                AEArgument arguments, ...);
 
+/*!
+ * Register a handler for messages sent to the main thread
+ *
+ *  Channels are a lightweight alternative to AEMessageQueuePerformSelectorOnMainThread for
+ *  frequent messages: the payload is copied straight into the message buffer without any memory
+ *  allocation, and the handler is called directly, with no selector lookup or NSInvocation.
+ *  Send messages with AEMessageQueueSendToMainThread.
+ *
+ *  Register channels up front, before sending any messages on them.
+ *
+ * @param handler The C function to call on the main thread for each message
+ * @param context A context pointer to pass to the handler
+ * @return The new channel, or 0 if no more channels are available
+ */
+- (AEMessageQueueChannel)registerMainThreadChannelWithHandler:(AEMessageQueueChannelHandler _Nonnull)handler
+                                                      context:(void * _Nullable)context;
+
+/*!
+ * Register a handler for messages sent to the audio thread
+ *
+ *  The audio-thread counterpart to registerMainThreadChannelWithHandler:context:. The handler
+ *  is called on the realtime thread from AEMessageQueuePoll, so the same restrictions apply as
+ *  for blocks given to performBlockOnAudioThread:. Send messages with AEMessageQueueSendToAudioThread.
+ *
+ * @param handler The C function to call on the realtime thread for each message
+ * @param context A context pointer to pass to the handler
+ * @return The new channel, or 0 if no more channels are available
+ */
+- (AEMessageQueueChannel)registerAudioThreadChannelWithHandler:(AEMessageQueueChannelHandler _Nonnull)handler
+                                                       context:(void * _Nullable)context;
+
+/*!
+ * Send a message to a main thread channel
+ *
+ *  Use this on the realtime thread. The payload is copied, and the channel's handler
+ *  will be called with the copy on the main thread.
+ *
+ * @param messageQueue The message queue instance
+ * @param channel A channel returned from registerMainThreadChannelWithHandler:context:
+ * @param payload Payload data (or NULL) to copy
+ * @param length Length of payload data
+ * @return YES on success, or NO if out of buffer space or the channel isn't a registered main thread channel
+ */
+BOOL AEMessageQueueSendToMainThread(__unsafe_unretained AEMessageQueue * _Nonnull messageQueue,
+                                    AEMessageQueueChannel channel,
+                                    const void * _Nullable payload,
+                                    size_t length);
+
+/*!
+ * Send a message to an audio thread channel
+ *
+ *  Use this on the main thread. The payload is copied, and the channel's handler
+ *  will be called with the copy on the realtime thread at the next poll interval.
+ *  Messages sent this way take part in message groups (see beginMessageGroup).
+ *
+ * @param messageQueue The message queue instance
+ * @param channel A channel returned from registerAudioThreadChannelWithHandler:context:
+ * @param payload Payload data (or NULL) to copy
+ * @param length Length of payload data
+ * @return YES on success, or NO if out of buffer space or the channel isn't a registered audio thread channel
+ */
+BOOL AEMessageQueueSendToAudioThread(__unsafe_unretained AEMessageQueue * _Nonnull messageQueue,
+                                     AEMessageQueueChannel channel,
+                                     const void * _Nullable payload,
+                                     size_t length);
+
 /*!
  * Begins a group of messages to be performed consecutively.
  *
@@ -27,12 +27,17 @@
 #import "AEMessageQueue.h"
 #import "AEMainThreadEndpoint.h"
 #import "AEAudioThreadEndpoint.h"
+#import "AEUtilities.h"
+#import <stdatomic.h>
 
 AEArgument AEArgumentNone = {NO, NULL, 0};
 
+#define kMaxChannels 64
+
 typedef enum {
     AEMessageQueueMainThreadMessage,
     AEMessageQueueAudioThreadMessage,
+    AEMessageQueueChannelMessage,
 } AEMessageQueueMessageType;
 
 // Audio thread message type
@@ -55,11 +60,40 @@ typedef struct {
     BOOL isValue;  // Whether to pass by value
 } main_thread_message_arg_t; // Data follows
 
-@interface AEMessageQueue ()
+// Channel message type
+typedef struct {
+    AEMessageQueueMessageType type;
+    AEMessageQueueChannel channel;
+} channel_message_t; // Payload follows
+
+// Registered channel
+typedef struct {
+    AEMessageQueueChannelHandler handler;
+    void * context;
+    BOOL audioThread;
+} channel_t;
+
+// Registered channels
+typedef struct {
+    channel_t channels[kMaxChannels];
+    _Atomic(int) count;
+} channel_table_t;
+
+@interface AEMessageQueue () {
+    channel_table_t * _channelTable;
+}
+@property (nonatomic, strong) NSMutableData * channelTableStorage;
 @property (nonatomic, strong) AEMainThreadEndpoint * mainThreadEndpoint;
 @property (nonatomic, strong) AEAudioThreadEndpoint * audioThreadEndpoint;
 @end
 
+static inline const channel_t * AEMessageQueueGetChannel(channel_table_t * table, AEMessageQueueChannel channel, BOOL audioThread) {
+    // Acquire pairs with the release in registerChannelWithHandler:, so the entry is fully visible
+    if ( channel == 0 || channel > atomic_load_explicit(&table->count, memory_order_acquire) ) return NULL;
+    const channel_t * entry = &table->channels[channel - 1];
+    return entry->audioThread == audioThread ? entry : NULL;
+}
+
 @implementation AEMessageQueue
 
 - (instancetype)init {
@@ -69,10 +103,27 @@ typedef struct {
 - (instancetype)initWithBufferCapacity:(size_t)bufferCapacity {
     if ( !(self = [super init]) ) return nil;
     
+    // The channel table is shared with the endpoints' handlers, which may outlive us: a pending
+    // main thread service pass keeps its endpoint alive. The handlers hold on to the storage, so the
+    // table is freed along with the last of the queue and its endpoints
+    NSMutableData * channelTableStorage = [NSMutableData dataWithLength:sizeof(channel_table_t)];
+    channel_table_t * channelTable = channelTableStorage.mutableBytes;
+    self.channelTableStorage = channelTableStorage;
+    _channelTable = channelTable;
+    
     // Create main thread endpoint
     self.mainThreadEndpoint = [[AEMainThreadEndpoint alloc] initWithHandler:^(const void * _Nullable data, size_t length) {
+        (void)channelTableStorage;
         const AEMessageQueueMessageType * type = (AEMessageQueueMessageType *)data;
-        if ( *type == AEMessageQueueMainThreadMessage ) {
+        if ( *type == AEMessageQueueChannelMessage ) {
+            // Call channel handler directly
+            const channel_message_t * message = (const channel_message_t *)data;
+            const channel_t * channel = AEMessageQueueGetChannel(channelTable, message->channel, NO);
+            if ( !channel ) return;
+            size_t payloadLength = length - sizeof(channel_message_t);
+            channel->handler(channel->context, payloadLength > 0 ? message + 1 : NULL, payloadLength);
+            
+        } else if ( *type == AEMessageQueueMainThreadMessage ) {
             const main_thread_message_t * message = (const main_thread_message_t *)data;
             id target = message->target;
             const char * selectorString = ((const char *)data) + sizeof(main_thread_message_t);
@@ -122,6 +173,17 @@ typedef struct {
     // Create audio thread endpoint
     AEMainThreadEndpoint * mainThread = _mainThreadEndpoint;
     self.audioThreadEndpoint = [[AEAudioThreadEndpoint alloc] initWithHandler:^(const void * _Nullable data, size_t length) {
+        (void)channelTableStorage;
+        if ( *(const AEMessageQueueMessageType *)data == AEMessageQueueChannelMessage ) {
+            // Call channel handler; nothing to clean up afterwards
+            const channel_message_t * message = (const channel_message_t *)data;
+            const channel_t * channel = AEMessageQueueGetChannel(channelTable, message->channel, YES);
+            if ( !channel ) return;
+            size_t payloadLength = length - sizeof(channel_message_t);
+            channel->handler(channel->context, payloadLength > 0 ? message + 1 : NULL, payloadLength);
+            return;
+        }
+        
         // Call block
         const audio_thread_message_t * message = (const audio_thread_message_t *)data;
         message->block();
@@ -216,6 +278,86 @@ BOOL AEMessageQueuePerformSelectorOnMainThread(__unsafe_unretained AEMessageQueu
     return YES;
 }
 
+- (AEMessageQueueChannel)registerMainThreadChannelWithHandler:(AEMessageQueueChannelHandler)handler context:(void *)context {
+    return [self registerChannelWithHandler:handler context:context audioThread:NO];
+}
+
+- (AEMessageQueueChannel)registerAudioThreadChannelWithHandler:(AEMessageQueueChannelHandler)handler context:(void *)context {
+    return [self registerChannelWithHandler:handler context:context audioThread:YES];
+}
+
+- (AEMessageQueueChannel)registerChannelWithHandler:(AEMessageQueueChannelHandler)handler context:(void *)context audioThread:(BOOL)audioThread {
+    int count = atomic_load_explicit(&_channelTable->count, memory_order_relaxed);
+    if ( count == kMaxChannels ) {
+        NSLog(@"AEMessageQueue: No more channels available");
+        return 0;
+    }
+    
+    // Entries are never reused, so the table can be read from either thread without locking, once
+    // the count that covers them has been published
+    _channelTable->channels[count] = (channel_t){ .handler = handler, .context = context, .audioThread = audioThread };
+    atomic_store_explicit(&_channelTable->count, count + 1, memory_order_release);
+    return count + 1;
+}
+
+BOOL AEMessageQueueSendToMainThread(__unsafe_unretained AEMessageQueue * THIS,
+                                    AEMessageQueueChannel channel,
+                                    const void * payload,
+                                    size_t length) {
+    if ( !AEMessageQueueGetChannel(THIS->_channelTable, channel, NO) ) {
+        // Not a registered main thread channel: drop the message
+        #ifdef DEBUG
+        if ( AERateLimit() ) printf("%s: Invalid channel %d\n", __FUNCTION__, (int)channel);
+        #endif
+        return NO;
+    }
+    
+    // Create message
+    channel_message_t * message = AEMainThreadEndpointCreateMessage(THIS->_mainThreadEndpoint, sizeof(channel_message_t) + length);
+    if ( !message ) return NO;
+    
+    // Write header and payload
+    message->type = AEMessageQueueChannelMessage;
+    message->channel = channel;
+    if ( length ) {
+        memcpy(message + 1, payload, length);
+    }
+    
+    // Dispatch
+    AEMainThreadEndpointDispatchMessage(THIS->_mainThreadEndpoint);
+    
+    return YES;
+}
+
+BOOL AEMessageQueueSendToAudioThread(__unsafe_unretained AEMessageQueue * THIS,
+                                     AEMessageQueueChannel channel,
+                                     const void * payload,
+                                     size_t length) {
+    if ( !AEMessageQueueGetChannel(THIS->_channelTable, channel, YES) ) {
+        // Not a registered audio thread channel: drop the message
+        #ifdef DEBUG
+        if ( AERateLimit() ) printf("%s: Invalid channel %d\n", __FUNCTION__, (int)channel);
+        #endif
+        return NO;
+    }
+    
+    // Create message
+    channel_message_t * message = AEAudioThreadEndpointCreateMessage(THIS->_audioThreadEndpoint, sizeof(channel_message_t) + length);
+    if ( !message ) return NO;
+    
+    // Write header and payload
+    message->type = AEMessageQueueChannelMessage;
+    message->channel = channel;
+    if ( length ) {
+        memcpy(message + 1, payload, length);
+    }
+    
+    // Dispatch
+    AEAudioThreadEndpointDispatchMessage(THIS->_audioThreadEndpoint);
+    
+    return YES;
+}
+
 - (void)beginMessageGroup {
     [self.audioThreadEndpoint beginMessageGroup];
 }
@@ -0,0 +1,138 @@
+//
+//  AEProgressiveAudioFileLoader.h
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#import <Foundation/Foundation.h>
+#import <AudioToolbox/AudioToolbox.h>
+
+@class AEProgressiveAudioFileLoader;
+
+typedef void (^AEProgressiveAudioFileLoaderCompletionBlock)(NSError * _Nullable error);
+
+/*!
+ * Progressive audio file loader
+ *
+ *  This utility decodes an audio file into memory in the background, while making the audio
+ *  decoded so far available to the realtime thread. Players may begin playback straight away,
+ *  and read up to the valid-frame watermark, which only ever advances.
+ *
+ *  The file is divided into independent chunks of a couple of seconds each, which are decoded
+ *  in parallel on several worker threads. Workers take chunks in order, so the front of the file
+ *  is always decoded first, and the watermark advances over each chunk as soon as all chunks
+ *  before it are complete. PCM files are read straight from a memory-mapped file
+ *  (see AEMappedAudioFile); compressed files are decoded by a separate ExtAudioFile per worker,
+ *  each of which decodes and discards a short preroll before its chunk so that the decoder
+ *  state has settled. Files which need sample rate conversion are decoded sequentially on a
+ *  single worker, as the converter's state spans the whole file.
+ *
+ *  Audio is provided in the standard non-interleaved float format, with the file's channel count,
+ *  at the sample rate given on creation. The audio buffer is allocated up front, and remains
+ *  valid for the lifetime of the loader.
+ */
+@interface AEProgressiveAudioFileLoader : NSObject
+
+/*!
+ * Begin loading a file
+ *
+ *  Opens the file and allocates the audio buffer synchronously, then begins decoding in the
+ *  background. The completion block is called on the main thread once the whole file has been
+ *  decoded, or when an error occurs. The loader is retained while loading.
+ *
+ * @param path Path to the audio file to load
+ * @param sampleRate The sample rate to provide audio at, or 0 to use the file's own rate
+ * @param block Block to call when loading finishes, or NULL
+ * @param error If not NULL, the error on output, if the file couldn't be opened
+ * @return The loader, or nil on error
+ */
++ (instancetype _Nullable)loadFileAtPath:(NSString * _Nonnull)path
+                              sampleRate:(double)sampleRate
+                         completionBlock:(AEProgressiveAudioFileLoaderCompletionBlock _Nullable)block
+                                   error:(NSError * _Nullable * _Nullable)error;
+
+/*!
+ * Cancel loading
+ *
+ *  Stops the workers at their next read; the completion block will not be called. Audio
+ *  below the watermark remains valid.
+ */
+- (void)cancel;
+
+/*!
+ * Get the number of valid frames
+ *
+ *  Frames below this watermark have been fully decoded, and may be read freely. The value only
+ *  ever increases.
+ *
+ *  For use on the realtime thread.
+ *
+ * @param loader The loader
+ * @param outFinished If not NULL, on output whether loading has finished, in which case the
+ *  watermark is the final length of the audio
+ * @return The number of valid frames from the start of the audio
+ */
+UInt32 AEProgressiveAudioFileLoaderGetValidFrames(__unsafe_unretained AEProgressiveAudioFileLoader * _Nonnull loader,
+                                                  BOOL * _Nullable outFinished);
+
+/*!
+ * Get the audio buffer
+ *
+ *  For use on the realtime thread.
+ *
+ * @param loader The loader
+ * @return The audio buffer, of which the first AEProgressiveAudioFileLoaderGetValidFrames frames are valid
+ */
+const AudioBufferList * _Nonnull AEProgressiveAudioFileLoaderGetAudio(__unsafe_unretained AEProgressiveAudioFileLoader * _Nonnull loader);
+
+//! The path of the file
+@property (nonatomic, strong, readonly) NSString * _Nonnull path;
+
+//! The audio buffer
+@property (nonatomic, readonly) const AudioBufferList * _Nonnull audio;
+
+//! The audio description of the buffer
+@property (nonatomic, readonly) AudioStreamBasicDescription audioDescription;
+
+//! The expected length of the audio, in frames; the final length may be shorter, if the file's reported length was an estimate
+@property (nonatomic, readonly) UInt32 capacity;
+
+//! The number of valid frames
+@property (nonatomic, readonly) UInt32 validFrames;
+
+//! Whether loading has finished
+@property (nonatomic, readonly) BOOL finished;
+
+//! The number of worker threads decoding the file
+@property (nonatomic, readonly) int numberOfWorkers;
+
+@end
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,340 @@
+//
+//  AEProgressiveAudioFileLoader.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+
+#import "AEProgressiveAudioFileLoader.h"
+#import "AEMappedAudioFile.h"
+#import "AEAudioBufferListUtilities.h"
+#import "AEUtilities.h"
+#import "AETypes.h"
+#import <stdatomic.h>
+#import <pthread.h>
+
+static const double kChunkDuration = 2.0;
+static const UInt32 kReadBlockFrames = 4096;
+static const UInt32 kPrerollFrames = 4096;
+
+@interface AEProgressiveAudioFileLoader () {
+    AudioBufferList * _audio;
+    AEMappedAudioFile * _mappedFile;
+    double _fileSampleRate;
+    
+    // Chunk bookkeeping, guarded by the mutex
+    pthread_mutex_t _mutex;
+    UInt32 _chunkFrames;
+    UInt32 _chunkCount;
+    UInt32 * _chunkProgress;
+    BOOL * _chunkDone;
+    UInt32 _frontChunk;
+    NSError * _error;
+    
+    atomic_uint _nextChunk;
+    atomic_uint _validFrames;
+    atomic_bool _finished;
+    atomic_bool _cancelled;
+}
+@property (nonatomic, strong, readwrite) NSString * path;
+@end
+
+@implementation AEProgressiveAudioFileLoader
+
++ (instancetype)loadFileAtPath:(NSString *)path sampleRate:(double)sampleRate
+               completionBlock:(AEProgressiveAudioFileLoaderCompletionBlock)block error:(NSError **)error {
+    AEProgressiveAudioFileLoader * loader = [[self alloc] initWithPath:path sampleRate:sampleRate error:error];
+    if ( !loader ) return nil;
+    [loader startWithCompletionBlock:block];
+    return loader;
+}
+
+- (instancetype)initWithPath:(NSString *)path sampleRate:(double)sampleRate error:(NSError **)error {
+    if ( !(self = [super init]) ) return nil;
+    
+    self.path = path;
+    
+    // Inspect the file, preferring direct access to PCM files
+    UInt64 fileLength = 0;
+    _mappedFile = AEMappedAudioFileOpen(path, NULL);
+    if ( _mappedFile ) {
+        _fileSampleRate = AEMappedAudioFileGetSampleRate(_mappedFile);
+        _audioDescription = AEAudioDescriptionWithChannelsAndRate(AEMappedAudioFileGetNumberOfChannels(_mappedFile), _fileSampleRate);
+        fileLength = AEMappedAudioFileGetLength(_mappedFile);
+    } else {
+        AudioStreamBasicDescription fileFormat;
+        if ( !AEExtAudioFileInspect([NSURL fileURLWithPath:path], &fileFormat, &fileLength, error) ) return nil;
+        _fileSampleRate = fileFormat.mSampleRate;
+        _audioDescription = AEAudioDescriptionWithChannelsAndRate(fileFormat.mChannelsPerFrame, _fileSampleRate);
+    }
+    
+    if ( sampleRate > 0 && fabs(sampleRate - _fileSampleRate) > DBL_EPSILON ) {
+        // Sample rate conversion is performed by ExtAudioFile
+        if ( _mappedFile ) {
+            AEMappedAudioFileClose(_mappedFile);
+            _mappedFile = NULL;
+        }
+        _audioDescription.mSampleRate = sampleRate;
+        fileLength = (UInt64)ceil(fileLength * (sampleRate / _fileSampleRate));
+    }
+    
+    if ( fileLength == 0 || fileLength > UINT32_MAX ) {
+        if ( error )
+        *error = [NSError errorWithDomain:NSOSStatusErrorDomain code:-50
+                                 userInfo:@{NSLocalizedDescriptionKey: fileLength == 0
+                                            ? NSLocalizedString(@"This audio file is empty", @"")
+                                            : NSLocalizedString(@"This audio file is too long to load", @"")}];
+        return nil;
+    }
+    
+    _capacity = (UInt32)fileLength;
+    _audio = AEAudioBufferListCreateWithFormat(_audioDescription, _capacity);
+    if ( !_audio ) {
+        if ( error )
+        *error = [NSError errorWithDomain:NSOSStatusErrorDomain code:kAudio_MemFullError
+                                 userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"Not enough memory to load this audio file", @"")}];
+        return nil;
+    }
+    
+    // Divide the file into chunks; with sample rate conversion, the whole file is one chunk
+    BOOL parallel = fabs(_audioDescription.mSampleRate - _fileSampleRate) <= DBL_EPSILON;
+    _chunkFrames = parallel ? (UInt32)MIN(_capacity, round(kChunkDuration * _audioDescription.mSampleRate)) : _capacity;
+    _chunkCount = (UInt32)(((UInt64)_capacity + _chunkFrames - 1) / _chunkFrames);
+    _chunkProgress = calloc(_chunkCount, sizeof(UInt32));
+    _chunkDone = calloc(_chunkCount, sizeof(BOOL));
+    _numberOfWorkers = (int)MIN((NSUInteger)_chunkCount, MAX((NSUInteger)1, [NSProcessInfo processInfo].activeProcessorCount));
+    
+    pthread_mutex_init(&_mutex, NULL);
+    atomic_init(&_nextChunk, 0);
+    atomic_init(&_validFrames, 0);
+    atomic_init(&_finished, false);
+    atomic_init(&_cancelled, false);
+    
+    return self;
+}
+
+- (void)dealloc {
+    if ( _mappedFile ) {
+        AEMappedAudioFileClose(_mappedFile);
+    }
+    if ( _audio ) {
+        AEAudioBufferListFree(_audio);
+    }
+    free(_chunkProgress);
+    free(_chunkDone);
+    pthread_mutex_destroy(&_mutex);
+}
+
+- (void)startWithCompletionBlock:(AEProgressiveAudioFileLoaderCompletionBlock)block {
+    dispatch_queue_t queue = dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0);
+    dispatch_async(queue, ^{
+        // Each worker takes the next chunk in order until none remain
+        dispatch_apply(self.numberOfWorkers, queue, ^(size_t worker) {
+            [self runWorker];
+        });
+        
+        if ( atomic_load_explicit(&self->_cancelled, memory_order_relaxed) ) return;
+        
+        pthread_mutex_lock(&self->_mutex);
+        NSError * error = self->_error;
+        pthread_mutex_unlock(&self->_mutex);
+        
+        atomic_store_explicit(&self->_finished, true, memory_order_release);
+        
+        if ( block ) {
+            dispatch_async(dispatch_get_main_queue(), ^{
+                block(error);
+            });
+        }
+    });
+}
+
+- (void)cancel {
+    atomic_store_explicit(&_cancelled, true, memory_order_relaxed);
+}
+
+UInt32 AEProgressiveAudioFileLoaderGetValidFrames(__unsafe_unretained AEProgressiveAudioFileLoader * THIS,
+                                                  BOOL * outFinished) {
+    if ( outFinished ) *outFinished = atomic_load_explicit(&THIS->_finished, memory_order_acquire);
+    return atomic_load_explicit(&THIS->_validFrames, memory_order_acquire);
+}
+
+const AudioBufferList * AEProgressiveAudioFileLoaderGetAudio(__unsafe_unretained AEProgressiveAudioFileLoader * THIS) {
+    return THIS->_audio;
+}
+
+- (const AudioBufferList *)audio {
+    return _audio;
+}
+
+- (UInt32)validFrames {
+    return AEProgressiveAudioFileLoaderGetValidFrames(self, NULL);
+}
+
+- (BOOL)finished {
+    return atomic_load_explicit(&_finished, memory_order_acquire);
+}
+
+#pragma mark - Workers
+
+- (void)runWorker {
+    ExtAudioFileRef audioFile = NULL;
+    AudioBufferList * preroll = NULL;
+    
+    if ( !_mappedFile ) {
+        // Each worker decodes with its own converter
+        NSError * error = nil;
+        AudioStreamBasicDescription clientFormat;
+        audioFile = AEExtAudioFileOpen([NSURL fileURLWithPath:self.path], &clientFormat, NULL, &error);
+        if ( audioFile && fabs(_audioDescription.mSampleRate - clientFormat.mSampleRate) > DBL_EPSILON ) {
+            clientFormat.mSampleRate = _audioDescription.mSampleRate;
+            OSStatus result = ExtAudioFileSetProperty(audioFile, kExtAudioFileProperty_ClientDataFormat,
+                                                      sizeof(clientFormat), &clientFormat);
+            if ( !AECheckOSStatus(result, "ExtAudioFileSetProperty(kExtAudioFileProperty_ClientDataFormat)") ) {
+                error = [NSError errorWithDomain:NSOSStatusErrorDomain code:result
+                                        userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"Couldn't convert the audio file", @"")}];
+                ExtAudioFileDispose(audioFile);
+                audioFile = NULL;
+            }
+        }
+        if ( !audioFile ) {
+            [self failWithError:error];
+            return;
+        }
+        preroll = AEAudioBufferListCreateWithFormat(_audioDescription, kReadBlockFrames);
+    }
+    
+    while ( !atomic_load_explicit(&_cancelled, memory_order_relaxed) ) {
+        UInt32 chunk = atomic_fetch_add_explicit(&_nextChunk, 1, memory_order_relaxed);
+        if ( chunk >= _chunkCount ) break;
+        
+        NSError * error = nil;
+        if ( !(audioFile
+               ? [self decodeChunk:chunk audioFile:audioFile preroll:preroll error:&error]
+               : [self readMappedChunk:chunk]) ) {
+            if ( error ) [self failWithError:error];
+            break;
+        }
+    }
+    
+    if ( audioFile ) {
+        ExtAudioFileDispose(audioFile);
+        AEAudioBufferListFree(preroll);
+    }
+}
+
+- (BOOL)readMappedChunk:(UInt32)chunk {
+    UInt32 start = chunk * _chunkFrames;
+    UInt32 end = MIN(_capacity, start + _chunkFrames);
+    UInt32 position = start;
+    while ( position < end ) {
+        if ( atomic_load_explicit(&_cancelled, memory_order_relaxed) ) return NO;
+        AEAudioBufferListCopyOnStackWithByteOffset(target, _audio, position * sizeof(float));
+        UInt32 frames = AEMappedAudioFileRead(_mappedFile, target, position, MIN(kReadBlockFrames, end - position));
+        if ( frames == 0 ) break;
+        position += frames;
+        if ( position < end ) [self updateChunk:chunk progress:position - start done:NO];
+    }
+    [self updateChunk:chunk progress:position - start done:YES];
+    return YES;
+}
+
+- (BOOL)decodeChunk:(UInt32)chunk audioFile:(ExtAudioFileRef)audioFile preroll:(AudioBufferList *)preroll
+              error:(NSError **)error {
+    UInt32 start = chunk * _chunkFrames;
+    UInt32 end = MIN(_capacity, start + _chunkFrames);
+    
+    // Seek a little before the chunk, and decode up to its start, so that the decoder's
+    // state matches that of a straight-through decode by the time we reach the chunk
+    UInt32 prerollFrames = MIN(start, kPrerollFrames);
+    OSStatus result = ExtAudioFileSeek(audioFile, start - prerollFrames);
+    if ( !AECheckOSStatus(result, "ExtAudioFileSeek") ) {
+        *error = [NSError errorWithDomain:NSOSStatusErrorDomain code:result
+                                 userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"Couldn't read the audio file", @"")}];
+        return NO;
+    }
+    while ( prerollFrames > 0 ) {
+        UInt32 frames = prerollFrames;
+        AEAudioBufferListSetLength(preroll, frames);
+        result = ExtAudioFileRead(audioFile, &frames, preroll);
+        if ( !AECheckOSStatus(result, "ExtAudioFileRead") ) {
+            *error = [NSError errorWithDomain:NSOSStatusErrorDomain code:result
+                                     userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"Couldn't read the audio file", @"")}];
+            return NO;
+        }
+        if ( frames == 0 ) break;
+        prerollFrames -= frames;
+    }
+    
+    UInt32 position = start;
+    while ( position < end ) {
+        if ( atomic_load_explicit(&_cancelled, memory_order_relaxed) ) return NO;
+        AEAudioBufferListCopyOnStackWithByteOffset(target, _audio, position * sizeof(float));
+        UInt32 frames = MIN(kReadBlockFrames, end - position);
+        AEAudioBufferListSetLength(target, frames);
+        result = ExtAudioFileRead(audioFile, &frames, target);
+        if ( !AECheckOSStatus(result, "ExtAudioFileRead") ) {
+            *error = [NSError errorWithDomain:NSOSStatusErrorDomain code:result
+                                     userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"Couldn't read the audio file", @"")}];
+            return NO;
+        }
+        if ( frames == 0 ) break;
+        position += frames;
+        if ( position < end ) [self updateChunk:chunk progress:position - start done:NO];
+    }
+    [self updateChunk:chunk progress:position - start done:YES];
+    return YES;
+}
+
+- (void)updateChunk:(UInt32)chunk progress:(UInt32)progress done:(BOOL)done {
+    pthread_mutex_lock(&_mutex);
+    _chunkProgress[chunk] = progress;
+    _chunkDone[chunk] = done;
+    
+    // Advance the watermark through the contiguous run of decoded audio from the start
+    UInt32 validFrames = atomic_load_explicit(&_validFrames, memory_order_relaxed);
+    while ( _frontChunk < _chunkCount ) {
+        UInt32 chunkStart = _frontChunk * _chunkFrames;
+        validFrames = chunkStart + _chunkProgress[_frontChunk];
+        if ( !_chunkDone[_frontChunk] ) break;
+        if ( _chunkProgress[_frontChunk] < MIN(_chunkFrames, _capacity - chunkStart) ) {
+            // The audio ended early (the file's length was an estimate): nothing after this is valid
+            _frontChunk = _chunkCount;
+            break;
+        }
+        _frontChunk++;
+    }
+    atomic_store_explicit(&_validFrames, validFrames, memory_order_release);
+    pthread_mutex_unlock(&_mutex);
+}
+
+- (void)failWithError:(NSError *)error {
+    pthread_mutex_lock(&_mutex);
+    if ( !_error ) _error = error;
+    pthread_mutex_unlock(&_mutex);
+    
+    // Stop the other workers from taking more chunks
+    atomic_store_explicit(&_nextChunk, _chunkCount, memory_order_relaxed);
+}
+
+@end
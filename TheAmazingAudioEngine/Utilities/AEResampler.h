@@ -0,0 +1,210 @@
+//
+//  AEResampler.h
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#import <Foundation/Foundation.h>
+#import <AudioToolbox/AudioToolbox.h>
+
+/*!
+ * Resampler quality
+ *
+ *  The linear and cubic tiers interpolate between neighbouring input frames without any
+ *  anti-aliasing filter: they are very cheap, and suit varispeed effects with many simultaneous
+ *  sources, but they alias when the ratio is above 1 and attenuate high frequencies.
+ *
+ *  The remaining tiers are band-limited windowed-sinc filters. Higher tiers use longer filters, for a
+ *  narrower transition band and more stopband attenuation, at the cost of CPU and lookahead (half the
+ *  filter length, in input frames). When downsampling, the filter is lengthened in proportion to the
+ *  ratio, to maintain the same quality.
+ */
+typedef enum {
+    AEResamplerQualityLinear, //!< Linear interpolation, from 2 input frames
+    AEResamplerQualityCubic,  //!< Cubic Hermite (Catmull-Rom) interpolation, from 4 input frames
+    AEResamplerQualityLow,    //!< 8-tap filter: lowest CPU and latency, for previews or many simultaneous voices
+    AEResamplerQualityMedium, //!< 16-tap filter
+    AEResamplerQualityHigh,   //!< 32-tap filter: transparent for most material
+    AEResamplerQualityBest,   //!< 64-tap filter: for offline conversion
+} AEResamplerQuality;
+
+/*!
+ * Resampler
+ *
+ *  A windowed-sinc polyphase sample rate converter, which works on non-interleaved float audio.
+ *  Linear and cubic interpolation are also available, through AEResamplerQualityLinear and
+ *  AEResamplerQualityCubic; these are evaluated for blocks of output frames at a time.
+ *
+ *  For conversion between fixed rates, the resampler precomputes one filter for every phase
+ *  required by the conversion ratio, so no interpolation is needed at render time. For arbitrary
+ *  ratios, or ratios that change during streaming, create the resampler with
+ *  AEResamplerNewWithVariableRatio: coefficients are then interpolated from a finely-spaced filter bank.
+ *  Inner products are performed with vDSP.
+ *
+ *  The resampler is realtime-safe once created: it can be driven directly from the render thread.
+ *  To convert the rate of a sub-renderer within a render loop, see AESampleRateConverterModule.
+ */
+typedef struct AEResampler_t AEResampler;
+
+/*!
+ * Create a resampler for a fixed conversion
+ *
+ * @param inputRate Input sample rate
+ * @param outputRate Output sample rate
+ * @param channels Number of channels
+ * @param quality Quality tier
+ * @return The new resampler, or NULL on error
+ */
+AEResampler * _Nullable AEResamplerNew(double inputRate, double outputRate, int channels, AEResamplerQuality quality);
+
+/*!
+ * Create a resampler with a variable conversion ratio
+ *
+ *  Use AEResamplerSetRatio to change the ratio at any time, including during rendering.
+ *
+ * @param ratio Initial ratio, in input frames per output frame (input rate / output rate)
+ * @param maximumRatio The largest ratio that will be used. For the windowed-sinc tiers, the filter's
+ *      cutoff follows the current ratio, and enough input is buffered for the filter at this ratio,
+ *      so ratios larger than this will alias.
+ * @param channels Number of channels
+ * @param quality Quality tier
+ * @return The new resampler, or NULL on error
+ */
+AEResampler * _Nullable AEResamplerNewWithVariableRatio(double ratio, double maximumRatio, int channels, AEResamplerQuality quality);
+
+/*!
+ * Free a resampler
+ *
+ * @param resampler The resampler
+ */
+void AEResamplerFree(AEResampler * _Nonnull resampler);
+
+/*!
+ * Set the conversion ratio of a variable-ratio resampler
+ *
+ *  This function is realtime-safe. It can only be used with resamplers created with
+ *  AEResamplerNewWithVariableRatio.
+ *
+ * @param resampler The resampler
+ * @param ratio The ratio, in input frames per output frame (input rate / output rate)
+ */
+void AEResamplerSetRatio(AEResampler * _Nonnull resampler, double ratio);
+
+/*!
+ * Get the current conversion ratio
+ *
+ * @param resampler The resampler
+ * @return The ratio, in input frames per output frame
+ */
+double AEResamplerGetRatio(AEResampler * _Nonnull resampler);
+
+/*!
+ * Get the resampler's lookahead
+ *
+ *  This is the number of input frames beyond an output frame's position that are needed to render
+ *  that frame. Output is aligned with input: output frame n corresponds to input time n * ratio, so
+ *  when converting a finite signal, provide this many frames of silence after the end of the input
+ *  (or pass NULL input to AEResamplerProcess) to flush the remaining output.
+ *
+ * @param resampler The resampler
+ * @return The lookahead, in input frames
+ */
+UInt32 AEResamplerGetLatency(AEResampler * _Nonnull resampler);
+
+/*!
+ * Determine how many input frames are needed to produce the given number of output frames
+ *
+ *  This accounts for the resampler's current position and the input it has already buffered, and
+ *  is exact: providing this many frames to AEResamplerProcess will produce exactly the requested
+ *  number of output frames, and no input will be left over. Use this when pulling input from a
+ *  source on demand, so the source never renders more than is needed.
+ *
+ * @param resampler The resampler
+ * @param outputFrames Number of output frames desired
+ * @return The number of input frames needed
+ */
+UInt32 AEResamplerGetInputFramesRequired(AEResampler * _Nonnull resampler, UInt32 outputFrames);
+
+/*!
+ * Process audio
+ *
+ *  Consumes input until either the output buffer is full, or all the input has been consumed,
+ *  whichever happens first. Input audio is copied into the resampler's history as needed, so the
+ *  input buffer doesn't need to remain valid after this call.
+ *
+ *  If the input has fewer channels than the resampler, the last channel is repeated; if the output
+ *  has more channels than the resampler, the last channel is repeated.
+ *
+ * @param resampler The resampler
+ * @param input Input audio, or NULL to provide silence (to flush remaining output at the end of a signal)
+ * @param ioInputFrames On input, the number of input frames available; on output, the number consumed
+ * @param output Output buffer
+ * @param ioOutputFrames On input, the capacity of the output buffer, in frames; on output, the number
+ *      of frames produced
+ */
+void AEResamplerProcess(AEResampler * _Nonnull resampler,
+                        const AudioBufferList * _Nullable input,
+                        UInt32 * _Nonnull ioInputFrames,
+                        const AudioBufferList * _Nonnull output,
+                        UInt32 * _Nonnull ioOutputFrames);
+
+/*!
+ * Reset the resampler
+ *
+ *  Clears history, and returns to the initial position. Realtime-safe.
+ *
+ * @param resampler The resampler
+ */
+void AEResamplerReset(AEResampler * _Nonnull resampler);
+
+/*!
+ * Resample a buffer list in one operation
+ *
+ *  This is a convenience for offline conversion, such as when loading files. The output is aligned
+ *  with the input, and its length is the input length scaled by the conversion ratio, rounded up.
+ *  Not realtime-safe.
+ *
+ * @param bufferList Input audio, in non-interleaved float format
+ * @param frames Number of input frames
+ * @param inputRate Input sample rate
+ * @param outputRate Output sample rate
+ * @param quality Quality tier
+ * @param outputFrames On output, if not NULL, the number of frames in the returned buffer
+ * @return A newly-allocated buffer list containing the resampled audio, which you must free with
+ *      AEAudioBufferListFree, or NULL on error
+ */
+AudioBufferList * _Nullable AEResamplerCreateResampledBufferList(const AudioBufferList * _Nonnull bufferList,
+                                                                 UInt32 frames,
+                                                                 double inputRate,
+                                                                 double outputRate,
+                                                                 AEResamplerQuality quality,
+                                                                 UInt32 * _Nullable outputFrames);
+
+#ifdef __cplusplus
+}
+#endif
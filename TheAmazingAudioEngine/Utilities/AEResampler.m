@@ -0,0 +1,488 @@
+//
+//  AEResampler.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+
+#import "AEResampler.h"
+#import "AETypes.h"
+#import "AEAudioBufferListUtilities.h"
+#import <Accelerate/Accelerate.h>
+
+static const UInt32 kInputChunkFrames = 4096;
+static const UInt32 kInterpolationBlockFrames = 256;
+static const UInt64 kMaxRationalPhases = 2048;
+static const UInt64 kVariableRatioDenominator = 1ULL << 32;
+static const int kMaxTaps = 1024;
+
+static const struct {
+    int taps;       // Filter length at ratios <= 1
+    double rolloff; // Cutoff, relative to the lower of the two Nyquist frequencies
+    double beta;    // Kaiser window parameter
+    int phases;     // Filter bank resolution, for variable-ratio resamplers
+} kQualitySettings[] = {
+    [AEResamplerQualityLinear] = { 2,  0,    0,    0 },
+    [AEResamplerQualityCubic]  = { 4,  0,    0,    0 },
+    [AEResamplerQualityLow]    = { 8,  0.80, 5.0,  64 },
+    [AEResamplerQualityMedium] = { 16, 0.88, 7.0,  128 },
+    [AEResamplerQualityHigh]   = { 32, 0.93, 9.0,  256 },
+    [AEResamplerQualityBest]   = { 64, 0.96, 11.0, 512 },
+};
+
+struct AEResampler_t {
+    int channels;
+    AEResamplerQuality quality;
+    int taps;               // Number of input frames under the filter, which determines buffering and lookahead
+    int filterTaps;         // Length of each filter in the bank
+    UInt64 phases;
+    BOOL variable;          // Whether the ratio may change
+    BOOL interpolated;      // Whether coefficients are interpolated between phases of the bank
+    float * filters;        // (phases+1) rows of 'filterTaps' coefficients; the final row is for interpolation
+    float * coefficients;   // Interpolated coefficients, for variable-ratio resamplers
+    float * kernel;         // Continuous filter kernel, for lowering the cutoff of variable-ratio resamplers
+    int kernelLength;
+    float * kernelIndices;
+    float * blockIndices;   // Per-frame positions and fractions, for the interpolating kernels
+    float * blockFractions;
+    float * blockScratch;
+    UInt64 denominator;     // Denominator of fractional position and step
+    UInt64 step;            // Input frames to advance per output frame, over denominator
+    UInt64 fraction;        // Fractional part of the current position, over denominator
+    int readIndex;          // Index within buffers of the first frame under the filter
+    int bufferedFrames;
+    int capacity;
+    float ** buffers;       // Input history, one per channel
+};
+
+static double AEResamplerBesselI0(double x) {
+    // Power series for the zeroth-order modified Bessel function of the first kind
+    double sum = 1.0, term = 1.0;
+    for ( int k=1; k<50; k++ ) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if ( term < sum * 1.0e-12 ) break;
+    }
+    return sum;
+}
+
+static double AEResamplerKernelValue(double x, int half, double cutoff, double beta, double windowScale) {
+    // Kaiser-windowed sinc, for a tap 'x' input frames from the output position
+    double sinc = fabs(x) < DBL_EPSILON ? 1.0 : sin(M_PI * cutoff * x) / (M_PI * cutoff * x);
+    double u = x / half;
+    double window = fabs(u) >= 1.0 ? 0.0 : AEResamplerBesselI0(beta * sqrt(1.0 - u*u)) * windowScale;
+    return cutoff * sinc * window;
+}
+
+static void AEResamplerDesignFilters(AEResampler * resampler, double cutoff, double beta) {
+    int taps = resampler->filterTaps;
+    int half = taps / 2;
+    double windowScale = 1.0 / AEResamplerBesselI0(beta);
+    
+    for ( UInt64 phase=0; phase <= resampler->phases; phase++ ) {
+        double fraction = (double)phase / resampler->phases;
+        float * row = resampler->filters + phase*taps;
+        double sum = 0.0;
+        for ( int i=0; i<taps; i++ ) {
+            double value = AEResamplerKernelValue((i - (half - 1)) - fraction, half, cutoff, beta, windowScale);
+            row[i] = value;
+            sum += value;
+        }
+        
+        // Normalize for unity gain at DC
+        float scale = sum > DBL_EPSILON ? 1.0 / sum : 1.0;
+        vDSP_vsmul(row, 1, &scale, row, 1, taps);
+    }
+}
+
+static void AEResamplerDesignKernel(AEResampler * resampler, double cutoff, double beta) {
+    // Sample the same kernel as the filter bank, at the bank's resolution, so it can be stretched
+    int half = resampler->filterTaps / 2;
+    double windowScale = 1.0 / AEResamplerBesselI0(beta);
+    resampler->kernelLength = 2 * half * (int)resampler->phases + 1;
+    resampler->kernel = calloc(resampler->kernelLength + 1, sizeof(float)); // Trailing zero, for interpolation at the end
+    for ( int i=0; i<resampler->kernelLength; i++ ) {
+        resampler->kernel[i] = AEResamplerKernelValue((double)i / resampler->phases - half, half, cutoff, beta, windowScale);
+    }
+}
+
+static AEResampler * AEResamplerCreate(double ratio, double filterRatio, UInt64 denominator, UInt64 step, UInt64 phases,
+                                       BOOL variable, BOOL interpolated, int channels, AEResamplerQuality quality) {
+    if ( channels < 1 || ratio <= 0.0 || quality < AEResamplerQualityLinear || quality > AEResamplerQualityBest ) return NULL;
+    
+    AEResampler * resampler = calloc(1, sizeof(AEResampler));
+    resampler->channels = channels;
+    resampler->quality = quality;
+    resampler->variable = variable;
+    resampler->interpolated = interpolated;
+    resampler->denominator = denominator;
+    resampler->step = step;
+    resampler->phases = phases;
+    
+    if ( quality == AEResamplerQualityLinear || quality == AEResamplerQualityCubic ) {
+        // Interpolating kernels are evaluated directly, a block of output frames at a time
+        resampler->taps = resampler->filterTaps = kQualitySettings[quality].taps;
+        resampler->blockIndices = malloc(sizeof(float) * kInterpolationBlockFrames);
+        resampler->blockFractions = malloc(sizeof(float) * kInterpolationBlockFrames);
+        resampler->blockScratch = malloc(sizeof(float) * kInterpolationBlockFrames * 5);
+        
+    } else if ( variable ) {
+        // The filter bank is designed for ratios up to 1. Above that, the kernel is stretched to lower the
+        // cutoff with the ratio, so buffer enough input for the stretched filter at the maximum ratio.
+        int taps = kQualitySettings[quality].taps;
+        resampler->filterTaps = taps;
+        resampler->taps = MIN(kMaxTaps, taps * (filterRatio > 1.0 ? (int)ceil(filterRatio) : 1));
+        resampler->filters = malloc(sizeof(float) * taps * (phases+1));
+        resampler->coefficients = malloc(sizeof(float) * resampler->taps);
+        resampler->kernelIndices = malloc(sizeof(float) * resampler->taps);
+        AEResamplerDesignFilters(resampler, kQualitySettings[quality].rolloff, kQualitySettings[quality].beta);
+        AEResamplerDesignKernel(resampler, kQualitySettings[quality].rolloff, kQualitySettings[quality].beta);
+        
+    } else {
+        // When downsampling, lower the cutoff and lengthen the filter in proportion to the ratio
+        int taps = kQualitySettings[quality].taps * (filterRatio > 1.0 ? (int)ceil(filterRatio) : 1);
+        resampler->taps = resampler->filterTaps = MIN(kMaxTaps, taps);
+        double cutoff = kQualitySettings[quality].rolloff * (filterRatio > 1.0 ? 1.0 / filterRatio : 1.0);
+        resampler->filters = malloc(sizeof(float) * resampler->taps * (phases+1));
+        resampler->coefficients = interpolated ? malloc(sizeof(float) * resampler->taps) : NULL;
+        AEResamplerDesignFilters(resampler, cutoff, kQualitySettings[quality].beta);
+    }
+    
+    resampler->capacity = resampler->taps + kInputChunkFrames;
+    resampler->buffers = malloc(sizeof(float *) * channels);
+    for ( int i=0; i<channels; i++ ) {
+        resampler->buffers[i] = malloc(sizeof(float) * resampler->capacity);
+    }
+    
+    AEResamplerReset(resampler);
+    return resampler;
+}
+
+static UInt64 AEResamplerGreatestCommonDivisor(UInt64 a, UInt64 b) {
+    while ( b ) {
+        UInt64 t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+AEResampler * AEResamplerNew(double inputRate, double outputRate, int channels, AEResamplerQuality quality) {
+    if ( inputRate <= 0.0 || outputRate <= 0.0 || quality < AEResamplerQualityLinear || quality > AEResamplerQualityBest ) return NULL;
+    double ratio = inputRate / outputRate;
+    
+    if ( fabs(inputRate - round(inputRate)) < DBL_EPSILON && fabs(outputRate - round(outputRate)) < DBL_EPSILON ) {
+        // Integer rates: use an exact rational ratio, with one precomputed filter per phase, if the number of
+        // phases is reasonable (e.g. 44100 -> 48000 needs 160 phases)
+        UInt64 in = (UInt64)round(inputRate);
+        UInt64 out = (UInt64)round(outputRate);
+        UInt64 divisor = AEResamplerGreatestCommonDivisor(in, out);
+        if ( out / divisor <= kMaxRationalPhases ) {
+            return AEResamplerCreate(ratio, ratio, out / divisor, in / divisor, out / divisor, NO, NO, channels, quality);
+        }
+    }
+    
+    // Otherwise, interpolate between phases of a finely-spaced filter bank
+    return AEResamplerCreate(ratio, ratio, kVariableRatioDenominator, (UInt64)llround(ratio * kVariableRatioDenominator),
+                             kQualitySettings[quality].phases, NO, YES, channels, quality);
+}
+
+AEResampler * AEResamplerNewWithVariableRatio(double ratio, double maximumRatio, int channels, AEResamplerQuality quality) {
+    if ( ratio <= 0.0 || quality < AEResamplerQualityLinear || quality > AEResamplerQualityBest ) return NULL;
+    return AEResamplerCreate(ratio, MAX(ratio, maximumRatio), kVariableRatioDenominator,
+                             (UInt64)llround(ratio * kVariableRatioDenominator), kQualitySettings[quality].phases,
+                             YES, YES, channels, quality);
+}
+
+void AEResamplerFree(AEResampler * resampler) {
+    for ( int i=0; i<resampler->channels; i++ ) {
+        free(resampler->buffers[i]);
+    }
+    free(resampler->buffers);
+    if ( resampler->filters ) free(resampler->filters);
+    if ( resampler->coefficients ) free(resampler->coefficients);
+    if ( resampler->kernel ) free(resampler->kernel);
+    if ( resampler->kernelIndices ) free(resampler->kernelIndices);
+    if ( resampler->blockIndices ) free(resampler->blockIndices);
+    if ( resampler->blockFractions ) free(resampler->blockFractions);
+    if ( resampler->blockScratch ) free(resampler->blockScratch);
+    free(resampler);
+}
+
+void AEResamplerSetRatio(AEResampler * resampler, double ratio) {
+    assert(resampler->variable);
+    if ( !resampler->variable || ratio <= 0.0 ) return;
+    resampler->step = MAX(1, (UInt64)llround(ratio * resampler->denominator));
+}
+
+double AEResamplerGetRatio(AEResampler * resampler) {
+    return (double)resampler->step / resampler->denominator;
+}
+
+UInt32 AEResamplerGetLatency(AEResampler * resampler) {
+    return resampler->taps / 2;
+}
+
+UInt32 AEResamplerGetInputFramesRequired(AEResampler * resampler, UInt32 outputFrames) {
+    if ( outputFrames == 0 ) return 0;
+    
+    // Find the read position of the last output frame, using the same arithmetic as rendering
+    UInt64 fraction = resampler->fraction + (UInt64)(outputFrames-1) * resampler->step;
+    SInt64 lastReadIndex = resampler->readIndex + (SInt64)(fraction / resampler->denominator);
+    SInt64 required = lastReadIndex + resampler->taps - resampler->bufferedFrames;
+    return required > 0 ? (UInt32)required : 0;
+}
+
+static const float * AEResamplerStretchedCoefficients(AEResampler * resampler, int * length) {
+    // Stretch the kernel in time by the ratio, lowering its cutoff to the output Nyquist frequency
+    const int half = resampler->filterTaps / 2;
+    const double stretch = MIN((double)resampler->step / resampler->denominator, (double)resampler->taps / resampler->filterTaps);
+    const int stretchedHalf = MIN((int)ceil(half * stretch), resampler->taps / 2);
+    const double fraction = (double)resampler->fraction / resampler->denominator;
+    *length = 2 * stretchedHalf;
+    
+    // Find the kernel positions of each tap, and interpolate the kernel there
+    float start = ((-(stretchedHalf - 1) - fraction) / stretch + half) * resampler->phases;
+    float increment = resampler->phases / stretch;
+    float lowest = 0;
+    float highest = resampler->kernelLength - 1;
+    vDSP_vramp(&start, &increment, resampler->kernelIndices, 1, *length);
+    vDSP_vclip(resampler->kernelIndices, 1, &lowest, &highest, resampler->kernelIndices, 1, *length);
+    vDSP_vlint(resampler->kernel, resampler->kernelIndices, 1, resampler->coefficients, 1, *length, resampler->kernelLength);
+    
+    // Normalize for unity gain at DC
+    float sum;
+    vDSP_sve(resampler->coefficients, 1, &sum, *length);
+    float scale = sum > FLT_EPSILON ? 1.0 / sum : 1.0;
+    vDSP_vsmul(resampler->coefficients, 1, &scale, resampler->coefficients, 1, *length);
+    return resampler->coefficients;
+}
+
+static UInt32 AEResamplerRenderFiltered(AEResampler * resampler, const AudioBufferList * output, UInt32 offset, UInt32 frames) {
+    const int taps = resampler->taps;
+    const UInt64 denominator = resampler->denominator;
+    const UInt64 step = resampler->step;
+    const UInt64 phases = resampler->phases;
+    UInt32 produced = 0;
+    
+    while ( produced < frames && resampler->readIndex + taps <= resampler->bufferedFrames ) {
+        const float * coefficients;
+        int length = resampler->filterTaps;
+        if ( resampler->variable && step > denominator ) {
+            coefficients = AEResamplerStretchedCoefficients(resampler, &length);
+        } else {
+            // Select the filter for this phase
+            UInt64 position = resampler->fraction * phases;
+            coefficients = resampler->filters + (position / denominator) * length;
+            if ( resampler->interpolated ) {
+                // Interpolate between this phase and the next
+                float weight = (float)(position % denominator) / (float)denominator;
+                vDSP_vintb(coefficients, 1, coefficients + length, 1, &weight, resampler->coefficients, 1, length);
+                coefficients = resampler->coefficients;
+            }
+        }
+        
+        // Filters shorter than the buffered span are centered within it
+        const int start = resampler->readIndex + (taps - length) / 2;
+        for ( int i=0; i<output->mNumberBuffers; i++ ) {
+            const float * source = resampler->buffers[MIN(i, resampler->channels-1)] + start;
+            vDSP_dotpr(source, 1, coefficients, 1, (float*)output->mBuffers[i].mData + offset + produced, length);
+        }
+        
+        // Advance
+        resampler->fraction += step;
+        resampler->readIndex += (int)(resampler->fraction / denominator);
+        resampler->fraction %= denominator;
+        produced++;
+    }
+    
+    return produced;
+}
+
+static UInt32 AEResamplerRenderInterpolated(AEResampler * resampler, const AudioBufferList * output, UInt32 offset, UInt32 frames) {
+    const int taps = resampler->taps;
+    const UInt64 denominator = resampler->denominator;
+    const UInt64 step = resampler->step;
+    float * indices = resampler->blockIndices;
+    float * fractions = resampler->blockFractions;
+    UInt32 produced = 0;
+    
+    while ( produced < frames ) {
+        // Lay out the positions of a block of output frames
+        UInt32 count = 0;
+        UInt32 limit = MIN(frames - produced, kInterpolationBlockFrames);
+        while ( count < limit && resampler->readIndex + taps <= resampler->bufferedFrames ) {
+            indices[count] = resampler->readIndex;
+            fractions[count] = (float)((double)resampler->fraction / denominator);
+            resampler->fraction += step;
+            resampler->readIndex += (int)(resampler->fraction / denominator);
+            resampler->fraction %= denominator;
+            count++;
+        }
+        if ( count == 0 ) break;
+        
+        // Then gather the frames under the kernel, and evaluate it for the whole block, one channel at a time
+        float * y0 = resampler->blockScratch;
+        float * y1 = y0 + kInterpolationBlockFrames;
+        float * y2 = y1 + kInterpolationBlockFrames;
+        float * y3 = y2 + kInterpolationBlockFrames;
+        float * c1 = y3 + kInterpolationBlockFrames;
+        for ( int i=0; i<output->mNumberBuffers; i++ ) {
+            const float * source = resampler->buffers[MIN(i, resampler->channels-1)];
+            float * target = (float*)output->mBuffers[i].mData + offset + produced;
+            
+            if ( resampler->quality == AEResamplerQualityLinear ) {
+                // y0 + t(y1 - y0)
+                vDSP_vindex(source, indices, 1, y0, 1, count);
+                vDSP_vindex(source + 1, indices, 1, y1, 1, count);
+                vDSP_vsub(y0, 1, y1, 1, y1, 1, count);
+                vDSP_vma(y1, 1, fractions, 1, y0, 1, target, 1, count);
+                
+            } else {
+                // Catmull-Rom cubic Hermite spline between y1 and y2, with coefficients:
+                //   c1 = (y2 - y0)/2
+                //   c3 = (y3 - y0)/2 + 3(y1 - y2)/2
+                //   c2 = (y2 - y1) - c1 - c3
+                // and output ((c3 t + c2) t + c1) t + y1
+                vDSP_vindex(source, indices, 1, y0, 1, count);
+                vDSP_vindex(source + 1, indices, 1, y1, 1, count);
+                vDSP_vindex(source + 2, indices, 1, y2, 1, count);
+                vDSP_vindex(source + 3, indices, 1, y3, 1, count);
+                float half = 0.5, threeHalves = 1.5;
+                vDSP_vsub(y0, 1, y2, 1, c1, 1, count);
+                vDSP_vsmul(c1, 1, &half, c1, 1, count);
+                vDSP_vsub(y2, 1, y1, 1, y2, 1, count);                        // y2 := y1 - y2
+                vDSP_vsub(y0, 1, y3, 1, y3, 1, count);
+                vDSP_vsmsma(y3, 1, &half, y2, 1, &threeHalves, y3, 1, count); // y3 := c3
+                vDSP_vadd(c1, 1, y3, 1, y0, 1, count);
+                vDSP_vadd(y0, 1, y2, 1, y0, 1, count);
+                vDSP_vneg(y0, 1, y0, 1, count);                               // y0 := c2
+                vDSP_vma(y3, 1, fractions, 1, y0, 1, y0, 1, count);
+                vDSP_vma(y0, 1, fractions, 1, c1, 1, y0, 1, count);
+                vDSP_vma(y0, 1, fractions, 1, y1, 1, target, 1, count);
+            }
+        }
+        
+        produced += count;
+    }
+    
+    return produced;
+}
+
+static UInt32 AEResamplerRender(AEResampler * resampler, const AudioBufferList * output, UInt32 offset, UInt32 frames) {
+    return resampler->quality == AEResamplerQualityLinear || resampler->quality == AEResamplerQualityCubic
+        ? AEResamplerRenderInterpolated(resampler, output, offset, frames)
+        : AEResamplerRenderFiltered(resampler, output, offset, frames);
+}
+
+void AEResamplerProcess(AEResampler * resampler, const AudioBufferList * input, UInt32 * ioInputFrames,
+                        const AudioBufferList * output, UInt32 * ioOutputFrames) {
+    UInt32 inputFrames = *ioInputFrames;
+    UInt32 outputFrames = *ioOutputFrames;
+    UInt32 inputOffset = 0;
+    UInt32 outputOffset = 0;
+    
+    while ( 1 ) {
+        // Produce as much output as the buffered input allows
+        outputOffset += AEResamplerRender(resampler, output, outputOffset, outputFrames - outputOffset);
+        if ( outputOffset == outputFrames || inputOffset == inputFrames ) break;
+        
+        // Discard history that's no longer under the filter
+        int discard = MIN(resampler->readIndex, resampler->bufferedFrames);
+        if ( discard > 0 ) {
+            int remaining = resampler->bufferedFrames - discard;
+            for ( int i=0; i<resampler->channels; i++ ) {
+                memmove(resampler->buffers[i], resampler->buffers[i] + discard, sizeof(float) * remaining);
+            }
+            resampler->bufferedFrames = remaining;
+            resampler->readIndex -= discard;
+        }
+        
+        if ( resampler->readIndex > 0 ) {
+            // Downsampling by a large ratio can step over input entirely: skip it without copying
+            UInt32 skip = MIN((UInt32)resampler->readIndex, inputFrames - inputOffset);
+            resampler->readIndex -= skip;
+            inputOffset += skip;
+            continue;
+        }
+        
+        // Take in more input
+        UInt32 count = MIN((UInt32)(resampler->capacity - resampler->bufferedFrames), inputFrames - inputOffset);
+        for ( int i=0; i<resampler->channels; i++ ) {
+            float * target = resampler->buffers[i] + resampler->bufferedFrames;
+            if ( input ) {
+                memcpy(target, (float*)input->mBuffers[MIN(i, input->mNumberBuffers-1)].mData + inputOffset, sizeof(float) * count);
+            } else {
+                vDSP_vclr(target, 1, count);
+            }
+        }
+        resampler->bufferedFrames += count;
+        inputOffset += count;
+    }
+    
+    *ioInputFrames = inputOffset;
+    *ioOutputFrames = outputOffset;
+}
+
+void AEResamplerReset(AEResampler * resampler) {
+    // Prime the history with silence, so the first output frame is aligned with the first input frame
+    int priming = resampler->taps/2 - 1;
+    for ( int i=0; i<resampler->channels; i++ ) {
+        vDSP_vclr(resampler->buffers[i], 1, priming);
+    }
+    resampler->bufferedFrames = priming;
+    resampler->readIndex = 0;
+    resampler->fraction = 0;
+}
+
+AudioBufferList * AEResamplerCreateResampledBufferList(const AudioBufferList * bufferList, UInt32 frames, double inputRate,
+                                                       double outputRate, AEResamplerQuality quality, UInt32 * outputFrames) {
+    int channels = bufferList->mNumberBuffers;
+    AEResampler * resampler = AEResamplerNew(inputRate, outputRate, channels, quality);
+    if ( !resampler ) return NULL;
+    
+    UInt32 length = (UInt32)ceil(frames * (outputRate / inputRate));
+    AudioBufferList * output = AEAudioBufferListCreateWithFormat(AEAudioDescriptionWithChannelsAndRate(channels, outputRate), length);
+    if ( !output ) {
+        AEResamplerFree(resampler);
+        return NULL;
+    }
+    
+    UInt32 inputFrames = frames;
+    UInt32 produced = length;
+    AEResamplerProcess(resampler, bufferList, &inputFrames, output, &produced);
+    
+    if ( produced < length ) {
+        // Flush the remainder with silence
+        AEAudioBufferListCopyOnStack(remainder, output, produced);
+        UInt32 silentFrames = AEResamplerGetInputFramesRequired(resampler, length - produced);
+        UInt32 remainingFrames = length - produced;
+        AEResamplerProcess(resampler, NULL, &silentFrames, remainder, &remainingFrames);
+        produced += remainingFrames;
+    }
+    
+    AEResamplerFree(resampler);
+    
+    if ( outputFrames ) *outputFrames = produced;
+    return output;
+}
@@ -0,0 +1,196 @@
+//
+//  AEStreamingSampleStore.h
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#import <Foundation/Foundation.h>
+#import <AudioToolbox/AudioToolbox.h>
+#import "AETime.h"
+
+@class AEStreamingSample;
+
+/*!
+ * Load block
+ *
+ * @param sample The loaded sample, or nil if an error occurred
+ * @param error The error, if one occurred
+ */
+typedef void (^AEStreamingSampleStoreLoadBlock)(AEStreamingSample * _Nullable sample, NSError * _Nullable error);
+
+/*!
+ * Streaming sample store
+ *
+ *  This class holds samples for instruments with too many zones to keep entirely in memory. Only
+ *  the head of each sample - its first few hundred milliseconds - is resident, loaded with
+ *  AEAudioFileReader, so notes start instantly; the remainder streams from disk while the head
+ *  plays.
+ *
+ *  Playback is performed by a fixed pool of voices, each with its own ring buffer (an
+ *  AECircularBuffer). Starting a voice on the realtime thread wakes the store's I/O thread, which
+ *  opens the sample's file, and decodes its tail into the voice's ring, ahead of the read position.
+ *  The I/O thread services voices in order of their deadline: how many render cycles each can play
+ *  before it reaches the end of its buffered audio. The render cycle length is taken from the
+ *  reads performed on the realtime thread.
+ *
+ *  The head duration should comfortably exceed the time taken to open a file and decode its first
+ *  block, under load; if the tail isn't ready in time, the voice keeps time with silence, and the
+ *  underrun is counted.
+ *
+ *  Audio is provided in non-interleaved float format, with the channel count and sample rate given
+ *  on initialization. Samples remain valid for the lifetime of the store.
+ *
+ *  Files at another sample rate are converted with AEResampler, for both the head and the tail, so
+ *  there's no discontinuity where one meets the other. To pick up the converter's state, the I/O
+ *  thread decodes and converts the head's audio again whenever a voice starts one of these samples,
+ *  so the head duration must also cover this work.
+ */
+@interface AEStreamingSampleStore : NSObject
+
+/*!
+ * Default initializer
+ *
+ * @param headDuration The duration of audio to keep resident for each sample, in seconds
+ * @param sampleRate The sample rate to provide audio at
+ * @param numberOfChannels The number of channels to provide
+ * @param voiceCount The number of voices available for playback
+ * @param tailBufferDuration How far ahead of each voice's read position to decode, in seconds
+ */
+- (instancetype _Nullable)initWithHeadDuration:(AESeconds)headDuration
+                                    sampleRate:(double)sampleRate
+                              numberOfChannels:(int)numberOfChannels
+                                    voiceCount:(int)voiceCount
+                            tailBufferDuration:(AESeconds)tailBufferDuration;
+
+/*!
+ * Load a sample
+ *
+ *  Loads the head of the sample in the background, and adds the sample to the store.
+ *
+ * @param path Path to the audio file
+ * @param block Block to call on the main thread when the head has loaded
+ */
+- (void)loadSampleAtPath:(NSString * _Nonnull)path completionBlock:(AEStreamingSampleStoreLoadBlock _Nonnull)block;
+
+/*!
+ * Start a voice
+ *
+ *  Begins playback of a sample from its start, replacing whatever the voice was playing.
+ *
+ *  For use on the realtime thread.
+ *
+ * @param store The store
+ * @param voice The voice index
+ * @param sample The sample to play, from this store
+ */
+void AEStreamingSampleStoreStartVoice(__unsafe_unretained AEStreamingSampleStore * _Nonnull store, int voice,
+                                      __unsafe_unretained AEStreamingSample * _Nonnull sample);
+
+/*!
+ * Stop a voice
+ *
+ *  For use on the realtime thread.
+ *
+ * @param store The store
+ * @param voice The voice index
+ */
+void AEStreamingSampleStoreStopVoice(__unsafe_unretained AEStreamingSampleStore * _Nonnull store, int voice);
+
+/*!
+ * Read audio from a voice
+ *
+ *  Copies audio from the voice's read position, from the resident head and then from the voice's
+ *  ring, and advances the read position. Frames which have not been streamed in time are replaced
+ *  with silence. The voice stops once it reaches the end of its sample.
+ *
+ *  For use on the realtime thread.
+ *
+ * @param store The store
+ * @param voice The voice index
+ * @param bufferList The buffer list to write audio to
+ * @param frames The number of frames to read
+ * @return The number of frames read; less than requested once the end of the sample is reached
+ */
+UInt32 AEStreamingSampleStoreReadVoice(__unsafe_unretained AEStreamingSampleStore * _Nonnull store, int voice,
+                                       const AudioBufferList * _Nonnull bufferList, UInt32 frames);
+
+/*!
+ * Determine if a voice is playing
+ *
+ *  For use on the realtime thread.
+ *
+ * @param store The store
+ * @param voice The voice index
+ * @return Whether the voice is playing a sample
+ */
+BOOL AEStreamingSampleStoreVoiceIsPlaying(__unsafe_unretained AEStreamingSampleStore * _Nonnull store, int voice);
+
+//! The duration of audio kept resident for each sample, in seconds
+@property (nonatomic, readonly) AESeconds headDuration;
+
+//! The sample rate audio is provided at
+@property (nonatomic, readonly) double sampleRate;
+
+//! The number of channels provided
+@property (nonatomic, readonly) int numberOfChannels;
+
+//! The number of voices
+@property (nonatomic, readonly) int voiceCount;
+
+//! The total size of the resident heads, in bytes
+@property (nonatomic, readonly) size_t residentBytes;
+
+//! The number of frames replaced with silence because the tail wasn't streamed in time
+@property (nonatomic, readonly) UInt64 underrunFrames;
+
+@end
+
+/*!
+ * Streaming sample
+ *
+ *  A sample in an AEStreamingSampleStore.
+ */
+@interface AEStreamingSample : NSObject
+
+//! The path to the file
+@property (nonatomic, strong, readonly) NSString * _Nonnull path;
+
+//! The length of the sample, in frames at the store's sample rate
+@property (nonatomic, readonly) UInt32 length;
+
+//! The length of the resident head, in frames
+@property (nonatomic, readonly) UInt32 headLength;
+
+//! The resident head (read-only)
+@property (nonatomic, readonly) const AudioBufferList * _Nonnull head;
+
+@end
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,551 @@
+//
+//  AEStreamingSampleStore.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+
+#import "AEStreamingSampleStore.h"
+#import "AEAudioFileReader.h"
+#import "AEResampler.h"
+#import "AECircularBuffer.h"
+#import "AEAudioBufferListUtilities.h"
+#import "AEUtilities.h"
+#import "AETypes.h"
+#import <stdatomic.h>
+#import <mach/semaphore.h>
+#import <mach/task.h>
+#import <mach/mach_init.h>
+#import <pthread.h>
+
+static const UInt32 kMaxReadFrames = 4096;
+static const UInt32 kMinReadFrames = 512;
+static const UInt32 kDefaultFramesPerCycle = 512;
+static const UInt32 kSafetyCycles = 4;
+static const AESeconds kMaxServiceInterval = 0.01;
+
+@interface AEStreamingSample () {
+  @public
+    AudioBufferList * _head;
+    UInt32 _headLength;
+    UInt32 _length;
+}
+@property (nonatomic, strong, readwrite) NSString * path;
+@end
+
+typedef struct {
+    // Requests from the realtime thread, guarded by a sequence counter: odd while the request is being
+    // written, and the even value identifies the request (its generation) once written
+    atomic_uint_fast64_t sequence;
+    __unsafe_unretained AEStreamingSample * requestedSample;
+    
+    AECircularBuffer ring;
+    
+    // Realtime thread state; the read position is published for the I/O thread's deadlines
+    __unsafe_unretained AEStreamingSample * sample;
+    UInt64 generation;
+    atomic_uint_fast64_t position;
+    
+    // I/O thread state
+    UInt64 producerGeneration;
+    __unsafe_unretained AEStreamingSample * producerSample;
+    ExtAudioFileRef audioFile;
+    AEResampler * resampler;
+    AudioBufferList * scratch;
+    UInt64 producerPosition;
+} AEStreamingSampleVoice;
+
+@class AEStreamingSampleStoreThread;
+
+@interface AEStreamingSampleStore () {
+    AEStreamingSampleVoice * _voices;
+    semaphore_t _semaphore;
+    atomic_uint _framesPerCycle;
+    atomic_uint_fast64_t _underrunFrames;
+    UInt64 * _deadlines;
+    int * _order;
+}
+@property (nonatomic, strong) NSMutableArray<AEStreamingSample *> * samples;
+@property (nonatomic, strong) AEStreamingSampleStoreThread * thread;
+@property (nonatomic, readwrite) size_t residentBytes;
+- (AESeconds)service;
+@end
+
+@interface AEStreamingSampleStoreThread : NSThread
+@property (nonatomic, weak) AEStreamingSampleStore * store;
+@property (nonatomic, readonly) semaphore_t semaphore;
+@end
+
+static UInt64 AEStreamingSampleStorePostRequest(AEStreamingSampleVoice * voice,
+                                                __unsafe_unretained AEStreamingSample * sample);
+
+@implementation AEStreamingSampleStore
+
+- (instancetype)initWithHeadDuration:(AESeconds)headDuration sampleRate:(double)sampleRate
+                    numberOfChannels:(int)numberOfChannels voiceCount:(int)voiceCount
+                  tailBufferDuration:(AESeconds)tailBufferDuration {
+    if ( !(self = [super init]) ) return nil;
+    
+    _headDuration = headDuration;
+    _sampleRate = sampleRate;
+    _numberOfChannels = numberOfChannels;
+    _voiceCount = voiceCount;
+    self.samples = [NSMutableArray array];
+    atomic_init(&_framesPerCycle, kDefaultFramesPerCycle);
+    atomic_init(&_underrunFrames, 0);
+    
+    _voices = calloc(voiceCount, sizeof(AEStreamingSampleVoice));
+    _deadlines = calloc(voiceCount, sizeof(UInt64));
+    _order = calloc(voiceCount, sizeof(int));
+    UInt32 capacity = MAX(kMaxReadFrames, (UInt32)ceil(tailBufferDuration * sampleRate));
+    for ( int i=0; i<voiceCount; i++ ) {
+        AEStreamingSampleVoice * voice = &_voices[i];
+        atomic_init(&voice->sequence, 0);
+        atomic_init(&voice->position, 0);
+        if ( !AECircularBufferInit(&voice->ring, capacity, numberOfChannels, sampleRate) ) {
+            _voiceCount = i;
+            return nil;
+        }
+    }
+    
+    self.thread = [AEStreamingSampleStoreThread new];
+    self.thread.store = self;
+    _semaphore = self.thread.semaphore;
+    [self.thread start];
+    
+    return self;
+}
+
+- (void)dealloc {
+    [self.thread cancel];
+    for ( int i=0; i<_voiceCount; i++ ) {
+        AEStreamingSampleVoice * voice = &_voices[i];
+        if ( voice->audioFile ) {
+            ExtAudioFileDispose(voice->audioFile);
+            AEAudioBufferListFree(voice->scratch);
+        }
+        if ( voice->resampler ) {
+            AEResamplerFree(voice->resampler);
+        }
+        AECircularBufferCleanup(&voice->ring);
+    }
+    free(_voices);
+    free(_deadlines);
+    free(_order);
+}
+
+- (void)loadSampleAtPath:(NSString *)path completionBlock:(AEStreamingSampleStoreLoadBlock)block {
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        // Determine the sample's length at our rate
+        AudioStreamBasicDescription fileAudioDescription;
+        UInt64 fileLength;
+        NSError * error = nil;
+        if ( !AEExtAudioFileInspect([NSURL fileURLWithPath:path], &fileAudioDescription, &fileLength, &error) ) {
+            dispatch_async(dispatch_get_main_queue(), ^{ block(nil, error); });
+            return;
+        }
+        UInt64 length = fabs(self.sampleRate - fileAudioDescription.mSampleRate) > DBL_EPSILON
+            ? (UInt64)ceil(fileLength * (self.sampleRate / fileAudioDescription.mSampleRate)) : fileLength;
+        if ( length == 0 || length > UINT32_MAX ) {
+            dispatch_async(dispatch_get_main_queue(), ^{
+                block(nil, [NSError errorWithDomain:NSOSStatusErrorDomain code:-50
+                                           userInfo:@{NSLocalizedDescriptionKey: length == 0
+                                                      ? NSLocalizedString(@"This audio file is empty", @"")
+                                                      : NSLocalizedString(@"This audio file is too long to load", @"")}]);
+            });
+            return;
+        }
+        
+        // Load just the head
+        UInt32 headLength = (UInt32)MIN(length, (UInt64)round(self.headDuration * self.sampleRate));
+        [AEAudioFileReader loadFileAtPath:path
+                   targetAudioDescription:AEAudioDescriptionWithChannelsAndRate(self.numberOfChannels, self.sampleRate)
+                            maximumLength:headLength
+                          completionBlock:^(AudioBufferList * audio, UInt32 loadedLength, NSError * error) {
+            if ( !audio ) {
+                block(nil, error);
+                return;
+            }
+            
+            AEStreamingSample * sample = [AEStreamingSample new];
+            sample.path = path;
+            sample->_head = audio;
+            sample->_headLength = loadedLength;
+            
+            // If the file ended within the head, the length was an estimate and the whole sample is resident
+            sample->_length = loadedLength < headLength ? loadedLength : (UInt32)length;
+            
+            [self.samples addObject:sample];
+            self.residentBytes += (size_t)loadedLength * self.numberOfChannels * sizeof(float);
+            block(sample, nil);
+        }];
+    });
+}
+
+- (UInt64)underrunFrames {
+    return atomic_load_explicit(&_underrunFrames, memory_order_relaxed);
+}
+
+#pragma mark - Realtime
+
+void AEStreamingSampleStoreStartVoice(__unsafe_unretained AEStreamingSampleStore * THIS, int voiceIndex,
+                                      __unsafe_unretained AEStreamingSample * sample) {
+    AEStreamingSampleVoice * voice = &THIS->_voices[voiceIndex];
+    voice->generation = AEStreamingSampleStorePostRequest(voice, sample);
+    voice->sample = sample;
+    atomic_store_explicit(&voice->position, 0, memory_order_relaxed);
+    semaphore_signal(THIS->_semaphore);
+}
+
+void AEStreamingSampleStoreStopVoice(__unsafe_unretained AEStreamingSampleStore * THIS, int voiceIndex) {
+    AEStreamingSampleVoice * voice = &THIS->_voices[voiceIndex];
+    if ( !voice->sample ) return;
+    voice->generation = AEStreamingSampleStorePostRequest(voice, nil);
+    voice->sample = nil;
+    semaphore_signal(THIS->_semaphore);
+}
+
+UInt32 AEStreamingSampleStoreReadVoice(__unsafe_unretained AEStreamingSampleStore * THIS, int voiceIndex,
+                                       const AudioBufferList * bufferList, UInt32 frames) {
+    // Track the render cycle length, for the I/O thread's deadlines
+    if ( frames > atomic_load_explicit(&THIS->_framesPerCycle, memory_order_relaxed) ) {
+        atomic_store_explicit(&THIS->_framesPerCycle, frames, memory_order_relaxed);
+    }
+    
+    AEStreamingSampleVoice * voice = &THIS->_voices[voiceIndex];
+    __unsafe_unretained AEStreamingSample * sample = voice->sample;
+    if ( !sample ) return 0;
+    
+    UInt64 position = atomic_load_explicit(&voice->position, memory_order_relaxed);
+    frames = (UInt32)MIN(frames, sample->_length - position);
+    UInt32 filled = 0;
+    
+    if ( position < sample->_headLength ) {
+        // Play from the resident head
+        filled = (UInt32)MIN(frames, sample->_headLength - position);
+        AEAudioBufferListCopyContents(bufferList, sample->_head, 0, (UInt32)position, filled);
+    }
+    
+    // Then from the streamed tail, dropping audio prefetched for an earlier request
+    AudioTimeStamp timestamp;
+    AudioBufferList * chunk;
+    while ( filled < frames && (chunk = AECircularBufferNextBufferList(&voice->ring, &timestamp, NULL)) ) {
+        UInt64 index = position + filled;
+        UInt64 chunkIndex = (UInt64)timestamp.mSampleTime;
+        UInt32 chunkLength = chunk->mBuffers[0].mDataByteSize / sizeof(float);
+        if ( timestamp.mWordClockTime != voice->generation || chunkIndex + chunkLength <= index ) {
+            AECircularBufferConsumeNextBufferList(&voice->ring);
+            continue;
+        }
+        
+        if ( chunkIndex > index ) {
+            // Audio is missing ahead of this chunk
+            UInt32 gap = (UInt32)MIN(chunkIndex - index, frames - filled);
+            AEAudioBufferListSilence(bufferList, filled, gap);
+            atomic_fetch_add_explicit(&THIS->_underrunFrames, gap, memory_order_relaxed);
+            filled += gap;
+            continue;
+        }
+        
+        UInt32 offset = (UInt32)(index - chunkIndex);
+        UInt32 count = MIN(chunkLength - offset, frames - filled);
+        AEAudioBufferListCopyContents(bufferList, chunk, filled, offset, count);
+        AECircularBufferConsumeNextBufferListPartial(&voice->ring, offset + count);
+        filled += count;
+    }
+    
+    if ( filled < frames ) {
+        // Underrun: keep time, and fill with silence
+        AEAudioBufferListSilence(bufferList, filled, frames - filled);
+        atomic_fetch_add_explicit(&THIS->_underrunFrames, frames - filled, memory_order_relaxed);
+    }
+    
+    position += frames;
+    atomic_store_explicit(&voice->position, position, memory_order_relaxed);
+    if ( position >= sample->_length ) {
+        AEStreamingSampleStoreStopVoice(THIS, voiceIndex);
+    }
+    
+    return frames;
+}
+
+BOOL AEStreamingSampleStoreVoiceIsPlaying(__unsafe_unretained AEStreamingSampleStore * THIS, int voiceIndex) {
+    return THIS->_voices[voiceIndex].sample != nil;
+}
+
+static UInt64 AEStreamingSampleStorePostRequest(AEStreamingSampleVoice * voice,
+                                                __unsafe_unretained AEStreamingSample * sample) {
+    uint_fast64_t sequence = atomic_load_explicit(&voice->sequence, memory_order_relaxed);
+    atomic_store_explicit(&voice->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    voice->requestedSample = sample;
+    atomic_store_explicit(&voice->sequence, sequence + 2, memory_order_release);
+    return sequence + 2;
+}
+
+static UInt64 AEStreamingSampleStoreLoadRequest(AEStreamingSampleVoice * voice,
+                                                __unsafe_unretained AEStreamingSample ** sample) {
+    while ( 1 ) {
+        uint_fast64_t sequence = atomic_load_explicit(&voice->sequence, memory_order_acquire);
+        if ( sequence & 1 ) continue;
+        *sample = voice->requestedSample;
+        atomic_thread_fence(memory_order_acquire);
+        if ( atomic_load_explicit(&voice->sequence, memory_order_relaxed) == sequence ) {
+            return sequence;
+        }
+    }
+}
+
+#pragma mark - I/O thread
+
+- (AESeconds)service {
+    UInt32 framesPerCycle = atomic_load_explicit(&_framesPerCycle, memory_order_relaxed);
+    
+    // Pick up requests, and order the streaming voices by deadline: the frames each can play before
+    // it runs out of buffered audio
+    int count = 0;
+    for ( int i=0; i<_voiceCount; i++ ) {
+        AEStreamingSampleVoice * voice = &_voices[i];
+        [self updateVoice:voice];
+        if ( !voice->audioFile || voice->producerPosition >= voice->producerSample->_length ) continue;
+        
+        UInt64 position = atomic_load_explicit(&voice->position, memory_order_relaxed);
+        _deadlines[i] = voice->producerPosition > position ? voice->producerPosition - position : 0;
+        int j = count++;
+        for ( ; j > 0 && _deadlines[_order[j-1]] > _deadlines[i]; j-- ) {
+            _order[j] = _order[j-1];
+        }
+        _order[j] = i;
+    }
+    
+    BOOL produced = NO;
+    for ( int i=0; i<count; i++ ) {
+        if ( [self fillVoice:&_voices[_order[i]]] ) {
+            produced = YES;
+        }
+    }
+    
+    if ( produced || count == 0 ) {
+        return produced ? 0 : kMaxServiceInterval;
+    }
+    
+    // Wake in time to top up the most urgent voice, with a few render cycles to spare
+    UInt64 deadline = _deadlines[_order[0]];
+    UInt64 margin = (UInt64)kSafetyCycles * framesPerCycle;
+    AESeconds interval = deadline > margin ? (deadline - margin) / _sampleRate : 0;
+    return MAX(framesPerCycle / _sampleRate, MIN(interval, kMaxServiceInterval));
+}
+
+- (void)updateVoice:(AEStreamingSampleVoice *)voice {
+    __unsafe_unretained AEStreamingSample * sample;
+    UInt64 generation = AEStreamingSampleStoreLoadRequest(voice, &sample);
+    if ( generation == voice->producerGeneration ) return;
+    
+    voice->producerGeneration = generation;
+    voice->producerSample = sample;
+    if ( voice->audioFile ) {
+        ExtAudioFileDispose(voice->audioFile);
+        AEAudioBufferListFree(voice->scratch);
+        voice->audioFile = NULL;
+        voice->scratch = NULL;
+    }
+    if ( voice->resampler ) {
+        AEResamplerFree(voice->resampler);
+        voice->resampler = NULL;
+    }
+    
+    if ( !sample || sample->_length <= sample->_headLength ) return;
+    
+    // Open the file, reading at its own rate in the head's format
+    AudioStreamBasicDescription fileFormat;
+    ExtAudioFileRef audioFile = AEExtAudioFileOpen([NSURL fileURLWithPath:sample.path], &fileFormat, NULL, NULL);
+    if ( !audioFile ) return;
+    
+    AudioStreamBasicDescription clientFormat = AEAudioDescriptionWithChannelsAndRate(_numberOfChannels, fileFormat.mSampleRate);
+    OSStatus result = ExtAudioFileSetProperty(audioFile, kExtAudioFileProperty_ClientDataFormat,
+                                              sizeof(clientFormat), &clientFormat);
+    if ( !AECheckOSStatus(result, "ExtAudioFileSetProperty(kExtAudioFileProperty_ClientDataFormat)") ) {
+        ExtAudioFileDispose(audioFile);
+        return;
+    }
+    
+    voice->audioFile = audioFile;
+    voice->scratch = AEAudioBufferListCreateWithFormat(clientFormat, kMaxReadFrames);
+    voice->producerPosition = sample->_headLength;
+    
+    if ( fabs(_sampleRate - fileFormat.mSampleRate) <= DBL_EPSILON ) {
+        // Continue straight on from the end of the head
+        if ( !AECheckOSStatus(ExtAudioFileSeek(audioFile, sample->_headLength), "ExtAudioFileSeek") ) {
+            ExtAudioFileDispose(audioFile);
+            AEAudioBufferListFree(voice->scratch);
+            voice->audioFile = NULL;
+            voice->scratch = NULL;
+        }
+        return;
+    }
+    
+    // The head was converted by AEAudioFileReader with AEResampler. Convert the tail the same way, running the
+    // resampler over the head's input first, so its history and phase carry on seamlessly into the tail
+    voice->resampler = AEResamplerNew(fileFormat.mSampleRate, _sampleRate, _numberOfChannels, AEResamplerQualityHigh);
+    if ( !voice->resampler ) {
+        ExtAudioFileDispose(audioFile);
+        AEAudioBufferListFree(voice->scratch);
+        voice->audioFile = NULL;
+        voice->scratch = NULL;
+        return;
+    }
+    AudioBufferList * discard =
+        AEAudioBufferListCreateWithFormat(AEAudioDescriptionWithChannelsAndRate(_numberOfChannels, _sampleRate), kMaxReadFrames);
+    for ( UInt32 position = 0; position < sample->_headLength; ) {
+        UInt32 frames = MIN(kMaxReadFrames, sample->_headLength - position);
+        AEAudioBufferListSetLength(discard, frames);
+        UInt32 decoded = [self decodeVoice:voice intoBufferList:discard frames:frames];
+        if ( decoded == 0 ) break;
+        position += decoded;
+    }
+    AEAudioBufferListFree(discard);
+}
+
+- (UInt32)decodeVoice:(AEStreamingSampleVoice *)voice intoBufferList:(const AudioBufferList *)bufferList frames:(UInt32)frames {
+    if ( !voice->resampler ) {
+        UInt32 readFrames = frames;
+        AEAudioBufferListSetLength(voice->scratch, readFrames);
+        OSStatus result = ExtAudioFileRead(voice->audioFile, &readFrames, voice->scratch);
+        if ( !AECheckOSStatus(result, "ExtAudioFileRead") ) return 0;
+        AEAudioBufferListCopyContents(bufferList, voice->scratch, 0, 0, readFrames);
+        return readFrames;
+    }
+    
+    UInt32 produced = 0;
+    while ( produced < frames ) {
+        // Read just the input needed, then resample it; past the end of the file, flush with silence as
+        // AEAudioFileReader does
+        UInt32 inputFrames = MIN(kMaxReadFrames, AEResamplerGetInputFramesRequired(voice->resampler, frames - produced));
+        UInt32 readFrames = inputFrames;
+        BOOL ended = NO;
+        if ( inputFrames > 0 ) {
+            AEAudioBufferListSetLength(voice->scratch, readFrames);
+            OSStatus result = ExtAudioFileRead(voice->audioFile, &readFrames, voice->scratch);
+            ended = !AECheckOSStatus(result, "ExtAudioFileRead") || readFrames == 0;
+        }
+        
+        AEAudioBufferListCopyOnStack(output, bufferList, produced);
+        UInt32 outputFrames = frames - produced;
+        if ( ended ) readFrames = inputFrames;
+        AEResamplerProcess(voice->resampler, ended ? NULL : voice->scratch, &readFrames, output, &outputFrames);
+        if ( outputFrames == 0 && readFrames == 0 ) break;
+        produced += outputFrames;
+    }
+    return produced;
+}
+
+- (BOOL)fillVoice:(AEStreamingSampleVoice *)voice {
+    BOOL produced = NO;
+    UInt64 end = voice->producerSample->_length;
+    while ( voice->producerPosition < end
+                && atomic_load_explicit(&voice->sequence, memory_order_relaxed) == voice->producerGeneration ) {
+        
+        // Decode into the ring, a block at a time, until it's full
+        UInt32 space = AECircularBufferGetAvailableSpace(&voice->ring);
+        UInt32 frames = (UInt32)MIN(MIN(space, kMaxReadFrames), end - voice->producerPosition);
+        if ( frames < MIN(kMinReadFrames, end - voice->producerPosition) ) break;
+        
+        AudioTimeStamp timestamp = {
+            .mFlags = kAudioTimeStampSampleTimeValid | kAudioTimeStampWordClockTimeValid,
+            .mSampleTime = voice->producerPosition,
+            .mWordClockTime = voice->producerGeneration,
+        };
+        AudioBufferList * bufferList = AECircularBufferPrepareEmptyAudioBufferList(&voice->ring, frames, &timestamp);
+        if ( !bufferList ) break;
+        
+        UInt32 readFrames = [self decodeVoice:voice intoBufferList:bufferList frames:frames];
+        if ( readFrames == 0 ) {
+            // The file ended early (length estimates can be short by a few frames): keep time with silence
+            AEAudioBufferListSilence(bufferList, 0, frames);
+            readFrames = frames;
+        } else {
+            AEAudioBufferListSetLength(bufferList, readFrames);
+        }
+        
+        AECircularBufferProduceAudioBufferList(&voice->ring, NULL);
+        voice->producerPosition += readFrames;
+        produced = YES;
+    }
+    return produced;
+}
+
+@end
+
+@implementation AEStreamingSample
+
+- (void)dealloc {
+    if ( _head ) {
+        AEAudioBufferListFree(_head);
+    }
+}
+
+- (const AudioBufferList *)head {
+    return _head;
+}
+
+@end
+
+#pragma mark - I/O thread
+
+@implementation AEStreamingSampleStoreThread
+
+- (instancetype)init {
+    if ( !(self = [super init]) ) return nil;
+    semaphore_create(mach_task_self(), &_semaphore, SYNC_POLICY_FIFO, 0);
+    return self;
+}
+
+- (void)dealloc {
+    semaphore_destroy(mach_task_self(), _semaphore);
+}
+
+- (void)cancel {
+    [super cancel];
+    semaphore_signal(_semaphore);
+}
+
+- (void)main {
+    pthread_setname_np("AEStreamingSampleStore");
+    pthread_set_qos_class_self_np(QOS_CLASS_USER_INTERACTIVE, 0);
+    
+    while ( !self.cancelled ) {
+        AESeconds interval;
+        @autoreleasepool {
+            AEStreamingSampleStore * store = self.store;
+            if ( !store ) break;
+            interval = [store service];
+        }
+        
+        if ( interval > 0 ) {
+            // Wait for a new voice, or until the most urgent voice needs topping up
+            semaphore_timedwait(_semaphore, (mach_timespec_t){ 0, (clock_res_t)(interval * NSEC_PER_SEC) });
+        }
+    }
+}
+
+@end
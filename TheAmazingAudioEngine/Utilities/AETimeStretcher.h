@@ -0,0 +1,181 @@
+//
+//  AETimeStretcher.h
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#import <Foundation/Foundation.h>
+#import <AudioToolbox/AudioToolbox.h>
+
+/*!
+ * Time stretch algorithm
+ */
+typedef enum {
+    //! Phase vocoder with identity phase locking: highest quality, for most material
+    AETimeStretchAlgorithmPhaseVocoder,
+    //! Waveform-similarity overlap-add: much lower CPU, best suited to speech and monophonic material
+    AETimeStretchAlgorithmWSOLA,
+} AETimeStretchAlgorithm;
+
+/*!
+ * Time stretcher
+ *
+ *  Changes the playback rate of audio independently of pitch, and the pitch independently of
+ *  rate, on non-interleaved float audio.
+ *
+ *  Two algorithms are available: a phase vocoder, using the FFT from AEDSPUtilities, and WSOLA, a
+ *  time-domain method which costs a fraction of the CPU. Pitch shifting is performed by stretching
+ *  and then resampling with AEResampler.
+ *
+ *  All memory is allocated on creation; once created, the time stretcher is realtime-safe, and
+ *  can be driven directly from the render thread. To stretch the output of a sub-renderer within
+ *  a render loop, see AETimePitchModule.
+ */
+typedef struct AETimeStretcher_t AETimeStretcher;
+
+/*!
+ * Create a time stretcher
+ *
+ * @param channels Number of channels
+ * @param sampleRate Sample rate, used to select analysis window sizes
+ * @param algorithm The algorithm to use
+ * @return The new time stretcher, or NULL on error
+ */
+AETimeStretcher * _Nullable AETimeStretcherNew(int channels, double sampleRate, AETimeStretchAlgorithm algorithm);
+
+/*!
+ * Free a time stretcher
+ *
+ * @param stretcher The time stretcher
+ */
+void AETimeStretcherFree(AETimeStretcher * _Nonnull stretcher);
+
+/*!
+ * Set the playback rate
+ *
+ *  Realtime-safe; takes effect from the next analysis hop.
+ *
+ * @param stretcher The time stretcher
+ * @param rate Playback rate, from 1/32 to 32; 2.0 plays twice as fast
+ */
+void AETimeStretcherSetRate(AETimeStretcher * _Nonnull stretcher, double rate);
+
+/*!
+ * Set the pitch shift
+ *
+ *  Realtime-safe.
+ *
+ * @param stretcher The time stretcher
+ * @param pitch Pitch shift in cents, from -2400 to 2400
+ */
+void AETimeStretcherSetPitch(AETimeStretcher * _Nonnull stretcher, double pitch);
+
+/*!
+ * Get the latency
+ *
+ *  The number of output frames produced before the first input frame is heard, at the current
+ *  pitch setting.
+ *
+ * @param stretcher The time stretcher
+ * @return The latency, in output frames
+ */
+UInt32 AETimeStretcherGetLatency(AETimeStretcher * _Nonnull stretcher);
+
+/*!
+ * Determine the number of input frames needed to produce the given number of output frames
+ *
+ *  The result is exact for the current rate and pitch: providing this many frames to
+ *  AETimeStretcherProcess will produce exactly the requested output, and consume all the input.
+ *
+ * @param stretcher The time stretcher
+ * @param outputFrames The number of output frames required
+ * @return The number of input frames required
+ */
+UInt32 AETimeStretcherGetInputFramesRequired(AETimeStretcher * _Nonnull stretcher, UInt32 outputFrames);
+
+/*!
+ * Process audio
+ *
+ *  Consumes input until either the output buffer is full, or all the input has been consumed,
+ *  whichever happens first. Input is copied as needed, so the input buffer doesn't need to remain
+ *  valid after this call.
+ *
+ *  If the input has fewer channels than the time stretcher, the last channel is repeated; if the
+ *  output has more channels than the time stretcher, the last channel is repeated.
+ *
+ * @param stretcher The time stretcher
+ * @param input Input audio, or NULL to provide silence (to flush remaining output at the end of a signal)
+ * @param ioInputFrames On input, the number of input frames available; on output, the number consumed
+ * @param output Output buffer
+ * @param ioOutputFrames On input, the capacity of the output buffer, in frames; on output, the number
+ *      of frames produced
+ */
+void AETimeStretcherProcess(AETimeStretcher * _Nonnull stretcher,
+                            const AudioBufferList * _Nullable input,
+                            UInt32 * _Nonnull ioInputFrames,
+                            const AudioBufferList * _Nonnull output,
+                            UInt32 * _Nonnull ioOutputFrames);
+
+/*!
+ * Reset the time stretcher
+ *
+ *  Clears history, and returns to the initial position. Realtime-safe.
+ *
+ * @param stretcher The time stretcher
+ */
+void AETimeStretcherReset(AETimeStretcher * _Nonnull stretcher);
+
+/*!
+ * Stretch a buffer list in one operation
+ *
+ *  This is a fast offline mode for processing whole files: the audio is divided into segments
+ *  which are processed concurrently on multiple threads, and then joined with short crossfades.
+ *  The output is aligned with the input, with latency removed, and its length is the input length
+ *  divided by the rate, rounded up. Not realtime-safe.
+ *
+ * @param bufferList Input audio, in non-interleaved float format
+ * @param frames Number of input frames
+ * @param sampleRate Sample rate
+ * @param algorithm The algorithm to use
+ * @param rate Playback rate, from 1/32 to 32
+ * @param pitch Pitch shift in cents, from -2400 to 2400
+ * @param outputFrames On output, if not NULL, the number of frames in the returned buffer
+ * @return A newly-allocated buffer list containing the stretched audio, which you must free with
+ *      AEAudioBufferListFree, or NULL on error
+ */
+AudioBufferList * _Nullable AETimeStretcherCreateStretchedBufferList(const AudioBufferList * _Nonnull bufferList,
+                                                                     UInt32 frames,
+                                                                     double sampleRate,
+                                                                     AETimeStretchAlgorithm algorithm,
+                                                                     double rate,
+                                                                     double pitch,
+                                                                     UInt32 * _Nullable outputFrames);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,697 @@
+//
+//  AETimeStretcher.m
+//  TheAmazingAudioEngine
+//
+//  Created by Michael Tyson on 18/10/2026.
+//  Copyright © 2026 A Tasty Pixel. All rights reserved.
+//
+//  This software is provided 'as-is', without any express or implied
+//  warranty.  In no event will the authors be held liable for any damages
+//  arising from the use of this software.
+//
+//  Permission is granted to anyone to use this software for any purpose,
+//  including commercial applications, and to alter it and redistribute it
+//  freely, subject to the following restrictions:
+//
+//  1. The origin of this software must not be misrepresented; you must not
+//     claim that you wrote the original software. If you use this software
+//     in a product, an acknowledgment in the product documentation would be
+//     appreciated but is not required.
+//
+//  2. Altered source versions must be plainly marked as such, and must not be
+//     misrepresented as being the original software.
+//
+//  3. This notice may not be removed or altered from any source distribution.
+//
+
+
+#import "AETimeStretcher.h"
+#import "AEResampler.h"
+#import "AEDSPUtilities.h"
+#import "AEAudioBufferListUtilities.h"
+#import "AETypes.h"
+#import "AEUtilities.h"
+#import <Accelerate/Accelerate.h>
+#import <dispatch/dispatch.h>
+#import <stdatomic.h>
+#import <unistd.h>
+
+static const double kMinimumRate = 1.0/32.0;
+static const double kMaximumRate = 32.0;
+static const double kMaximumPitch = 2400.0;
+static const double kPitchRatioTolerance = 1.0e-6;
+static const UInt64 kPositionScale = 1ULL << 32;
+static const int kInputChunkFrames = 4096;
+static const UInt32 kPitchBufferFrames = 4096;
+static const int kSearchDecimation = 4;
+static const float kMinimumWindowSum = 0.25;
+static const UInt32 kOfflineBlockFrames = 4096;
+static const UInt32 kOfflineMinimumSegmentFrames = 1 << 16;
+static const UInt32 kOfflineCrossfadeFrames = 2048;
+
+struct AETimeStretcher_t {
+    int channels;
+    AETimeStretchAlgorithm algorithm;
+    int windowLength;           // Analysis/synthesis frame length
+    int hop;                    // Synthesis hop
+    int tolerance;              // WSOLA search range either side of the nominal position
+    int templateLength;         // WSOLA search template length
+    double rate;
+    double pitchRatio;
+    UInt64 hopStep;             // Analysis hop, in fixed point
+    UInt64 analysisPosition;    // Start of the next analysis frame, relative to input[0], in fixed point
+    int previousPosition;       // Start of the previous analysis frame, relative to input[0]
+    BOOL hasPrevious;
+    
+    float ** input;
+    int inputFrames;
+    int inputCapacity;
+    
+    float ** accumulator;       // Overlap-add accumulators, one per channel
+    float * windowSum;          // Sum of windows applied at each accumulator frame, for normalization
+    float * normalization;
+    float * window;
+    float * synthesisWindow;
+    int readyOffset;            // Finished output frames at the front of the accumulators
+    int readyFrames;
+    BOOL shiftPending;
+    
+    // Phase vocoder
+    AEDSPFFT * fft;
+    float * frame;
+    float * real;
+    float * imag;
+    float * magnitude;
+    float * phase;
+    float * sine;
+    float * cosine;
+    float ** previousPhase;
+    float ** synthesisPhase;
+    int * peaks;
+    
+    // WSOLA
+    float * search;
+    float * template;
+    float * correlation;
+    
+    // Pitch shifting
+    AEResampler * resampler;
+    AudioBufferList * pitchBuffer;
+    BOOL resampling;
+};
+
+static int AETimeStretcherWindowLength(double sampleRate, double duration) {
+    // Nearest power of two to the given duration
+    return 1 << (int)round(log2(sampleRate * duration));
+}
+
+static void AETimeStretcherUpdateHopStep(AETimeStretcher * stretcher) {
+    // Stretch by the combined rate and pitch ratio, then resample by the pitch ratio
+    double stretchRate = stretcher->rate / stretcher->pitchRatio;
+    stretcher->hopStep = MAX(1, (UInt64)llround(stretcher->hop * stretchRate * kPositionScale));
+}
+
+AETimeStretcher * AETimeStretcherNew(int channels, double sampleRate, AETimeStretchAlgorithm algorithm) {
+    if ( channels < 1 || sampleRate <= 0.0 ) return NULL;
+    
+    AETimeStretcher * stretcher = calloc(1, sizeof(AETimeStretcher));
+    stretcher->channels = channels;
+    stretcher->algorithm = algorithm;
+    stretcher->rate = 1.0;
+    stretcher->pitchRatio = 1.0;
+    
+    if ( algorithm == AETimeStretchAlgorithmPhaseVocoder ) {
+        // ~46ms frames, with 4x overlap
+        stretcher->windowLength = AETimeStretcherWindowLength(sampleRate, 0.046);
+        stretcher->hop = stretcher->windowLength / 4;
+        stretcher->tolerance = 0;
+    } else {
+        // ~23ms frames, with 2x overlap, searching within half a hop either side
+        stretcher->windowLength = AETimeStretcherWindowLength(sampleRate, 0.023);
+        stretcher->hop = stretcher->windowLength / 2;
+        stretcher->tolerance = stretcher->hop / 2;
+        stretcher->templateLength = stretcher->hop;
+    }
+    AETimeStretcherUpdateHopStep(stretcher);
+    
+    int length = stretcher->windowLength;
+    stretcher->inputCapacity = length + 2*stretcher->tolerance + kInputChunkFrames;
+    stretcher->input = malloc(sizeof(float *) * channels);
+    stretcher->accumulator = malloc(sizeof(float *) * channels);
+    for ( int i=0; i<channels; i++ ) {
+        stretcher->input[i] = malloc(sizeof(float) * stretcher->inputCapacity);
+        stretcher->accumulator[i] = malloc(sizeof(float) * length);
+    }
+    stretcher->windowSum = malloc(sizeof(float) * length);
+    stretcher->normalization = malloc(sizeof(float) * stretcher->hop);
+    
+    // Periodic Hann window, which sums to a constant when overlapped at a quarter or half its length
+    stretcher->window = malloc(sizeof(float) * length);
+    stretcher->synthesisWindow = malloc(sizeof(float) * length);
+    for ( int i=0; i<length; i++ ) {
+        stretcher->window[i] = 0.5 - 0.5 * cos(2.0 * M_PI * i / length);
+    }
+    
+    if ( algorithm == AETimeStretchAlgorithmPhaseVocoder ) {
+        // Windowed on analysis and synthesis; fold the FFT round-trip scaling into the synthesis window
+        float scale = 1.0 / (2.0 * length);
+        vDSP_vsmul(stretcher->window, 1, &scale, stretcher->synthesisWindow, 1, length);
+        
+        int bins = length / 2;
+        stretcher->fft = AEDSPFFTInit(length);
+        stretcher->frame = malloc(sizeof(float) * length);
+        stretcher->real = malloc(sizeof(float) * bins);
+        stretcher->imag = malloc(sizeof(float) * bins);
+        stretcher->magnitude = malloc(sizeof(float) * bins);
+        stretcher->phase = malloc(sizeof(float) * bins);
+        stretcher->sine = malloc(sizeof(float) * bins);
+        stretcher->cosine = malloc(sizeof(float) * bins);
+        stretcher->peaks = malloc(sizeof(int) * bins);
+        stretcher->previousPhase = malloc(sizeof(float *) * channels);
+        stretcher->synthesisPhase = malloc(sizeof(float *) * channels);
+        for ( int i=0; i<channels; i++ ) {
+            stretcher->previousPhase[i] = malloc(sizeof(float) * bins);
+            stretcher->synthesisPhase[i] = malloc(sizeof(float) * bins);
+        }
+    } else {
+        // Windowed on synthesis only
+        memcpy(stretcher->synthesisWindow, stretcher->window, sizeof(float) * length);
+        
+        stretcher->search = malloc(sizeof(float) * (2*stretcher->tolerance + stretcher->templateLength));
+        stretcher->template = malloc(sizeof(float) * stretcher->templateLength);
+        stretcher->correlation = malloc(sizeof(float) * (2*stretcher->tolerance + 1));
+    }
+    
+    stretcher->resampler = AEResamplerNewWithVariableRatio(1.0, pow(2.0, kMaximumPitch/1200.0), channels, AEResamplerQualityMedium);
+    stretcher->pitchBuffer = AEAudioBufferListCreateWithFormat(AEAudioDescriptionWithChannelsAndRate(channels, sampleRate), kPitchBufferFrames);
+    
+    AETimeStretcherReset(stretcher);
+    return stretcher;
+}
+
+void AETimeStretcherFree(AETimeStretcher * stretcher) {
+    for ( int i=0; i<stretcher->channels; i++ ) {
+        free(stretcher->input[i]);
+        free(stretcher->accumulator[i]);
+        if ( stretcher->previousPhase ) free(stretcher->previousPhase[i]);
+        if ( stretcher->synthesisPhase ) free(stretcher->synthesisPhase[i]);
+    }
+    free(stretcher->input);
+    free(stretcher->accumulator);
+    free(stretcher->windowSum);
+    free(stretcher->normalization);
+    free(stretcher->window);
+    free(stretcher->synthesisWindow);
+    if ( stretcher->fft ) AEDSPFFTDealloc(stretcher->fft);
+    if ( stretcher->frame ) free(stretcher->frame);
+    if ( stretcher->real ) free(stretcher->real);
+    if ( stretcher->imag ) free(stretcher->imag);
+    if ( stretcher->magnitude ) free(stretcher->magnitude);
+    if ( stretcher->phase ) free(stretcher->phase);
+    if ( stretcher->sine ) free(stretcher->sine);
+    if ( stretcher->cosine ) free(stretcher->cosine);
+    if ( stretcher->peaks ) free(stretcher->peaks);
+    if ( stretcher->previousPhase ) free(stretcher->previousPhase);
+    if ( stretcher->synthesisPhase ) free(stretcher->synthesisPhase);
+    if ( stretcher->search ) free(stretcher->search);
+    if ( stretcher->template ) free(stretcher->template);
+    if ( stretcher->correlation ) free(stretcher->correlation);
+    AEResamplerFree(stretcher->resampler);
+    AEAudioBufferListFree(stretcher->pitchBuffer);
+    free(stretcher);
+}
+
+void AETimeStretcherSetRate(AETimeStretcher * stretcher, double rate) {
+    rate = MAX(kMinimumRate, MIN(kMaximumRate, rate));
+    if ( rate == stretcher->rate ) return;
+    stretcher->rate = rate;
+    AETimeStretcherUpdateHopStep(stretcher);
+}
+
+void AETimeStretcherSetPitch(AETimeStretcher * stretcher, double pitch) {
+    double pitchRatio = pow(2.0, MAX(-kMaximumPitch, MIN(kMaximumPitch, pitch)) / 1200.0);
+    if ( pitchRatio == stretcher->pitchRatio ) return;
+    stretcher->pitchRatio = pitchRatio;
+    AETimeStretcherUpdateHopStep(stretcher);
+    
+    BOOL resampling = fabs(pitchRatio - 1.0) > kPitchRatioTolerance;
+    if ( resampling && !stretcher->resampling ) {
+        AEResamplerReset(stretcher->resampler);
+    }
+    stretcher->resampling = resampling;
+    AEResamplerSetRatio(stretcher->resampler, pitchRatio);
+}
+
+UInt32 AETimeStretcherGetLatency(AETimeStretcher * stretcher) {
+    UInt32 latency = stretcher->windowLength / 2;
+    return stretcher->resampling ? (UInt32)round(latency / stretcher->pitchRatio) : latency;
+}
+
+#pragma mark - Stretching
+
+static UInt32 AETimeStretcherGetStretchInputFramesRequired(AETimeStretcher * stretcher, UInt32 outputFrames) {
+    if ( outputFrames <= stretcher->readyFrames ) return 0;
+    
+    // Find the extent of the last analysis frame we'll need, using the same arithmetic as the hops themselves
+    UInt64 hops = (outputFrames - stretcher->readyFrames + stretcher->hop - 1) / stretcher->hop;
+    SInt64 lastPosition = (SInt64)((stretcher->analysisPosition + (hops-1) * stretcher->hopStep) / kPositionScale);
+    SInt64 required = lastPosition + stretcher->tolerance + stretcher->windowLength - stretcher->inputFrames;
+    return required > 0 ? (UInt32)required : 0;
+}
+
+static void AETimeStretcherPhaseVocoderFrame(AETimeStretcher * stretcher, int channel, int position) {
+    const int bins = stretcher->windowLength / 2;
+    const float hop = stretcher->hop;
+    const float analysisHop = position - stretcher->previousPosition;
+    float * previousPhase = stretcher->previousPhase[channel];
+    float * synthesisPhase = stretcher->synthesisPhase[channel];
+    float * magnitude = stretcher->magnitude;
+    float * phase = stretcher->phase;
+    
+    // Analyse
+    vDSP_vmul(stretcher->input[channel] + position, 1, stretcher->window, 1, stretcher->frame, 1, stretcher->windowLength);
+    AEDSPFFTForward(stretcher->fft, stretcher->frame, stretcher->real, stretcher->imag);
+    float dc = stretcher->real[0];
+    float nyquist = stretcher->imag[0];
+    stretcher->imag[0] = 0;
+    DSPSplitComplex split = { .realp = stretcher->real, .imagp = stretcher->imag };
+    vDSP_zvabs(&split, 1, magnitude, 1, bins);
+    vDSP_zvphas(&split, 1, phase, 1, bins);
+    
+    if ( !stretcher->hasPrevious ) {
+        memcpy(synthesisPhase, phase, sizeof(float) * bins);
+    } else {
+        // Identity phase locking: propagate the phase of each spectral peak from its measured instantaneous
+        // frequency, then keep the bins around each peak at the same phase relationship they had on analysis
+        int peakCount = 0;
+        for ( int k=1; k<bins-1; k++ ) {
+            if ( magnitude[k] > magnitude[k-1] && magnitude[k] >= magnitude[k+1] ) {
+                stretcher->peaks[peakCount++] = k;
+            }
+        }
+        
+        const float binFrequency = 2.0 * M_PI / stretcher->windowLength;
+        for ( int p=0; p<peakCount; p++ ) {
+            int k = stretcher->peaks[p];
+            float omega = binFrequency * k;
+            float deviation = phase[k] - previousPhase[k] - omega * analysisHop;
+            deviation -= 2.0 * M_PI * rintf(deviation / (2.0 * M_PI));
+            float frequency = analysisHop > 0 ? omega + deviation / analysisHop : omega;
+            float advanced = synthesisPhase[k] + frequency * hop;
+            synthesisPhase[k] = advanced - 2.0 * M_PI * rintf(advanced / (2.0 * M_PI));
+        }
+        
+        if ( peakCount == 0 ) {
+            // No peaks (silence, or a flat spectrum): advance every bin at its centre frequency
+            for ( int k=1; k<bins; k++ ) {
+                float advanced = synthesisPhase[k] + binFrequency * k * hop;
+                synthesisPhase[k] = advanced - 2.0 * M_PI * rintf(advanced / (2.0 * M_PI));
+            }
+        } else {
+            // Assign each bin to its nearest peak, with boundaries midway between peaks
+            int regionStart = 1;
+            for ( int p=0; p<peakCount; p++ ) {
+                int peak = stretcher->peaks[p];
+                int regionEnd = p < peakCount-1 ? (peak + stretcher->peaks[p+1]) / 2 : bins-1;
+                float rotation = synthesisPhase[peak] - phase[peak];
+                for ( int k=regionStart; k<=regionEnd; k++ ) {
+                    if ( k != peak ) synthesisPhase[k] = phase[k] + rotation;
+                }
+                regionStart = regionEnd + 1;
+            }
+        }
+    }
+    memcpy(previousPhase, phase, sizeof(float) * bins);
+    
+    // Resynthesize
+    vvsincosf(stretcher->sine, stretcher->cosine, synthesisPhase, &bins);
+    vDSP_vmul(magnitude, 1, stretcher->cosine, 1, stretcher->real, 1, bins);
+    vDSP_vmul(magnitude, 1, stretcher->sine, 1, stretcher->imag, 1, bins);
+    stretcher->real[0] = dc;
+    stretcher->imag[0] = nyquist;
+    AEDSPFFTInverse(stretcher->fft, stretcher->real, stretcher->imag, stretcher->frame);
+    vDSP_vma(stretcher->frame, 1, stretcher->synthesisWindow, 1, stretcher->accumulator[channel], 1,
+             stretcher->accumulator[channel], 1, stretcher->windowLength);
+}
+
+static void AETimeStretcherMixdown(AETimeStretcher * stretcher, int position, int length, float * output) {
+    memcpy(output, stretcher->input[0] + position, sizeof(float) * length);
+    for ( int i=1; i<stretcher->channels; i++ ) {
+        vDSP_vadd(output, 1, stretcher->input[i] + position, 1, output, 1, length);
+    }
+}
+
+static int AETimeStretcherWSOLASearch(AETimeStretcher * stretcher, int position) {
+    // Find the offset around the nominal position whose waveform best continues the previous segment,
+    // with a coarse search on decimated signals, then a fine search around the best coarse candidate
+    const int tolerance = stretcher->tolerance;
+    const int templateLength = stretcher->templateLength;
+    AETimeStretcherMixdown(stretcher, position - tolerance, 2*tolerance + templateLength, stretcher->search);
+    
+    float peak;
+    vDSP_Length peakIndex;
+    int coarseCount = (2*tolerance) / kSearchDecimation + 1;
+    vDSP_conv(stretcher->search, kSearchDecimation, stretcher->template, kSearchDecimation, stretcher->correlation, 1,
+              coarseCount, templateLength / kSearchDecimation);
+    vDSP_maxvi(stretcher->correlation, 1, &peak, &peakIndex, coarseCount);
+    
+    int fineStart = MAX(0, (int)peakIndex * kSearchDecimation - (kSearchDecimation-1));
+    int fineEnd = MIN(2*tolerance, (int)peakIndex * kSearchDecimation + (kSearchDecimation-1));
+    vDSP_conv(stretcher->search + fineStart, 1, stretcher->template, 1, stretcher->correlation, 1,
+              fineEnd - fineStart + 1, templateLength);
+    vDSP_maxvi(stretcher->correlation, 1, &peak, &peakIndex, fineEnd - fineStart + 1);
+    
+    return fineStart + (int)peakIndex - tolerance;
+}
+
+static void AETimeStretcherDiscardInput(AETimeStretcher * stretcher, int frames) {
+    if ( frames <= 0 ) return;
+    int remaining = stretcher->inputFrames - frames;
+    for ( int i=0; i<stretcher->channels; i++ ) {
+        memmove(stretcher->input[i], stretcher->input[i] + frames, sizeof(float) * remaining);
+    }
+    stretcher->inputFrames = remaining;
+    stretcher->analysisPosition -= (UInt64)frames * kPositionScale;
+    stretcher->previousPosition -= frames;
+}
+
+static int AETimeStretcherFirstRequiredInputFrame(AETimeStretcher * stretcher) {
+    return (int)(stretcher->analysisPosition / kPositionScale) - stretcher->tolerance;
+}
+
+static void AETimeStretcherPerformHop(AETimeStretcher * stretcher) {
+    const int length = stretcher->windowLength;
+    const int hop = stretcher->hop;
+    
+    if ( stretcher->shiftPending ) {
+        // Move the accumulators along by a hop
+        for ( int i=0; i<stretcher->channels; i++ ) {
+            memmove(stretcher->accumulator[i], stretcher->accumulator[i] + hop, sizeof(float) * (length - hop));
+            vDSP_vclr(stretcher->accumulator[i] + length - hop, 1, hop);
+        }
+        memmove(stretcher->windowSum, stretcher->windowSum + hop, sizeof(float) * (length - hop));
+        vDSP_vclr(stretcher->windowSum + length - hop, 1, hop);
+    }
+    
+    int position = (int)(stretcher->analysisPosition / kPositionScale);
+    
+    if ( stretcher->algorithm == AETimeStretchAlgorithmPhaseVocoder ) {
+        for ( int i=0; i<stretcher->channels; i++ ) {
+            AETimeStretcherPhaseVocoderFrame(stretcher, i, position);
+        }
+        vDSP_vma(stretcher->window, 1, stretcher->window, 1, stretcher->windowSum, 1, stretcher->windowSum, 1, length);
+    } else {
+        if ( stretcher->hasPrevious ) {
+            position += AETimeStretcherWSOLASearch(stretcher, position);
+        }
+        for ( int i=0; i<stretcher->channels; i++ ) {
+            vDSP_vma(stretcher->input[i] + position, 1, stretcher->synthesisWindow, 1, stretcher->accumulator[i], 1,
+                     stretcher->accumulator[i], 1, length);
+        }
+        vDSP_vadd(stretcher->window, 1, stretcher->windowSum, 1, stretcher->windowSum, 1, length);
+        
+        // Take the natural continuation of this segment as the template for the next search
+        AETimeStretcherMixdown(stretcher, position + hop, stretcher->templateLength, stretcher->template);
+    }
+    
+    // The first hop of the accumulators is now complete: normalize it by the applied window gain
+    vDSP_vthr(stretcher->windowSum, 1, &kMinimumWindowSum, stretcher->normalization, 1, hop);
+    for ( int i=0; i<stretcher->channels; i++ ) {
+        vDSP_vdiv(stretcher->normalization, 1, stretcher->accumulator[i], 1, stretcher->accumulator[i], 1, hop);
+    }
+    stretcher->readyOffset = 0;
+    stretcher->readyFrames = hop;
+    stretcher->shiftPending = YES;
+    
+    // Advance, and discard input we no longer need
+    stretcher->previousPosition = position;
+    stretcher->hasPrevious = YES;
+    stretcher->analysisPosition += stretcher->hopStep;
+    AETimeStretcherDiscardInput(stretcher, MIN(stretcher->inputFrames, AETimeStretcherFirstRequiredInputFrame(stretcher)));
+}
+
+static UInt32 AETimeStretcherStretch(AETimeStretcher * stretcher, const AudioBufferList * input, UInt32 * inputOffset,
+                                     UInt32 inputFrames, const AudioBufferList * output, UInt32 outputFrames) {
+    UInt32 produced = 0;
+    while ( 1 ) {
+        // Copy out finished frames
+        if ( stretcher->readyFrames > 0 ) {
+            UInt32 frames = MIN((UInt32)stretcher->readyFrames, outputFrames - produced);
+            for ( int i=0; i<output->mNumberBuffers; i++ ) {
+                memcpy((float*)output->mBuffers[i].mData + produced,
+                       stretcher->accumulator[MIN(i, stretcher->channels-1)] + stretcher->readyOffset, sizeof(float) * frames);
+            }
+            stretcher->readyOffset += frames;
+            stretcher->readyFrames -= frames;
+            produced += frames;
+        }
+        if ( produced == outputFrames ) break;
+        
+        // Perform the next hop, if we have enough input
+        int position = (int)(stretcher->analysisPosition / kPositionScale);
+        if ( position + stretcher->tolerance + stretcher->windowLength <= stretcher->inputFrames ) {
+            AETimeStretcherPerformHop(stretcher);
+            continue;
+        }
+        
+        if ( *inputOffset == inputFrames ) break;
+        
+        int firstRequired = AETimeStretcherFirstRequiredInputFrame(stretcher);
+        if ( stretcher->inputFrames == 0 && firstRequired > 0 ) {
+            // Fast playback can step over input entirely: skip it without copying
+            UInt32 skip = MIN((UInt32)firstRequired, inputFrames - *inputOffset);
+            stretcher->analysisPosition -= (UInt64)skip * kPositionScale;
+            stretcher->previousPosition -= skip;
+            *inputOffset += skip;
+            continue;
+        }
+        
+        // Take in more input
+        UInt32 count = MIN((UInt32)(stretcher->inputCapacity - stretcher->inputFrames), inputFrames - *inputOffset);
+        for ( int i=0; i<stretcher->channels; i++ ) {
+            float * target = stretcher->input[i] + stretcher->inputFrames;
+            if ( input ) {
+                memcpy(target, (float*)input->mBuffers[MIN(i, input->mNumberBuffers-1)].mData + *inputOffset, sizeof(float) * count);
+            } else {
+                vDSP_vclr(target, 1, count);
+            }
+        }
+        stretcher->inputFrames += count;
+        *inputOffset += count;
+    }
+    
+    return produced;
+}
+
+#pragma mark - Processing
+
+UInt32 AETimeStretcherGetInputFramesRequired(AETimeStretcher * stretcher, UInt32 outputFrames) {
+    if ( stretcher->resampling ) {
+        outputFrames = AEResamplerGetInputFramesRequired(stretcher->resampler, outputFrames);
+    }
+    return AETimeStretcherGetStretchInputFramesRequired(stretcher, outputFrames);
+}
+
+void AETimeStretcherProcess(AETimeStretcher * stretcher, const AudioBufferList * input, UInt32 * ioInputFrames,
+                            const AudioBufferList * output, UInt32 * ioOutputFrames) {
+    UInt32 inputFrames = *ioInputFrames;
+    UInt32 outputFrames = *ioOutputFrames;
+    UInt32 inputOffset = 0;
+    
+    if ( !stretcher->resampling ) {
+        *ioOutputFrames = AETimeStretcherStretch(stretcher, input, &inputOffset, inputFrames, output, outputFrames);
+        *ioInputFrames = inputOffset;
+        return;
+    }
+    
+    // Stretch into the pitch buffer, then resample from there to the output
+    UInt32 produced = 0;
+    while ( produced < outputFrames ) {
+        UInt32 remaining = outputFrames - produced;
+        UInt32 stretchFrames = MIN(AEResamplerGetInputFramesRequired(stretcher->resampler, remaining), kPitchBufferFrames);
+        UInt32 stretched = AETimeStretcherStretch(stretcher, input, &inputOffset, inputFrames, stretcher->pitchBuffer, stretchFrames);
+        
+        UInt32 consumed = stretched;
+        UInt32 resampled = remaining;
+        AEAudioBufferListCopyOnStack(target, output, produced);
+        AEResamplerProcess(stretcher->resampler, stretcher->pitchBuffer, &consumed, target, &resampled);
+        #ifdef DEBUG
+        // The resampler should take exactly what it asked for; if it didn't, the rest is dropped
+        if ( consumed < stretched && AERateLimit() ) {
+            printf("%s: resampler consumed %u of %u stretched frames\n", __FUNCTION__, (unsigned)consumed, (unsigned)stretched);
+        }
+        #endif
+        produced += resampled;
+        
+        if ( stretched < stretchFrames ) break;
+    }
+    
+    *ioInputFrames = inputOffset;
+    *ioOutputFrames = produced;
+}
+
+void AETimeStretcherReset(AETimeStretcher * stretcher) {
+    // Prime the input with silence, so the first analysis frame is centred on the first input frame
+    int priming = stretcher->windowLength/2 + stretcher->tolerance;
+    for ( int i=0; i<stretcher->channels; i++ ) {
+        vDSP_vclr(stretcher->input[i], 1, priming);
+        vDSP_vclr(stretcher->accumulator[i], 1, stretcher->windowLength);
+    }
+    vDSP_vclr(stretcher->windowSum, 1, stretcher->windowLength);
+    stretcher->inputFrames = priming;
+    stretcher->analysisPosition = (UInt64)stretcher->tolerance * kPositionScale;
+    stretcher->previousPosition = 0;
+    stretcher->hasPrevious = NO;
+    stretcher->readyOffset = 0;
+    stretcher->readyFrames = 0;
+    stretcher->shiftPending = NO;
+    AEResamplerReset(stretcher->resampler);
+}
+
+#pragma mark - Offline
+
+typedef struct {
+    const AudioBufferList * input;
+    UInt32 inputFrames;
+    double sampleRate;
+    AETimeStretchAlgorithm algorithm;
+    double rate;
+    double pitch;
+    UInt32 outputFrames;
+    UInt32 segmentCount;
+    AudioBufferList * output;
+    AudioBufferList ** tails;
+    atomic_bool failed; // Set by any segment's worker
+} AETimeStretcherOfflineJob;
+
+static UInt32 AETimeStretcherOfflineSegmentStart(AETimeStretcherOfflineJob * job, size_t segment) {
+    return (UInt32)(((UInt64)job->outputFrames * segment) / job->segmentCount);
+}
+
+static void AETimeStretcherOfflineCopy(const AudioBufferList * source, UInt32 sourcePosition, UInt32 frames,
+                                       UInt32 rangeStart, UInt32 rangeEnd, AudioBufferList * destination, UInt32 destinationOffset) {
+    // Copy the part of the source, which starts at the given position, that intersects the given range
+    UInt32 start = MAX(sourcePosition, rangeStart);
+    UInt32 end = MIN(sourcePosition + frames, rangeEnd);
+    if ( end <= start ) return;
+    for ( int i=0; i<destination->mNumberBuffers; i++ ) {
+        memcpy((float*)destination->mBuffers[i].mData + destinationOffset + (start - rangeStart),
+               (float*)source->mBuffers[i].mData + (start - sourcePosition), sizeof(float) * (end - start));
+    }
+}
+
+static void AETimeStretcherOfflineRenderSegment(void * context, size_t segment) {
+    AETimeStretcherOfflineJob * job = (AETimeStretcherOfflineJob *)context;
+    AETimeStretcher * stretcher = AETimeStretcherNew(job->input->mNumberBuffers, job->sampleRate, job->algorithm);
+    AudioBufferList * block = AEAudioBufferListCreateWithFormat(
+        AEAudioDescriptionWithChannelsAndRate(job->input->mNumberBuffers, job->sampleRate), kOfflineBlockFrames);
+    if ( !stretcher || !block ) {
+        if ( stretcher ) AETimeStretcherFree(stretcher);
+        if ( block ) AEAudioBufferListFree(block);
+        atomic_store_explicit(&job->failed, YES, memory_order_relaxed);
+        return;
+    }
+    AETimeStretcherSetRate(stretcher, job->rate);
+    AETimeStretcherSetPitch(stretcher, job->pitch);
+    
+    // Start a little early, so analysis has settled by the time we reach the segment, and
+    // run a little past the end, to provide material for the crossfade into the next segment
+    UInt32 start = AETimeStretcherOfflineSegmentStart(job, segment);
+    UInt32 end = AETimeStretcherOfflineSegmentStart(job, segment+1);
+    UInt32 leadIn = MIN(start, 2 * stretcher->windowLength);
+    UInt32 tail = segment < job->segmentCount-1 ? MIN(kOfflineCrossfadeFrames, job->outputFrames - end) : 0;
+    UInt32 inputPosition = (UInt32)MIN((double)job->inputFrames, round((start - leadIn) * job->rate));
+    UInt32 skip = AETimeStretcherGetLatency(stretcher) + leadIn;
+    UInt32 length = end - start;
+    UInt32 total = skip + length + tail;
+    
+    for ( UInt32 position = 0; position < total; ) {
+        UInt32 frames = MIN(kOfflineBlockFrames, total - position);
+        UInt32 required = AETimeStretcherGetInputFramesRequired(stretcher, frames);
+        UInt32 available = inputPosition < job->inputFrames ? MIN(required, job->inputFrames - inputPosition) : 0;
+        
+        // Provide input, then silence beyond the end of the input
+        UInt32 produced = 0;
+        if ( available > 0 ) {
+            AEAudioBufferListCopyOnStack(source, job->input, inputPosition);
+            UInt32 consumed = available;
+            produced = frames;
+            AETimeStretcherProcess(stretcher, source, &consumed, block, &produced);
+            inputPosition += consumed;
+        }
+        if ( produced < frames ) {
+            AEAudioBufferListCopyOnStack(target, block, produced);
+            UInt32 silence = AETimeStretcherGetInputFramesRequired(stretcher, frames - produced);
+            UInt32 remaining = frames - produced;
+            AETimeStretcherProcess(stretcher, NULL, &silence, target, &remaining);
+            produced += remaining;
+        }
+        
+        // Copy the part that falls within the segment, then the part that falls within the crossfade
+        AETimeStretcherOfflineCopy(block, position, produced, skip, skip + length, job->output, start);
+        if ( tail > 0 ) {
+            AETimeStretcherOfflineCopy(block, position, produced, skip + length, total, job->tails[segment], 0);
+        }
+        position += produced;
+    }
+    
+    AETimeStretcherFree(stretcher);
+    AEAudioBufferListFree(block);
+}
+
+AudioBufferList * AETimeStretcherCreateStretchedBufferList(const AudioBufferList * bufferList, UInt32 frames, double sampleRate,
+                                                           AETimeStretchAlgorithm algorithm, double rate, double pitch,
+                                                           UInt32 * outputFrames) {
+    rate = MAX(kMinimumRate, MIN(kMaximumRate, rate));
+    int channels = bufferList->mNumberBuffers;
+    AudioStreamBasicDescription format = AEAudioDescriptionWithChannelsAndRate(channels, sampleRate);
+    
+    AETimeStretcherOfflineJob job = {
+        .input = bufferList,
+        .inputFrames = frames,
+        .sampleRate = sampleRate,
+        .algorithm = algorithm,
+        .rate = rate,
+        .pitch = pitch,
+        .outputFrames = (UInt32)ceil(frames / rate),
+    };
+    
+    // Divide the output into segments, to be rendered concurrently
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    job.segmentCount = (UInt32)MAX(1, MIN(MAX(1, processors) * 2, job.outputFrames / kOfflineMinimumSegmentFrames));
+    
+    job.output = AEAudioBufferListCreateWithFormat(format, MAX(1, job.outputFrames));
+    job.tails = calloc(job.segmentCount, sizeof(AudioBufferList *));
+    for ( UInt32 i=0; i<job.segmentCount-1 && job.output; i++ ) {
+        job.tails[i] = AEAudioBufferListCreateWithFormat(format, kOfflineCrossfadeFrames);
+        if ( !job.tails[i] ) atomic_store_explicit(&job.failed, YES, memory_order_relaxed);
+    }
+    
+    if ( job.output && !atomic_load_explicit(&job.failed, memory_order_relaxed) ) {
+        dispatch_apply_f(job.segmentCount, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), &job,
+                         AETimeStretcherOfflineRenderSegment);
+    }
+    
+    // Crossfade from the tail of each segment into the start of the next (dispatch_apply_f has waited for
+    // every worker, so their writes are visible here)
+    BOOL failed = atomic_load_explicit(&job.failed, memory_order_relaxed);
+    for ( UInt32 i=0; i<job.segmentCount-1 && job.output && !failed; i++ ) {
+        UInt32 start = AETimeStretcherOfflineSegmentStart(&job, i+1);
+        UInt32 length = MIN(kOfflineCrossfadeFrames, job.outputFrames - start);
+        AEAudioBufferListCopyOnStack(target, job.output, start);
+        AEDSPCrossfade(job.tails[i], target, target, length);
+    }
+    
+    for ( UInt32 i=0; i<job.segmentCount-1; i++ ) {
+        if ( job.tails[i] ) AEAudioBufferListFree(job.tails[i]);
+    }
+    free(job.tails);
+    
+    if ( failed && job.output ) {
+        AEAudioBufferListFree(job.output);
+        job.output = NULL;
+    }
+    
+    if ( outputFrames ) *outputFrames = job.output ? job.outputFrames : 0;
+    return job.output;
+}